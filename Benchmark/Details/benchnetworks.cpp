@@ -0,0 +1,152 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "benchnetworks.h"
+
+#include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/qrutils.h"
+
+#include "Support/random.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+namespace uiiit {
+namespace qr {
+namespace bench {
+
+std::string toString(const Topology aTopology) {
+  switch (aTopology) {
+    case Topology::Ppp:
+      return "ppp";
+    case Topology::Waxman:
+      return "waxman";
+  }
+  throw std::runtime_error("invalid topology: " +
+                           std::to_string(static_cast<int>(aTopology)));
+}
+
+std::vector<std::int64_t> allTopologies() {
+  return {static_cast<std::int64_t>(Topology::Ppp),
+          static_cast<std::int64_t>(Topology::Waxman)};
+}
+
+std::vector<std::int64_t> networkSizes(const std::int64_t aMaxNodes) {
+  std::vector<std::int64_t> ret;
+  for (std::int64_t myNodes = 100; myNodes <= aMaxNodes; myNodes *= 10) {
+    ret.emplace_back(myNodes);
+  }
+  return ret;
+}
+
+const CapacityNetwork::WeightVector& networkEdges(const Topology    aTopology,
+                                                  const std::size_t aNodes) {
+  static std::map<std::pair<Topology, std::size_t>,
+                  CapacityNetwork::WeightVector>
+      myNetworks;
+
+  const auto myKey = std::make_pair(aTopology, aNodes);
+  auto       it    = myNetworks.find(myKey);
+  if (it == myNetworks.end()) {
+    const auto mySeed = 42u;
+    const auto myNetwork =
+        aTopology == Topology::Ppp ? makePppNetwork(aNodes, mySeed) :
+                                     makeWaxmanNetwork(aNodes, mySeed);
+    it = myNetworks.emplace(myKey, myNetwork->weights()).first;
+  }
+  return it->second;
+}
+
+std::unique_ptr<CapacityNetwork> makePppNetwork(const std::size_t aNodes,
+                                                const std::size_t aSeed) {
+  // 100 nodes in a 60 km x 60 km area, with 15 km maximum link length
+  support::UniformRv      myEprRv(1, 400, aSeed, 0, 0);
+  std::vector<Coordinate> myCoordinates;
+  return makeCapacityNetworkPpp<CapacityNetwork>(
+      myEprRv,
+      aSeed,
+      static_cast<double>(aNodes),
+      60000 * std::sqrt(aNodes / 100.0),
+      15000,
+      1,
+      myCoordinates);
+}
+
+std::unique_ptr<CapacityNetwork> makeWaxmanNetwork(const std::size_t aNodes,
+                                                   const std::size_t aSeed) {
+  // 100 nodes with alpha = beta = 0.4, over a maximum distance of 100 km
+  const auto              myMaxDistance = 100.0;
+  const auto              myMaxCapacity = 100e3;
+  std::vector<Coordinate> myCoordinates;
+  return makeCapacityNetworkWaxman<CapacityNetwork>(
+      [myMaxDistance, myMaxCapacity](const double d) {
+        return myMaxCapacity * std::exp(-d / myMaxDistance);
+      },
+      aSeed,
+      aNodes,
+      myMaxDistance,
+      0.4,
+      std::min(1.0, 0.4 * 100 / aNodes),
+      myCoordinates);
+}
+
+std::unique_ptr<CapacityNetwork>
+makeWaxmanNetworkParallel(const std::size_t aNodes,
+                          const std::size_t aSeed,
+                          const std::size_t aNumThreads) {
+  const auto              myMaxDistance = 100.0;
+  const auto              myMaxCapacity = 100e3;
+  std::vector<Coordinate> myCoordinates;
+  return makeCapacityNetworkWaxmanParallel<CapacityNetwork>(
+      [myMaxDistance, myMaxCapacity](const double d) {
+        return myMaxCapacity * std::exp(-d / myMaxDistance);
+      },
+      aSeed,
+      aNodes,
+      myMaxDistance,
+      0.4,
+      std::min(1.0, 0.4 * 100 / aNodes),
+      myCoordinates,
+      aNumThreads);
+}
+
+bool fidelityCheck(const std::size_t aHops) {
+  assert(aHops > 0);
+  return fidelitySwapping(1, 1, 1, aHops - 1, 0.99) >= 0.95;
+}
+
+} // namespace bench
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,141 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+namespace bench {
+
+/**
+ * @brief The topologies of the networks used in the benchmarks.
+ *
+ * The parameters are those of the experiments, with the size of the area
+ * (PPP) or the edge density (Waxman) scaled so that the average node degree
+ * does not depend on the number of nodes.
+ */
+enum class Topology : int {
+  Ppp    = 0, //!< Poisson Point Process, as in experiments 001-005
+  Waxman = 1, //!< Waxman model, as in experiment 006
+};
+
+std::string toString(const Topology aTopology);
+
+//! \return all the topologies, to be used as benchmark arguments.
+std::vector<std::int64_t> allTopologies();
+
+//! \return the values of an enum, to be used as benchmark arguments.
+template <class ENUM>
+std::vector<std::int64_t> toArgs(const std::vector<ENUM>& aValues) {
+  std::vector<std::int64_t> ret;
+  for (const auto& myValue : aValues) {
+    ret.emplace_back(static_cast<std::int64_t>(myValue));
+  }
+  return ret;
+}
+
+//! \return the network sizes 100, 1000, ... up to aMaxNodes.
+std::vector<std::int64_t> networkSizes(const std::int64_t aMaxNodes);
+
+/**
+ * @brief Create the edges of a network with the given topology.
+ *
+ * The networks are generated only once per topology and size, with the same
+ * seed, hence all the benchmarks run on the same networks.
+ *
+ * @param aTopology The topology of the network.
+ * @param aNodes The number of nodes, which is only the average with PPP.
+ * @return the edges and their capacities.
+ */
+const CapacityNetwork::WeightVector& networkEdges(const Topology    aTopology,
+                                                  const std::size_t aNodes);
+
+//! \return a network built with the edges returned by networkEdges().
+template <class NETWORK>
+std::unique_ptr<NETWORK> makeNetwork(const Topology    aTopology,
+                                     const std::size_t aNodes) {
+  return std::make_unique<NETWORK>(networkEdges(aTopology, aNodes));
+}
+
+/**
+ * @brief Create a PPP network with the factory.
+ *
+ * @param aNodes The average number of nodes.
+ * @param aSeed The seed for random number generation.
+ * @return the network created.
+ */
+std::unique_ptr<CapacityNetwork> makePppNetwork(const std::size_t aNodes,
+                                                const std::size_t aSeed);
+
+/**
+ * @brief Create a Waxman network with the factory.
+ *
+ * @param aNodes The number of nodes.
+ * @param aSeed The seed for random number generation.
+ * @return the network created.
+ */
+std::unique_ptr<CapacityNetwork> makeWaxmanNetwork(const std::size_t aNodes,
+                                                   const std::size_t aSeed);
+
+/**
+ * @brief Create a Waxman network with the factory drawing the edges in
+ * parallel, with the same parameters as makeWaxmanNetwork().
+ *
+ * @param aNodes The number of nodes.
+ * @param aSeed The seed for random number generation.
+ * @param aNumThreads The number of threads, if 0 use the hardware
+ * concurrency.
+ * @return the network created.
+ */
+std::unique_ptr<CapacityNetwork>
+makeWaxmanNetworkParallel(const std::size_t aNodes,
+                          const std::size_t aSeed,
+                          const std::size_t aNumThreads);
+
+/**
+ * @brief Check the fidelity of a path, as in the experiments.
+ *
+ * @param aHops The path length, in hops.
+ * @return true if the end-to-end fidelity with entanglement swapping is at
+ * least 0.95, with a local entanglement fidelity of 0.99.
+ */
+bool fidelityCheck(const std::size_t aHops);
+
+} // namespace bench
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,194 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Details/benchnetworks.h"
+
+#include "QuantumRouting/capacitynetwork.h"
+
+#include "Support/random.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+namespace {
+
+//! \return aNum random pairs (source, destinations), with aNumDst each.
+std::vector<std::pair<unsigned long, std::set<unsigned long>>>
+makeQueries(const std::size_t aNumNodes,
+            const std::size_t aNum,
+            const std::size_t aNumDst) {
+  us::UniformIntRv<unsigned long> myNodeRv(0, aNumNodes - 1, 0, 0, 0);
+  std::vector<std::pair<unsigned long, std::set<unsigned long>>> ret;
+  for (std::size_t i = 0; i < aNum; i++) {
+    ret.emplace_back(myNodeRv(), std::set<unsigned long>());
+    while (ret.back().second.size() < aNumDst) {
+      ret.back().second.emplace(myNodeRv());
+    }
+  }
+  return ret;
+}
+
+} // namespace
+
+// arguments: topology, number of nodes
+static void BM_CapacityNetworkCspf(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::CapacityNetwork>(myTopology, aState.range(1));
+
+  // the capacity requirement is half the average edge capacity
+  const auto myCapacity =
+      myNetwork->totalCapacity() / myNetwork->numEdges() / 2;
+  const auto myQueries = makeQueries(myNetwork->numNodes(), 100, 10);
+
+  qr::CsrGraph::Scratch                               myScratch;
+  std::map<unsigned long, std::vector<unsigned long>> myPaths;
+  std::size_t                                         myNext = 0;
+  for (auto _ : aState) {
+    const auto& myQuery = myQueries[myNext++ % myQueries.size()];
+    myNetwork->cspf(
+        myQuery.first, myCapacity, myQuery.second, myScratch, myPaths);
+    benchmark::DoNotOptimize(myPaths);
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+}
+BENCHMARK(BM_CapacityNetworkCspf)
+    ->ArgNames({"topology", "nodes"})
+    ->ArgsProduct({qr::bench::allTopologies(), qr::bench::networkSizes(10000)});
+
+// arguments: topology, number of nodes
+static void BM_CapacityNetworkReachableNodes(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::CapacityNetwork>(myTopology, aState.range(1));
+
+  std::size_t myDiameter = 0;
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(myNetwork->reachableNodes(
+        0, std::numeric_limits<std::size_t>::max(), myDiameter));
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+}
+// the output has one entry per pair of nodes, which is too big with 10k nodes
+BENCHMARK(BM_CapacityNetworkReachableNodes)
+    ->ArgNames({"topology", "nodes"})
+    ->ArgsProduct({qr::bench::allTopologies(), qr::bench::networkSizes(1000)})
+    ->Unit(benchmark::kMillisecond);
+
+// arguments: topology, number of nodes
+static void BM_CapacityNetworkReachableNodesCompact(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::CapacityNetwork>(myTopology, aState.range(1));
+
+  std::size_t myDiameter = 0;
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(myNetwork->reachableNodesCompact(
+        0, std::numeric_limits<std::size_t>::max(), myDiameter));
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+}
+BENCHMARK(BM_CapacityNetworkReachableNodesCompact)
+    ->ArgNames({"topology", "nodes"})
+    ->ArgsProduct({qr::bench::allTopologies(), qr::bench::networkSizes(10000)})
+    ->Unit(benchmark::kMillisecond);
+
+// arguments: topology, number of nodes
+static void BM_CapacityNetworkClosestNodes(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::CapacityNetwork>(myTopology, aState.range(1));
+
+  us::UniformIntRv<unsigned long> mySrcRv(
+      0, myNetwork->numNodes() - 1, 0, 0, 0);
+  us::UniformRv myTieRv(0, 1, 0, 0, 0);
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(myNetwork->closestNodes(mySrcRv(), 10, myTieRv));
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+}
+BENCHMARK(BM_CapacityNetworkClosestNodes)
+    ->ArgNames({"topology", "nodes"})
+    ->ArgsProduct({qr::bench::allTopologies(), qr::bench::networkSizes(10000)})
+    ->Unit(benchmark::kMicrosecond);
+
+// arguments: topology, number of nodes, use the hop distance index or not
+static void BM_CapacityNetworkClosestDataCenters(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::CapacityNetwork>(myTopology, aState.range(1));
+  const auto myUseIndex = aState.range(2) != 0;
+
+  // 50 data centers and 100 apps asking for the 2 closest ones each
+  us::UniformIntRv<unsigned long> myNodeRv(
+      0, myNetwork->numNodes() - 1, 0, 0, 0);
+  std::set<unsigned long> myDataCenters;
+  while (myDataCenters.size() < std::min<std::size_t>(50, aState.range(1))) {
+    myDataCenters.emplace(myNodeRv());
+  }
+  const std::vector<unsigned long> myCandidates(myDataCenters.begin(),
+                                                myDataCenters.end());
+  std::vector<unsigned long>       myHosts;
+  for (std::size_t i = 0; i < 100; i++) {
+    myHosts.emplace_back(myNodeRv());
+  }
+
+  us::UniformRv myTieRv(0, 1, 0, 0, 0);
+  for (auto _ : aState) {
+    if (myUseIndex) {
+      const auto myIndex = myNetwork->hopDistanceIndex(myCandidates);
+      for (const auto myHost : myHosts) {
+        benchmark::DoNotOptimize(myIndex.closest(myHost, 2, myTieRv));
+      }
+    } else {
+      for (const auto myHost : myHosts) {
+        benchmark::DoNotOptimize(
+            myNetwork->closestNodes(myHost, 2, myTieRv, myDataCenters));
+      }
+    }
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+}
+BENCHMARK(BM_CapacityNetworkClosestDataCenters)
+    ->ArgNames({"topology", "nodes", "index"})
+    ->ArgsProduct({qr::bench::allTopologies(),
+                   qr::bench::networkSizes(10000),
+                   {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,155 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Details/benchnetworks.h"
+
+#include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/kspcache.h"
+
+#include "Support/random.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+// arguments: topology, number of nodes, FlowRouteAlgo
+static void BM_EsNetworkRouteFlows(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myAlgo     = static_cast<qr::FlowRouteAlgo>(aState.range(2));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::EsNetwork>(myTopology, aState.range(1));
+  myNetwork->measurementProbability(0.5);
+  const auto mySnapshot = myNetwork->snapshot();
+
+  // 100 flows between random nodes, as in experiment 001
+  us::UniformIntRv<unsigned long> mySrcDstRv(
+      0, myNetwork->numNodes() - 1, 0, 0, 0);
+  us::UniformRv                       myNetRateRv(1, 10, 0, 0, 0);
+  std::vector<unsigned long>          mySrcs;
+  std::vector<unsigned long>          myDsts;
+  std::vector<double>                 myNetRates;
+  while (mySrcs.size() < 100) {
+    const auto mySrc = mySrcDstRv();
+    const auto myDst = mySrcDstRv();
+    if (mySrc != myDst) {
+      mySrcs.emplace_back(mySrc);
+      myDsts.emplace_back(myDst);
+      myNetRates.emplace_back(myNetRateRv());
+    }
+  }
+
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    myNetwork->restore(mySnapshot);
+    std::vector<qr::EsNetwork::FlowDescriptor> myFlows;
+    for (std::size_t i = 0; i < mySrcs.size(); i++) {
+      myFlows.emplace_back(mySrcs[i], myDsts[i], myNetRates[i]);
+    }
+    aState.ResumeTiming();
+
+    myNetwork->route(myFlows, myAlgo, [](const auto& aFlow) {
+      return qr::bench::fidelityCheck(aFlow.thePath.size());
+    });
+    benchmark::DoNotOptimize(myFlows);
+  }
+  aState.SetLabel(qr::bench::toString(myTopology) + "/" +
+                  qr::toString(myAlgo));
+  aState.SetItemsProcessed(aState.iterations() * mySrcs.size());
+}
+BENCHMARK(BM_EsNetworkRouteFlows)
+    ->ArgNames({"topology", "nodes", "algo"})
+    ->ArgsProduct({qr::bench::allTopologies(),
+                   qr::bench::networkSizes(10000),
+                   qr::bench::toArgs(qr::allFlowRouteAlgos())})
+    ->Unit(benchmark::kMillisecond);
+
+// arguments: topology, number of nodes, AppRouteAlgo
+static void BM_EsNetworkRouteApps(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myAlgo     = static_cast<qr::AppRouteAlgo>(aState.range(2));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::EsNetwork>(myTopology, aState.range(1));
+  myNetwork->measurementProbability(0.5);
+  const auto mySnapshot = myNetwork->snapshot();
+
+  // 100 apps on random hosts with two peers among the closest nodes, as in
+  // experiment 002
+  us::UniformIntRv<unsigned long> myHostRv(
+      0, myNetwork->numNodes() - 1, 0, 0, 0);
+  us::UniformRv                           myTieRv(0, 1, 0, 0, 0);
+  std::vector<unsigned long>              myHosts;
+  std::vector<std::vector<unsigned long>> myPeers;
+  for (std::size_t i = 0; i < 100; i++) {
+    myHosts.emplace_back(myHostRv());
+    myPeers.emplace_back(myNetwork->closestNodes(myHosts.back(), 2, myTieRv));
+  }
+
+  // the DRR quantum is scaled with the average edge capacity, so that it is
+  // equal to the number of apps with PPP, as in experiment 002
+  const auto myQuantum = myHosts.size() * myNetwork->totalCapacity() /
+                         myNetwork->numEdges() / 200;
+
+  us::UniformRv myRouteRv(0, 1, 0, 0, 0);
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    myNetwork->restore(mySnapshot);
+    myNetwork->kspCache(std::make_shared<qr::KspCache>());
+    std::vector<qr::EsNetwork::AppDescriptor> myApps;
+    for (std::size_t i = 0; i < myHosts.size(); i++) {
+      myApps.emplace_back(myHosts[i], myPeers[i], 1.0, 0.95);
+    }
+    aState.ResumeTiming();
+
+    myNetwork->route(myApps,
+                     myAlgo,
+                     myQuantum,
+                     myRouteRv,
+                     5,
+                     [](const auto&, const auto& aPath) {
+                       return qr::bench::fidelityCheck(aPath.size());
+                     });
+    benchmark::DoNotOptimize(myApps);
+  }
+  aState.SetLabel(qr::bench::toString(myTopology) + "/" +
+                  qr::toString(myAlgo));
+  aState.SetItemsProcessed(aState.iterations() * myHosts.size());
+}
+// the search of the k-shortest paths takes tens of seconds with 10k nodes
+BENCHMARK(BM_EsNetworkRouteApps)
+    ->ArgNames({"topology", "nodes", "algo"})
+    ->ArgsProduct({qr::bench::allTopologies(),
+                   qr::bench::networkSizes(1000),
+                   qr::bench::toArgs(qr::allAppRouteAlgos())})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,105 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Details/benchnetworks.h"
+
+#include "QuantumRouting/mecqkdnetwork.h"
+
+#include "Support/random.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+// arguments: topology, number of nodes, MecQkdAlgo
+static void BM_MecQkdNetworkAllocate(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myAlgo     = static_cast<qr::MecQkdAlgo>(aState.range(2));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::MecQkdNetwork>(myTopology, aState.range(1));
+
+  // 10 random user nodes and 10 random edge nodes, as in experiment 006
+  us::UniformIntRv<unsigned long> myNodeRv(
+      0, myNetwork->numNodes() - 1, 0, 0, 0);
+  std::set<unsigned long> myUserNodes;
+  while (myUserNodes.size() < 10) {
+    myUserNodes.emplace(myNodeRv());
+  }
+  us::UniformRv                   myProcessingRv(1, 3, 0, 0, 0);
+  std::map<unsigned long, double> myEdgeProcessing;
+  while (myEdgeProcessing.size() < 10) {
+    const auto myNode = myNodeRv();
+    if (myUserNodes.count(myNode) == 0) {
+      myEdgeProcessing.emplace(myNode, myProcessingRv());
+    }
+  }
+  myNetwork->userNodes(myUserNodes);
+  myNetwork->edgeNodes(myEdgeProcessing);
+  const auto mySnapshot = myNetwork->snapshot();
+
+  // 100 apps, each with a rate of about 1% of the average edge capacity
+  const std::vector<unsigned long> myUsers(myUserNodes.begin(),
+                                           myUserNodes.end());
+  const auto myAvgCapacity = myNetwork->totalCapacity() / myNetwork->numEdges();
+  us::UniformRv                              myRateRv(0.5, 1.5, 0, 0, 0);
+  us::UniformRv                              myLoadRv(0.05, 0.15, 0, 0, 0);
+  std::vector<qr::MecQkdNetwork::Allocation> myInitApps;
+  for (std::size_t i = 0; i < 100; i++) {
+    myInitApps.emplace_back(myUsers[i % myUsers.size()],
+                            myAvgCapacity * myRateRv() / 100,
+                            myLoadRv());
+  }
+
+  us::UniformRv myAllocationRv(0, 1, 0, 0, 0);
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    myNetwork->restore(mySnapshot);
+    auto myApps = myInitApps;
+    aState.ResumeTiming();
+
+    myNetwork->allocate(myApps, myAlgo, myAllocationRv);
+    benchmark::DoNotOptimize(myApps);
+  }
+  aState.SetLabel(qr::bench::toString(myTopology) + "/" +
+                  qr::toString(myAlgo));
+  aState.SetItemsProcessed(aState.iterations() * myInitApps.size());
+}
+BENCHMARK(BM_MecQkdNetworkAllocate)
+    ->ArgNames({"topology", "nodes", "algo"})
+    ->ArgsProduct({qr::bench::allTopologies(),
+                   qr::bench::networkSizes(10000),
+                   qr::bench::toArgs(qr::allMecQkdAlgos())})
+    ->Unit(benchmark::kMillisecond);
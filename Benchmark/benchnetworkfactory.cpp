@@ -0,0 +1,99 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Details/benchnetworks.h"
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/edgelist.h"
+#include "QuantumRouting/networkfactory.h"
+
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+
+#include <string>
+
+namespace qr = uiiit::qr;
+
+// arguments: number of nodes
+static void BM_NetworkFactoryPpp(benchmark::State& aState) {
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(qr::bench::makePppNetwork(aState.range(0), 42));
+  }
+}
+BENCHMARK(BM_NetworkFactoryPpp)
+    ->ArgName("nodes")
+    ->ArgsProduct({qr::bench::networkSizes(10000)})
+    ->Unit(benchmark::kMillisecond);
+
+// arguments: number of nodes
+static void BM_NetworkFactoryWaxman(benchmark::State& aState) {
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(
+        qr::bench::makeWaxmanNetwork(aState.range(0), 42));
+  }
+}
+BENCHMARK(BM_NetworkFactoryWaxman)
+    ->ArgName("nodes")
+    ->ArgsProduct({qr::bench::networkSizes(10000)})
+    ->Unit(benchmark::kMillisecond);
+
+// arguments: number of nodes, number of threads
+static void BM_NetworkFactoryWaxmanParallel(benchmark::State& aState) {
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(qr::bench::makeWaxmanNetworkParallel(
+        aState.range(0), 42, aState.range(1)));
+  }
+}
+BENCHMARK(BM_NetworkFactoryWaxmanParallel)
+    ->ArgNames({"nodes", "threads"})
+    ->ArgsProduct({qr::bench::networkSizes(10000), {1, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+// arguments: number of nodes
+static void BM_NetworkFactoryEdgeList(benchmark::State& aState) {
+  const auto myFilename = (boost::filesystem::temp_directory_path() /
+                           boost::filesystem::unique_path("%%%%-%%%%.edges"))
+                              .string();
+  qr::saveEdgeList(myFilename,
+                   qr::bench::networkEdges(qr::bench::Topology::Ppp,
+                                           aState.range(0)));
+
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(
+        qr::makeCapacityNetworkEdgeList<qr::CapacityNetwork>(myFilename));
+  }
+  boost::filesystem::remove(myFilename);
+}
+BENCHMARK(BM_NetworkFactoryEdgeList)
+    ->ArgName("nodes")
+    ->ArgsProduct({qr::bench::networkSizes(10000)})
+    ->Unit(benchmark::kMillisecond);
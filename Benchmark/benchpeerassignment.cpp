@@ -0,0 +1,92 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Details/benchnetworks.h"
+
+#include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/kspcache.h"
+#include "QuantumRouting/peerassignment.h"
+
+#include "Support/random.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+// arguments: topology, number of nodes
+template <class ASSIGNMENT>
+static void BM_PeerAssignment(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myNetwork =
+      qr::bench::makeNetwork<qr::EsNetwork>(myTopology, aState.range(1));
+  myNetwork->measurementProbability(0.5);
+
+  // 20 apps on random hosts, with 5 random candidate data centers
+  us::UniformIntRv<unsigned long> myNodeRv(
+      0, myNetwork->numNodes() - 1, 0, 0, 0);
+  std::vector<qr::PeerAssignment::AppDescriptor> myApps;
+  for (std::size_t i = 0; i < 20; i++) {
+    myApps.emplace_back(myNodeRv(), 1.0, 0.95);
+  }
+  std::set<unsigned long> myDataCenters;
+  while (myDataCenters.size() < 5) {
+    myDataCenters.emplace(myNodeRv());
+  }
+  const std::vector<unsigned long> myCandidatePeers(myDataCenters.begin(),
+                                                    myDataCenters.end());
+
+  ASSIGNMENT myAssignment(*myNetwork, [](const auto&, const auto& aPath) {
+    return qr::bench::fidelityCheck(aPath.size());
+  });
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    myNetwork->kspCache(std::make_shared<qr::KspCache>());
+    aState.ResumeTiming();
+
+    benchmark::DoNotOptimize(myAssignment.assign(myApps, 1, myCandidatePeers));
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+  aState.SetItemsProcessed(aState.iterations() * myApps.size());
+}
+// every app needs the k-shortest paths to all the data centers
+BENCHMARK_TEMPLATE(BM_PeerAssignment, qr::PeerAssignmentLoadBalancing)
+    ->ArgNames({"topology", "nodes"})
+    ->ArgsProduct({qr::bench::allTopologies(), qr::bench::networkSizes(1000)})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PeerAssignment, qr::PeerAssignmentLoadBalancingMcf)
+    ->ArgNames({"topology", "nodes"})
+    ->ArgsProduct({qr::bench::allTopologies(), qr::bench::networkSizes(1000)})
+    ->Unit(benchmark::kMillisecond);
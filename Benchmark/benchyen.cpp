@@ -0,0 +1,94 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Details/benchnetworks.h"
+
+#include "QuantumRouting/capacitynetwork.h"
+
+#include "Support/random.h"
+
+#include "yen/yen_ksp.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/property_map/property_map.hpp>
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+// arguments: topology, number of nodes, number of paths
+static void BM_YenKsp(benchmark::State& aState) {
+  const auto myTopology = static_cast<qr::bench::Topology>(aState.range(0));
+  const auto myK        = static_cast<unsigned>(aState.range(2));
+
+  // same graph and weights as the k-shortest paths of EsNetwork
+  qr::CapacityNetwork::Graph myGraph;
+  for (const auto& myEdge :
+       qr::bench::networkEdges(myTopology, aState.range(1))) {
+    boost::add_edge(std::get<0>(myEdge), std::get<1>(myEdge), myGraph);
+  }
+
+  us::UniformIntRv<unsigned long> mySrcDstRv(
+      0, boost::num_vertices(myGraph) - 1, 0, 0, 0);
+  std::vector<std::pair<unsigned long, unsigned long>> myQueries;
+  while (myQueries.size() < 100) {
+    const auto mySrc = mySrcDstRv();
+    const auto myDst = mySrcDstRv();
+    if (mySrc != myDst) {
+      myQueries.emplace_back(mySrc, myDst);
+    }
+  }
+
+  std::size_t myNext = 0;
+  for (auto _ : aState) {
+    const auto& myQuery = myQueries[myNext++ % myQueries.size()];
+    benchmark::DoNotOptimize(boost::yen_ksp(
+        myGraph,
+        myQuery.first,
+        myQuery.second,
+        boost::make_static_property_map<qr::CapacityNetwork::EdgeDescriptor>(
+            1),
+        boost::get(boost::vertex_index, myGraph),
+        myK));
+  }
+  aState.SetLabel(qr::bench::toString(myTopology));
+}
+BENCHMARK(BM_YenKsp)
+    ->ArgNames({"topology", "nodes", "k"})
+    ->ArgsProduct({qr::bench::allTopologies(),
+                   qr::bench::networkSizes(10000),
+                   {1, 10}})
+    ->Unit(benchmark::kMillisecond);
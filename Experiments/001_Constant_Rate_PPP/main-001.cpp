@@ -30,12 +30,13 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/networkfactory.h"
 #include "QuantumRouting/qrutils.h"
-#include "Support/experimentdata.h"
+#include "QuantumRouting/resultsink.h"
+#include "QuantumRouting/shard.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/stat.h"
 #include "Support/versionutils.h"
@@ -74,6 +75,16 @@ struct Parameters {
   double      theMaxNetRate;
   double      theFidelityThreshold;
 
+  // not part of the experiment
+  std::string theTopologyCache;
+  std::size_t theFlowWindow;
+
+  // the estimated cost of the run, used to balance the shards, i.e., the number
+  // of nodes times the number of flows
+  double cost() const {
+    return theMu * theNumFlows;
+  }
+
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
         "seed",
@@ -124,6 +135,13 @@ struct Parameters {
              << ',' << theMaxNetRate << ',' << theFidelityThreshold;
     return myStream.str();
   }
+
+  // the parameters that determine the results, i.e., those in the CSV output
+  // except the seed
+  std::string key() const {
+    const auto myCsv = toCsv();
+    return myCsv.substr(myCsv.find(',') + 1);
+  }
 };
 
 struct Output {
@@ -146,8 +164,11 @@ struct Output {
   double      theAvgPathSize      = 0;
   double      theAvgFidelity      = 0;
 
-  static const std::vector<std::string>& names() {
-    static std::vector<std::string> ret({
+  // costs of the run
+  qr::Instrumentation theInstrumentation;
+
+  static std::vector<std::string> names() {
+    std::vector<std::string> ret({
         "num-nodes",
         "num-edges",
         "min-in-degree",
@@ -164,6 +185,8 @@ struct Output {
         "avg-path-size",
         "avg-fidelity",
     });
+    const auto& myCostNames = qr::Instrumentation::names();
+    ret.insert(ret.end(), myCostNames.begin(), myCostNames.end());
     return ret;
   }
 
@@ -182,6 +205,7 @@ struct Output {
              << theAvgPathSize
              << ", average fidelity of the end-to-end entangled pair "
              << theAvgFidelity;
+    myStream << "; " << theInstrumentation.toString();
     return myStream.str();
   }
 
@@ -194,11 +218,12 @@ struct Output {
              << theSumGrossRate << ',' << theSumNetRate << ','
              << theAdmissionRate << ',' << theAdmittedFlows << ','
              << theAvgPathSize << ',' << theAvgFidelity;
+    myStream << ',' << theInstrumentation.toCsv();
     return myStream.str();
   }
 };
 
-using Data = us::ExperimentData<Parameters, Output>;
+using Data = qr::ResultSink<Parameters, Output>;
 
 void runExperiment(Data& aData, Parameters&& aParameters) {
   // fidelity computation parameters
@@ -209,6 +234,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters));
 
   Output myOutput;
+  const qr::Instrumentation::Scope myScope(myOutput.theInstrumentation);
 
   // create network
   us::UniformRv myLinkEprRv(myRaii.in().theLinkMinEpr,
@@ -218,13 +244,15 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                             0);
   [[maybe_unused]] std::vector<qr::Coordinate> myCoordinates;
   const auto                                   myNetwork =
-      qr::makeCapacityNetworkPpp<qr::EsNetwork>(myLinkEprRv,
-                                                myRaii.in().theSeed,
-                                                myRaii.in().theMu,
-                                                myRaii.in().theGridLength,
-                                                myRaii.in().theThreshold,
-                                                myRaii.in().theLinkProbability,
-                                                myCoordinates);
+      qr::makeCapacityNetworkPpp<qr::EsNetwork>(
+          myLinkEprRv,
+          myRaii.in().theSeed,
+          myRaii.in().theMu,
+          myRaii.in().theGridLength,
+          myRaii.in().theThreshold,
+          myRaii.in().theLinkProbability,
+          myCoordinates,
+          qr::TopologyCache(myRaii.in().theTopologyCache));
   myNetwork->measurementProbability(myRaii.in().theQ);
 
   // network properties
@@ -258,16 +286,27 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
     myFlows.emplace_back(mySrc, myDst, myNetRateRv());
   }
 
-  // route traffic flows
-  myNetwork->route(myFlows, [&myRaii](const auto& aFlow) {
-    assert(not aFlow.thePath.empty());
-    return qr::fidelitySwapping(p1,
-                                p2,
-                                eta,
-                                aFlow.thePath.size() - 1,
-                                myRaii.in().theFidelityInit) >=
-           myRaii.in().theFidelityThreshold;
-  });
+  // route traffic flows, without searching paths that are too long to
+  // satisfy the fidelity threshold
+  const auto myMaxHops = qr::fidelityMaxHops(p1,
+                                             p2,
+                                             eta,
+                                             myRaii.in().theFidelityInit,
+                                             myRaii.in().theFidelityThreshold);
+  myNetwork->routeBatch(
+      myFlows,
+      qr::FlowRouteAlgo::Iterative,
+      myRaii.in().theFlowWindow,
+      [&myRaii](const auto& aFlow) {
+        assert(not aFlow.thePath.empty());
+        return qr::fidelitySwapping(p1,
+                                    p2,
+                                    eta,
+                                    aFlow.thePath.size() - 1,
+                                    myRaii.in().theFidelityInit) >=
+               myRaii.in().theFidelityThreshold;
+      },
+      myMaxHops);
 
   // traffic metrics
   myOutput.theResidualCapacity = myNetwork->totalCapacity();
@@ -342,8 +381,10 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myResultFile;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::string myShard;
 
   double      myMu;
   double      myLinkMinEpr;
@@ -357,6 +398,8 @@ int main(int argc, char* argv[]) {
   double      myQ;
   double      myFidelityInit;
   double      myFidelityThreshold;
+  std::string myTopologyCache;
+  std::size_t myFlowWindow;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -365,9 +408,15 @@ int main(int argc, char* argv[]) {
     ("version,v", "print the version and quit")
     ("explain-output", "report the meaning of the columns in the output")
     ("print-header", "print the header of the CSV output file")
+    ("topology-cache",
+     po::value<std::string>(&myTopologyCache)->default_value(""),
+     "Directory where the topologies generated are cached. Not used if empty.")
+    ("flow-window",
+     po::value<std::size_t>(&myFlowWindow)->default_value(0),
+     "Number of consecutive flows whose paths are searched in parallel, with the same results as if routed one by one. If smaller than 2, then the flows are routed one by one.")
     ("num-threads",
      po::value<std::size_t>(&myNumThreads)->default_value(1),
-     "Number of threads used.")
+     "Number of threads used, shared by the runs and their parallel computations. If 0, then use the hardware concurrency value.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
      "Output file name.")
@@ -377,7 +426,14 @@ int main(int argc, char* argv[]) {
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("shard",
+     po::value<std::string>(&myShard)->default_value("0/1"),
+     "Only run the i-th of n shards, specified as i/n with 0 <= i < n: the runs are assigned to the shards based on their estimated cost, so that the shards of a campaign can be run on different hosts and their outputs merged with Scripts/merge-shards.py.")
     ("append", "Append to the output file.")
+    ("result-file",
+     po::value<std::string>(&myResultFile)->default_value(""),
+     "Binary file where the results are saved as soon as every run finishes, then exported to the output file at the end. Not used if empty.")
+    ("resume", "Do not run again the seeds already in the result file, which must have been written with the same parameters.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -436,6 +492,10 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     }
 
+    if (myVarMap.count("resume") == 1 and myResultFile.empty()) {
+      throw std::runtime_error("cannot resume without a result file");
+    }
+
     std::ofstream myFile(myOutputFilename,
                          myVarMap.count("append") == 1 ? std::ios::app :
                                                          std::ios::trunc);
@@ -444,29 +504,45 @@ int main(int argc, char* argv[]) {
                                myOutputFilename);
     }
 
-    Data myData;
+    Data myData(myResultFile, myVarMap.count("resume") == 1);
 
-    us::Queue<Parameters> myParameters;
+    const auto              myRunShard = qr::Shard::fromString(myShard);
+    std::vector<Parameters> myParameters;
     for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   myQ,
-                                   myFidelityInit,
-                                   myNumFlows,
-                                   myMinNetRate,
-                                   myMaxNetRate,
-                                   myFidelityThreshold});
+      myParameters.emplace_back(Parameters{mySeed,
+                                           myMu,
+                                           myGridSize,
+                                           myThreshold,
+                                           myLinkProbability,
+                                           myLinkMinEpr,
+                                           myLinkMaxEpr,
+                                           myQ,
+                                           myFidelityInit,
+                                           myNumFlows,
+                                           myMinNetRate,
+                                           myMaxNetRate,
+                                           myFidelityThreshold,
+                                           myTopologyCache,
+                                           myFlowWindow});
+    }
+    myParameters = myRunShard.select(
+        std::move(myParameters),
+        [](const Parameters& aParameters) { return aParameters.cost(); });
+    VLOG(1) << myParameters.size() << " runs in shard "
+            << myRunShard.toString();
+
+    qr::TaskScheduler myScheduler(myNumThreads);
+    for (auto& myParameter : myParameters) {
+      if (myData.contains(myParameter)) {
+        VLOG(1) << "skipping seed " << myParameter.theSeed << ": already in "
+                << myResultFile;
+        continue;
+      }
+      myScheduler.submit([&myData, &myParameter]() {
+        runExperiment(myData, std::move(myParameter));
+      });
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
-        });
-    const auto myExceptions = myWorkers.wait();
+    const auto myExceptions = myScheduler.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
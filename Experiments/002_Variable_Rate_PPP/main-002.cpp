@@ -30,13 +30,14 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/networkfactory.h"
 #include "QuantumRouting/qrutils.h"
-#include "Support/experimentdata.h"
+#include "QuantumRouting/resultsink.h"
+#include "QuantumRouting/shard.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/fairness.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/stat.h"
 #include "Support/versionutils.h"
@@ -85,6 +86,13 @@ struct Parameters {
 
   // not part of the experiment
   std::string theDotFile;
+  std::string theTopologyCache;
+
+  // the estimated cost of the run, used to balance the shards, i.e., the number
+  // of nodes times the number of peers
+  double cost() const {
+    return theMu * theNumApps * theNumPeersMax;
+  }
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -153,6 +161,13 @@ struct Parameters {
              << theFidelityThreshold << ',' << theTargetResidual;
     return myStream.str();
   }
+
+  // the parameters that determine the results, i.e., those in the CSV output
+  // except the seed
+  std::string key() const {
+    const auto myCsv = toCsv();
+    return myCsv.substr(myCsv.find(',') + 1);
+  }
 };
 
 struct Output {
@@ -177,8 +192,11 @@ struct Output {
   double      theFairnessJain     = 0;
   double      theFairnessJitter   = 0;
 
-  static const std::vector<std::string>& names() {
-    static std::vector<std::string> ret({
+  // costs of the run
+  qr::Instrumentation theInstrumentation;
+
+  static std::vector<std::string> names() {
+    std::vector<std::string> ret({
         "num-nodes",
         "num-edges",
         "min-in-degree",
@@ -198,6 +216,8 @@ struct Output {
         "fairness-jain",
         "fairness-jitter",
     });
+    const auto& myCostNames = qr::Instrumentation::names();
+    ret.insert(ret.end(), myCostNames.begin(), myCostNames.end());
     return ret;
   }
 
@@ -216,6 +236,7 @@ struct Output {
              << ", average fidelity of the end-to-end entangled pair "
              << theAvgFidelity << ", Jain's fairness index " << theFairnessJain
              << ", max rate - min rate " << theFairnessJitter << " EPR-pairs/s";
+    myStream << "; " << theInstrumentation.toString();
     return myStream.str();
   }
 
@@ -228,11 +249,12 @@ struct Output {
              << theAvgVisits << ',' << theSumGrossRate << ',' << theSumNetRate
              << ',' << theAvgPathSize << ',' << theAvgFidelity << ','
              << theFairnessJain << ',' << theFairnessJitter;
+    myStream << ',' << theInstrumentation.toCsv();
     return myStream.str();
   }
 };
 
-using Data = us::ExperimentData<Parameters, Output>;
+using Data = qr::ResultSink<Parameters, Output>;
 
 void runExperiment(Data& aData, Parameters&& aParameters) {
   if (aParameters.theTargetResidual > 1) {
@@ -248,6 +270,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters));
 
   Output myOutput;
+  const qr::Instrumentation::Scope myScope(myOutput.theInstrumentation);
 
   const auto                          MANY_TRIES = 1000000u;
   std::unique_ptr<qr::EsNetwork>      myNetwork  = nullptr;
@@ -271,7 +294,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
         myRaii.in().theGridLength,
         myRaii.in().theThreshold,
         myRaii.in().theLinkProbability,
-        myCoordinates);
+        myCoordinates,
+        qr::TopologyCache(myRaii.in().theTopologyCache));
 
     // network properties
     assert(myNetwork.get() != nullptr);
@@ -321,6 +345,15 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                                  0);
     us::UniformRv myPeerSampleRv(0, 1, myRaii.in().theSeed, 0, 0);
 
+    // the paths that are too long to satisfy the fidelity threshold are not
+    // searched
+    const auto myMaxHops =
+        qr::fidelityMaxHops(p1,
+                            p2,
+                            eta,
+                            myRaii.in().theFidelityInit,
+                            myRaii.in().theFidelityThreshold);
+
     do {
       std::vector<qr::EsNetwork::AppDescriptor> mySingleRunApps;
 
@@ -357,7 +390,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                     aPath.size() - 1,
                                     myRaii.in().theFidelityInit) >=
                                 myRaii.in().theFidelityThreshold;
-                       });
+                       },
+                       [myMaxHops](const auto&) { return myMaxHops; });
 
       std::move(mySingleRunApps.begin(),
                 mySingleRunApps.end(),
@@ -456,8 +490,10 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myResultFile;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::string myShard;
 
   double      myMu;
   double      myLinkMinEpr;
@@ -477,6 +513,7 @@ int main(int argc, char* argv[]) {
   std::size_t myDistanceMax;
   double      myTargetResidual;
   std::string myDotFile;
+  std::string myTopologyCache;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -488,9 +525,12 @@ int main(int argc, char* argv[]) {
     ("dot-file",
      po::value<std::string>(&myDotFile)->default_value(""),
      "Save the network to this Graphviz file.")
+    ("topology-cache",
+     po::value<std::string>(&myTopologyCache)->default_value(""),
+     "Directory where the topologies generated are cached. Not used if empty.")
     ("num-threads",
      po::value<std::size_t>(&myNumThreads)->default_value(1),
-     "Number of threads used.")
+     "Number of threads used, shared by the runs and their parallel computations. If 0, then use the hardware concurrency value.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
      "Output file name.")
@@ -500,7 +540,14 @@ int main(int argc, char* argv[]) {
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("shard",
+     po::value<std::string>(&myShard)->default_value("0/1"),
+     "Only run the i-th of n shards, specified as i/n with 0 <= i < n: the runs are assigned to the shards based on their estimated cost, so that the shards of a campaign can be run on different hosts and their outputs merged with Scripts/merge-shards.py.")
     ("append", "Append to the output file.")
+    ("result-file",
+     po::value<std::string>(&myResultFile)->default_value(""),
+     "Binary file where the results are saved as soon as every run finishes, then exported to the output file at the end. Not used if empty.")
+    ("resume", "Do not run again the seeds already in the result file, which must have been written with the same parameters.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -574,6 +621,10 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     }
 
+    if (myVarMap.count("resume") == 1 and myResultFile.empty()) {
+      throw std::runtime_error("cannot resume without a result file");
+    }
+
     std::ofstream myFile(myOutputFilename,
                          myVarMap.count("append") == 1 ? std::ios::app :
                                                          std::ios::trunc);
@@ -582,35 +633,50 @@ int main(int argc, char* argv[]) {
                                myOutputFilename);
     }
 
-    Data myData;
+    Data myData(myResultFile, myVarMap.count("resume") == 1);
 
-    us::Queue<Parameters> myParameters;
+    const auto              myRunShard = qr::Shard::fromString(myShard);
+    std::vector<Parameters> myParameters;
     for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   myQ,
-                                   myQuantum,
-                                   myK,
-                                   myFidelityInit,
-                                   myNumApps,
-                                   myNumPeersMin,
-                                   myNumPeersMax,
-                                   myDistanceMin,
-                                   myDistanceMax,
-                                   myFidelityThreshold,
-                                   myTargetResidual,
-                                   myDotFile});
+      myParameters.emplace_back(Parameters{mySeed,
+                                           myMu,
+                                           myGridSize,
+                                           myThreshold,
+                                           myLinkProbability,
+                                           myLinkMinEpr,
+                                           myLinkMaxEpr,
+                                           myQ,
+                                           myQuantum,
+                                           myK,
+                                           myFidelityInit,
+                                           myNumApps,
+                                           myNumPeersMin,
+                                           myNumPeersMax,
+                                           myDistanceMin,
+                                           myDistanceMax,
+                                           myFidelityThreshold,
+                                           myTargetResidual,
+                                           myDotFile,
+                                           myTopologyCache});
+    }
+    myParameters = myRunShard.select(
+        std::move(myParameters),
+        [](const Parameters& aParameters) { return aParameters.cost(); });
+    VLOG(1) << myParameters.size() << " runs in shard "
+            << myRunShard.toString();
+
+    qr::TaskScheduler myScheduler(myNumThreads);
+    for (auto& myParameter : myParameters) {
+      if (myData.contains(myParameter)) {
+        VLOG(1) << "skipping seed " << myParameter.theSeed << ": already in "
+                << myResultFile;
+        continue;
+      }
+      myScheduler.submit([&myData, &myParameter]() {
+        runExperiment(myData, std::move(myParameter));
+      });
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
-        });
-    const auto myExceptions = myWorkers.wait();
+    const auto myExceptions = myScheduler.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
@@ -29,13 +29,17 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "QuantumRouting/aliassampler.h"
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/eventengine.h"
+#include "QuantumRouting/fidelityhoptable.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/networkfactory.h"
 #include "QuantumRouting/qrutils.h"
-#include "Support/experimentdata.h"
+#include "QuantumRouting/resultsink.h"
+#include "QuantumRouting/shard.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/split.h"
 #include "Support/stat.h"
@@ -88,7 +92,17 @@ struct Parameters {
   std::vector<double> theFidelityThresholds;
 
   // simulation
-  std::string theTopoFilename;
+  std::string       theTopoFilename;
+  qr::FlowRouteAlgo theFlowRouteAlgo;
+
+  // not part of the experiment
+  std::string theTopologyCache;
+
+  // the estimated cost of the run, used to balance the shards, i.e., the number
+  // of nodes times the number of flows
+  double cost() const {
+    return theMu * theArrivalRate * theSimDuration;
+  }
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -137,7 +151,8 @@ struct Parameters {
         << ", minimum fidelity drawn randomly from {"
         << v2s(theFidelityThresholds) << "}"
         << ", and a net requested rate drawn randomly from {"
-        << v2s(theNetRates) << "} EPR pairs/s, experiment seed " << theSeed;
+        << v2s(theNetRates) << "} EPR pairs/s, flows routed with "
+        << qr::toString(theFlowRouteAlgo) << ", experiment seed " << theSeed;
 
     return myStream.str();
   }
@@ -153,6 +168,14 @@ struct Parameters {
              << v2s(theNetRates) << ',' << v2s(theFidelityThresholds);
     return myStream.str();
   }
+
+  // the parameters that determine the results, i.e., those in the CSV output
+  // except the seed, and the flow routing algorithm
+  std::string key() const {
+    const auto myCsv = toCsv();
+    return myCsv.substr(myCsv.find(',') + 1) + ',' +
+           qr::toString(theFlowRouteAlgo);
+  }
 };
 
 struct Output {
@@ -205,6 +228,8 @@ struct Output {
         }
       }
     }
+    const auto& myCostNames = qr::Instrumentation::names();
+    theNames.insert(theNames.end(), myCostNames.begin(), myCostNames.end());
   }
 
   // graph properties
@@ -235,6 +260,9 @@ struct Output {
   };
   std::vector<std::vector<PerClass>> thePerClass;
 
+  // costs of the run
+  qr::Instrumentation theInstrumentation;
+
   std::vector<std::string> theNames;
 
   const std::vector<std::string> names() {
@@ -256,6 +284,7 @@ struct Output {
              << theAvgPathSize
              << ", average fidelity of the end-to-end entangled pair "
              << theAvgFidelity;
+    myStream << "; " << theInstrumentation.toString();
     return myStream.str();
   }
 
@@ -282,11 +311,12 @@ struct Output {
         }
       }
     }
+    myStream << ',' << theInstrumentation.toCsv();
     return myStream.str();
   }
 };
 
-using Data = us::ExperimentData<Parameters, Output>;
+using Data = qr::ResultSink<Parameters, Output>;
 
 void runExperiment(Data& aData, Parameters&& aParameters) {
   // fidelity computation parameters
@@ -297,6 +327,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters));
 
   Output myOutput(myRaii.in().theNetRates, myRaii.in().theFidelityThresholds);
+  const qr::Instrumentation::Scope myScope(myOutput.theInstrumentation);
 
   // consistency checks
   if (myRaii.in().theArrivalRate <= 0) {
@@ -335,7 +366,9 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                  myRaii.in().theGridLength,
                                  myRaii.in().theThreshold,
                                  myRaii.in().theLinkProbability,
-                                 myCoordinates) :
+                                 myCoordinates,
+                                 qr::TopologyCache(
+                                     myRaii.in().theTopologyCache)) :
                              qr::makeCapacityNetworkGraphMl<qr::EsNetwork>(
                                  myLinkEprRv, *myGraphMlStream, myCoordinates);
   myNetwork->measurementProbability(myRaii.in().theQ);
@@ -351,8 +384,15 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                              "two nodes");
   }
 
-  // simulated clock
-  double myNow = 0;
+  // simulation engine, with arrivals of new flows and departures of
+  // admitted ones
+  struct Arrival {};
+  struct Departure {
+    unsigned long              theSrc;
+    std::vector<unsigned long> thePath;
+    double                     theGrossRate;
+  };
+  qr::EventEngine<Arrival, Departure> myEngine(myRaii.in().theWarmup);
 
   // network properties
   assert(myNetwork.get() != nullptr);
@@ -372,8 +412,10 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
     us::SummaryStat theAdmissionRate;
     us::SummaryStat thePathSize;
   };
-  us::SummaryWeightedStat myResidualCapacity(myNow, myRaii.in().theWarmup);
-  us::SummaryWeightedStat myNumActiveFlows(myNow, myRaii.in().theWarmup);
+  us::SummaryWeightedStat myResidualCapacity(myEngine.clock(),
+                                             myRaii.in().theWarmup);
+  us::SummaryWeightedStat myNumActiveFlows(myEngine.clock(),
+                                           myRaii.in().theWarmup);
   us::SummaryStat         myDijkstra;
   us::SummaryStat         myGrossRate;
   us::SummaryStat         myNetRate;
@@ -392,14 +434,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   myResidualCapacity(myNetwork->totalCapacity());
   myNumActiveFlows(0);
 
-  // flows admitted at any time
-  struct AdmittedFlow {
-    unsigned long              theSrc;
-    std::vector<unsigned long> thePath;
-    double                     theLeaveTime;
-    double                     theGrossRate;
-  };
-  std::list<AdmittedFlow> myAdmittedFlows;
+  // number of flows admitted at any time
+  std::size_t myAdmittedFlows = 0;
 
   // prepare random variables for flow
   // generation
@@ -422,136 +458,144 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   }
   const auto myNodeCapacities = myNetwork->nodeCapacities();
   assert(myNodeCapacities.size() == myNodes.size());
+  std::unique_ptr<qr::AliasSampler> myNodeSampler;
+  if (myRaii.in().theSrcDstPolicy == "nodecapacities") {
+    myNodeSampler = std::make_unique<qr::AliasSampler>(myNodeCapacities);
+  }
 
-  // run simulation
-  double myNextArrival = 0;
-  while (myNow <= myRaii.in().theSimDuration) {
-    const auto myEarliestLeave =
-        std::min_element(myAdmittedFlows.begin(),
-                         myAdmittedFlows.end(),
-                         [](const auto& aLhs, const auto& aRhs) {
-                           return aLhs.theLeaveTime < aRhs.theLeaveTime;
-                         });
-
-    if (myEarliestLeave == myAdmittedFlows.end() or
-        myNextArrival < myEarliestLeave->theLeaveTime) {
-      myNow = myNextArrival;
-
-      std::vector<unsigned long> mySrcDstNodes;
-      if (myRaii.in().theSrcDstPolicy == "uniform") {
-        mySrcDstNodes = us::sample(myNodes, 2, mySrcDstRv);
-      } else if (myRaii.in().theSrcDstPolicy == "nodecapacities") {
-        mySrcDstNodes =
-            us::sampleWeighted(myNodes, myNodeCapacities, 2, mySrcDstRv);
-      } else {
-        throw std::runtime_error("unknown src/dst policy: " +
-                                 myRaii.in().theSrcDstPolicy);
-      }
-      assert(mySrcDstNodes.size() == 2);
-      assert(mySrcDstNodes[0] != mySrcDstNodes[1]);
-
-      const auto myNetRateId = myNetRatesRv();
-      assert(myNetRateId < myRaii.in().theNetRates.size());
-      std::vector<qr::EsNetwork::FlowDescriptor> myFlows(
-          {{mySrcDstNodes[0],
-            mySrcDstNodes[1],
-            myRaii.in().theNetRates[myNetRateId]}});
-
-      // try to admit the new traffic flow
-      const auto myFidelityThresholdId = myFidelitiesRv();
-      assert(myFidelityThresholdId < myRaii.in().theFidelityThresholds.size());
-      myNetwork->route(
-          myFlows, [&myRaii, myFidelityThresholdId](const auto& aFlow) {
-            assert(not aFlow.thePath.empty());
-            return qr::fidelitySwapping(p1,
+  // the paths that are too long to satisfy the fidelity threshold of a flow
+  // are not searched
+  const qr::FidelityHopTable myHopTable(p1,
                                         p2,
                                         eta,
-                                        aFlow.thePath.size() - 1,
-                                        myRaii.in().theFidelityInit) >=
-                   myRaii.in().theFidelityThresholds[myFidelityThresholdId];
-          });
-      assert(myFlows.size() == 1);
+                                        {myRaii.in().theFidelityInit},
+                                        myRaii.in().theFidelityThresholds);
 
-      // retrieve the per-class set of
+  // run simulation
+  myEngine.handler<Arrival>([&](Arrival&) {
+    std::vector<unsigned long> mySrcDstNodes;
+    if (myRaii.in().theSrcDstPolicy == "uniform") {
+      mySrcDstNodes = us::sample(myNodes, 2, mySrcDstRv);
+    } else if (myRaii.in().theSrcDstPolicy == "nodecapacities") {
+      assert(myNodeSampler != nullptr);
+      for (const auto myNode : myNodeSampler->sample(2, mySrcDstRv)) {
+        mySrcDstNodes.emplace_back(myNodes[myNode]);
+      }
+    } else {
+      throw std::runtime_error("unknown src/dst policy: " +
+                               myRaii.in().theSrcDstPolicy);
+    }
+    assert(mySrcDstNodes.size() == 2);
+    assert(mySrcDstNodes[0] != mySrcDstNodes[1]);
+
+    const auto myNetRateId = myNetRatesRv();
+    assert(myNetRateId < myRaii.in().theNetRates.size());
+    std::vector<qr::EsNetwork::FlowDescriptor> myFlows(
+        {{mySrcDstNodes[0],
+          mySrcDstNodes[1],
+          myRaii.in().theNetRates[myNetRateId]}});
+
+    // try to admit the new traffic flow
+    const auto myFidelityThresholdId = myFidelitiesRv();
+    assert(myFidelityThresholdId < myRaii.in().theFidelityThresholds.size());
+    myNetwork->route(
+        myFlows,
+        myRaii.in().theFlowRouteAlgo,
+        [&myRaii, myFidelityThresholdId](const auto& aFlow) {
+          assert(not aFlow.thePath.empty());
+          return qr::fidelitySwapping(p1,
+                                      p2,
+                                      eta,
+                                      aFlow.thePath.size() - 1,
+                                      myRaii.in().theFidelityInit) >=
+                 myRaii.in().theFidelityThresholds[myFidelityThresholdId];
+        },
+        myHopTable(myRaii.in().theFidelityInit,
+                   myRaii.in().theFidelityThresholds[myFidelityThresholdId]));
+    assert(myFlows.size() == 1);
+
+    // retrieve the per-class set of
+    // statistics
+    assert(myNetRateId < myPerClassStats.size());
+    assert(myFidelityThresholdId < myPerClassStats[myNetRateId].size());
+    auto& myPerClassStat = myPerClassStats[myNetRateId][myFidelityThresholdId];
+    assert(myPerClassStat.get() != nullptr);
+
+    if (myFlows[0].thePath.empty()) {
+      VLOG(2) << "time " << myEngine.now() << " dropped  "
+              << myFlows[0].toString() << ", fidelity threshold "
+              << myRaii.in().theFidelityThresholds[myFidelityThresholdId];
+
+      // record global and per-class
       // statistics
-      assert(myNetRateId < myPerClassStats.size());
-      assert(myFidelityThresholdId < myPerClassStats[myNetRateId].size());
-      auto& myPerClassStat =
-          myPerClassStats[myNetRateId][myFidelityThresholdId];
-      assert(myPerClassStat.get() != nullptr);
-
-      if (myFlows[0].thePath.empty()) {
-        VLOG(2) << "time " << myNow << " dropped  " << myFlows[0].toString()
-                << ", fidelity threshold "
-                << myRaii.in().theFidelityThresholds[myFidelityThresholdId];
-
-        // record global and per-class
-        // statistics
-        if (myNow >= myRaii.in().theWarmup) {
-          myDijkstra(myFlows[0].theDijsktra);
-          myAdmissionRate(0.0);
-          myPerClassStat->theAdmissionRate(0.0);
-        }
+      if (myEngine.warm()) {
+        myDijkstra(myFlows[0].theDijsktra);
+        myAdmissionRate(0.0);
+        myPerClassStat->theAdmissionRate(0.0);
+      }
 
-      } else {
-        const auto myLeaveTime = myNow + myDurationRv();
-        VLOG(2) << "time " << myNow << " admitted " << myFlows[0].toString()
-                << ", fidelity threshold "
-                << myRaii.in().theFidelityThresholds[myFidelityThresholdId]
-                << ", will leave at " << myLeaveTime;
-        assert(myFlows[0].theGrossRate > 0);
-
-        myAdmittedFlows.emplace_back(AdmittedFlow{myFlows[0].theSrc,
-                                                  myFlows[0].thePath,
-                                                  myLeaveTime,
-                                                  myFlows[0].theGrossRate});
-
-        // time-weighted statistics
-        myResidualCapacity(myNetwork->totalCapacity());
-        myNumActiveFlows(myAdmittedFlows.size());
-
-        // time-independent statistics
-        if (myNow >= myRaii.in().theWarmup) {
-          // global statistics
-          myDijkstra(myFlows[0].theDijsktra);
-          myGrossRate(myFlows[0].theGrossRate);
-          myNetRate(myFlows[0].theNetRate);
-          myAdmissionRate(1.0);
-          myPathSize(myFlows[0].thePath.size());
-          myFidelity(qr::fidelitySwapping(p1,
-                                          p2,
-                                          eta,
-                                          myFlows[0].thePath.size() - 1,
-                                          myRaii.in().theFidelityInit));
-          // per-class statistics
-          myPerClassStat->theGrossRate(myFlows[0].theGrossRate);
-          myPerClassStat->theNetRate(myFlows[0].theNetRate);
-          myPerClassStat->theAdmissionRate(1.0);
-          myPerClassStat->thePathSize(myFlows[0].thePath.size());
-        }
+    } else {
+      const auto myLeaveTime = myEngine.now() + myDurationRv();
+      VLOG(2) << "time " << myEngine.now() << " admitted "
+              << myFlows[0].toString() << ", fidelity threshold "
+              << myRaii.in().theFidelityThresholds[myFidelityThresholdId]
+              << ", will leave at " << myLeaveTime;
+      assert(myFlows[0].theGrossRate > 0);
+
+      myEngine.schedule(myLeaveTime,
+                        Departure{myFlows[0].theSrc,
+                                  myFlows[0].thePath,
+                                  myFlows[0].theGrossRate});
+      myAdmittedFlows++;
+
+      // time-weighted statistics
+      myResidualCapacity(myNetwork->totalCapacity());
+      myNumActiveFlows(myAdmittedFlows);
+
+      // time-independent statistics
+      if (myEngine.warm()) {
+        // global statistics
+        myDijkstra(myFlows[0].theDijsktra);
+        myGrossRate(myFlows[0].theGrossRate);
+        myNetRate(myFlows[0].theNetRate);
+        myAdmissionRate(1.0);
+        myPathSize(myFlows[0].thePath.size());
+        myFidelity(qr::fidelitySwapping(p1,
+                                        p2,
+                                        eta,
+                                        myFlows[0].thePath.size() - 1,
+                                        myRaii.in().theFidelityInit));
+        // per-class statistics
+        myPerClassStat->theGrossRate(myFlows[0].theGrossRate);
+        myPerClassStat->theNetRate(myFlows[0].theNetRate);
+        myPerClassStat->theAdmissionRate(1.0);
+        myPerClassStat->thePathSize(myFlows[0].thePath.size());
       }
+    }
 
-      myNextArrival = myNow + myArrivalRv();
+    myEngine.schedule(myEngine.now() + myArrivalRv(), Arrival{});
+  });
+  myEngine.handler<Departure>([&](Departure& aDeparture) {
+    VLOG(3) << "time " << myEngine.now() << " an admitted flow leaves";
 
-    } else {
-      assert(myEarliestLeave != myAdmittedFlows.end());
-      myNow = myEarliestLeave->theLeaveTime;
-      VLOG(3) << "time " << myNow << " an admitted flow leaves";
+    // restore the capacity of the path
+    myNetwork->addCapacityToPath(
+        aDeparture.theSrc, aDeparture.thePath, aDeparture.theGrossRate);
 
-      // restore the capacity of the path
-      myNetwork->addCapacityToPath(myEarliestLeave->theSrc,
-                                   myEarliestLeave->thePath,
-                                   myEarliestLeave->theGrossRate);
+    // remove the flow from the admitted/active ones
+    assert(myAdmittedFlows > 0);
+    myAdmittedFlows--;
 
-      // remove the flow from the list of
-      // admitted/active ones
-      myAdmittedFlows.erase(myEarliestLeave);
+    // record statistics
+    myResidualCapacity(myNetwork->totalCapacity());
+    myNumActiveFlows(myAdmittedFlows);
+  });
+  myEngine.schedule(0, Arrival{});
+  myEngine.run(myRaii.in().theSimDuration);
 
-      // record statistics
-      myResidualCapacity(myNetwork->totalCapacity());
-      myNumActiveFlows(myAdmittedFlows.size());
-    }
-  }
+  // close the time-weighted statistics at the end of the simulation
+  myResidualCapacity(myNetwork->totalCapacity());
+  myNumActiveFlows(myAdmittedFlows);
 
   myOutput.theResidualCapacity = myResidualCapacity.mean();
   myOutput.theNumActiveFlows   = myNumActiveFlows.mean();
@@ -623,8 +667,10 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myResultFile;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::string myShard;
 
   double      myMu;
   double      myLinkMinEpr;
@@ -643,6 +689,8 @@ int main(int argc, char* argv[]) {
   double      myArrivalRate;
   double      myFlowDuration;
   std::string myTopoFilename;
+  std::string myFlowRouteAlgo;
+  std::string myTopologyCache;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -651,9 +699,12 @@ int main(int argc, char* argv[]) {
     ("version,v", "print the version and quit")
     ("explain-output", "report the meaning of the columns in the output")
     ("print-header", "print the header of the CSV output file")
+    ("topology-cache",
+     po::value<std::string>(&myTopologyCache)->default_value(""),
+     "Directory where the topologies generated are cached. Not used if empty.")
     ("num-threads",
      po::value<std::size_t>(&myNumThreads)->default_value(1),
-     "Number of threads used.")
+     "Number of threads used, shared by the runs and their parallel computations. If 0, then use the hardware concurrency value.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
      "Output file name.")
@@ -663,7 +714,14 @@ int main(int argc, char* argv[]) {
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("shard",
+     po::value<std::string>(&myShard)->default_value("0/1"),
+     "Only run the i-th of n shards, specified as i/n with 0 <= i < n: the runs are assigned to the shards based on their estimated cost, so that the shards of a campaign can be run on different hosts and their outputs merged with Scripts/merge-shards.py.")
     ("append", "Append to the output file.")
+    ("result-file",
+     po::value<std::string>(&myResultFile)->default_value(""),
+     "Binary file where the results are saved as soon as every run finishes, then exported to the output file at the end. Not used if empty.")
+    ("resume", "Do not run again the seeds already in the result file, which must have been written with the same parameters.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -715,6 +773,9 @@ int main(int argc, char* argv[]) {
     ("topo-filename",
      po::value<std::string>(&myTopoFilename)->default_value(""),
      "Save the topology to files with the given base name.")
+    ("flow-route-algo",
+     po::value<std::string>(&myFlowRouteAlgo)->default_value("iterative"),
+     "Algorithm used to route the flows. One of {iterative, layered}.")
     ;
   // clang-format on
 
@@ -753,6 +814,10 @@ int main(int argc, char* argv[]) {
                                myGraphMlFilename);
     }
 
+    if (myVarMap.count("resume") == 1 and myResultFile.empty()) {
+      throw std::runtime_error("cannot resume without a result file");
+    }
+
     std::ofstream myFile(myOutputFilename,
                          myVarMap.count("append") == 1 ? std::ios::app :
                                                          std::ios::trunc);
@@ -761,34 +826,53 @@ int main(int argc, char* argv[]) {
                                myOutputFilename);
     }
 
-    Data myData;
+    const auto myFlowRouteAlgoValue =
+        qr::flowRouteAlgofromString(myFlowRouteAlgo);
+
+    Data myData(myResultFile, myVarMap.count("resume") == 1);
 
-    us::Queue<Parameters> myParameters;
+    const auto              myRunShard = qr::Shard::fromString(myShard);
+    std::vector<Parameters> myParameters;
     for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   mySrcDstPolicy,
-                                   myGraphMlFilename,
-                                   myQ,
-                                   myFidelityInit,
-                                   mySimDuration,
-                                   myWarmupDuration,
-                                   myArrivalRate,
-                                   myFlowDuration,
-                                   myNetRates,
-                                   myFidelityThresholds,
-                                   myTopoFilename});
+      myParameters.emplace_back(Parameters{mySeed,
+                                           myMu,
+                                           myGridSize,
+                                           myThreshold,
+                                           myLinkProbability,
+                                           myLinkMinEpr,
+                                           myLinkMaxEpr,
+                                           mySrcDstPolicy,
+                                           myGraphMlFilename,
+                                           myQ,
+                                           myFidelityInit,
+                                           mySimDuration,
+                                           myWarmupDuration,
+                                           myArrivalRate,
+                                           myFlowDuration,
+                                           myNetRates,
+                                           myFidelityThresholds,
+                                           myTopoFilename,
+                                           myFlowRouteAlgoValue,
+                                           myTopologyCache});
+    }
+    myParameters = myRunShard.select(
+        std::move(myParameters),
+        [](const Parameters& aParameters) { return aParameters.cost(); });
+    VLOG(1) << myParameters.size() << " runs in shard "
+            << myRunShard.toString();
+
+    qr::TaskScheduler myScheduler(myNumThreads);
+    for (auto& myParameter : myParameters) {
+      if (myData.contains(myParameter)) {
+        VLOG(1) << "skipping seed " << myParameter.theSeed << ": already in "
+                << myResultFile;
+        continue;
+      }
+      myScheduler.submit([&myData, &myParameter]() {
+        runExperiment(myData, std::move(myParameter));
+      });
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
-        });
-    const auto myExceptions = myWorkers.wait();
+    const auto myExceptions = myScheduler.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
@@ -30,13 +30,15 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/fidelityhoptable.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/networkfactory.h"
 #include "QuantumRouting/qrutils.h"
-#include "Support/experimentdata.h"
+#include "QuantumRouting/resultsink.h"
+#include "QuantumRouting/shard.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/fairness.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/split.h"
 #include "Support/stat.h"
@@ -92,6 +94,13 @@ struct Parameters {
 
   // not part of the experiment
   std::string theDotFile;
+  std::string theTopologyCache;
+
+  // the estimated cost of the run, used to balance the shards, i.e., the number
+  // of nodes times the number of peers
+  double cost() const {
+    return theMu * theNumApps * theNumPeersMax;
+  }
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -167,6 +176,13 @@ struct Parameters {
              << ::toStringStd(thePriorities, "@") << ',' << theTargetResidual;
     return myStream.str();
   }
+
+  // the parameters that determine the results, i.e., those in the CSV output
+  // except the seed
+  std::string key() const {
+    const auto myCsv = toCsv();
+    return myCsv.substr(myCsv.find(',') + 1);
+  }
 };
 
 struct Output {
@@ -215,6 +231,9 @@ struct Output {
   };
   std::vector<PerClass> thePerClassStats;
 
+  // costs of the run
+  qr::Instrumentation theInstrumentation;
+
   static std::vector<std::string>
   names(const std::vector<double>& aPriorities,
         const std::vector<double>& aFidelityThresholds) {
@@ -241,6 +260,8 @@ struct Output {
         }
       }
     }
+    const auto& myCostNames = qr::Instrumentation::names();
+    ret.insert(ret.end(), myCostNames.begin(), myCostNames.end());
     return ret;
   }
 
@@ -265,6 +286,7 @@ struct Output {
                << stat.theFairnessJain << ", max rate - min rate "
                << stat.theFairnessJitter << " EPR-pairs/s";
     }
+    myStream << "; " << theInstrumentation.toString();
     return myStream.str();
   }
 
@@ -302,11 +324,12 @@ struct Output {
     myPrinter(myStream,
               [](const auto& elem) { return elem.theFairnessJitter; });
 
+    myStream << ',' << theInstrumentation.toCsv();
     return myStream.str();
   }
 };
 
-using Data = us::ExperimentData<Parameters, Output>;
+using Data = qr::ResultSink<Parameters, Output>;
 
 void runExperiment(Data& aData, Parameters&& aParameters) {
   if (aParameters.theTargetResidual > 1) {
@@ -328,6 +351,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters));
 
   Output myOutput;
+  const qr::Instrumentation::Scope myScope(myOutput.theInstrumentation);
 
   const auto                          MANY_TRIES = 1000000u;
   std::unique_ptr<qr::EsNetwork>      myNetwork  = nullptr;
@@ -351,7 +375,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
         myRaii.in().theGridLength,
         myRaii.in().theThreshold,
         myRaii.in().theLinkProbability,
-        myCoordinates);
+        myCoordinates,
+        qr::TopologyCache(myRaii.in().theTopologyCache));
 
     // network properties
     assert(myNetwork.get() != nullptr);
@@ -405,6 +430,17 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
     }
     assert(myClassParams.size() == myNumClasses);
 
+    // the paths that are too long to satisfy the fidelity threshold of an app
+    // are not searched
+    const qr::FidelityHopTable myHopTable(p1,
+                                          p2,
+                                          eta,
+                                          {myRaii.in().theFidelityInit},
+                                          myRaii.in().theFidelityThresholds);
+    const auto myHopLimit = [&myRaii, &myHopTable](const auto& aApp) {
+      return myHopTable(myRaii.in().theFidelityInit, aApp.theFidelityThreshold);
+    };
+
     // create all the random variables related to the applications
     us::UniformIntRv<unsigned long> myHostRv(
         0, myNetwork->numNodes() - 1, myRaii.in().theSeed, 2, 0);
@@ -458,7 +494,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                     aPath.size() - 1,
                                     myRaii.in().theFidelityInit) >=
                                 aApp.theFidelityThreshold;
-                       });
+                       },
+                       myHopLimit);
 
       std::move(mySingleRunApps.begin(),
                 mySingleRunApps.end(),
@@ -611,8 +648,10 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myResultFile;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::string myShard;
 
   double      myMu;
   double      myLinkMinEpr;
@@ -634,6 +673,7 @@ int main(int argc, char* argv[]) {
   std::size_t myDistanceMax;
   double      myTargetResidual;
   std::string myDotFile;
+  std::string myTopologyCache;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -645,9 +685,12 @@ int main(int argc, char* argv[]) {
     ("dot-file",
      po::value<std::string>(&myDotFile)->default_value(""),
      "Save the network to this Graphviz file.")
+    ("topology-cache",
+     po::value<std::string>(&myTopologyCache)->default_value(""),
+     "Directory where the topologies generated are cached. Not used if empty.")
     ("num-threads",
      po::value<std::size_t>(&myNumThreads)->default_value(1),
-     "Number of threads used. If 0, then use the hardware concurrency value.")
+     "Number of threads used, shared by the runs and their parallel computations. If 0, then use the hardware concurrency value.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
      "Output file name.")
@@ -657,7 +700,14 @@ int main(int argc, char* argv[]) {
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("shard",
+     po::value<std::string>(&myShard)->default_value("0/1"),
+     "Only run the i-th of n shards, specified as i/n with 0 <= i < n: the runs are assigned to the shards based on their estimated cost, so that the shards of a campaign can be run on different hosts and their outputs merged with Scripts/merge-shards.py.")
     ("append", "Append to the output file.")
+    ("result-file",
+     po::value<std::string>(&myResultFile)->default_value(""),
+     "Binary file where the results are saved as soon as every run finishes, then exported to the output file at the end. Not used if empty.")
+    ("resume", "Do not run again the seeds already in the result file, which must have been written with the same parameters.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -747,6 +797,10 @@ int main(int argc, char* argv[]) {
       VLOG(1) << "using " << myNumThreads << " threads";
     }
 
+    if (myVarMap.count("resume") == 1 and myResultFile.empty()) {
+      throw std::runtime_error("cannot resume without a result file");
+    }
+
     std::ofstream myFile(myOutputFilename,
                          myVarMap.count("append") == 1 ? std::ios::app :
                                                          std::ios::trunc);
@@ -755,37 +809,53 @@ int main(int argc, char* argv[]) {
                                myOutputFilename);
     }
 
-    Data myData;
+    Data myData(myResultFile, myVarMap.count("resume") == 1);
 
-    us::Queue<Parameters> myParameters;
+    const auto              myRunShard = qr::Shard::fromString(myShard);
+    std::vector<Parameters> myParameters;
     for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   qr::appRouteAlgofromString(myAlgorithm),
-                                   myQ,
-                                   myQuantum,
-                                   myK,
-                                   myFidelityInit,
-                                   myNumApps,
-                                   myNumPeersMin,
-                                   myNumPeersMax,
-                                   myDistanceMin,
-                                   myDistanceMax,
-                                   myPriorities,
-                                   myFidelityThresholds,
-                                   myTargetResidual,
-                                   myDotFile});
+      myParameters.emplace_back(
+          Parameters{mySeed,
+                     myMu,
+                     myGridSize,
+                     myThreshold,
+                     myLinkProbability,
+                     myLinkMinEpr,
+                     myLinkMaxEpr,
+                     qr::appRouteAlgofromString(myAlgorithm),
+                     myQ,
+                     myQuantum,
+                     myK,
+                     myFidelityInit,
+                     myNumApps,
+                     myNumPeersMin,
+                     myNumPeersMax,
+                     myDistanceMin,
+                     myDistanceMax,
+                     myPriorities,
+                     myFidelityThresholds,
+                     myTargetResidual,
+                     myDotFile,
+                     myTopologyCache});
+    }
+    myParameters = myRunShard.select(
+        std::move(myParameters),
+        [](const Parameters& aParameters) { return aParameters.cost(); });
+    VLOG(1) << myParameters.size() << " runs in shard "
+            << myRunShard.toString();
+
+    qr::TaskScheduler myScheduler(myNumThreads);
+    for (auto& myParameter : myParameters) {
+      if (myData.contains(myParameter)) {
+        VLOG(1) << "skipping seed " << myParameter.theSeed << ": already in "
+                << myResultFile;
+        continue;
+      }
+      myScheduler.submit([&myData, &myParameter]() {
+        runExperiment(myData, std::move(myParameter));
+      });
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
-        });
-    const auto myExceptions = myWorkers.wait();
+    const auto myExceptions = myScheduler.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
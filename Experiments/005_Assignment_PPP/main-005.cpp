@@ -30,14 +30,16 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/fidelityhoptable.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/networkfactory.h"
 #include "QuantumRouting/peerassignment.h"
 #include "QuantumRouting/qrutils.h"
-#include "Support/experimentdata.h"
+#include "QuantumRouting/resultsink.h"
+#include "QuantumRouting/shard.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/fairness.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/split.h"
 #include "Support/stat.h"
@@ -93,6 +95,14 @@ struct Parameters {
 
   // not part of the experiment
   std::string theDotFile;
+  std::size_t theAssignThreads;
+  std::string theTopologyCache;
+
+  // the estimated cost of the run, used to balance the shards, i.e., the number
+  // of nodes times the number of peers
+  double cost() const {
+    return theMu * theNumApps * theNumPeers;
+  }
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -170,6 +180,13 @@ struct Parameters {
              << ::toStringStd(thePriorities, "@") << ',' << theTargetResidual;
     return myStream.str();
   }
+
+  // the parameters that determine the results, i.e., those in the CSV output
+  // except the seed
+  std::string key() const {
+    const auto myCsv = toCsv();
+    return myCsv.substr(myCsv.find(',') + 1);
+  }
 };
 
 struct Output {
@@ -226,6 +243,9 @@ struct Output {
   };
   std::vector<PerClass> thePerClassStats;
 
+  // costs of the run
+  qr::Instrumentation theInstrumentation;
+
   static std::vector<std::string>
   names(const std::vector<double>& aPriorities,
         const std::vector<double>& aFidelityThresholds) {
@@ -259,6 +279,8 @@ struct Output {
         }
       }
     }
+    const auto& myCostNames = qr::Instrumentation::names();
+    ret.insert(ret.end(), myCostNames.begin(), myCostNames.end());
     return ret;
   }
 
@@ -290,6 +312,7 @@ struct Output {
                << stat.theFairnessJain << ", max rate - min rate "
                << stat.theFairnessJitter << " EPR-pairs/s";
     }
+    myStream << "; " << theInstrumentation.toString();
     return myStream.str();
   }
 
@@ -331,11 +354,12 @@ struct Output {
     myPrinter(myStream,
               [](const auto& elem) { return elem.theFairnessJitter; });
 
+    myStream << ',' << theInstrumentation.toCsv();
     return myStream.str();
   }
 };
 
-using Data = us::ExperimentData<Parameters, Output>;
+using Data = qr::ResultSink<Parameters, Output>;
 
 void runExperiment(Data& aData, Parameters&& aParameters) {
   if (aParameters.theTargetResidual > 1) {
@@ -356,6 +380,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
 
   Data::Raii myRaii(aData, std::move(aParameters)); // experiment input
   Output     myOutput;                              // experiment output
+  const qr::Instrumentation::Scope myScope(myOutput.theInstrumentation);
 
   // create network
   us::UniformRv myLinkEprRv(myRaii.in().theLinkMinEpr,
@@ -365,13 +390,15 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                             0);
   [[maybe_unused]] std::vector<qr::Coordinate> myCoordinates;
   auto                                         myNetwork =
-      qr::makeCapacityNetworkPpp<qr::EsNetwork>(myLinkEprRv,
-                                                myRaii.in().theSeed,
-                                                myRaii.in().theMu,
-                                                myRaii.in().theGridLength,
-                                                myRaii.in().theThreshold,
-                                                myRaii.in().theLinkProbability,
-                                                myCoordinates);
+      qr::makeCapacityNetworkPpp<qr::EsNetwork>(
+          myLinkEprRv,
+          myRaii.in().theSeed,
+          myRaii.in().theMu,
+          myRaii.in().theGridLength,
+          myRaii.in().theThreshold,
+          myRaii.in().theLinkProbability,
+          myCoordinates,
+          qr::TopologyCache(myRaii.in().theTopologyCache));
   myNetwork->measurementProbability(myRaii.in().theQ);
 
   // define validity of a path based on the minimum fidelity
@@ -454,6 +481,27 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
     }
     assert(myClassParams.size() == myNumClasses);
 
+    // the paths that are too long to satisfy the fidelity threshold of an app
+    // are not searched
+    const qr::FidelityHopTable myHopTable(p1,
+                                          p2,
+                                          eta,
+                                          {myRaii.in().theFidelityInit},
+                                          myRaii.in().theFidelityThresholds);
+    const auto myHopLimit = [&myRaii, &myHopTable](const auto& aApp) {
+      return myHopTable(myRaii.in().theFidelityInit, aApp.theFidelityThreshold);
+    };
+
+    // the load balancing peer assignments find the net rates with a fixed
+    // fidelity threshold, which may not be in the table
+    const auto myAssignHopLimit = [&myRaii](const auto& aApp) {
+      return qr::fidelityMaxHops(p1,
+                                 p2,
+                                 eta,
+                                 myRaii.in().theFidelityInit,
+                                 aApp.theFidelityThreshold);
+    };
+
     // create all the random variables related to the applications
     us::UniformIntRv<unsigned long> myHostRv(
         0, myCandidateHosts.size() - 1, myRaii.in().theSeed, 2, 0);
@@ -466,7 +514,9 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
         qr::makePeerAssignment(*myNetwork,
                                myRaii.in().thePeerAssignmentAlgo,
                                myPeerAssignmentRv,
-                               myCheckFunction);
+                               myCheckFunction,
+                               myRaii.in().theAssignThreads,
+                               myAssignHopLimit);
     assert(myPeerAssignment.get() != nullptr);
     assert(myPeerAssignment->algo() == myRaii.in().thePeerAssignmentAlgo);
 
@@ -497,7 +547,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                        myRaii.in().theQuantum * myRaii.in().theNumApps,
                        myRouteRv,
                        myRaii.in().theK,
-                       myCheckFunction);
+                       myCheckFunction,
+                       myHopLimit);
 
       std::move(mySingleRunApps.begin(),
                 mySingleRunApps.end(),
@@ -685,8 +736,10 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myResultFile;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::string myShard;
 
   double      myMu;
   double      myLinkMinEpr;
@@ -708,6 +761,8 @@ int main(int argc, char* argv[]) {
   std::string myPeerAssignmentAlgo;
   double      myTargetResidual;
   std::string myDotFile;
+  std::size_t myAssignThreads;
+  std::string myTopologyCache;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -719,9 +774,15 @@ int main(int argc, char* argv[]) {
     ("dot-file",
      po::value<std::string>(&myDotFile)->default_value(""),
      "Save the network to this Graphviz file.")
+    ("topology-cache",
+     po::value<std::string>(&myTopologyCache)->default_value(""),
+     "Directory where the topologies generated are cached. Not used if empty.")
     ("num-threads",
      po::value<std::size_t>(&myNumThreads)->default_value(1),
-     "Number of threads used. If 0, then use the hardware concurrency value.")
+     "Number of threads used, shared by the runs and their parallel computations. If 0, then use the hardware concurrency value.")
+    ("assign-threads",
+     po::value<std::size_t>(&myAssignThreads)->default_value(1),
+     "Number of threads used by each experiment for peer assignment, taken from those of --num-threads. If 1, peer assignment is not parallel.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
      "Output file name.")
@@ -731,7 +792,14 @@ int main(int argc, char* argv[]) {
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("shard",
+     po::value<std::string>(&myShard)->default_value("0/1"),
+     "Only run the i-th of n shards, specified as i/n with 0 <= i < n: the runs are assigned to the shards based on their estimated cost, so that the shards of a campaign can be run on different hosts and their outputs merged with Scripts/merge-shards.py.")
     ("append", "Append to the output file.")
+    ("result-file",
+     po::value<std::string>(&myResultFile)->default_value(""),
+     "Binary file where the results are saved as soon as every run finishes, then exported to the output file at the end. Not used if empty.")
+    ("resume", "Do not run again the seeds already in the result file, which must have been written with the same parameters.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -821,6 +889,10 @@ int main(int argc, char* argv[]) {
       VLOG(1) << "using " << myNumThreads << " threads";
     }
 
+    if (myVarMap.count("resume") == 1 and myResultFile.empty()) {
+      throw std::runtime_error("cannot resume without a result file");
+    }
+
     std::ofstream myFile(myOutputFilename,
                          myVarMap.count("append") == 1 ? std::ios::app :
                                                          std::ios::trunc);
@@ -829,11 +901,12 @@ int main(int argc, char* argv[]) {
                                myOutputFilename);
     }
 
-    Data myData;
+    Data myData(myResultFile, myVarMap.count("resume") == 1);
 
-    us::Queue<Parameters> myParameters;
+    const auto              myRunShard = qr::Shard::fromString(myShard);
+    std::vector<Parameters> myParameters;
     for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(
+      myParameters.emplace_back(
           Parameters{mySeed,
                      myMu,
                      myGridSize,
@@ -854,13 +927,28 @@ int main(int argc, char* argv[]) {
                      myPriorities,
                      myFidelityThresholds,
                      myTargetResidual,
-                     myDotFile});
+                     myDotFile,
+                     myAssignThreads,
+                     myTopologyCache});
+    }
+    myParameters = myRunShard.select(
+        std::move(myParameters),
+        [](const Parameters& aParameters) { return aParameters.cost(); });
+    VLOG(1) << myParameters.size() << " runs in shard "
+            << myRunShard.toString();
+
+    qr::TaskScheduler myScheduler(myNumThreads);
+    for (auto& myParameter : myParameters) {
+      if (myData.contains(myParameter)) {
+        VLOG(1) << "skipping seed " << myParameter.theSeed << ": already in "
+                << myResultFile;
+        continue;
+      }
+      myScheduler.submit([&myData, &myParameter]() {
+        runExperiment(myData, std::move(myParameter));
+      });
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
-        });
-    const auto myExceptions = myWorkers.wait();
+    const auto myExceptions = myScheduler.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
@@ -29,14 +29,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/mecqkdnetwork.h"
 #include "QuantumRouting/networkfactory.h"
 #include "QuantumRouting/qrutils.h"
-#include "Support/experimentdata.h"
+#include "QuantumRouting/resultsink.h"
+#include "QuantumRouting/shard.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/fairness.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/split.h"
 #include "Support/stat.h"
@@ -74,6 +75,7 @@ struct Parameters {
   double      theBeta;
   double      theMaxDistance; // in km
   double      theMaxCapacity; // in secret b/s
+  bool        theParallelTopology;
 
   // workload generation
   std::string theAppSpec;        // file containing the apps' specifications
@@ -86,6 +88,13 @@ struct Parameters {
 
   // not part of the experiment
   std::string theDotFile;
+  std::string theTopologyCache;
+
+  // the estimated cost of the run, used to balance the shards, i.e., the number
+  // of nodes times the number of applications
+  double cost() const {
+    return static_cast<double>(theNodes) * theApplications;
+  }
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({"seed",
@@ -108,7 +117,8 @@ struct Parameters {
   std::string toString() const {
     std::stringstream myStream;
     myStream << "topology randomly generated according to the Waxman model "
-                "with parameters: alpha "
+             << (theParallelTopology ? "(edges drawn in parallel) " : "")
+             << "with parameters: alpha "
              << theAlpha << ", beta " << theBeta << ", grid length "
              << theMaxDistance << " km; number of nodes: " << theNodes
              << "; maximum capacity of the QKD links: " << theMaxCapacity
@@ -130,6 +140,14 @@ struct Parameters {
              << ',' << qr::toString(theAlgo);
     return myStream.str();
   }
+
+  // the parameters that determine the results, i.e., those in the CSV output
+  // except the seed, and the topology generator
+  std::string key() const {
+    const auto myCsv = toCsv();
+    return myCsv.substr(myCsv.find(',') + 1) + ',' +
+           std::to_string(theParallelTopology);
+  }
 };
 
 struct Output {
@@ -156,6 +174,13 @@ struct Output {
   double      theJainEdgeNodeUtil   = 0;
   double      theSpreadEdgeNodeUtil = 0;
 
+  // copy of the parameter, after the other columns so that their positions
+  // are the same as without it
+  bool theParallelTopology = false;
+
+  // costs of the run
+  qr::Instrumentation theInstrumentation;
+
   static std::vector<std::string> names() {
     static std::vector<std::string> myStaticNames({
         // topology properties
@@ -180,8 +205,14 @@ struct Output {
         "edge-node-util-stddev",
         "edge-node-util-jain",
         "edge-node-util-spread",
+
+        // topology generation
+        "parallel-topology",
     });
-    return myStaticNames;
+    std::vector<std::string> ret(myStaticNames);
+    const auto& myCostNames = qr::Instrumentation::names();
+    ret.insert(ret.end(), myCostNames.begin(), myCostNames.end());
+    return ret;
   }
 
   std::string toString() const {
@@ -199,6 +230,7 @@ struct Output {
              << " (std dev) " << theJainEdgeNodeUtil
              << " (Jain's fairness index) " << theSpreadEdgeNodeUtil
              << " (max-min spread)";
+    myStream << "; " << theInstrumentation.toString();
     return myStream.str();
   }
 
@@ -211,31 +243,47 @@ struct Output {
              << theResidualProcessing << ',' << theAllocatedApps << ','
              << theAvgPathLength << ',' << theTotalNetRate << ','
              << theStdDevEdgeNodeUtil << ',' << theJainEdgeNodeUtil << ','
-             << theSpreadEdgeNodeUtil;
+             << theSpreadEdgeNodeUtil << ',' << theParallelTopology;
+    myStream << ',' << theInstrumentation.toCsv();
     return myStream.str();
   }
 };
 
-using Data = us::ExperimentData<Parameters, Output>;
+using Data = qr::ResultSink<Parameters, Output>;
 
 void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters)); // experiment input
   Output     myOutput;                              // experiment output
+  const qr::Instrumentation::Scope myScope(myOutput.theInstrumentation);
 
   // create network
   std::vector<qr::Coordinate> myCoordinates;
   const auto                  myMaxDistance = myRaii.in().theMaxDistance;
   const auto                  myMaxCapacity = myRaii.in().theMaxCapacity;
-  auto myNetwork = qr::makeCapacityNetworkWaxman<qr::MecQkdNetwork>(
-      [myMaxDistance, myMaxCapacity](const double d) {
-        return myMaxCapacity * std::exp(-d / myMaxDistance);
-      },
-      myRaii.in().theSeed,
-      myRaii.in().theNodes,
-      myRaii.in().theMaxDistance,
-      myRaii.in().theAlpha,
-      myRaii.in().theBeta,
-      myCoordinates);
+  const auto myCapacity = [myMaxDistance, myMaxCapacity](const double d) {
+    return myMaxCapacity * std::exp(-d / myMaxDistance);
+  };
+  auto myNetwork =
+      myRaii.in().theParallelTopology ?
+          qr::makeCapacityNetworkWaxmanParallel<qr::MecQkdNetwork>(
+              myCapacity,
+              myRaii.in().theSeed,
+              myRaii.in().theNodes,
+              myRaii.in().theMaxDistance,
+              myRaii.in().theAlpha,
+              myRaii.in().theBeta,
+              myCoordinates,
+              1,
+              qr::TopologyCache(myRaii.in().theTopologyCache)) :
+          qr::makeCapacityNetworkWaxman<qr::MecQkdNetwork>(
+              myCapacity,
+              myRaii.in().theSeed,
+              myRaii.in().theNodes,
+              myRaii.in().theMaxDistance,
+              myRaii.in().theAlpha,
+              myRaii.in().theBeta,
+              myCoordinates,
+              qr::TopologyCache(myRaii.in().theTopologyCache));
   assert(myNetwork->numNodes() == myRaii.in().theNodes);
 
   // load the workload generator parameters from file
@@ -291,9 +339,10 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
 
   // save the network properties
   assert(myNetwork.get() != nullptr);
-  myOutput.theNumNodes      = myNetwork->numNodes();
-  myOutput.theNumEdges      = myNetwork->numEdges();
-  myOutput.theTotalCapacity = myNetwork->totalCapacity();
+  myOutput.theNumNodes         = myNetwork->numNodes();
+  myOutput.theNumEdges         = myNetwork->numEdges();
+  myOutput.theTotalCapacity    = myNetwork->totalCapacity();
+  myOutput.theParallelTopology = myRaii.in().theParallelTopology;
   std::tie(myOutput.theMinInDegree, myOutput.theMaxInDegree) =
       myNetwork->inDegree();
   std::tie(myOutput.theMinOutDegree, myOutput.theMaxOutDegree) =
@@ -397,8 +446,10 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myResultFile;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::string myShard;
 
   std::size_t myNodes;
   double      myAlpha;
@@ -412,6 +463,7 @@ int main(int argc, char* argv[]) {
   std::string myAlgo;
 
   std::string myDotFile;
+  std::string myTopologyCache;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -423,9 +475,12 @@ int main(int argc, char* argv[]) {
     ("dot-file",
      po::value<std::string>(&myDotFile)->default_value(""),
      "Save the network to this Graphviz file.")
+    ("topology-cache",
+     po::value<std::string>(&myTopologyCache)->default_value(""),
+     "Directory where the topologies generated are cached. Not used if empty.")
     ("num-threads",
      po::value<std::size_t>(&myNumThreads)->default_value(1),
-     "Number of threads used. If 0, then use the hardware concurrency value.")
+     "Number of threads used, shared by the runs and their parallel computations. If 0, then use the hardware concurrency value.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
      "Output file name.")
@@ -435,7 +490,14 @@ int main(int argc, char* argv[]) {
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("shard",
+     po::value<std::string>(&myShard)->default_value("0/1"),
+     "Only run the i-th of n shards, specified as i/n with 0 <= i < n: the runs are assigned to the shards based on their estimated cost, so that the shards of a campaign can be run on different hosts and their outputs merged with Scripts/merge-shards.py.")
     ("append", "Append to the output file.")
+    ("result-file",
+     po::value<std::string>(&myResultFile)->default_value(""),
+     "Binary file where the results are saved as soon as every run finishes, then exported to the output file at the end. Not used if empty.")
+    ("resume", "Do not run again the seeds already in the result file, which must have been written with the same parameters.")
     ("nodes",
      po::value<std::size_t>(&myNodes)->default_value(50),
      "Number of nodes.")
@@ -451,6 +513,8 @@ int main(int argc, char* argv[]) {
     ("max-capacity",
      po::value<double>(&myMaxCapacity)->default_value(100e3),
      "Max QKD capacity, in b/s.")
+    ("parallel-topology",
+     "Draw the edges of the Waxman topology in parallel with a counter-based pseudo-random number generator, which is faster with many nodes but yields different topologies from the default generator.")
     ("app-spec",
      po::value<std::string>(&myAppSpec)->default_value("applications.dat"),
      "Name of the CSV file containing the specifications of the applications.")
@@ -493,6 +557,10 @@ int main(int argc, char* argv[]) {
       VLOG(1) << "using " << myNumThreads << " threads";
     }
 
+    if (myVarMap.count("resume") == 1 and myResultFile.empty()) {
+      throw std::runtime_error("cannot resume without a result file");
+    }
+
     std::ofstream myFile(myOutputFilename,
                          myVarMap.count("append") == 1 ? std::ios::app :
                                                          std::ios::trunc);
@@ -501,28 +569,45 @@ int main(int argc, char* argv[]) {
                                myOutputFilename);
     }
 
-    Data myData;
+    Data myData(myResultFile, myVarMap.count("resume") == 1);
 
-    us::Queue<Parameters> myParameters;
+    const auto myParallelTopology = myVarMap.count("parallel-topology") == 1;
+    const auto myRunShard         = qr::Shard::fromString(myShard);
+    std::vector<Parameters> myParameters;
     for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myNodes,
-                                   myAlpha,
-                                   myBeta,
-                                   myMaxDistance,
-                                   myMaxCapacity,
-                                   myAppSpec,
-                                   myApplications,
-                                   myEdgeNodes,
-                                   myEdgeProcessing,
-                                   qr::mecQkdAlgofromString(myAlgo),
-                                   myDotFile});
+      myParameters.emplace_back(Parameters{mySeed,
+                                           myNodes,
+                                           myAlpha,
+                                           myBeta,
+                                           myMaxDistance,
+                                           myMaxCapacity,
+                                           myParallelTopology,
+                                           myAppSpec,
+                                           myApplications,
+                                           myEdgeNodes,
+                                           myEdgeProcessing,
+                                           qr::mecQkdAlgofromString(myAlgo),
+                                           myDotFile,
+                                           myTopologyCache});
+    }
+    myParameters = myRunShard.select(
+        std::move(myParameters),
+        [](const Parameters& aParameters) { return aParameters.cost(); });
+    VLOG(1) << myParameters.size() << " runs in shard "
+            << myRunShard.toString();
+
+    qr::TaskScheduler myScheduler(myNumThreads);
+    for (auto& myParameter : myParameters) {
+      if (myData.contains(myParameter)) {
+        VLOG(1) << "skipping seed " << myParameter.theSeed << ": already in "
+                << myResultFile;
+        continue;
+      }
+      myScheduler.submit([&myData, &myParameter]() {
+        runExperiment(myData, std::move(myParameter));
+      });
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
-        });
-    const auto myExceptions = myWorkers.wait();
+    const auto myExceptions = myScheduler.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
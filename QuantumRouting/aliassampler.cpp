@@ -0,0 +1,179 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/aliassampler.h"
+
+#include "Support/random.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+// maximum number of consecutive rejections in AliasSampler::sample() before
+// falling back to a linear scan
+constexpr std::size_t MAX_REJECTIONS = 64;
+
+bool contains(const std::vector<std::size_t>& aValues,
+              const std::size_t               aValue) {
+  return std::find(aValues.begin(), aValues.end(), aValue) != aValues.end();
+}
+
+} // namespace
+
+AliasSampler::AliasSampler(const std::vector<double>& aWeights)
+    : theWeights(aWeights)
+    , theProbabilities(aWeights.size(), 0)
+    , theAliases(aWeights.size(), 0)
+    , thePositive(0)
+    , theTotal(0) {
+  if (aWeights.empty()) {
+    throw std::runtime_error("cannot build an alias sampler without weights");
+  }
+  for (const auto& myWeight : aWeights) {
+    if (myWeight < 0 or not std::isfinite(myWeight)) {
+      throw std::runtime_error("invalid weight in alias sampler: " +
+                               std::to_string(myWeight));
+    }
+    theTotal += myWeight;
+    if (myWeight > 0) {
+      thePositive++;
+    }
+  }
+  if (thePositive == 0) {
+    throw std::runtime_error("cannot build an alias sampler with zero weights");
+  }
+
+  // Vose's algorithm: pair every column that is under-full with one that is
+  // over-full, which becomes its alias
+  const auto               N = aWeights.size();
+  std::vector<double>      myScaled(N);
+  std::vector<std::size_t> mySmall;
+  std::vector<std::size_t> myLarge;
+  for (std::size_t i = 0; i < N; i++) {
+    myScaled[i]   = aWeights[i] * N / theTotal;
+    theAliases[i] = i;
+    (myScaled[i] < 1 ? mySmall : myLarge).emplace_back(i);
+  }
+  std::size_t myLastLarge = myLarge.empty() ? 0 : myLarge.back();
+  while (not mySmall.empty() and not myLarge.empty()) {
+    const auto mySmallId = mySmall.back();
+    const auto myLargeId = myLarge.back();
+    mySmall.pop_back();
+    myLarge.pop_back();
+    theProbabilities[mySmallId] = myScaled[mySmallId];
+    theAliases[mySmallId]       = myLargeId;
+
+    myScaled[myLargeId] -= 1 - myScaled[mySmallId];
+    (myScaled[myLargeId] < 1 ? mySmall : myLarge).emplace_back(myLargeId);
+    myLastLarge = myLargeId;
+  }
+
+  // the columns left are full, save for rounding errors, but the indices
+  // with zero weight must never be drawn
+  for (const auto i : myLarge) {
+    theProbabilities[i] = 1;
+  }
+  for (const auto i : mySmall) {
+    if (aWeights[i] > 0) {
+      theProbabilities[i] = 1;
+    } else {
+      theAliases[i] = myLastLarge;
+    }
+  }
+}
+
+std::size_t AliasSampler::operator()(support::RealRvInterface& aRv) const {
+  if (theProbabilities.size() == 1) {
+    return 0;
+  }
+  const auto myValue = aRv() * theProbabilities.size();
+  const auto myColumn =
+      std::min(theProbabilities.size() - 1, static_cast<std::size_t>(myValue));
+  return (myValue - myColumn) < theProbabilities[myColumn] ?
+             myColumn :
+             theAliases[myColumn];
+}
+
+std::vector<std::size_t>
+AliasSampler::sample(const std::size_t         aNum,
+                     support::RealRvInterface& aRv) const {
+  if (aNum > thePositive) {
+    throw std::runtime_error("cannot draw " + std::to_string(aNum) +
+                             " distinct indices out of " +
+                             std::to_string(thePositive) +
+                             " with non-zero weight");
+  }
+
+  std::vector<std::size_t> ret;
+  ret.reserve(aNum);
+  while (ret.size() < aNum) {
+    auto myIndex = (*this)(aRv);
+    for (std::size_t i = 0; i < MAX_REJECTIONS and contains(ret, myIndex);
+         i++) {
+      myIndex = (*this)(aRv);
+    }
+    if (contains(ret, myIndex)) {
+      myIndex = scan(ret, aRv);
+    }
+    ret.emplace_back(myIndex);
+  }
+  return ret;
+}
+
+std::size_t AliasSampler::scan(const std::vector<std::size_t>& aDrawn,
+                               support::RealRvInterface&       aRv) const {
+  auto myResidual = theTotal;
+  for (const auto i : aDrawn) {
+    myResidual -= theWeights[i];
+  }
+  auto        myValue = aRv() * myResidual;
+  std::size_t ret     = theWeights.size();
+  for (std::size_t i = 0; i < theWeights.size(); i++) {
+    if (theWeights[i] > 0 and not contains(aDrawn, i)) {
+      ret = i;
+      if (myValue < theWeights[i]) {
+        break;
+      }
+      myValue -= theWeights[i];
+    }
+  }
+  assert(ret < theWeights.size());
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,112 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace uiiit {
+
+namespace support {
+class RealRvInterface;
+}
+
+namespace qr {
+
+/**
+ * @brief Sampler of the indices of a discrete distribution with given
+ * weights, in constant time using the alias method.
+ *
+ * The tables are built once with Vose's algorithm in linear time, then every
+ * index is drawn with a single realization of a r.v. uniformly distributed in
+ * [0, 1): its integer part selects a column of the table and its fractional
+ * part decides between the column and its alias.
+ */
+class AliasSampler final
+{
+ public:
+  /**
+   * @brief Build the tables of the sampler.
+   *
+   * @param aWeights The (unnormalized) weights of the indices.
+   *
+   * @throw std::runtime_error if the weights are empty, any of them is
+   * negative or not finite, or they are all zero.
+   */
+  explicit AliasSampler(const std::vector<double>& aWeights);
+
+  //! \return the number of indices, including those with zero weight.
+  std::size_t size() const noexcept {
+    return theProbabilities.size();
+  }
+
+  /**
+   * @brief Draw an index with probability proportional to its weight.
+   *
+   * @param aRv The r.v. in [0, 1), not used if there is only one index.
+   * @return the index drawn.
+   */
+  std::size_t operator()(support::RealRvInterface& aRv) const;
+
+  /**
+   * @brief Draw distinct indices, i.e., without replacement.
+   *
+   * Each index is drawn from those not drawn yet with probability
+   * proportional to its weight, by rejecting the indices already drawn. If
+   * the weights left are too small then rejection is abandoned in favor of
+   * a linear scan.
+   *
+   * @param aNum The number of indices to draw.
+   * @param aRv The r.v. in [0, 1).
+   * @return the indices, in the order drawn.
+   *
+   * @throw std::runtime_error if there are less than aNum indices with a
+   * non-zero weight.
+   */
+  std::vector<std::size_t> sample(const std::size_t         aNum,
+                                  support::RealRvInterface& aRv) const;
+
+ private:
+  // draw an index not in aDrawn with a linear scan of the weights
+  std::size_t scan(const std::vector<std::size_t>& aDrawn,
+                   support::RealRvInterface&       aRv) const;
+
+ private:
+  const std::vector<double> theWeights;
+  std::vector<double>       theProbabilities; //!< of not taking the alias
+  std::vector<std::size_t>  theAliases;
+  std::size_t               thePositive; //!< number of non-zero weights
+  double                    theTotal;
+};
+
+} // namespace qr
+} // namespace uiiit
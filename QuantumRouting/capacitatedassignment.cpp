@@ -0,0 +1,247 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitatedassignment.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace uiiit {
+namespace qr {
+
+CapacitatedAssignment::CapacitatedAssignment(
+    const std::vector<std::vector<double>>& aProfits,
+    const std::vector<std::size_t>&         aCapacities)
+    : theProfits(aProfits)
+    , theCapacities(aCapacities)
+    , thePotentials(aProfits.size() + aCapacities.size(), 0)
+    , theDistances()
+    , thePredecessors()
+    , theAssigned(aCapacities.size()) {
+  const auto R = numRows();
+  for (std::size_t r = 0; r < R; r++) {
+    if (theProfits[r].size() != numColumns()) {
+      throw std::runtime_error(
+          "invalid number of columns in row " + std::to_string(r) + ": " +
+          std::to_string(theProfits[r].size()) + " instead of " +
+          std::to_string(numColumns()));
+    }
+    for (std::size_t c = 0; c < numColumns(); c++) {
+      if (theProfits[r][c] < 0) {
+        throw std::runtime_error("invalid negative profit in row " +
+                                 std::to_string(r) + ", column " +
+                                 std::to_string(c));
+      }
+      // the costs are the opposite of the profits: with these potentials all
+      // the reduced costs are non-negative
+      thePotentials[R + c] = std::min(thePotentials[R + c], -theProfits[r][c]);
+    }
+  }
+}
+
+std::vector<long> CapacitatedAssignment::next() {
+  static const auto INF = std::numeric_limits<double>::infinity();
+
+  // the flow network has a source connected to every row, the rows are
+  // connected to the columns for which they have a positive profit and to the
+  // sink, which means that the row is not assigned, and the columns are
+  // connected to the sink, with capacity equal to the column's; the source
+  // and the sink are implicit
+  //
+  // as in the Hungarian algorithm, the rows are added one at a time and
+  // the flow is augmented along the shortest path from the new row to the
+  // sink, which always exists
+  const auto R = numRows();
+  const auto N = R + numColumns();
+  theDistances.resize(N);
+  thePredecessors.resize(N);
+  for (auto& myRows : theAssigned) {
+    myRows.clear();
+  }
+  std::vector<long> ret(R, UNASSIGNED);
+  std::vector<char> myLeft(R, false); // rows added but not assigned
+
+  using Item = std::pair<double, std::size_t>;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> myQueue;
+
+  const auto myRelax = [&](const std::size_t aFrom,
+                           const std::size_t aTo,
+                           const double      aCost) {
+    auto myReducedCost = aCost + thePotentials[aFrom] - thePotentials[aTo];
+    if (myReducedCost < 0) {
+      // only the round-off errors are set to zero
+      const auto myTolerance =
+          EPSILON * std::max({1.0,
+                              std::abs(aCost),
+                              std::abs(thePotentials[aFrom]),
+                              std::abs(thePotentials[aTo])});
+      assert(myReducedCost >= -myTolerance);
+      if (myReducedCost >= -myTolerance) {
+        myReducedCost = 0;
+      }
+    }
+    const auto myDistance = theDistances[aFrom] + myReducedCost;
+    if (myDistance < theDistances[aTo]) {
+      theDistances[aTo]    = myDistance;
+      thePredecessors[aTo] = aFrom;
+      myQueue.emplace(myDistance, aTo);
+    }
+  };
+
+  for (std::size_t myRow = 0; myRow < R; myRow++) {
+    // the potential of the sink is such that the reduced costs of the arcs
+    // towards it are non-negative
+    auto mySinkPotential = thePotentials[myRow];
+    for (std::size_t r = 0; r < myRow; r++) {
+      if (not myLeft[r]) {
+        mySinkPotential = std::min(mySinkPotential, thePotentials[r]);
+      }
+    }
+    for (std::size_t c = 0; c < numColumns(); c++) {
+      if (theAssigned[c].size() < theCapacities[c]) {
+        mySinkPotential = std::min(mySinkPotential, thePotentials[R + c]);
+      }
+    }
+
+    // Dijkstra's algorithm with reduced costs, until the sink is reached
+    std::fill(theDistances.begin(), theDistances.end(), INF);
+    theDistances[myRow]    = 0;
+    thePredecessors[myRow] = myRow;
+    myQueue.emplace(0, myRow);
+    auto        mySinkDistance = INF;
+    std::size_t myLast         = N; // last node of the shortest path
+    const auto  myRelaxSink    = [&](const std::size_t u) {
+      const auto myDistance =
+          theDistances[u] + thePotentials[u] - mySinkPotential;
+      if (myDistance < mySinkDistance) {
+        mySinkDistance = myDistance;
+        myLast         = u;
+      }
+    };
+    while (not myQueue.empty()) {
+      const auto myItem = myQueue.top();
+      myQueue.pop();
+      if (myItem.first >= mySinkDistance) {
+        break;
+      }
+      if (myItem.first > theDistances[myItem.second]) {
+        continue; // stale item
+      }
+      const auto u = myItem.second;
+      if (u < R) {
+        // arc to the sink, i.e., the row is left unassigned
+        myRelaxSink(u);
+
+        // forward arcs from a row to the columns not assigned to it
+        for (std::size_t c = 0; c < numColumns(); c++) {
+          if (theProfits[u][c] > 0 and ret[u] != static_cast<long>(c)) {
+            myRelax(u, R + c, -theProfits[u][c]);
+          }
+        }
+      } else {
+        // arc to the sink, if there is residual capacity
+        const auto c = u - R;
+        if (theAssigned[c].size() < theCapacities[c]) {
+          myRelaxSink(u);
+        }
+
+        // backward arcs from a column to the rows assigned to it
+        for (const auto r : theAssigned[c]) {
+          myRelax(u, r, theProfits[r][c]);
+        }
+      }
+    }
+    while (not myQueue.empty()) {
+      myQueue.pop();
+    }
+    assert(myLast < N);
+
+    // update the potentials, capping the distances to that of the sink so
+    // that the reduced costs remain non-negative
+    for (std::size_t v = 0; v < N; v++) {
+      thePotentials[v] += std::min(theDistances[v], mySinkDistance);
+    }
+
+    // augment along the path, which alternates rows and columns
+    if (myLast < R) {
+      // the last row is left unassigned
+      if (ret[myLast] != UNASSIGNED) {
+        auto& myRows = theAssigned[ret[myLast]];
+        myRows.erase(std::find(myRows.begin(), myRows.end(), myLast));
+        ret[myLast] = UNASSIGNED;
+      }
+      myLeft[myLast] = true;
+      if (myLast == myRow) {
+        continue;
+      }
+      myLast = thePredecessors[myLast];
+    }
+    for (auto v = myLast; true;) {
+      assert(v >= R);
+      const auto c = v - R;
+      const auto r = thePredecessors[v];
+      assert(r < R);
+      const auto myOld = ret[r];
+      ret[r]           = c;
+      theAssigned[c].emplace_back(r);
+      if (r == myRow) {
+        break;
+      }
+      assert(myOld != UNASSIGNED);
+      auto& myRows = theAssigned[myOld];
+      myRows.erase(std::find(myRows.begin(), myRows.end(), r));
+      v = thePredecessors[r];
+      assert(v == R + myOld);
+    }
+  }
+
+  // consume the capacities and remove the arcs of the pairs assigned, which
+  // keeps the reduced costs of the remaining arcs non-negative
+  for (std::size_t r = 0; r < R; r++) {
+    if (ret[r] != UNASSIGNED) {
+      assert(theCapacities[ret[r]] > 0);
+      theCapacities[ret[r]]--;
+      theProfits[r][ret[r]] = 0;
+    }
+  }
+
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
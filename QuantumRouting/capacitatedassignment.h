@@ -0,0 +1,120 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Solver of a sequence of capacitated assignment problems.
+ *
+ * There are rows (e.g., apps) and columns (e.g., data centers), with a
+ * non-negative profit for every pair and a capacity for every column. At
+ * every call of next() each row is assigned at most one column so that the
+ * total profit is maximized, without exceeding the capacity of any column;
+ * the pairs with zero profit are never assigned. After a call, the pairs
+ * assigned cannot be assigned again and the capacities of the columns are
+ * reduced by the number of rows assigned to them.
+ *
+ * The problems are solved as min-cost flows with successive shortest paths,
+ * on the original rows x columns profits, using Dijkstra's algorithm with
+ * node potentials. The potentials remain valid after a call, hence
+ * each call is warm-started from the previous one.
+ */
+class CapacitatedAssignment final
+{
+ public:
+  //! Value returned for the rows that are not assigned any column.
+  static constexpr long UNASSIGNED = -1;
+
+  /**
+   * @brief Tolerance on the reduced costs.
+   *
+   * The reduced costs are non-negative in exact arithmetic, but round-off
+   * may make them slightly negative: they are set to zero if not smaller than
+   * -EPSILON times the largest among 1 and the absolute values of the cost
+   * and potentials involved. Larger negative values are a bug.
+   */
+  static constexpr double EPSILON = 1e-9;
+
+  /**
+   * @brief Create a solver.
+   *
+   * @param aProfits The profits, one vector per row, with one value for every
+   * column.
+   * @param aCapacities The capacity of every column.
+   *
+   * @throw std::runtime_error if the rows do not have the same number of
+   * columns as aCapacities or if there are negative profits.
+   */
+  explicit CapacitatedAssignment(
+      const std::vector<std::vector<double>>& aProfits,
+      const std::vector<std::size_t>&         aCapacities);
+
+  /**
+   * @brief Solve the next assignment problem.
+   *
+   * @return the column assigned to every row, or UNASSIGNED.
+   */
+  std::vector<long> next();
+
+  //! \return the number of rows.
+  std::size_t numRows() const noexcept {
+    return theProfits.size();
+  }
+
+  //! \return the number of columns.
+  std::size_t numColumns() const noexcept {
+    return theCapacities.size();
+  }
+
+  //! \return the residual capacity of a column.
+  std::size_t capacity(const std::size_t aColumn) const {
+    return theCapacities.at(aColumn);
+  }
+
+ private:
+  std::vector<std::vector<double>> theProfits; //!< set to 0 once assigned
+  std::vector<std::size_t>         theCapacities;
+  std::vector<double>              thePotentials; //!< rows, then columns
+
+  // working memory of next()
+  std::vector<double>                   theDistances;
+  std::vector<std::size_t>              thePredecessors;
+  std::vector<std::vector<std::size_t>> theAssigned; //!< rows per column
+};
+
+} // namespace qr
+} // namespace uiiit
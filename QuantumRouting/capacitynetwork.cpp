@@ -30,12 +30,12 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/instrumentation.h"
 
 #include "Support/tostring.h"
 
 #include <algorithm>
 #include <boost/graph/detail/adjacency_list.hpp>
-#include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/graph_utility.hpp>
 #include <boost/graph/properties.hpp>
@@ -49,22 +49,43 @@ SOFTWARE.
 #include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <tuple>
 
 namespace uiiit {
 namespace qr {
 
+namespace {
+
+// contribution of an edge to the topology version (splitmix64 finalizer)
+std::uint64_t edgeHash(const unsigned long aSrc, const unsigned long aDst) {
+  auto x = (static_cast<std::uint64_t>(aSrc) << 32) ^
+           static_cast<std::uint64_t>(aDst);
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
 CapacityNetwork::CapacityNetwork(
     const std::vector<std::pair<unsigned long, unsigned long>>& aEdges,
     support::RealRvInterface&                                   aWeightRv,
     const bool aMakeBidirectional)
     : Network()
-    , theGraph() {
-  std::set<std::string> myFound;
-  for (const auto& myEdge : aEdges) {
-    if (myFound
-            .emplace(std::to_string(myEdge.first) + "-" +
-                     std::to_string(myEdge.second))
-            .second == false) {
+    , theGraph()
+    , theCsr()
+    , theDescriptors()
+    , theRanks()
+    , theMinCapacities()
+    , theTopologyVersion(0)
+    , theTotalCapacity(0)
+    , theNodeCapacities()
+    , theNumCapacityUpdates(0) {
+  const auto myDuplicates = findDuplicateEdges(aEdges);
+  for (std::size_t i = 0; i < aEdges.size(); i++) {
+    const auto& myEdge = aEdges[i];
+    if (myDuplicates[i]) {
       VLOG(2) << "duplicate edge found: (" << myEdge.first << ','
               << myEdge.second;
       continue;
@@ -75,27 +96,82 @@ CapacityNetwork::CapacityNetwork(
       Utils<Graph>::addEdge(theGraph, myEdge.second, myEdge.first, myWeight);
     }
   }
+  makeCsr();
 }
 
 CapacityNetwork::CapacityNetwork(const WeightVector& aEdgeWeights)
+    : CapacityNetwork(aEdgeWeights, false) {
+  // noop
+}
+
+CapacityNetwork::CapacityNetwork(const WeightVector& aEdgeWeights,
+                                 const bool          aMakeBidirectional)
     : Network()
-    , theGraph() {
+    , theGraph()
+    , theCsr()
+    , theDescriptors()
+    , theRanks()
+    , theMinCapacities()
+    , theTopologyVersion(0)
+    , theTotalCapacity(0)
+    , theNodeCapacities()
+    , theNumCapacityUpdates(0) {
   for (const auto& elem : aEdgeWeights) {
     Utils<Graph>::addEdge(
         theGraph, std::get<0>(elem), std::get<1>(elem), std::get<2>(elem));
+    if (aMakeBidirectional) {
+      Utils<Graph>::addEdge(
+          theGraph, std::get<1>(elem), std::get<0>(elem), std::get<2>(elem));
+    }
   }
+  makeCsr();
+}
+
+CapacityNetwork::Snapshot CapacityNetwork::snapshot() const {
+  return Snapshot{theCsr.capacities(),
+                  theCsr.enabledEdges(),
+                  theMinCapacities,
+                  theNodeCapacities,
+                  theTopologyVersion,
+                  theTotalCapacity,
+                  theNumCapacityUpdates};
+}
+
+void CapacityNetwork::restore(const Snapshot& aSnapshot) {
+  if (aSnapshot.theNodeCapacities.size() != theCsr.numVertices() or
+      aSnapshot.theCapacities.size() != theCsr.numEdges() or
+      aSnapshot.theEnabled.size() != theCsr.numEdges() or
+      aSnapshot.theMinCapacities.size() != theCsr.numEdges()) {
+    throw std::runtime_error(
+        "cannot restore a snapshot with " +
+        std::to_string(aSnapshot.theNodeCapacities.size()) + " nodes and " +
+        std::to_string(aSnapshot.theCapacities.size()) +
+        " edges into a network with " + std::to_string(theCsr.numVertices()) +
+        " nodes and " + std::to_string(theCsr.numEdges()) + " edges");
+  }
+
+  theCsr.restore(aSnapshot.theCapacities, aSnapshot.theEnabled);
+  commitCsr();
+  theMinCapacities      = aSnapshot.theMinCapacities;
+  theNodeCapacities     = aSnapshot.theNodeCapacities;
+  theTopologyVersion    = aSnapshot.theTopologyVersion;
+  theTotalCapacity      = aSnapshot.theTotalCapacity;
+  theNumCapacityUpdates = aSnapshot.theNumCapacityUpdates;
 }
 
 void CapacityNetwork::toDot(const std::string& aFilename) const {
-  Utils<Graph>::toDot(theGraph, aFilename);
+  Utils<EnabledGraph>::toDot(enabledGraph(), aFilename);
 }
 
 CapacityNetwork::WeightVector CapacityNetwork::weights() const {
   WeightVector ret;
   const auto   myEdges   = boost::edges(theGraph);
   const auto   myWeights = boost::get(boost::edge_weight, theGraph);
+  const auto   myIndices = boost::get(boost::edge_index, theGraph);
   for (auto it = myEdges.first; it != myEdges.second; ++it) {
-    ret.push_back({it->m_source, it->m_target, myWeights[*it]});
+    if (theCsr.enabled(myIndices[*it])) {
+      ret.push_back({it->m_source, it->m_target, myWeights[*it]});
+    }
   }
   return ret;
 }
@@ -103,51 +179,58 @@ CapacityNetwork::WeightVector CapacityNetwork::weights() const {
 std::map<unsigned long, std::vector<unsigned long>>
 CapacityNetwork::cspf(const unsigned long            aSource,
                       const double                   aCapacity,
-                      const std::set<unsigned long>& aDestinations) const {
-  const auto V = boost::num_vertices(theGraph);
+                      const std::set<unsigned long>& aDestinations,
+                      const std::size_t              aMaxHops) const {
+  CsrGraph::Scratch                                   myScratch;
+  std::map<unsigned long, std::vector<unsigned long>> ret;
+  cspf(aSource, aCapacity, aDestinations, myScratch, ret, aMaxHops);
+  return ret;
+}
+
+void CapacityNetwork::cspf(
+    const unsigned long                                  aSource,
+    const double                                         aCapacity,
+    const std::set<unsigned long>&                       aDestinations,
+    CsrGraph::Scratch&                                   aScratch,
+    std::map<unsigned long, std::vector<unsigned long>>& aPaths,
+    const std::size_t                                    aMaxHops) const {
 #ifndef NDEBUG
+  const auto V = theCsr.numVertices();
   assert(aSource < V);
   for (const auto& v : aDestinations) {
     assert(v < V);
   }
 #endif
 
-  // make a working copy of the graph
-  auto myGraph = theGraph;
-
-  // remove all edges without enough capacity to satisfy the requirement
-  const auto myWeights = boost::get(boost::edge_weight, myGraph);
-  {
-    boost::graph_traits<Graph>::edge_iterator it, end, next;
-    std::tie(it, end) = boost::edges(myGraph);
-    for (next = it; it != end; it = next) {
-      next++;
-      if (myWeights[*it] < aCapacity) {
-        boost::remove_edge(*it, myGraph);
-      }
+  // find the shortest paths in hops on the CSR snapshot by following only
+  // the edges with enough capacity to satisfy the requirement, up to the
+  // maximum length
+  theCsr.shortestPathTree(
+      aSource, aCapacity, aDestinations, aScratch, aMaxHops);
+
+  // reuse the output entries, unless the destinations have changed
+  if (aPaths.size() != aDestinations.size() or
+      not std::equal(aDestinations.begin(),
+                     aDestinations.end(),
+                     aPaths.begin(),
+                     [](const auto aLhs, const auto& aRhs) {
+                       return aLhs == aRhs.first;
+                     })) {
+    aPaths.clear();
+    for (const auto myDestination : aDestinations) {
+      aPaths.emplace(myDestination, std::vector<unsigned long>());
     }
   }
 
-  // run Dijkstra with distance measured in hops
-  std::vector<VertexDescriptor> myPredecessors(V);
-  boost::dijkstra_shortest_paths(
-      myGraph,
-      aSource,
-      boost::predecessor_map(myPredecessors.data())
-          .weight_map(
-              boost::make_static_property_map<Graph::edge_descriptor>(1)));
-
   // save the shortest paths found
-  std::map<unsigned long, std::vector<unsigned long>> ret;
-  for (const auto myDestination : aDestinations) {
-    auto it = ret.emplace(myDestination, std::vector<unsigned long>()).first;
-    if (myPredecessors[myDestination] != myDestination) {
+  const auto& myPredecessors = aScratch.thePredecessors;
+  for (auto& elem : aPaths) {
+    elem.second.clear();
+    if (myPredecessors[elem.first] != elem.first) {
       HopsFinder myHopsFinder(myPredecessors, aSource);
-      myHopsFinder(it->second, myDestination);
+      myHopsFinder(elem.second, elem.first);
     }
   }
-
-  return ret;
 }
 
 std::size_t CapacityNetwork::numNodes() const {
@@ -155,72 +238,48 @@ std::size_t CapacityNetwork::numNodes() const {
 }
 
 std::size_t CapacityNetwork::numEdges() const {
-  return boost::num_edges(theGraph);
+  const auto& myEnabled = theCsr.enabledEdges();
+  return static_cast<std::size_t>(
+      std::count(myEnabled.begin(), myEnabled.end(), true));
 }
 
 std::pair<std::size_t, std::size_t> CapacityNetwork::inDegree() const {
-  return minMaxVertexProp(
-      [](Graph::vertex_descriptor aVertex, const Graph& aGraph) {
-        return boost::in_degree(aVertex, aGraph);
-      });
+  return minMaxDegree([](const CsrGraph& aCsr, const CsrGraph::EdgeId aEdge) {
+    return aCsr.target(aEdge);
+  });
 }
 
 std::pair<std::size_t, std::size_t> CapacityNetwork::outDegree() const {
-  return minMaxVertexProp(
-      [](Graph::vertex_descriptor aVertex, const Graph& aGraph) {
-        return boost::out_degree(aVertex, aGraph);
-      });
-}
-
-double CapacityNetwork::totalCapacity() const {
-  const auto myEdges   = boost::edges(theGraph);
-  const auto myWeights = boost::get(boost::edge_weight, theGraph);
-  double     ret       = 0;
-  for (auto it = myEdges.first; it != myEdges.second; ++it) {
-    ret += myWeights[*it];
-  }
-  return ret;
+  return minMaxDegree([](const CsrGraph& aCsr, const CsrGraph::EdgeId aEdge) {
+    return aCsr.source(aEdge);
+  });
 }
 
 std::map<unsigned long, std::set<unsigned long>>
 CapacityNetwork::reachableNodes(const std::size_t aMinHops,
                                 const std::size_t aMaxHops,
                                 std::size_t&      aDiameter) const {
+  const auto myReachableNodes =
+      reachableNodesCompact(aMinHops, aMaxHops, aDiameter);
+
+  // the time of the search is added by reachableNodesCompact()
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Reachability);
+  return myReachableNodes.toMap();
+}
+
+CompactReachableNodes
+CapacityNetwork::reachableNodesCompact(const std::size_t aMinHops,
+                                       const std::size_t aMaxHops,
+                                       std::size_t&      aDiameter,
+                                       const std::size_t aNumThreads) const {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Reachability);
+
   if (aMinHops > aMaxHops) {
     throw std::runtime_error(
         "Invalid min distance (" + std::to_string(aMinHops) +
         ") larger than max distance (" + std::to_string(aMaxHops) + ")");
   }
-
-  const auto                    V = boost::num_vertices(theGraph);
-  std::vector<VertexDescriptor> myDistances(V);
-
-  aDiameter = 0;
-  std::map<unsigned long, std::set<unsigned long>> ret;
-  boost::graph_traits<Graph>::vertex_iterator      it, end;
-  for (std::tie(it, end) = vertices(theGraph); it != end; ++it) {
-    boost::dijkstra_shortest_paths(
-        theGraph,
-        *it,
-        boost::weight_map(
-            boost::make_static_property_map<Graph::edge_descriptor>(1))
-            .distance_map(boost::make_iterator_property_map(
-                myDistances.data(), get(boost::vertex_index, theGraph))));
-
-    auto myEmplaceRet = ret.emplace(*it, std::set<unsigned long>());
-    assert(myEmplaceRet.second);
-    for (unsigned long i = 0; i < V; i++) {
-      if (*it != i and
-          myDistances[i] != std::numeric_limits<unsigned long>::max()) {
-        aDiameter = std::max(aDiameter, myDistances[i]);
-        VLOG(2) << *it << "->" << i << ": " << myDistances[i];
-        if (myDistances[i] >= aMinHops and myDistances[i] <= aMaxHops) {
-          myEmplaceRet.first->second.emplace(i);
-        }
-      }
-    }
-  }
-  return ret;
+  return theCsr.reachableNodes(aMinHops, aMaxHops, aNumThreads, aDiameter);
 }
 
 std::vector<unsigned long>
@@ -228,6 +287,8 @@ CapacityNetwork::closestNodes(const unsigned long            aSrc,
                               const unsigned long            aNum,
                               support::RealRvInterface&      aRv,
                               const std::set<unsigned long>& aWhiteList) const {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Reachability);
+
   std::vector<unsigned long> ret;
   if (aNum == 0) {
     return ret;
@@ -236,21 +297,14 @@ CapacityNetwork::closestNodes(const unsigned long            aSrc,
   // find the shortest paths to reach any node from aSrc
   const auto                    V = boost::num_vertices(theGraph);
   std::vector<VertexDescriptor> myDistances(V);
-  boost::dijkstra_shortest_paths(
-      theGraph,
-      boost::vertex(aSrc, theGraph),
-      boost::weight_map(
-          boost::make_static_property_map<Graph::edge_descriptor>(1))
-          .distance_map(boost::make_iterator_property_map(
-              myDistances.data(), get(boost::vertex_index, theGraph))));
+  theCsr.hopDistances(aSrc, myDistances);
 
   // sort the distances
   // - do not include the nodes that are unreachable
   // - add a tiny floating point variation to break ties
   std::list<std::pair<double, unsigned long>> myDestinations;
   for (unsigned long i = 0; i < V; i++) {
-    if (aSrc != i and
-        myDistances[i] != std::numeric_limits<unsigned long>::max()) {
+    if (aSrc != i and myDistances[i] != CsrGraph::INFINITE_DISTANCE) {
       myDestinations.emplace_back(myDistances[i] + aRv() * .1, i);
     }
   }
@@ -269,26 +323,16 @@ CapacityNetwork::closestNodes(const unsigned long            aSrc,
   return ret;
 }
 
+HopDistanceIndex CapacityNetwork::hopDistanceIndex(
+    const std::vector<unsigned long>& aTargets) const {
+  return HopDistanceIndex(theCsr, aTargets);
+}
+
 void CapacityNetwork::addCapacityToPath(
     const VertexDescriptor               aSrc,
     const std::vector<VertexDescriptor>& aPath,
     const double                         aCapacity) {
-  removeCapacityFromPath(aSrc, aPath, -aCapacity, std::nullopt, theGraph);
-}
-
-std::vector<double> CapacityNetwork::nodeCapacities() const {
-  std::vector<double> ret(boost::num_vertices(theGraph), 0);
-  for (const auto& myNode :
-       boost::make_iterator_range(boost::vertices(theGraph))) {
-    double myCapacity = 0;
-    for (const auto& myEdge :
-         boost::make_iterator_range(boost::out_edges(myNode, theGraph))) {
-      myCapacity += boost::get(boost::edge_weight, theGraph, myEdge);
-    }
-    assert(myNode < ret.size());
-    ret[myNode] = myCapacity;
-  }
-  return ret;
+  removeCapacityFromPath(aSrc, aPath, -aCapacity, std::nullopt);
 }
 
 void CapacityNetwork::toGnuplot(
@@ -317,7 +361,7 @@ void CapacityNetwork::toGnuplot(
 
   std::ofstream myOutEdges(aFilename + "-edges.dat");
   for (const auto& myEdge :
-       boost::make_iterator_range(boost::edges(theGraph))) {
+       boost::make_iterator_range(boost::edges(enabledGraph()))) {
     myOutEdges << std::get<0>(aCoordinates[myEdge.m_source]) << ','
                << std::get<1>(aCoordinates[myEdge.m_source]) << '\n'
                << std::get<0>(aCoordinates[myEdge.m_target]) << ','
@@ -326,45 +370,26 @@ void CapacityNetwork::toGnuplot(
   }
 }
 
-bool CapacityNetwork::checkCapacity(const VertexDescriptor               aSrc,
-                                    const std::vector<VertexDescriptor>& aPath,
-                                    const double aCapacity,
-                                    const Graph& aGraph) {
-  auto mySrc = aSrc;
-  for (std::size_t i = 0; i < aPath.size(); i++) {
-    auto myDst = aPath[i];
-
-    EdgeDescriptor        myEdge;
-    [[maybe_unused]] auto myFound = false;
-    std::tie(myEdge, myFound)     = boost::edge(mySrc, myDst, aGraph);
-    assert(myFound);
-    if (boost::get(boost::edge_weight, aGraph, myEdge) < aCapacity) {
-      return false;
-    }
-
-    // move to the next edge
-    mySrc = myDst;
-  }
-  return true;
-}
-
 double
 CapacityNetwork::minCapacity(const VertexDescriptor               aSrc,
                              const std::vector<VertexDescriptor>& aPath) const {
-  double ret   = std::numeric_limits<double>::max();
-  auto   mySrc = aSrc;
+  const auto V     = theCsr.numVertices();
+  double     ret   = std::numeric_limits<double>::max();
+  auto       mySrc = aSrc;
   for (std::size_t i = 0; i < aPath.size(); i++) {
     auto myDst = aPath[i];
 
-    EdgeDescriptor myEdge;
-    auto           myFound    = false;
-    std::tie(myEdge, myFound) = boost::edge(mySrc, myDst, theGraph);
+    CsrGraph::EdgeId myEdge  = 0;
+    auto             myFound = false;
+    if (mySrc < V and myDst < V) {
+      std::tie(myEdge, myFound) = theCsr.findEdge(mySrc, myDst);
+    }
     if (not myFound) {
       throw std::runtime_error("non-existing path for src node " +
                                std::to_string(aSrc) + ": " +
                                ::toStringStd(aPath, ","));
     }
-    ret = std::min(ret, boost::get(boost::edge_weight, theGraph, myEdge));
+    ret = std::min(ret, theCsr.capacity(myEdge));
 
     // move to the next edge
     mySrc = myDst;
@@ -372,6 +397,25 @@ CapacityNetwork::minCapacity(const VertexDescriptor               aSrc,
   return ret;
 }
 
+CapacityNetwork::EnabledGraph CapacityNetwork::enabledGraph() const {
+  return EnabledGraph(theGraph, EnabledEdge{&theGraph, &theCsr});
+}
+
+std::pair<CsrGraph::EdgeId, bool>
+CapacityNetwork::findCsrEdge(const VertexDescriptor aSrc,
+                             const VertexDescriptor aDst) const {
+  auto ret = theCsr.findEdge(aSrc, aDst);
+  if (not ret.second) {
+    const auto myEdges = theCsr.outEdges(aSrc);
+    for (auto e = myEdges.first; e < myEdges.second and not ret.second; e++) {
+      if (theCsr.target(e) == aDst) {
+        ret = {e, true};
+      }
+    }
+  }
+  return ret;
+}
+
 double CapacityNetwork::minCapacity(const Path& aPath, const Graph& aGraph) {
   double ret = std::numeric_limits<double>::max();
   for (const auto& edge : aPath) {
@@ -380,44 +424,16 @@ double CapacityNetwork::minCapacity(const Path& aPath, const Graph& aGraph) {
   return ret;
 }
 
-void CapacityNetwork::removeSmallestCapacityEdge(
-    const VertexDescriptor               aSrc,
-    const std::vector<VertexDescriptor>& aPath,
-    Graph&                               aGraph) {
-  auto           mySrc = aSrc;
-  EdgeDescriptor mySmallestCapacityEdge;
-  double         mySmallestCapacity = std::numeric_limits<double>::max();
-  for (std::size_t i = 0; i < aPath.size(); i++) {
-    auto myDst = aPath[i];
-
-    EdgeDescriptor        myEdge;
-    [[maybe_unused]] auto myFound = false;
-    std::tie(myEdge, myFound)     = boost::edge(mySrc, myDst, aGraph);
-    assert(myFound);
-    const auto myCapacity = boost::get(boost::edge_weight, aGraph, myEdge);
-    if (myCapacity < mySmallestCapacity) {
-      mySmallestCapacity     = myCapacity;
-      mySmallestCapacityEdge = myEdge;
-    }
-
-    // move to the next edge
-    mySrc = myDst;
-  }
-  boost::remove_edge(mySmallestCapacityEdge, aGraph);
-}
-
 void CapacityNetwork::removeCapacityFromPath(
     const VertexDescriptor               aSrc,
     const std::vector<VertexDescriptor>& aPath,
     const double                         aCapacity,
-    const std::optional<double>          aMinCapacity,
-    Graph&                               aGraph) {
-  const auto V = boost::num_vertices(aGraph);
+    const std::optional<double>          aMinCapacity) {
+  const auto V = boost::num_vertices(theGraph);
   if (aSrc >= V) {
     throw std::runtime_error("source node does not exist: " +
                              std::to_string(aSrc));
   }
-  auto myWeights = boost::get(boost::edge_weight, aGraph);
 
   // first pass: only checks, throw if needed
   auto mySrc = aSrc;
@@ -428,17 +444,18 @@ void CapacityNetwork::removeCapacityFromPath(
                                std::to_string(myDst));
     }
 
-    EdgeDescriptor myEdge;
-    auto           myFound    = false;
-    std::tie(myEdge, myFound) = boost::edge(mySrc, myDst, aGraph);
-    if (not myFound) {
-      throw std::runtime_error("edge not in the graph: " + ::toString(myEdge));
+    CsrGraph::EdgeId myEdge   = 0;
+    auto             myFound  = false;
+    std::tie(myEdge, myFound) = findCsrEdge(mySrc, myDst);
+    const auto myName =
+        "(" + std::to_string(mySrc) + "," + std::to_string(myDst) + ")";
+    if (not myFound or (not theCsr.enabled(myEdge) and aCapacity >= 0)) {
+      throw std::runtime_error("edge not in the graph: " + myName);
     }
-    auto& myWeight = myWeights[myEdge];
-    if (myWeight < aCapacity) {
+    if (theCsr.capacity(myEdge) < aCapacity) {
       throw std::runtime_error(
           "cannot remove capacity " + std::to_string(aCapacity) + " > " +
-          std::to_string(myWeight) + " for edge " + ::toString(myEdge));
+          std::to_string(theCsr.capacity(myEdge)) + " for edge " + myName);
     }
 
     // move to the next edge
@@ -450,12 +467,12 @@ void CapacityNetwork::removeCapacityFromPath(
   for (std::size_t i = 0; i < aPath.size(); i++) {
     auto myDst = aPath[i];
 
-    auto  myEdge   = boost::edge(mySrc, myDst, aGraph).first;
-    auto& myWeight = myWeights[myEdge];
-    myWeight -= aCapacity;
+    const auto myEdge     = findCsrEdge(mySrc, myDst).first;
+    const auto myResidual = removeCapacityFromEdge(myEdge, aCapacity);
 
-    if (aMinCapacity.has_value() and myWeight < aMinCapacity.value()) {
-      boost::remove_edge(myEdge, aGraph);
+    if (aMinCapacity.has_value() and theCsr.enabled(myEdge) and
+        myResidual < aMinCapacity.value()) {
+      disableCsrEdge(myEdge, aMinCapacity.value());
     }
 
     // move to the next edge
@@ -463,14 +480,131 @@ void CapacityNetwork::removeCapacityFromPath(
   }
 }
 
-std::pair<std::size_t, std::size_t> CapacityNetwork::minMaxVertexProp(
-    const std::function<std::size_t(Graph::vertex_descriptor, const Graph&)>&
-        aPropFunctor) const {
-  auto        myRange = boost::vertices(theGraph);
-  std::size_t myMin   = std::numeric_limits<std::size_t>::max();
-  std::size_t myMax   = 0;
-  for (auto it = myRange.first; it != myRange.second; ++it) {
-    const auto myCur = aPropFunctor(*it, theGraph);
+double CapacityNetwork::removeCapacityFromEdge(const CsrGraph::EdgeId aEdge,
+                                               const double aCapacity) {
+  double ret = 0;
+  if (theCsr.enabled(aEdge)) {
+    ret = removeCsrCapacity(aEdge, aCapacity);
+  } else {
+    // the aggregate capacities do not include the disabled edges
+    ret = theCsr.capacity(aEdge) - aCapacity;
+    theCsr.capacity(aEdge, ret);
+    if (ret >= theMinCapacities[aEdge]) {
+      enableCsrEdge(aEdge);
+    }
+  }
+  boost::put(boost::edge_weight, theGraph, theDescriptors[aEdge], ret);
+  return ret;
+}
+
+double CapacityNetwork::removeCsrCapacity(const CsrGraph::EdgeId aEdge,
+                                          const double           aCapacity) {
+  const auto ret = theCsr.capacity(aEdge) - aCapacity;
+  theCsr.capacity(aEdge, ret);
+  updateCapacities(aEdge, -aCapacity);
+  return ret;
+}
+
+void CapacityNetwork::disableCsrEdge(const CsrGraph::EdgeId aEdge,
+                                     const double           aMinCapacity) {
+  assert(theCsr.enabled(aEdge));
+  theMinCapacities[aEdge] = aMinCapacity;
+  theTopologyVersion -= edgeHash(theCsr.source(aEdge), theCsr.target(aEdge));
+  theCsr.disable(aEdge);
+  updateCapacities(aEdge, -theCsr.capacity(aEdge));
+}
+
+void CapacityNetwork::enableCsrEdge(const CsrGraph::EdgeId aEdge) {
+  assert(not theCsr.enabled(aEdge));
+  theTopologyVersion += edgeHash(theCsr.source(aEdge), theCsr.target(aEdge));
+  theCsr.enable(aEdge);
+  updateCapacities(aEdge, theCsr.capacity(aEdge));
+}
+
+void CapacityNetwork::commitCsr() {
+  auto myWeights = boost::get(boost::edge_weight, theGraph);
+  for (std::size_t e = 0; e < theDescriptors.size(); e++) {
+    myWeights[theDescriptors[e]] = theCsr.capacity(e);
+  }
+}
+
+void CapacityNetwork::makeCsr() {
+  Instrumentation::count(Instrumentation::Counter::GraphCopies);
+
+  WeightVector myEdges;
+  myEdges.reserve(boost::num_edges(theGraph));
+  theDescriptors.clear();
+  theDescriptors.reserve(boost::num_edges(theGraph));
+  theTopologyVersion = edgeHash(boost::num_vertices(theGraph), 0);
+  auto myIndices = boost::get(boost::edge_index, theGraph);
+  auto myWeights = boost::get(boost::edge_weight, theGraph);
+  for (const auto& myNode :
+       boost::make_iterator_range(boost::vertices(theGraph))) {
+    for (const auto& myEdge :
+         boost::make_iterator_range(boost::out_edges(myNode, theGraph))) {
+      myIndices[myEdge] = myEdges.size();
+      myEdges.emplace_back(myNode, myEdge.m_target, myWeights[myEdge]);
+      theDescriptors.emplace_back(myEdge);
+      theTopologyVersion += edgeHash(myNode, myEdge.m_target);
+    }
+  }
+  theCsr = CsrGraph(boost::num_vertices(theGraph), myEdges);
+  theMinCapacities.assign(myEdges.size(), 0);
+
+  std::vector<std::size_t> myOrder(theDescriptors.size());
+  std::iota(myOrder.begin(), myOrder.end(), 0);
+  std::sort(myOrder.begin(),
+            myOrder.end(),
+            [this](const std::size_t aLhs, const std::size_t aRhs) {
+              return std::make_tuple(
+                         theCsr.source(aLhs), theCsr.target(aLhs), aLhs) <
+                     std::make_tuple(
+                         theCsr.source(aRhs), theCsr.target(aRhs), aRhs);
+            });
+  theRanks.resize(myOrder.size());
+  for (std::size_t i = 0; i < myOrder.size(); i++) {
+    theRanks[myOrder[i]] = i;
+  }
+
+  computeCapacities();
+}
+
+void CapacityNetwork::updateCapacities(const CsrGraph::EdgeId aEdge,
+                                       const double           aDelta) {
+  theTotalCapacity += aDelta;
+  theNodeCapacities[theCsr.source(aEdge)] += aDelta;
+  if (++theNumCapacityUpdates >= theCsr.numEdges()) {
+    computeCapacities();
+  }
+}
+
+void CapacityNetwork::computeCapacities() {
+  theTotalCapacity = 0;
+  theNodeCapacities.assign(theCsr.numVertices(), 0);
+  theNumCapacityUpdates = 0;
+  for (std::size_t myNode = 0; myNode < theNodeCapacities.size(); myNode++) {
+    const auto myEdges = theCsr.outEdges(myNode);
+    for (auto e = myEdges.first; e < myEdges.second; e++) {
+      if (theCsr.enabled(e)) {
+        theNodeCapacities[myNode] += theCsr.capacity(e);
+      }
+    }
+    theTotalCapacity += theNodeCapacities[myNode];
+  }
+}
+
+template <class VERTEX>
+std::pair<std::size_t, std::size_t>
+CapacityNetwork::minMaxDegree(VERTEX&& aVertexFunctor) const {
+  std::vector<std::size_t> myDegrees(theCsr.numVertices(), 0);
+  for (std::size_t e = 0; e < theCsr.numEdges(); e++) {
+    if (theCsr.enabled(e)) {
+      myDegrees[aVertexFunctor(theCsr, e)]++;
+    }
+  }
+  std::size_t myMin = std::numeric_limits<std::size_t>::max();
+  std::size_t myMax = 0;
+  for (const auto myCur : myDegrees) {
     if (myCur < myMin) {
       myMin = myCur;
     }
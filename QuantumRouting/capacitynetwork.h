@@ -31,12 +31,15 @@ SOFTWARE.
 
 #pragma once
 
+#include "QuantumRouting/csrgraph.h"
+#include "QuantumRouting/hopdistanceindex.h"
 #include "QuantumRouting/network.h"
 #include "QuantumRouting/qrutils.h"
 #include "Support/random.h"
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/detail/adjacency_list.hpp>
+#include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/graph_utility.hpp>
 #include <boost/graph/properties.hpp>
@@ -46,6 +49,7 @@ SOFTWARE.
 #include <functional>
 #include <list>
 #include <map>
+#include <optional>
 #include <set>
 #include <tuple>
 #include <utility>
@@ -65,15 +69,22 @@ class CapacityNetwork : public Network
  public:
   FRIEND_TEST(TestCapacityNetwork, test_min_capacity_edges);
   FRIEND_TEST(TestCapacityNetwork, test_remove_capacity_from_path);
-
-  using Graph =
-      boost::adjacency_list<boost::listS,
-                            boost::vecS,
-                            boost::bidirectionalS,
-                            boost::no_property,
-                            boost::property<boost::edge_weight_t, double>,
-                            boost::no_property,
-                            boost::listS>;
+  FRIEND_TEST(TestCapacityNetwork, test_add_capacity_after_prune);
+  FRIEND_TEST(TestCapacityNetwork, test_aggregate_capacities);
+  FRIEND_TEST(TestCapacityNetwork, test_snapshot);
+  FRIEND_TEST(TestCapacityNetwork, test_edge_ranks);
+
+  // the edge index is the identifier of the edge in the CSR snapshot
+  using Graph = boost::adjacency_list<
+      boost::listS,
+      boost::vecS,
+      boost::bidirectionalS,
+      boost::no_property,
+      boost::property<boost::edge_weight_t,
+                      double,
+                      boost::property<boost::edge_index_t, std::size_t>>,
+      boost::no_property,
+      boost::listS>;
   using VertexDescriptor = boost::graph_traits<Graph>::vertex_descriptor;
   using EdgeDescriptor   = boost::graph_traits<Graph>::edge_descriptor;
   using Path             = std::list<EdgeDescriptor>;
@@ -86,6 +97,23 @@ class CapacityNetwork : public Network
   // map of host -> { peers }
   using ReachableNodes = std::map<unsigned long, std::set<unsigned long>>;
 
+  //! Maximum path length, in hops, meaning that there is no limit.
+  static constexpr std::size_t UNLIMITED_HOPS = CsrGraph::INFINITE_DISTANCE;
+
+  /**
+   * @brief The residual capacity state of a network, which can be restored
+   * any number of times into the network from which it was taken.
+   */
+  struct Snapshot {
+    std::vector<double> theCapacities;    //!< indexed by CSR edge identifier
+    std::vector<bool>   theEnabled;       //!< indexed by CSR edge identifier
+    std::vector<double> theMinCapacities; //!< indexed by CSR edge identifier
+    std::vector<double> theNodeCapacities;
+    std::uint64_t       theTopologyVersion    = 0;
+    double              theTotalCapacity      = 0;
+    std::size_t         theNumCapacityUpdates = 0;
+  };
+
   /**
    * @brief Create a network with given links and assign random weights
    *
@@ -106,10 +134,20 @@ class CapacityNetwork : public Network
    */
   explicit CapacityNetwork(const WeightVector& aEdgeWeights);
 
+  /**
+   * @brief Create a network with given links and weights
+   *
+   * @param aEdgeWeights The edges and weights of the network (src, dst, w).
+   * @param aMakeBidirectional If true then for each edge (A,B,w) two edges
+   * are added A->B and B->A, with the same weight.
+   */
+  explicit CapacityNetwork(const WeightVector& aEdgeWeights,
+                           const bool          aMakeBidirectional);
+
   //! \return the number of nodes.
   std::size_t numNodes() const;
 
-  //! \return the number of edges.
+  //! \return the number of edges, not including those with no capacity left.
   std::size_t numEdges() const;
 
   //! \return the min-max in-degree of the graph.
@@ -118,13 +156,47 @@ class CapacityNetwork : public Network
   //! \return the min-max out-degree of the graph.
   std::pair<std::size_t, std::size_t> outDegree() const;
 
-  //! \return the total capacity across all the edges.
-  double totalCapacity() const;
+  /**
+   * @brief Return the topology version of the network.
+   *
+   * The version is derived from the number of nodes and the set of enabled
+   * edges: it changes whenever an edge is disabled or enabled again, but not
+   * when the capacities change, and it is the same for networks with the
+   * same topology, which allows search results to be shared between them.
+   *
+   * @return the topology version.
+   */
+  std::uint64_t topologyVersion() const noexcept {
+    return theTopologyVersion;
+  }
+
+  //! \return the total capacity across all the edges, in O(1).
+  double totalCapacity() const noexcept {
+    return theTotalCapacity;
+  }
+
+  //! \return the current residual capacity state of the network.
+  Snapshot snapshot() const;
+
+  /**
+   * @brief Bring the network back to the state of a snapshot.
+   *
+   * The capacities and the enabled flags are copied in bulk into the CSR
+   * snapshot and then the capacities are written to the graph with a single
+   * pass over the edges, in O(E), without allocating memory.
+   *
+   * @param aSnapshot The state, which must have been taken from this network.
+   *
+   * @throw std::runtime_error if the snapshot is from a network with a
+   * different number of nodes or edges.
+   */
+  void restore(const Snapshot& aSnapshot);
 
   //! Save to a dot file.
   void toDot(const std::string& aFilename) const;
 
-  //! \return the current weights, one per element in the return vector.
+  //! \return the current weights of the enabled edges, one per element in the
+  //! return vector.
   WeightVector weights() const;
 
   /**
@@ -135,15 +207,40 @@ class CapacityNetwork : public Network
    * @param aSource The source node.
    * @param aCapacity The capacity requirement.
    * @param aDestinations The set of destinations.
+   * @param aMaxHops The maximum length of the paths, in hops: the search
+   * stops at this distance from the source.
    * @return std::map<unsigned long, std::vector<unsigned long>> The constrained
-   * shortest path found for each node. If there is no feasible path or if the
-   * destination node is the same as the source, then the value in the map is
-   * empty.
+   * shortest path found for each node. If there is no feasible path within
+   * the maximum length or if the destination node is the same as the source,
+   * then the value in the map is empty.
    */
   std::map<unsigned long, std::vector<unsigned long>>
   cspf(const unsigned long            aSource,
        const double                   aCapacity,
-       const std::set<unsigned long>& aDestinations) const;
+       const std::set<unsigned long>& aDestinations,
+       const std::size_t              aMaxHops = UNLIMITED_HOPS) const;
+
+  /**
+   * @brief Same as above, but using caller-owned working memory and output.
+   *
+   * The search stops as soon as all the destinations have been reached and
+   * does not allocate memory if the same objects are passed to repeated
+   * calls with the same set of destinations.
+   *
+   * @param aSource The source node.
+   * @param aCapacity The capacity requirement.
+   * @param aDestinations The set of destinations.
+   * @param aScratch The working memory of the search.
+   * @param aPaths The constrained shortest path found for each node, with the
+   * same semantics as the return value of the function above.
+   * @param aMaxHops The maximum length of the paths, in hops.
+   */
+  void cspf(const unsigned long                                  aSource,
+            const double                                         aCapacity,
+            const std::set<unsigned long>&                       aDestinations,
+            CsrGraph::Scratch&                                   aScratch,
+            std::map<unsigned long, std::vector<unsigned long>>& aPaths,
+            const std::size_t aMaxHops = UNLIMITED_HOPS) const;
 
   /**
    * @brief For each node, find the reachable nodes with min/max distance.
@@ -157,6 +254,27 @@ class CapacityNetwork : public Network
                                 const std::size_t aMaxHops,
                                 std::size_t&      aDiameter) const;
 
+  /**
+   * @brief Same as reachableNodes() but return a compact representation.
+   *
+   * The breadth-first searches are run for 64 sources at a time and they can
+   * use multiple threads. If called from a task of a TaskScheduler, they
+   * always use its workers.
+   *
+   * @param aMinHops The minimum distance, in hops.
+   * @param aMaxHops The maximum distance, in hops.
+   * @param aDiameter Return the network diameter, in hops.
+   * @param aNumThreads The number of threads when not called from a task of
+   * a TaskScheduler, if 0 use the hardware concurrency.
+   * @return the reachable nodes for each node.
+   * @throw std::runtime_error if aMinHops > aMaxHops.
+   */
+  CompactReachableNodes
+  reachableNodesCompact(const std::size_t aMinHops,
+                        const std::size_t aMaxHops,
+                        std::size_t&      aDiameter,
+                        const std::size_t aNumThreads = 1) const;
+
   /**
    * @brief Find the aNum nodes closest to a source node.
    *
@@ -174,6 +292,19 @@ class CapacityNetwork : public Network
                const std::set<unsigned long>& aWhiteList =
                    std::set<unsigned long>()) const;
 
+  /**
+   * @brief Find the distances from all the nodes to a set of targets, with
+   * the current topology, to find quickly the targets closest to any node.
+   *
+   * @param aTargets The target nodes, e.g., the data centers.
+   * @return the index of the distances, which is not updated if edges are
+   * disabled afterwards.
+   * @throw std::range_error if a node is 65535 hops or more away from a
+   * target.
+   */
+  HopDistanceIndex
+  hopDistanceIndex(const std::vector<unsigned long>& aTargets) const;
+
   /**
    * @brief Add capacity on all the edges along a given path from a source node.
    *
@@ -181,6 +312,10 @@ class CapacityNetwork : public Network
    * @param aPath the path
    * @param aCapacity the capacity to be added
    *
+   * The edges that have been disabled because their residual capacity was
+   * too small are enabled again if it becomes at least the minimum capacity
+   * with which they were disabled.
+   *
    * @throw std::runtime_error if one of the edges in the path does not exist in
    * the graph
    */
@@ -205,7 +340,9 @@ class CapacityNetwork : public Network
    *
    * @return std::vector<double> The capacity value for each node index.
    */
-  std::vector<double> nodeCapacities() const;
+  const std::vector<double>& nodeCapacities() const noexcept {
+    return theNodeCapacities;
+  }
 
   /**
    * @brief Save the nodes and vertices of the graph to two files that can be
@@ -237,10 +374,32 @@ class CapacityNetwork : public Network
     const VertexDescriptor               theSource;
   };
 
-  static bool checkCapacity(const VertexDescriptor               aSrc,
-                            const std::vector<VertexDescriptor>& aPath,
-                            const double                         aCapacity,
-                            const Graph&                         aGraph);
+  /**
+   * @brief Predicate of the edges of theGraph that are enabled in the CSR
+   * snapshot, to hide the disabled ones from the BGL algorithms.
+   */
+  struct EnabledEdge {
+    bool operator()(const EdgeDescriptor& aEdge) const {
+      return theCsr->enabled(boost::get(boost::edge_index, *theGraph, aEdge));
+    }
+    const Graph*    theGraph = nullptr;
+    const CsrGraph* theCsr   = nullptr;
+  };
+  using EnabledGraph = boost::filtered_graph<Graph, EnabledEdge>;
+
+  //! \return a view of theGraph with only the enabled edges.
+  EnabledGraph enabledGraph() const;
+
+  /**
+   * @brief Find the edge between two vertices used to change the capacity.
+   *
+   * @param aSrc The source vertex.
+   * @param aDst The target vertex.
+   * @return the first enabled edge, if any, otherwise the first disabled one,
+   * and true if found, or false otherwise.
+   */
+  std::pair<CsrGraph::EdgeId, bool>
+  findCsrEdge(const VertexDescriptor aSrc, const VertexDescriptor aDst) const;
 
   /**
    * @brief Find the minimum capacity along a path in a graph.
@@ -251,32 +410,122 @@ class CapacityNetwork : public Network
    */
   static double minCapacity(const Path& aPath, const Graph& aGraph);
 
-  static void
-  removeSmallestCapacityEdge(const VertexDescriptor               aSrc,
-                             const std::vector<VertexDescriptor>& aPath,
-                             Graph&                               aGraph);
-
   /**
    * @brief Remove the capacity from all the edges along a path.
    *
+   * The changes are written through to the CSR snapshot. A disabled edge
+   * is only found when adding capacity, i.e., with a negative aCapacity, in
+   * which case it is enabled again if its residual capacity becomes at least
+   * the minimum capacity with which it was disabled.
+   *
    * @param aSrc The source node.
    * @param aPath The path.
    * @param aCapacity The capacity to be subtracted.
-   * @param aMinCapacity If specified,remove the edge with a smaller residual.
-   * @param aGraph The graph.
+   * @param aMinCapacity If specified, disable the edges with a smaller
+   * residual.
    */
-  static void removeCapacityFromPath(const VertexDescriptor               aSrc,
-                                     const std::vector<VertexDescriptor>& aPath,
-                                     const double                aCapacity,
-                                     const std::optional<double> aMinCapacity,
-                                     Graph&                      aGraph);
+  void removeCapacityFromPath(const VertexDescriptor               aSrc,
+                              const std::vector<VertexDescriptor>& aPath,
+                              const double                         aCapacity,
+                              const std::optional<double> aMinCapacity);
 
-  std::pair<std::size_t, std::size_t> minMaxVertexProp(
-      const std::function<std::size_t(Graph::vertex_descriptor, const Graph&)>&
-          aPropFunctor) const;
+  /**
+   * @brief Remove capacity from an edge, both in the CSR snapshot and in the
+   * graph.
+   *
+   * A disabled edge is enabled again if its residual capacity is at least
+   * the minimum capacity with which it was disabled.
+   *
+   * @param aEdge The edge identifier.
+   * @param aCapacity The capacity to be subtracted.
+   * @return double The residual capacity of the edge.
+   */
+  double removeCapacityFromEdge(const CsrGraph::EdgeId aEdge,
+                                const double           aCapacity);
+
+  /**
+   * @brief Remove capacity from an edge in the CSR snapshot only.
+   *
+   * The graph is updated only upon a call to commitCsr().
+   *
+   * @param aEdge The edge identifier, which must be enabled.
+   * @param aCapacity The capacity to be subtracted.
+   * @return double The residual capacity of the edge.
+   */
+  double removeCsrCapacity(const CsrGraph::EdgeId aEdge,
+                           const double           aCapacity);
+
+  /**
+   * @brief Disable an edge in the CSR snapshot, which is also hidden from
+   * the graph consumers.
+   *
+   * @param aEdge The edge identifier, which must be enabled.
+   * @param aMinCapacity The edge is enabled again only when its residual
+   * capacity becomes at least this value.
+   */
+  void disableCsrEdge(const CsrGraph::EdgeId aEdge, const double aMinCapacity);
+
+  /**
+   * @brief Enable again an edge in the CSR snapshot.
+   *
+   * @param aEdge The edge identifier, which must be disabled.
+   */
+  void enableCsrEdge(const CsrGraph::EdgeId aEdge);
+
+  //! Write the capacities of the CSR snapshot back to the graph.
+  void commitCsr();
+
+  //! Create the CSR snapshot from the current graph.
+  void makeCsr();
+
+  /**
+   * @brief Update the aggregate capacities after a change of an edge, which
+   * must have been already applied to the CSR snapshot.
+   */
+  void updateCapacities(const CsrGraph::EdgeId aEdge, const double aDelta);
+
+  //! Compute the aggregate capacities from the CSR snapshot.
+  void computeCapacities();
+
+  //! \return the minimum and maximum number of enabled edges per vertex, as
+  //! given by a functor called with the CSR snapshot and the edge identifier.
+  template <class VERTEX>
+  std::pair<std::size_t, std::size_t>
+  minMaxDegree(VERTEX&& aVertexFunctor) const;
 
  protected:
   Graph theGraph;
+
+  // read-optimized copy of theGraph used by the searches: the out-edges
+  // of every vertex are in the same order as in theGraph and the edges with no
+  // capacity left are disabled in the snapshot, while they are kept in
+  // theGraph, so that they can be enabled again; a batch of changes can be
+  // applied to the snapshot only and then committed to theGraph at once with
+  // commitCsr()
+  CsrGraph theCsr;
+
+  // the edges of theGraph, indexed by CSR edge identifier
+  std::vector<EdgeDescriptor> theDescriptors;
+
+  // the rank of every edge, indexed by CSR edge identifier, in the order by
+  // source, target and CSR edge identifier: it breaks the ties between paths
+  // with the same length, so that the same paths are found in every run
+  std::vector<std::size_t> theRanks;
+
+  // the minimum capacity with which every disabled edge has been disabled,
+  // indexed by CSR edge identifier, undefined for the enabled edges
+  std::vector<double> theMinCapacities;
+
+ private:
+  std::uint64_t theTopologyVersion;
+
+  // the aggregate capacities of the enabled edges are updated incrementally
+  // and computed again from scratch after as many updates as the number of
+  // edges, to bound the floating point error accumulated with an amortized
+  // O(1) cost
+  double              theTotalCapacity;
+  std::vector<double> theNodeCapacities;
+  std::size_t         theNumCapacityUpdates;
 };
 
 } // namespace qr
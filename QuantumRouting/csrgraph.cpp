@@ -0,0 +1,561 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/csrgraph.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/taskscheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+// the d-ary heap below reproduces exactly the behavior of the priority queue
+// boost::d_ary_heap_indirect<> used by boost::dijkstra_shortest_paths(), but
+// without decrease-key, which is not needed with unit weights
+
+constexpr std::size_t HEAP_ARITY = 4;
+
+void heapPush(std::vector<std::size_t>&       aHeap,
+              const std::vector<std::size_t>& aDistances,
+              const std::size_t               aValue) {
+  const auto myDistance = aDistances[aValue];
+  auto       myIndex    = aHeap.size();
+  aHeap.emplace_back(aValue);
+  while (myIndex > 0) {
+    const auto myParent = (myIndex - 1) / HEAP_ARITY;
+    if (not(myDistance < aDistances[aHeap[myParent]])) {
+      break;
+    }
+    aHeap[myIndex] = aHeap[myParent];
+    myIndex        = myParent;
+  }
+  aHeap[myIndex] = aValue;
+}
+
+std::size_t heapPop(std::vector<std::size_t>&       aHeap,
+                    const std::vector<std::size_t>& aDistances) {
+  assert(not aHeap.empty());
+  const auto ret     = aHeap.front();
+  const auto myMoved = aHeap.back();
+  aHeap.pop_back();
+  if (aHeap.empty()) {
+    return ret;
+  }
+
+  // move the last element to the root and then sift it down
+  const auto  myDistance = aDistances[myMoved];
+  const auto  mySize     = aHeap.size();
+  std::size_t myIndex    = 0;
+  while (true) {
+    const auto myFirstChild = myIndex * HEAP_ARITY + 1;
+    if (myFirstChild >= mySize) {
+      break;
+    }
+    const auto myLastChild = std::min(myFirstChild + HEAP_ARITY, mySize);
+    auto       mySmallest  = myFirstChild;
+    for (auto c = myFirstChild + 1; c < myLastChild; c++) {
+      if (aDistances[aHeap[c]] < aDistances[aHeap[mySmallest]]) {
+        mySmallest = c;
+      }
+    }
+    if (not(aDistances[aHeap[mySmallest]] < myDistance)) {
+      break;
+    }
+    aHeap[myIndex] = aHeap[mySmallest];
+    myIndex        = mySmallest;
+  }
+  aHeap[myIndex] = myMoved;
+  return ret;
+}
+
+} // namespace
+
+CsrGraph::CsrGraph()
+    : theOffsets({0})
+    , theSources()
+    , theTargets()
+    , theCapacities()
+    , theEnabled() {
+  // noop
+}
+
+CsrGraph::CsrGraph(const std::size_t aNumVertices, const WeightVector& aEdges)
+    : theOffsets(aNumVertices + 1, 0)
+    , theSources()
+    , theTargets()
+    , theCapacities()
+    , theEnabled(aEdges.size(), true) {
+  theSources.reserve(aEdges.size());
+  theTargets.reserve(aEdges.size());
+  theCapacities.reserve(aEdges.size());
+
+  std::size_t myPrevSource = 0;
+  for (const auto& myEdge : aEdges) {
+    const auto mySrc = std::get<0>(myEdge);
+    const auto myDst = std::get<1>(myEdge);
+    if (mySrc >= aNumVertices or myDst >= aNumVertices) {
+      throw std::runtime_error("invalid edge (" + std::to_string(mySrc) + "," +
+                               std::to_string(myDst) + ") with " +
+                               std::to_string(aNumVertices) + " vertices");
+    }
+    if (mySrc < myPrevSource) {
+      throw std::runtime_error("edges not sorted by source vertex");
+    }
+    myPrevSource = mySrc;
+    theOffsets[mySrc + 1]++;
+    theSources.emplace_back(mySrc);
+    theTargets.emplace_back(myDst);
+    theCapacities.emplace_back(std::get<2>(myEdge));
+  }
+
+  // turn the out-degrees into offsets
+  for (std::size_t v = 0; v < aNumVertices; v++) {
+    theOffsets[v + 1] += theOffsets[v];
+  }
+  assert(theOffsets.back() == aEdges.size());
+}
+
+std::pair<CsrGraph::EdgeId, bool>
+CsrGraph::findEdge(const std::size_t aSrc,
+                   const std::size_t aDst) const noexcept {
+  assert(aSrc < numVertices());
+  for (auto e = theOffsets[aSrc]; e < theOffsets[aSrc + 1]; e++) {
+    if (theTargets[e] == aDst and theEnabled[e]) {
+      return {e, true};
+    }
+  }
+  return {0, false};
+}
+
+std::pair<CsrGraph::EdgeId, bool>
+CsrGraph::findEdge(const std::size_t aSrc,
+                   const std::size_t aDst,
+                   const Scratch&    aScratch) const noexcept {
+  assert(aSrc < numVertices());
+  const auto& myExcluded = aScratch.theExcluded;
+  for (auto e = theOffsets[aSrc]; e < theOffsets[aSrc + 1]; e++) {
+    if (theTargets[e] == aDst and theEnabled[e] and
+        (myExcluded.empty() or not myExcluded[e])) {
+      return {e, true};
+    }
+  }
+  return {0, false};
+}
+
+void CsrGraph::restore(const std::vector<double>& aCapacities,
+                       const std::vector<bool>&   aEnabled) {
+  if (aCapacities.size() != numEdges() or aEnabled.size() != numEdges()) {
+    throw std::runtime_error("cannot restore " +
+                             std::to_string(aCapacities.size()) +
+                             " capacities and " +
+                             std::to_string(aEnabled.size()) +
+                             " flags into a graph with " +
+                             std::to_string(numEdges()) + " edges");
+  }
+  std::copy(aCapacities.begin(), aCapacities.end(), theCapacities.begin());
+  theEnabled = aEnabled;
+}
+
+void CsrGraph::exclude(const EdgeId aEdge, Scratch& aScratch) const {
+  assert(aEdge < numEdges());
+  if (aScratch.theExcluded.size() != numEdges()) {
+    aScratch.theExcluded.assign(numEdges(), false);
+    aScratch.theExcludedEdges.clear();
+  }
+  if (not aScratch.theExcluded[aEdge]) {
+    aScratch.theExcluded[aEdge] = true;
+    aScratch.theExcludedEdges.emplace_back(aEdge);
+  }
+}
+
+void CsrGraph::excludeVertex(const std::size_t aVertex,
+                             Scratch&          aScratch) const {
+  assert(aVertex < numVertices());
+  if (aScratch.theVertexExcluded.size() != numVertices()) {
+    aScratch.theVertexExcluded.assign(numVertices(), false);
+    aScratch.theExcludedVertices.clear();
+  }
+  if (not aScratch.theVertexExcluded[aVertex]) {
+    aScratch.theVertexExcluded[aVertex] = true;
+    aScratch.theExcludedVertices.emplace_back(aVertex);
+  }
+}
+
+void CsrGraph::clearExcluded(Scratch& aScratch) const {
+  if (aScratch.theExcluded.size() == numEdges()) {
+    for (const auto e : aScratch.theExcludedEdges) {
+      aScratch.theExcluded[e] = false;
+    }
+  } else {
+    aScratch.theExcluded.clear();
+  }
+  aScratch.theExcludedEdges.clear();
+  if (aScratch.theVertexExcluded.size() == numVertices()) {
+    for (const auto v : aScratch.theExcludedVertices) {
+      aScratch.theVertexExcluded[v] = false;
+    }
+  } else {
+    aScratch.theVertexExcluded.clear();
+  }
+  aScratch.theExcludedVertices.clear();
+}
+
+void CsrGraph::hopDistances(const std::size_t         aSource,
+                            std::vector<std::size_t>& aDistances) const {
+  const auto V = numVertices();
+  assert(aSource < V);
+  aDistances.assign(V, INFINITE_DISTANCE);
+  Instrumentation::count(Instrumentation::Counter::PathSearches);
+  Instrumentation::LocalCounter myRelaxed(
+      Instrumentation::Counter::EdgesRelaxed);
+
+  // the vector is used as a FIFO queue: every vertex is pushed at most once
+  std::vector<std::size_t> myQueue;
+  myQueue.reserve(V);
+  Instrumentation::count(Instrumentation::Counter::Allocations);
+  myQueue.emplace_back(aSource);
+  aDistances[aSource] = 0;
+  for (std::size_t myHead = 0; myHead < myQueue.size(); myHead++) {
+    const auto u = myQueue[myHead];
+    for (auto e = theOffsets[u]; e < theOffsets[u + 1]; e++) {
+      ++myRelaxed;
+      const auto v = theTargets[e];
+      if (theEnabled[e] and aDistances[v] == INFINITE_DISTANCE) {
+        aDistances[v] = aDistances[u] + 1;
+        myQueue.emplace_back(v);
+      }
+    }
+  }
+}
+
+CompactReachableNodes
+CsrGraph::reachableNodes(const std::size_t aMinHops,
+                         const std::size_t aMaxHops,
+                         const std::size_t aNumThreads,
+                         std::size_t&      aDiameter) const {
+  static constexpr std::size_t BATCH = 64;
+
+  const auto            V = numVertices();
+  CompactReachableNodes ret(V);
+  const auto            myNumBatches = (V + BATCH - 1) / BATCH;
+
+  // every batch of sources only modifies the rows of the corresponding
+  // sources in the output, and its own diameter
+  std::vector<std::size_t> myDiameters(std::max<std::size_t>(1, myNumBatches),
+                                       0);
+  const auto myBatches = [&](const std::size_t aFirstBatch,
+                             const std::size_t aLastBatch) {
+    // bit k refers to the k-th source of the current batch
+    std::vector<std::uint64_t> myVisited(V);
+    std::vector<std::uint64_t> myFrontier(V);
+    std::vector<std::uint64_t> myNext(V);
+    Instrumentation::count(Instrumentation::Counter::Allocations, 3);
+    Instrumentation::LocalCounter myRelaxed(
+        Instrumentation::Counter::EdgesRelaxed);
+    for (auto b = aFirstBatch; b < aLastBatch; b++) {
+      const auto myFirst = b * BATCH;
+      const auto myLast  = std::min(V, myFirst + BATCH);
+      Instrumentation::count(Instrumentation::Counter::PathSearches,
+                             myLast - myFirst);
+
+      std::fill(myVisited.begin(), myVisited.end(), 0);
+      std::fill(myFrontier.begin(), myFrontier.end(), 0);
+      for (auto s = myFirst; s < myLast; s++) {
+        myVisited[s] = myFrontier[s] = std::uint64_t(1) << (s - myFirst);
+      }
+
+      for (std::size_t d = 1; true; d++) {
+        // expand the frontier by one hop for all the sources at once
+        for (std::size_t u = 0; u < V; u++) {
+          if (myFrontier[u] == 0) {
+            continue;
+          }
+          for (auto e = theOffsets[u]; e < theOffsets[u + 1]; e++) {
+            ++myRelaxed;
+            if (theEnabled[e]) {
+              myNext[theTargets[e]] |= myFrontier[u];
+            }
+          }
+        }
+
+        // keep only the sources that have never reached the vertex before
+        auto myEmpty = true;
+        for (std::size_t v = 0; v < V; v++) {
+          auto& myBits = myNext[v];
+          myBits &= ~myVisited[v];
+          if (myBits == 0) {
+            continue;
+          }
+          myEmpty = false;
+          myVisited[v] |= myBits;
+          if (d >= aMinHops and d <= aMaxHops) {
+            for (auto myWord = myBits; myWord != 0; myWord &= myWord - 1) {
+              ret.set(myFirst + __builtin_ctzll(myWord), v);
+            }
+          }
+        }
+        if (myEmpty) {
+          break;
+        }
+        myDiameters[b] = std::max(myDiameters[b], d);
+        myFrontier.swap(myNext);
+        std::fill(myNext.begin(), myNext.end(), 0);
+      }
+    }
+  };
+  parallelFor(0, myNumBatches, aNumThreads, myBatches);
+
+  aDiameter = *std::max_element(myDiameters.begin(), myDiameters.end());
+  return ret;
+}
+
+void CsrGraph::shortestPathTree(const std::size_t         aSource,
+                                const double              aMinCapacity,
+                                std::vector<std::size_t>& aPredecessors) const {
+  Scratch myScratch;
+  search(aSource, aMinCapacity, nullptr, INFINITE_DISTANCE, myScratch);
+  aPredecessors.swap(myScratch.thePredecessors);
+}
+
+void CsrGraph::shortestPathTree(const std::size_t              aSource,
+                                const double                   aMinCapacity,
+                                const std::set<unsigned long>& aDestinations,
+                                Scratch&                       aScratch,
+                                const std::size_t aMaxHops) const {
+  search(aSource, aMinCapacity, &aDestinations, aMaxHops, aScratch);
+}
+
+void CsrGraph::search(const std::size_t              aSource,
+                      const double                   aMinCapacity,
+                      const std::set<unsigned long>* aDestinations,
+                      const std::size_t              aMaxHops,
+                      Scratch&                       aScratch) const {
+  const auto V = numVertices();
+  assert(aSource < V);
+
+  auto& myDistances    = aScratch.theDistances;
+  auto& myPredecessors = aScratch.thePredecessors;
+  auto& myHeap         = aScratch.theHeap;
+  auto& myVisited      = aScratch.theVisited;
+  auto& myExcluded     = aScratch.theExcluded;
+  auto& myVertexExcl   = aScratch.theVertexExcluded;
+
+  Instrumentation::count(Instrumentation::Counter::PathSearches);
+  Instrumentation::LocalCounter myRelaxed(
+      Instrumentation::Counter::EdgesRelaxed);
+
+  // clear the state left by the previous search, if any: every vertex is
+  // visited at most once, hence neither the heap nor the list of visited
+  // vertices can grow beyond V
+  if (myDistances.size() != V or myPredecessors.size() != V) {
+    myDistances.assign(V, INFINITE_DISTANCE);
+    myPredecessors.resize(V);
+    for (std::size_t v = 0; v < V; v++) {
+      myPredecessors[v] = v;
+    }
+    myHeap.reserve(V);
+    myVisited.reserve(V);
+    Instrumentation::count(Instrumentation::Counter::Allocations);
+  } else {
+    for (const auto v : myVisited) {
+      myDistances[v]    = INFINITE_DISTANCE;
+      myPredecessors[v] = v;
+    }
+  }
+  myHeap.clear();
+  myVisited.clear();
+  if (myExcluded.size() != numEdges()) {
+    myExcluded.assign(numEdges(), false);
+    aScratch.theExcludedEdges.clear();
+    Instrumentation::count(Instrumentation::Counter::Allocations);
+  }
+  if (myVertexExcl.size() != V) {
+    myVertexExcl.assign(V, false);
+    aScratch.theExcludedVertices.clear();
+    Instrumentation::count(Instrumentation::Counter::Allocations);
+  }
+
+  // number of destinations still to be discovered
+  auto myRemaining = std::numeric_limits<std::size_t>::max();
+  if (aDestinations != nullptr) {
+    myRemaining = 0;
+    for (const auto v : *aDestinations) {
+      assert(v < V);
+      if (v != aSource) {
+        myRemaining++;
+      }
+    }
+    if (myRemaining == 0) {
+      return;
+    }
+  }
+
+  // since all the weights are unitary a vertex is never relaxed after being
+  // discovered, hence the visit order only depends on the heap and the
+  // out-edge order; also, the vertices are popped in non-decreasing distance,
+  // hence the search can stop at the first one at the maximum distance
+  myDistances[aSource] = 0;
+  myVisited.emplace_back(aSource);
+  heapPush(myHeap, myDistances, aSource);
+  while (not myHeap.empty()) {
+    const auto u = heapPop(myHeap, myDistances);
+    if (myDistances[u] >= aMaxHops) {
+      return;
+    }
+    for (auto e = theOffsets[u]; e < theOffsets[u + 1]; e++) {
+      ++myRelaxed;
+      const auto v = theTargets[e];
+      if (theEnabled[e] and not myExcluded[e] and not myVertexExcl[v] and
+          theCapacities[e] >= aMinCapacity and
+          myDistances[v] == INFINITE_DISTANCE) {
+        myDistances[v]    = myDistances[u] + 1;
+        myPredecessors[v] = u;
+        myVisited.emplace_back(v);
+        heapPush(myHeap, myDistances, v);
+
+        if (aDestinations != nullptr and aDestinations->count(v) > 0 and
+            --myRemaining == 0) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+bool CsrGraph::shortestFeasiblePath(
+    const std::size_t                               aSource,
+    const std::size_t                               aTarget,
+    const std::function<double(const std::size_t)>& aMinCapacity,
+    LayeredScratch&                                 aScratch,
+    std::vector<unsigned long>&                     aPath,
+    const std::size_t                               aMaxHops) const {
+  static constexpr auto NO_LABEL = std::numeric_limits<std::size_t>::max();
+  static constexpr auto INF      = std::numeric_limits<double>::infinity();
+
+  const auto V = numVertices();
+  assert(aSource < V);
+  assert(aTarget < V);
+  assert(aSource != aTarget);
+
+  auto& myLabels  = aScratch.theLabels;
+  auto& myBest    = aScratch.theBest;
+  auto& myLast    = aScratch.theLast;
+  auto& myVisited = aScratch.theVisited;
+
+  Instrumentation::count(Instrumentation::Counter::PathSearches);
+  Instrumentation::LocalCounter myRelaxed(
+      Instrumentation::Counter::EdgesRelaxed);
+
+  // clear the state left by the previous search, if any
+  if (myBest.size() != V or myLast.size() != V) {
+    myBest.assign(V, -INF);
+    myLast.assign(V, NO_LABEL);
+    myVisited.reserve(V);
+    Instrumentation::count(Instrumentation::Counter::Allocations);
+  } else {
+    for (const auto v : myVisited) {
+      myBest[v] = -INF;
+      myLast[v] = NO_LABEL;
+    }
+  }
+  myVisited.clear();
+  myLabels.clear();
+  aPath.clear();
+
+  // myBest[v] is the largest bottleneck capacity of the partial paths found
+  // so far to v, in any previous layer or in the current one, while
+  // myLast[v] is the index of the last label of v
+  myBest[aSource] = INF;
+  myVisited.emplace_back(aSource);
+  myLabels.emplace_back(LayeredScratch::Label{aSource, NO_LABEL, INF});
+
+  // the labels of the previous layer are in [myBegin, myEnd)
+  std::size_t myBegin = 0;
+  std::size_t myEnd   = myLabels.size();
+  for (std::size_t h = 1; myBegin < myEnd and h <= aMaxHops; h++) {
+    const auto myMinCapacity = aMinCapacity(h);
+    for (auto i = myBegin; i < myEnd; i++) {
+      const auto u            = myLabels[i].theVertex;
+      const auto myBottleneck = myLabels[i].theBottleneck;
+      if (myBottleneck < myMinCapacity) {
+        continue;
+      }
+      for (auto e = theOffsets[u]; e < theOffsets[u + 1]; e++) {
+        ++myRelaxed;
+        if (not theEnabled[e] or theCapacities[e] < myMinCapacity) {
+          continue;
+        }
+        const auto v = theTargets[e];
+        const auto b = std::min(myBottleneck, theCapacities[e]);
+        if (not(b > myBest[v])) {
+          continue; // dominated
+        }
+        if (myBest[v] == -INF) {
+          myVisited.emplace_back(v);
+        }
+        myBest[v] = b;
+
+        if (myLast[v] != NO_LABEL and myLast[v] >= myEnd) {
+          // v already reached in this layer with a smaller bottleneck
+          myLabels[myLast[v]].theParent     = i;
+          myLabels[myLast[v]].theBottleneck = b;
+        } else {
+          myLast[v] = myLabels.size();
+          myLabels.emplace_back(LayeredScratch::Label{v, i, b});
+        }
+
+        if (v == aTarget) {
+          // the first path found is feasible: compose it bottom-up
+          aPath.resize(h);
+          for (auto j = myLast[v]; j != 0; j = myLabels[j].theParent) {
+            assert(h > 0);
+            aPath[--h] = myLabels[j].theVertex;
+          }
+          assert(h == 0);
+          return true;
+        }
+      }
+    }
+    myBegin = myEnd;
+    myEnd   = myLabels.size();
+  }
+
+  return false;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,350 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/reachablenodes.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief A read-optimized snapshot of a directed graph in Compressed Sparse
+ * Row (CSR) format.
+ *
+ * The out-edges of vertex v occupy the contiguous range of positions
+ * [offset(v), offset(v+1)) of the per-edge arrays, in the same order as they
+ * appear in the adjacency list from which the snapshot is made. The position
+ * of an edge in the per-edge arrays is also its identifier, i.e., the targets
+ * and the capacities are both indexed by edge identifier.
+ *
+ * The topology cannot be changed after construction: only the capacities
+ * can be modified and edges can be disabled, which is equivalent to removing
+ * them for the purpose of all the searches.
+ */
+class CsrGraph final
+{
+ public:
+  using EdgeId = std::size_t;
+
+  // vector of (src, dst, weight)
+  using WeightVector =
+      std::vector<std::tuple<unsigned long, unsigned long, double>>;
+
+  //! Distance of vertices that cannot be reached.
+  static constexpr std::size_t INFINITE_DISTANCE =
+      std::numeric_limits<std::size_t>::max();
+
+  /**
+   * @brief Working memory of the searches.
+   *
+   * The same object can be reused across searches, also on different graphs:
+   * memory is only allocated the first time it is used with a graph of a given
+   * size, after which a search only touches the entries of the vertices
+   * visited by the previous one.
+   *
+   * Edges and vertices can be excluded from the searches using a given
+   * working memory, without modifying the graph, with exclude() and
+   * excludeVertex().
+   */
+  struct Scratch {
+    std::vector<std::size_t> theDistances;
+    std::vector<std::size_t> thePredecessors;
+    std::vector<std::size_t> theHeap;
+    std::vector<std::size_t> theVisited;
+    std::vector<char>        theExcluded;
+    std::vector<EdgeId>      theExcludedEdges;
+    std::vector<char>        theVertexExcluded;
+    std::vector<std::size_t> theExcludedVertices;
+  };
+
+  /**
+   * @brief Working memory of shortestFeasiblePath(), with the same reuse
+   * properties as Scratch.
+   */
+  struct LayeredScratch {
+    struct Label {
+      std::size_t theVertex;
+      std::size_t theParent; //!< index of the parent label
+      double      theBottleneck;
+    };
+    std::vector<Label>       theLabels;
+    std::vector<double>      theBest;
+    std::vector<std::size_t> theLast;
+    std::vector<std::size_t> theVisited;
+  };
+
+  //! Create an empty graph.
+  CsrGraph();
+
+  /**
+   * @brief Create a graph from a list of directed edges.
+   *
+   * @param aNumVertices The number of vertices.
+   * @param aEdges The edges (src, dst, capacity), sorted by source.
+   *
+   * @throw std::runtime_error if the edges are not sorted by source or if they
+   * refer to non-existing vertices.
+   */
+  explicit CsrGraph(const std::size_t aNumVertices, const WeightVector& aEdges);
+
+  //! \return the number of vertices.
+  std::size_t numVertices() const noexcept {
+    return theOffsets.size() - 1;
+  }
+
+  //! \return the number of edges, including the disabled ones.
+  std::size_t numEdges() const noexcept {
+    return theTargets.size();
+  }
+
+  //! \return the range of identifiers of the out-edges of a vertex.
+  std::pair<EdgeId, EdgeId> outEdges(const std::size_t aVertex) const noexcept {
+    return {theOffsets[aVertex], theOffsets[aVertex + 1]};
+  }
+
+  //! \return the source vertex of an edge.
+  std::size_t source(const EdgeId aEdge) const noexcept {
+    return theSources[aEdge];
+  }
+
+  //! \return the target vertex of an edge.
+  std::size_t target(const EdgeId aEdge) const noexcept {
+    return theTargets[aEdge];
+  }
+
+  //! \return the capacity of an edge.
+  double capacity(const EdgeId aEdge) const noexcept {
+    return theCapacities[aEdge];
+  }
+
+  //! Set the capacity of an edge.
+  void capacity(const EdgeId aEdge, const double aCapacity) noexcept {
+    theCapacities[aEdge] = aCapacity;
+  }
+
+  //! \return true if the edge has not been disabled.
+  bool enabled(const EdgeId aEdge) const noexcept {
+    return theEnabled[aEdge];
+  }
+
+  //! Disable an edge, which is then ignored by all searches.
+  void disable(const EdgeId aEdge) noexcept {
+    theEnabled[aEdge] = false;
+  }
+
+  //! Enable again an edge that has been disabled.
+  void enable(const EdgeId aEdge) noexcept {
+    theEnabled[aEdge] = true;
+  }
+
+  //! \return the capacities of all the edges, indexed by edge identifier.
+  const std::vector<double>& capacities() const noexcept {
+    return theCapacities;
+  }
+
+  //! \return the enabled flags of all the edges, indexed by edge identifier.
+  const std::vector<bool>& enabledEdges() const noexcept {
+    return theEnabled;
+  }
+
+  /**
+   * @brief Overwrite the capacities and the enabled flags of all the edges.
+   *
+   * No memory is allocated, since the topology does not change.
+   *
+   * @param aCapacities The new capacities, indexed by edge identifier.
+   * @param aEnabled The new enabled flags, indexed by edge identifier.
+   *
+   * @throw std::runtime_error if the sizes do not match the number of edges.
+   */
+  void restore(const std::vector<double>& aCapacities,
+               const std::vector<bool>&   aEnabled);
+
+  /**
+   * @brief Find the first enabled edge between two vertices.
+   *
+   * @param aSrc The source vertex.
+   * @param aDst The target vertex.
+   * @return the edge identifier and true if found, or false otherwise.
+   */
+  std::pair<EdgeId, bool> findEdge(const std::size_t aSrc,
+                                   const std::size_t aDst) const noexcept;
+
+  //! Same as above, but skip the edges excluded in the working memory.
+  std::pair<EdgeId, bool> findEdge(const std::size_t aSrc,
+                                   const std::size_t aDst,
+                                   const Scratch&    aScratch) const noexcept;
+
+  //! Exclude an edge from the searches that use a given working memory.
+  void exclude(const EdgeId aEdge, Scratch& aScratch) const;
+
+  //! Exclude a vertex from the searches that use a given working memory,
+  //! i.e., it is never reached, unless it is the source.
+  void excludeVertex(const std::size_t aVertex, Scratch& aScratch) const;
+
+  //! Remove all the exclusions, of edges and vertices, from a working memory.
+  void clearExcluded(Scratch& aScratch) const;
+
+  /**
+   * @brief Find the distance, in hops, of all vertices from a source with a
+   * breadth-first search on the enabled edges.
+   *
+   * @param aSource The source vertex.
+   * @param aDistances The distances found, one per vertex. Vertices that are
+   * not reachable have distance INFINITE_DISTANCE.
+   */
+  void hopDistances(const std::size_t         aSource,
+                    std::vector<std::size_t>& aDistances) const;
+
+  /**
+   * @brief Find, for each vertex, the vertices within a given hop distance
+   * range following the enabled edges.
+   *
+   * The breadth-first searches from 64 sources are run together in a single
+   * pass, with one bit per source in the frontier of each vertex, and
+   * different groups of sources are handled by different threads: those of
+   * the task scheduler running the caller, if any, see parallelFor().
+   *
+   * @param aMinHops The minimum distance, in hops.
+   * @param aMaxHops The maximum distance, in hops.
+   * @param aNumThreads The number of threads to be used if not called from
+   * a task of a TaskScheduler, if 0 use as many threads as the hardware
+   * concurrency.
+   * @param aDiameter Return the maximum distance between any two vertices
+   * connected by a path, in hops.
+   * @return the set of vertices within range from each vertex, which never
+   * includes the vertex itself.
+   */
+  CompactReachableNodes reachableNodes(const std::size_t aMinHops,
+                                       const std::size_t aMaxHops,
+                                       const std::size_t aNumThreads,
+                                       std::size_t&      aDiameter) const;
+
+  /**
+   * @brief Find the shortest path tree, in hops, from a source by following
+   * only the enabled edges with a minimum capacity.
+   *
+   * The vertices are visited exactly in the same order as
+   * boost::dijkstra_shortest_paths() would do with unit weights on the
+   * adjacency list from which this snapshot was made, so that ties between
+   * paths with the same length are broken in the same way.
+   *
+   * @param aSource The source vertex.
+   * @param aMinCapacity The minimum capacity of the edges traversed.
+   * @param aPredecessors The predecessor of each vertex along the shortest
+   * path from the source. A vertex is its own predecessor if it is the source
+   * or if it cannot be reached.
+   */
+  void shortestPathTree(const std::size_t         aSource,
+                        const double              aMinCapacity,
+                        std::vector<std::size_t>& aPredecessors) const;
+
+  /**
+   * @brief Same as above but stop as soon as all the destinations have been
+   * reached, without allocating memory if aScratch has been already used.
+   *
+   * Since a vertex is never relaxed after being discovered, the predecessors
+   * of the destinations, and of all the vertices along their shortest paths,
+   * are the same as with the full search.
+   *
+   * @param aSource The source vertex.
+   * @param aMinCapacity The minimum capacity of the edges traversed.
+   * @param aDestinations The destinations.
+   * @param aScratch The working memory of the search. After the call its
+   * member thePredecessors holds the predecessor of each vertex, which is
+   * only meaningful for the vertices along the paths to the destinations.
+   * @param aMaxHops The search does not go beyond this distance, in hops,
+   * hence the destinations that are farther are considered unreachable.
+   */
+  void shortestPathTree(
+      const std::size_t              aSource,
+      const double                   aMinCapacity,
+      const std::set<unsigned long>& aDestinations,
+      Scratch&                       aScratch,
+      const std::size_t              aMaxHops = INFINITE_DISTANCE) const;
+
+  /**
+   * @brief Find the shortest path, in hops, between two vertices whose
+   * edges all have a minimum capacity that depends on the length of the path.
+   *
+   * The search proceeds in layers: at layer h, it extends the partial paths
+   * of h - 1 hops found in the previous layer only via the edges that satisfy
+   * the requirement for h hops. A partial path is dropped if it is dominated
+   * by one to the same vertex with fewer hops and no less bottleneck
+   * capacity. Since the requirement does not decrease with the length, every
+   * edge that is discarded at a given layer could not be used at any later
+   * layer either, hence the path found, if any, is the shortest feasible one.
+   *
+   * @param aSource The source vertex.
+   * @param aTarget The target vertex, which must be different from aSource.
+   * @param aMinCapacity The minimum capacity required for all the edges of a
+   * path with the given number of hops, which must be non-decreasing.
+   * @param aScratch The working memory of the search.
+   * @param aPath The path found, not including the source, or empty.
+   * @param aMaxHops The maximum number of hops of the path: the search stops
+   * at the layer with this number of hops.
+   * @return true if a feasible path has been found.
+   */
+  bool shortestFeasiblePath(
+      const std::size_t                               aSource,
+      const std::size_t                               aTarget,
+      const std::function<double(const std::size_t)>& aMinCapacity,
+      LayeredScratch&                                 aScratch,
+      std::vector<unsigned long>&                     aPath,
+      const std::size_t aMaxHops = INFINITE_DISTANCE) const;
+
+ private:
+  void search(const std::size_t              aSource,
+              const double                   aMinCapacity,
+              const std::set<unsigned long>* aDestinations,
+              const std::size_t              aMaxHops,
+              Scratch&                       aScratch) const;
+
+ private:
+  std::vector<std::size_t> theOffsets;    //!< size: V + 1
+  std::vector<std::size_t> theSources;    //!< size: E
+  std::vector<std::size_t> theTargets;    //!< size: E
+  std::vector<double>      theCapacities; //!< size: E
+  std::vector<bool>        theEnabled;    //!< size: E
+};
+
+} // namespace qr
+} // namespace uiiit
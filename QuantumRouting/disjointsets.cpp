@@ -0,0 +1,73 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/disjointsets.h"
+
+#include <cassert>
+#include <numeric>
+#include <utility>
+
+namespace uiiit {
+namespace qr {
+
+DisjointSets::DisjointSets(const std::size_t N)
+    : theParents(N)
+    , theSizes(N, 1)
+    , theNumSets(N) {
+  std::iota(theParents.begin(), theParents.end(), 0);
+}
+
+std::size_t DisjointSets::find(std::size_t aElem) {
+  assert(aElem < theParents.size());
+  while (theParents[aElem] != aElem) {
+    theParents[aElem] = theParents[theParents[aElem]];
+    aElem             = theParents[aElem];
+  }
+  return aElem;
+}
+
+bool DisjointSets::merge(const std::size_t aLhs, const std::size_t aRhs) {
+  auto myLhs = find(aLhs);
+  auto myRhs = find(aRhs);
+  if (myLhs == myRhs) {
+    return false;
+  }
+  if (theSizes[myLhs] < theSizes[myRhs]) {
+    std::swap(myLhs, myRhs);
+  }
+  theParents[myRhs] = myLhs;
+  theSizes[myLhs] += theSizes[myRhs];
+  theNumSets--;
+  return true;
+}
+
+} // namespace qr
+} // namespace uiiit
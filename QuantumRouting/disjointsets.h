@@ -0,0 +1,72 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Partition of the integers [0, N) into disjoint sets, which can be
+ * merged, i.e., union-find.
+ *
+ * The sets are merged by size, with path halving, hence any sequence of
+ * operations takes almost linear time.
+ */
+class DisjointSets final
+{
+ public:
+  //! Create N singletons.
+  explicit DisjointSets(const std::size_t N);
+
+  //! \return the representative of the set containing an element.
+  std::size_t find(std::size_t aElem);
+
+  //! Merge the sets containing two elements.
+  //! \return true if they were in different sets.
+  bool merge(const std::size_t aLhs, const std::size_t aRhs);
+
+  //! \return the number of sets.
+  std::size_t numSets() const noexcept {
+    return theNumSets;
+  }
+
+ private:
+  std::vector<std::size_t> theParents;
+  std::vector<std::size_t> theSizes; //!< only meaningful for representatives
+  std::size_t              theNumSets;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,261 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/edgelist.h"
+#include "QuantumRouting/topologycache.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+//! Key of the topologies converted from GraphML files.
+const std::string GRAPHML_KEY = "graphml";
+
+//! Read-only memory mapping of a whole file, released on destruction.
+class MappedFile final
+{
+ public:
+  explicit MappedFile(const std::string& aFilename)
+      : theData(nullptr)
+      , theSize(0) {
+    const auto myFd = ::open(aFilename.c_str(), O_RDONLY);
+    if (myFd < 0) {
+      throw std::runtime_error("cannot open " + aFilename + ": " +
+                               std::strerror(errno));
+    }
+    struct stat myStat;
+    if (::fstat(myFd, &myStat) != 0) {
+      ::close(myFd);
+      throw std::runtime_error("cannot stat " + aFilename + ": " +
+                               std::strerror(errno));
+    }
+    theSize = static_cast<std::size_t>(myStat.st_size);
+    if (theSize > 0) {
+      auto myData = ::mmap(nullptr, theSize, PROT_READ, MAP_PRIVATE, myFd, 0);
+      if (myData == MAP_FAILED) {
+        ::close(myFd);
+        throw std::runtime_error("cannot map " + aFilename + ": " +
+                                 std::strerror(errno));
+      }
+      theData = static_cast<const char*>(myData);
+    }
+    ::close(myFd);
+  }
+
+  ~MappedFile() {
+    if (theData != nullptr) {
+      ::munmap(const_cast<char*>(theData), theSize);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* begin() const noexcept {
+    return theData;
+  }
+  const char* end() const noexcept {
+    return theData + theSize;
+  }
+
+ private:
+  const char* theData;
+  std::size_t theSize;
+};
+
+bool isSeparator(const char c) noexcept {
+  return c == ' ' or c == '\t' or c == ',' or c == '\r';
+}
+
+/**
+ * @brief Parser of the fields of a line, which is not null-terminated.
+ */
+class LineParser final
+{
+ public:
+  LineParser(const char*        aBegin,
+             const char*        aEnd,
+             const std::string& aFilename,
+             const std::size_t  aLine)
+      : theCur(aBegin)
+      , theEnd(aEnd)
+      , theFilename(aFilename)
+      , theLine(aLine) {
+    skip();
+  }
+
+  //! \return true if there are no more fields or the line is a comment.
+  bool done() const noexcept {
+    return theCur == theEnd or *theCur == '#';
+  }
+
+  unsigned long nextUnsigned() {
+    constexpr auto MAX_VALUE = std::numeric_limits<unsigned long>::max();
+    const auto     myBegin   = theCur;
+    unsigned long  ret       = 0;
+    for (; theCur != theEnd and not isSeparator(*theCur); ++theCur) {
+      if (*theCur < '0' or *theCur > '9') {
+        throw error("invalid node identifier");
+      }
+      const unsigned long myDigit = *theCur - '0';
+      if (ret > (MAX_VALUE - myDigit) / 10) {
+        throw error("node identifier out of range");
+      }
+      ret = ret * 10 + myDigit;
+    }
+    if (theCur == myBegin) {
+      throw error("missing node identifier");
+    }
+    skip();
+    return ret;
+  }
+
+  double nextDouble() {
+    // copy the field into a null-terminated buffer for strtod()
+    std::array<char, 64> myBuffer;
+    std::size_t          mySize = 0;
+    for (; theCur != theEnd and not isSeparator(*theCur); ++theCur) {
+      if (mySize == myBuffer.size() - 1) {
+        throw error("weight too long");
+      }
+      myBuffer[mySize++] = *theCur;
+    }
+    if (mySize == 0) {
+      throw error("missing weight");
+    }
+    myBuffer[mySize] = '\0';
+    char*      myEnd = nullptr;
+    const auto ret   = std::strtod(myBuffer.data(), &myEnd);
+    if (myEnd != myBuffer.data() + mySize) {
+      throw error("invalid weight");
+    }
+    skip();
+    return ret;
+  }
+
+  std::runtime_error error(const std::string& aReason) const {
+    return std::runtime_error(aReason + " in " + theFilename + " at line " +
+                              std::to_string(theLine));
+  }
+
+ private:
+  void skip() noexcept {
+    while (theCur != theEnd and isSeparator(*theCur)) {
+      ++theCur;
+    }
+  }
+
+ private:
+  const char*        theCur;
+  const char* const  theEnd;
+  const std::string& theFilename;
+  const std::size_t  theLine;
+};
+
+} // namespace
+
+CapacityNetwork::WeightVector loadEdgeList(const std::string& aFilename) {
+  const MappedFile myFile(aFilename);
+
+  CapacityNetwork::WeightVector ret;
+  ret.reserve(std::count(myFile.begin(), myFile.end(), '\n') + 1);
+
+  std::size_t myLine = 0;
+  for (auto myCur = myFile.begin(); myCur < myFile.end();) {
+    myLine++;
+    const auto myEol = std::find(myCur, myFile.end(), '\n');
+    LineParser myParser(myCur, myEol, aFilename, myLine);
+    if (not myParser.done()) {
+      const auto mySrc    = myParser.nextUnsigned();
+      const auto myDst    = myParser.nextUnsigned();
+      const auto myWeight = myParser.nextDouble();
+      if (not myParser.done()) {
+        throw myParser.error("unexpected fields");
+      }
+      ret.emplace_back(mySrc, myDst, myWeight);
+    }
+    myCur = myEol + 1;
+  }
+
+  VLOG(1) << "loaded " << ret.size() << " edges from " << aFilename;
+  return ret;
+}
+
+void saveEdgeList(const std::string&                   aFilename,
+                  const CapacityNetwork::WeightVector& aEdges) {
+  std::ofstream myStream(aFilename);
+  myStream.precision(std::numeric_limits<double>::max_digits10);
+  for (const auto& myEdge : aEdges) {
+    myStream << std::get<0>(myEdge) << ' ' << std::get<1>(myEdge) << ' '
+             << std::get<2>(myEdge) << '\n';
+  }
+  if (not myStream) {
+    throw std::runtime_error("cannot write the edge list to " + aFilename);
+  }
+}
+
+void convertGraphMl(std::istream& aGraphMl, const std::string& aFilename) {
+  TopologyCache::Topology myTopology;
+  myTopology.theEdges = findLinks(aGraphMl, myTopology.theCoordinates);
+  TopologyCache::writeFile(aFilename, GRAPHML_KEY, myTopology);
+}
+
+std::vector<std::pair<unsigned long, unsigned long>>
+loadConvertedGraphMl(const std::string&       aFilename,
+                     std::vector<Coordinate>& aCoordinates) {
+  TopologyCache::Topology myTopology;
+  if (not TopologyCache::readFile(aFilename, GRAPHML_KEY, myTopology)) {
+    throw std::runtime_error("cannot load the converted GraphML file " +
+                             aFilename);
+  }
+  myTopology.theCoordinates.swap(aCoordinates);
+  return std::move(myTopology.theEdges);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,95 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/qrutils.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Load the edges of a network from a text file.
+ *
+ * Every line contains the source, the destination and the weight of one
+ * unidirectional edge, separated by white spaces or commas. Empty lines and
+ * lines beginning with '#' are ignored.
+ *
+ * The file is memory-mapped and parsed in place, hence it is suitable for
+ * large networks.
+ *
+ * @param aFilename The name of the file.
+ * @return the edges loaded, in the same order as in the file.
+ * @throw std::runtime_error if the file cannot be read or a line is invalid.
+ */
+CapacityNetwork::WeightVector loadEdgeList(const std::string& aFilename);
+
+/**
+ * @brief Save the edges of a network to a text file in the format read by
+ * loadEdgeList().
+ *
+ * @param aFilename The name of the file.
+ * @param aEdges The edges to be saved.
+ * @throw std::runtime_error if the file cannot be written.
+ */
+void saveEdgeList(const std::string&                   aFilename,
+                  const CapacityNetwork::WeightVector& aEdges);
+
+/**
+ * @brief Convert a GraphML file into a binary file in the TopologyCache
+ * format, which can be loaded much faster with loadConvertedGraphMl().
+ *
+ * @param aGraphMl The input GraphML file.
+ * @param aFilename The name of the output file.
+ * @throw std::runtime_error if the output file cannot be written.
+ */
+void convertGraphMl(std::istream& aGraphMl, const std::string& aFilename);
+
+/**
+ * @brief Load a GraphML file converted with convertGraphMl().
+ *
+ * @param aFilename The name of the file.
+ * @param aCoordinates The coordinates of the nodes.
+ * @return the links found, as returned by findLinks() from the original
+ * GraphML file.
+ * @throw std::runtime_error if the file does not exist or is not valid.
+ */
+std::vector<std::pair<unsigned long, unsigned long>>
+loadConvertedGraphMl(const std::string&       aFilename,
+                     std::vector<Coordinate>& aCoordinates);
+
+} // namespace qr
+} // namespace uiiit
@@ -30,14 +30,20 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/kspgenerator.h"
+#include "QuantumRouting/taskscheduler.h"
 
 #include "Support/tostring.h"
 
-#include "yen/yen_ksp.hpp"
-
 #include <glog/logging.h>
 #include <glog/vlog_is_on.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
 namespace uiiit {
 namespace qr {
 
@@ -79,6 +85,39 @@ AppRouteAlgo appRouteAlgofromString(const std::string& aAlgo) {
       ")");
 }
 
+std::vector<FlowRouteAlgo> allFlowRouteAlgos() {
+  static const std::vector<FlowRouteAlgo> myAlgos({
+      FlowRouteAlgo::Iterative,
+      FlowRouteAlgo::Layered,
+  });
+  return myAlgos;
+}
+
+std::string toString(const FlowRouteAlgo aAlgo) {
+  switch (aAlgo) {
+    case FlowRouteAlgo::Iterative:
+      return "iterative";
+    case FlowRouteAlgo::Layered:
+      return "layered";
+    default:; /* fall-through */
+  }
+  return "unknown";
+}
+
+FlowRouteAlgo flowRouteAlgofromString(const std::string& aAlgo) {
+  if (aAlgo == "iterative") {
+    return FlowRouteAlgo::Iterative;
+  } else if (aAlgo == "layered") {
+    return FlowRouteAlgo::Layered;
+  }
+  throw std::runtime_error(
+      "invalid flow route algorithm: " + aAlgo + " (valid options are: " +
+      ::toString(allFlowRouteAlgos(),
+                 ",",
+                 [](const auto& aAlgo) { return toString(aAlgo); }) +
+      ")");
+}
+
 EsNetwork::FlowDescriptor::FlowDescriptor(const unsigned long aSrc,
                                           const unsigned long aDst,
                                           const double        aNetRate) noexcept
@@ -127,8 +166,8 @@ EsNetwork::AppDescriptor::AppDescriptor(
 bool EsNetwork::AppDescriptor::operator<(const AppDescriptor& aOther) const {
   return not theRemainingPaths.empty() and
          (aOther.theRemainingPaths.empty() or
-          theRemainingPaths.begin()->first <
-              aOther.theRemainingPaths.begin()->first);
+          theRemainingPaths.theShortest <
+              aOther.theRemainingPaths.theShortest);
 }
 
 EsNetwork::AppDescriptor::AppDescriptor::Output::Output(const Path& aPath)
@@ -138,21 +177,9 @@ EsNetwork::AppDescriptor::AppDescriptor::Output::Output(const Path& aPath)
   }
 }
 
-double EsNetwork::AppDescriptor::accumulate(
-    const std::function<double(const AppDescriptor::Output&)>& aFn) const {
-  return std::accumulate(
-      theAllocated.begin(),
-      theAllocated.end(),
-      0.0,
-      [&aFn](auto aLhs, const auto& aRhs) {
-        return std::accumulate(
-            aRhs.second.begin(),
-            aRhs.second.end(),
-            aLhs,
-            [&aFn](const auto aInnerLhs, const auto& aInnerRhs) {
-              return aInnerLhs + aFn(aInnerRhs);
-            });
-      });
+EsNetwork::AppDescriptor::AppDescriptor::Output::Output(Hops&& aHops)
+    : theHops(std::move(aHops)) {
+  // noop
 }
 
 double EsNetwork::AppDescriptor::netRate() const {
@@ -182,13 +209,23 @@ EsNetwork::EsNetwork(
     support::RealRvInterface&                                   aWeightRv,
     const bool aMakeBidirectional)
     : CapacityNetwork(aEdges, aWeightRv, aMakeBidirectional)
-    , theMeasurementProbability(1) {
+    , theMeasurementProbability(1)
+    , theKspCache(std::make_shared<KspCache>()) {
   // noop
 }
 
 EsNetwork::EsNetwork(const WeightVector& aEdgeWeights)
     : CapacityNetwork(aEdgeWeights)
-    , theMeasurementProbability(1) {
+    , theMeasurementProbability(1)
+    , theKspCache(std::make_shared<KspCache>()) {
+  // noop
+}
+
+EsNetwork::EsNetwork(const WeightVector& aEdgeWeights,
+                     const bool          aMakeBidirectional)
+    : CapacityNetwork(aEdgeWeights, aMakeBidirectional)
+    , theMeasurementProbability(1)
+    , theKspCache(std::make_shared<KspCache>()) {
   // noop
 }
 
@@ -201,158 +238,276 @@ void EsNetwork::measurementProbability(const double aMeasurementProbability) {
   theMeasurementProbability = aMeasurementProbability;
 }
 
-double EsNetwork::maxNetRate(const AppDescriptor&    aApp,
-                             const unsigned long     aPeer,
-                             const AppCheckFunction& aCheckFunction) const {
-  const auto NUM_PATHS  = 10u;
-  auto       myIndexMap = boost::get(boost::vertex_index, theGraph);
-  auto       myResult =
-      boost::yen_ksp(theGraph,
-                     aApp.theHost,
-                     aPeer,
-                     boost::make_static_property_map<Graph::edge_descriptor>(1),
-                     myIndexMap,
-                     NUM_PATHS);
-  assert(myResult.size() <= NUM_PATHS);
-
-  std::list<double> myNetRates({0.0}); // 0 is always a possible output
-  for (auto& elem : myResult) {
-    assert(elem.first > 0);
-    assert(static_cast<std::size_t>(elem.first) == elem.second.size());
-    if (aCheckFunction(aApp, elem.second) == false) {
-      // this path is invalid
-      continue;
-    }
-    myNetRates.emplace_back(
-        toNetRate(minCapacity(elem.second, theGraph), elem.first));
-  }
-  assert(myNetRates.size() <= (1 + NUM_PATHS));
+double EsNetwork::maxNetRate(const AppDescriptor&       aApp,
+                             const unsigned long        aPeer,
+                             const AppCheckFunction&    aCheckFunction,
+                             const AppHopLimitFunction& aHopLimit) const {
+  return maxNetRate<const AppCheckFunction&>(
+      aApp, aPeer, aCheckFunction, aHopLimit);
+}
 
-  // return the maximum net rate found (can be 0)
-  assert(not myNetRates.empty());
-  myNetRates.sort();
-  return myNetRates.back();
+void EsNetwork::kspCache(const std::shared_ptr<KspCache>& aKspCache) {
+  if (aKspCache.get() == nullptr) {
+    throw std::runtime_error("invalid null k-shortest paths cache");
+  }
+  theKspCache = aKspCache;
 }
 
 void EsNetwork::route(std::vector<FlowDescriptor>& aFlows,
                       const FlowCheckFunction&     aCheckFunction) {
-  const auto V = boost::num_vertices(theGraph);
+  route(aFlows, FlowRouteAlgo::Iterative, aCheckFunction);
+}
 
-  // pre-condition checks
-  for (const auto& myFlow : aFlows) {
-    assert(myFlow.thePath.empty());
-    assert(myFlow.theGrossRate == 0);
-    assert(myFlow.theDijsktra == 0);
+void EsNetwork::route(std::vector<FlowDescriptor>& aFlows,
+                      const FlowRouteAlgo          aAlgo,
+                      const FlowCheckFunction&     aCheckFunction,
+                      const std::size_t            aMaxHops) {
+  route<const FlowCheckFunction&>(aFlows, aAlgo, aCheckFunction, aMaxHops);
+}
 
-    if (boost::vertex(myFlow.theSrc, theGraph) >= V) {
-      throw std::runtime_error("invalid source node in flow: " +
-                               std::to_string(myFlow.theSrc));
-    }
-    if (boost::vertex(myFlow.theDst, theGraph) >= V) {
-      throw std::runtime_error("invalid destination node in flow: " +
-                               std::to_string(myFlow.theDst));
-    }
-    if (myFlow.theSrc == myFlow.theDst) {
-      throw std::runtime_error("invalid flow: from " +
-                               std::to_string(myFlow.theSrc) + " to itself");
+bool EsNetwork::admissible(FlowDescriptor&          aFlow,
+                           const FlowRouteAlgo      aAlgo,
+                           QueryScratch&            aScratch,
+                           const FlowCheckFunction& aCheckFunction,
+                           const std::size_t        aMaxHops) const {
+  return admissible<const FlowCheckFunction&>(
+      aFlow, aAlgo, aScratch, aCheckFunction, aMaxHops);
+}
+
+void EsNetwork::commit(const std::vector<FlowDescriptor>& aFlows) {
+  // first pass: add up the gross rates on every edge, throw if needed
+  std::map<CsrGraph::EdgeId, double> myDemands;
+  for (const auto& myFlow : aFlows) {
+    checkFlow(myFlow);
+    auto mySrc = myFlow.theSrc;
+    for (const auto myDst : myFlow.thePath) {
+      if (myDst >= theCsr.numVertices()) {
+        throw std::runtime_error("intermediate node does not exist: " +
+                                 std::to_string(myDst));
+      }
+      const auto myEdge = theCsr.findEdge(mySrc, myDst);
+      if (not myEdge.second) {
+        throw std::runtime_error("edge not in the graph: (" +
+                                 std::to_string(mySrc) + "," +
+                                 std::to_string(myDst) + ")");
+      }
+      myDemands[myEdge.first] += myFlow.theGrossRate;
+      mySrc = myDst;
     }
-    if (myFlow.theNetRate <= 0) {
+  }
+  for (const auto& elem : myDemands) {
+    if (theCsr.capacity(elem.first) < elem.second) {
       throw std::runtime_error(
-          "invalid nonpositive capacity request in flow: " +
-          std::to_string(myFlow.theNetRate));
+          "cannot reserve capacity " + std::to_string(elem.second) + " > " +
+          std::to_string(theCsr.capacity(elem.first)) + " for edge (" +
+          std::to_string(theCsr.source(elem.first)) + "," +
+          std::to_string(theCsr.target(elem.first)) + ")");
     }
   }
 
-  std::vector<VertexDescriptor> myDistances(V);
-  std::vector<VertexDescriptor> myPredecessors(V);
+  // second pass: no checks, just do the job
+  for (const auto& myFlow : aFlows) {
+    if (not myFlow.thePath.empty()) {
+      removeCapacityFromPath(
+          myFlow.theSrc, myFlow.thePath, myFlow.theGrossRate, std::nullopt);
+    }
+  }
+}
 
-  for (auto& myFlow : aFlows) {
-    assert(myFlow.thePath.empty());
-    assert(myFlow.theGrossRate == 0);
-    VLOG(2) << "flow " << myFlow.toString();
-
-    auto myFoundOrDisconnected = false;
-    auto myCopiedGraph         = theGraph;
-
-    // loop until either there is no path from the source to the destination
-    // or we find a candidate that can satisfy the flow requirements
-    while (not myFoundOrDisconnected) {
-      myFlow.theDijsktra++;
-      boost::dijkstra_shortest_paths(
-          myCopiedGraph,
-          myFlow.theSrc,
-          boost::predecessor_map(myPredecessors.data())
-              .weight_map(
-                  boost::make_static_property_map<Graph::edge_descriptor>(1))
-              .distance_map(boost::make_iterator_property_map(
-                  myDistances.data(),
-                  get(boost::vertex_index, myCopiedGraph))));
-
-      if (myPredecessors[myFlow.theDst] == myFlow.theDst) {
-        myFoundOrDisconnected = true; // disconnected
+void EsNetwork::route(std::vector<AppDescriptor>& aApps,
+                      const AppRouteAlgo          aAlgo,
+                      const double                aQuantum,
+                      support::RealRvInterface&   aRv,
+                      const std::size_t           aK,
+                      const AppCheckFunction&     aCheckFunction,
+                      const AppHopLimitFunction&  aHopLimit) {
+  route<const AppCheckFunction&>(
+      aApps, aAlgo, aQuantum, aRv, aK, aCheckFunction, aHopLimit);
+}
 
-      } else {
-        // there is at least one path from source to destination
-        HopsFinder     myHopsFinder(myPredecessors, myFlow.theSrc);
-        FlowDescriptor myCandidate(myFlow);
-        myHopsFinder(myCandidate.thePath, myFlow.theDst);
-        assert(not myCandidate.thePath.empty());
-        myCandidate.theGrossRate =
-            toGrossRate(myCandidate.theNetRate, myCandidate.thePath.size());
-        VLOG(2) << "candidate " << myCandidate.toString();
-
-        // if the flow is not admissible because of the external function
-        // we assume there is no need to continue the search, otherwise
-        // we check that the gross EPR rate is feasible along the path
-        // selected
-        if (not aCheckFunction(myCandidate)) {
-          myFoundOrDisconnected = true;
-
-        } else if (checkCapacity(myCandidate.theSrc,
-                                 myCandidate.thePath,
-                                 myCandidate.theGrossRate,
-                                 myCopiedGraph)) {
-          // flow is admissible on the shortest path, break from loop
-          myFoundOrDisconnected = true;
-          myFlow.movePathRateFrom(myCandidate);
-
-        } else {
-          // flow not admissible on the shortest path, remove the edge with
-          // smallest capacity along the path and try again
-          removeSmallestCapacityEdge(
-              myCandidate.theSrc, myCandidate.thePath, myCopiedGraph);
-        }
+std::vector<EsNetwork::Path>
+EsNetwork::kShortestPaths(const unsigned long aSrc,
+                          const unsigned long aDst,
+                          const std::size_t   aK,
+                          const std::size_t   aMaxHops,
+                          CsrGraph::Scratch&  aScratch) const {
+  if (aMaxHops == 0) {
+    return {};
+  }
+
+  // the search always returns at least one path, if any, even with k = 0
+  const auto      myK = std::max<std::size_t>(1, aK);
+  KspCache::Paths myHops;
+  if (not theKspCache->find(topologyVersion(), aSrc, aDst, myK, myHops)) {
+    // the paths longer than the maximum length are not searched at all, and
+    // the ties are broken by the ranks of the edges
+    KspGenerator myGenerator(theCsr, theRanks, aSrc, aDst, myK, aMaxHops);
+    while (myGenerator.next(aScratch)) {
+      // noop
+    }
+    const auto& myPaths = myGenerator.paths();
+    myHops.resize(myPaths.size());
+    for (std::size_t i = 0; i < myPaths.size(); i++) {
+      for (const auto myEdge : myPaths[i]) {
+        myHops[i].emplace_back(theCsr.target(myEdge));
       }
     }
 
-    if (myFlow.thePath.empty()) {
-      VLOG(2) << "flow rejected " << myFlow.toString();
+    // the paths found are the first ones that would be found with a search
+    // without a length limit, and all of them only if there is no limit
+    if (aMaxHops == UNLIMITED_HOPS) {
+      theKspCache->insert(topologyVersion(), aSrc, aDst, myK, myHops);
+    } else if (not myHops.empty()) {
+      theKspCache->insert(
+          topologyVersion(), aSrc, aDst, myHops.size(), myHops);
+    }
+  }
 
-    } else {
-      VLOG(2) << "flow admitted " << myFlow.toString();
-      // flow admissible: remove the gross capacity from the edges along the
-      // path and then move to the next flow in the list
-      removeCapacityFromPath(myFlow.theSrc,
-                             myFlow.thePath,
-                             myFlow.theGrossRate,
-                             std::nullopt,
-                             theGraph);
+  // the paths are sorted by length, hence those within the maximum length
+  // are a prefix of them
+  const auto myNumPaths = static_cast<std::size_t>(
+      std::find_if(myHops.begin(),
+                   myHops.end(),
+                   [aMaxHops](const auto& aHops) {
+                     return aHops.size() > aMaxHops;
+                   }) -
+      myHops.begin());
+
+  // the edges are found in this graph, since the paths may have been found
+  // by another network with the same topology
+  std::vector<Path> ret(myNumPaths);
+  for (std::size_t i = 0; i < myNumPaths; i++) {
+    auto myPrev = aSrc;
+    for (const auto myHop : myHops[i]) {
+      const auto myEdge = theCsr.findEdge(myPrev, myHop);
+      assert(myEdge.second);
+      ret[i].emplace_back(theDescriptors[myEdge.first]);
+      myPrev = myHop;
     }
   }
+  return ret;
 }
 
-void EsNetwork::route(std::vector<AppDescriptor>& aApps,
-                      const AppRouteAlgo          aAlgo,
-                      const double                aQuantum,
-                      support::RealRvInterface&   aRv,
-                      const std::size_t           aK,
-                      const AppCheckFunction&     aCheckFunction) {
-  // check arguments
+bool EsNetwork::shortestCandidate(FlowDescriptor&    aCandidate,
+                                  const std::size_t  aMaxHops,
+                                  CsrGraph::Scratch& aScratch) const {
+  static const auto NO_CAPACITY = -std::numeric_limits<double>::infinity();
+  const std::set<unsigned long> myDestinations({aCandidate.theDst});
+  theCsr.shortestPathTree(
+      aCandidate.theSrc, NO_CAPACITY, myDestinations, aScratch, aMaxHops);
+  const auto& myPredecessors = aScratch.thePredecessors;
+
+  if (myPredecessors[aCandidate.theDst] == aCandidate.theDst) {
+    return false;
+  }
+
+  // there is at least one path from source to destination
+  HopsFinder myHopsFinder(myPredecessors, aCandidate.theSrc);
+  myHopsFinder(aCandidate.thePath, aCandidate.theDst);
+  assert(not aCandidate.thePath.empty());
+  aCandidate.theGrossRate =
+      toGrossRate(aCandidate.theNetRate, aCandidate.thePath.size());
+  VLOG(2) << "candidate " << aCandidate.toString();
+  return true;
+}
+
+bool EsNetwork::feasible(const FlowDescriptor&          aCandidate,
+                         CsrGraph::Scratch&             aScratch,
+                         std::vector<CsrGraph::EdgeId>* aEdges) const {
+  // find the edge with smallest capacity along the path
+  auto             myFeasible         = true;
+  CsrGraph::EdgeId mySmallestEdge     = 0;
+  double           mySmallestCapacity = std::numeric_limits<double>::max();
+  auto             mySrc              = aCandidate.theSrc;
+  for (const auto myDst : aCandidate.thePath) {
+    [[maybe_unused]] auto myFound = false;
+    CsrGraph::EdgeId      myEdge;
+    std::tie(myEdge, myFound) = theCsr.findEdge(mySrc, myDst, aScratch);
+    assert(myFound);
+    if (aEdges != nullptr) {
+      aEdges->emplace_back(myEdge);
+    }
+    const auto myCapacity = theCsr.capacity(myEdge);
+    if (myCapacity < aCandidate.theGrossRate) {
+      myFeasible = false;
+    }
+    if (myCapacity < mySmallestCapacity) {
+      mySmallestCapacity = myCapacity;
+      mySmallestEdge     = myEdge;
+    }
+    mySrc = myDst;
+  }
+
+  // flow not admissible on the shortest path, remove the edge with
+  // smallest capacity along the path for the next search
+  if (not myFeasible) {
+    theCsr.exclude(mySmallestEdge, aScratch);
+  }
+  return myFeasible;
+}
+
+bool EsNetwork::feasibleCandidate(FlowDescriptor&           aCandidate,
+                                  const std::size_t         aMaxHops,
+                                  CsrGraph::LayeredScratch& aScratch) const {
+  if (not theCsr.shortestFeasiblePath(
+          aCandidate.theSrc,
+          aCandidate.theDst,
+          [this, &aCandidate](const std::size_t aNumEdges) {
+            return toGrossRate(aCandidate.theNetRate, aNumEdges);
+          },
+          aScratch,
+          aCandidate.thePath,
+          aMaxHops)) {
+    return false; // no feasible path
+  }
+
+  assert(not aCandidate.thePath.empty());
+  aCandidate.theGrossRate =
+      toGrossRate(aCandidate.theNetRate, aCandidate.thePath.size());
+  VLOG(2) << "candidate " << aCandidate.toString();
+  return true;
+}
+
+void EsNetwork::checkFlow(const FlowDescriptor& aFlow) const {
+  const auto V = boost::num_vertices(theGraph);
+  if (boost::vertex(aFlow.theSrc, theGraph) >= V) {
+    throw std::runtime_error("invalid source node in flow: " +
+                             std::to_string(aFlow.theSrc));
+  }
+  if (boost::vertex(aFlow.theDst, theGraph) >= V) {
+    throw std::runtime_error("invalid destination node in flow: " +
+                             std::to_string(aFlow.theDst));
+  }
+  if (aFlow.theSrc == aFlow.theDst) {
+    throw std::runtime_error("invalid flow: from " +
+                             std::to_string(aFlow.theSrc) + " to itself");
+  }
+  if (aFlow.theNetRate <= 0) {
+    throw std::runtime_error("invalid nonpositive capacity request in flow: " +
+                             std::to_string(aFlow.theNetRate));
+  }
+}
+
+void EsNetwork::checkFlows(const std::vector<FlowDescriptor>& aFlows,
+                           const FlowRouteAlgo                aAlgo) const {
+  if (aAlgo != FlowRouteAlgo::Iterative and aAlgo != FlowRouteAlgo::Layered) {
+    throw std::runtime_error("invalid flow route algorithm: " +
+                             std::to_string(static_cast<int>(aAlgo)));
+  }
+  for (const auto& myFlow : aFlows) {
+    assert(myFlow.thePath.empty());
+    assert(myFlow.theGrossRate == 0);
+    assert(myFlow.theDijsktra == 0);
+    checkFlow(myFlow);
+  }
+}
+
+void EsNetwork::checkApps(const std::vector<AppDescriptor>& aApps,
+                          const std::size_t                 aK) const {
   if (aK == 0) {
     throw std::runtime_error("invalid k: cannot be null");
   }
 
-  // pre-condition checks
   const auto V = boost::num_vertices(theGraph);
   for (const auto& myApp : aApps) {
     assert(myApp.theRemainingPaths.empty());
@@ -378,50 +533,6 @@ void EsNetwork::route(std::vector<AppDescriptor>& aApps,
                                std::to_string(myApp.thePriority));
     }
   }
-
-  // for each app, find k-shortest paths towards each peer with Yen's
-  // algorithm
-  auto myIndexMap = boost::get(boost::vertex_index, theGraph);
-  for (auto& myApp : aApps) {
-    for (const auto& myPeer : myApp.thePeers) {
-      auto myResult = boost::yen_ksp(
-          theGraph,
-          myApp.theHost,
-          myPeer,
-          boost::make_static_property_map<Graph::edge_descriptor>(1),
-          myIndexMap,
-          aK);
-      for (auto& elem : myResult) {
-        const auto myValid = aCheckFunction(myApp, elem.second);
-        VLOG(2) << myApp.theHost << " -> " << myPeer << ": "
-                << (myValid ? "valid" : "invalid") << " path found ["
-                << elem.first << "] {"
-                << ::toString(elem.second,
-                              ",",
-                              [](const auto& aEdge) {
-                                return std::to_string(aEdge.m_target);
-                              })
-                << "}";
-        if (myValid) {
-          auto myRes =
-              myApp.theRemainingPaths.emplace(elem.first, std::list<Path>());
-          myRes.first->second.emplace_back(std::move(elem.second));
-        }
-      }
-    }
-  }
-
-  // allocate resources based on the specific algorithm used
-  if (aAlgo == AppRouteAlgo::Random) {
-    routeRandom(aApps, aRv);
-  } else if (aAlgo == AppRouteAlgo::BestFit) {
-    routeBestFit(aApps);
-  } else if (aAlgo == AppRouteAlgo::Drr) {
-    routeDrr(aApps, aQuantum);
-  } else {
-    throw std::runtime_error("allocation strategy not implemented: " +
-                             toString(aAlgo));
-  }
 }
 
 double EsNetwork::toGrossRate(const double      aNetRate,
@@ -440,10 +551,87 @@ double EsNetwork::toNetRate(const double      aGrossRate,
   return aGrossRate * std::pow(theMeasurementProbability, aNumEdges - 1);
 }
 
+void EsNetwork::reserve(const FlowDescriptor& aFlow, TouchedEdges& aTouched) {
+  // the edges are the same as those found by removeCapacityFromPath()
+  auto mySrc = aFlow.theSrc;
+  for (const auto myDst : aFlow.thePath) {
+    aTouched.add(findCsrEdge(mySrc, myDst).first);
+    mySrc = myDst;
+  }
+  removeCapacityFromPath(
+      aFlow.theSrc, aFlow.thePath, aFlow.theGrossRate, std::nullopt);
+}
+
+EsNetwork::TouchedEdges::TouchedEdges(const CsrGraph& aCsr)
+    : theCsr(aCsr)
+    , theEdges(aCsr.numEdges(), 0)
+    , theSources(aCsr.numVertices(), 0)
+    , theTouched() {
+  // noop
+}
+
+void EsNetwork::TouchedEdges::add(const CsrGraph::EdgeId aEdge) {
+  assert(aEdge < theEdges.size());
+  if (theEdges[aEdge] == 0) {
+    theEdges[aEdge]                  = 1;
+    theSources[theCsr.source(aEdge)] = 1;
+    theTouched.emplace_back(aEdge);
+  }
+}
+
+bool EsNetwork::TouchedEdges::any(
+    const FlowRouteAlgo aAlgo, const std::vector<std::size_t>& aReads) const {
+  if (theTouched.empty()) {
+    return false;
+  }
+  const auto& myTouched =
+      aAlgo == FlowRouteAlgo::Iterative ? theEdges : theSources;
+  return std::any_of(aReads.begin(),
+                     aReads.end(),
+                     [&myTouched](const auto aRead) {
+                       assert(aRead < myTouched.size());
+                       return myTouched[aRead] != 0;
+                     });
+}
+
+void EsNetwork::TouchedEdges::clear() {
+  for (const auto myEdge : theTouched) {
+    theEdges[myEdge]                  = 0;
+    theSources[theCsr.source(myEdge)] = 0;
+  }
+  theTouched.clear();
+}
+
+void EsNetwork::allocate(std::vector<AppDescriptor>& aApps,
+                         const AppRouteAlgo          aAlgo,
+                         const double                aQuantum,
+                         support::RealRvInterface&   aRv,
+                         AppPaths&                   aPaths) {
+  // allocate resources based on the specific algorithm used
+  if (aAlgo == AppRouteAlgo::Random) {
+    routeRandom(aApps, aPaths, aRv);
+  } else if (aAlgo == AppRouteAlgo::BestFit) {
+    routeBestFit(aApps, aPaths);
+  } else if (aAlgo == AppRouteAlgo::Drr) {
+    routeDrr(aApps, aPaths, aQuantum);
+  } else {
+    throw std::runtime_error("allocation strategy not implemented: " +
+                             toString(aAlgo));
+  }
+  aPaths.cache();
+
+  // the allocation only changes the CSR snapshot, where the edges with no
+  // residual capacity are disabled: the capacities are written to the graph
+  // at once here
+  commitCsr();
+}
+
 void EsNetwork::routeRandom(std::vector<AppDescriptor>& aApps,
+                            AppPaths&                   aPaths,
                             support::RealRvInterface&   aRv) {
-  // create a structure that contains all apps with remaining paths
-  std::list<std::size_t> myAppIndices;
+  // create a structure that contains all apps with remaining paths, in
+  // increasing order of index
+  std::vector<std::size_t> myAppIndices;
   for (std::size_t ndx = 0; ndx < aApps.size(); ndx++) {
     if (not aApps[ndx].theRemainingPaths.empty()) {
       myAppIndices.emplace_back(ndx);
@@ -451,34 +639,52 @@ void EsNetwork::routeRandom(std::vector<AppDescriptor>& aApps,
   }
 
   // iterate by choosing one application at random, which is then
-  // removed from list of indices if there are no more remaining paths
+  // removed from list of indices if there are no more remaining paths:
+  // the order of the indices is preserved, so that the same applications are
+  // drawn for a given sequence of random numbers
   auto myInfinite = std::numeric_limits<double>::max();
   while (not myAppIndices.empty()) {
     const auto myRndNdx = support::choice(myAppIndices, aRv);
     auto&      myCurApp = aApps[myRndNdx];
-    schedule(myCurApp, myInfinite);
+    schedule(myCurApp, myRndNdx, aPaths, myInfinite);
     if (myCurApp.theRemainingPaths.empty()) {
-      auto it = std::find(myAppIndices.begin(), myAppIndices.end(), myRndNdx);
-      assert(it != myAppIndices.end());
+      const auto it = std::lower_bound(
+          myAppIndices.begin(), myAppIndices.end(), myRndNdx);
+      assert(it != myAppIndices.end() and *it == myRndNdx);
       myAppIndices.erase(it);
     }
   }
 }
 
-void EsNetwork::routeBestFit(std::vector<AppDescriptor>& aApps) {
+void EsNetwork::routeBestFit(std::vector<AppDescriptor>& aApps,
+                             AppPaths&                   aPaths) {
+  // min-heap of the apps with remaining paths, ordered by the length of their
+  // shortest remaining path and then by index
+  using Item = std::pair<std::size_t, std::size_t>; // length, index
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> myHeap;
+  for (std::size_t ndx = 0; ndx < aApps.size(); ndx++) {
+    if (not aApps[ndx].theRemainingPaths.empty()) {
+      myHeap.emplace(aApps[ndx].theRemainingPaths.theShortest, ndx);
+    }
+  }
+
   // iterate until there are no more applications with remaining paths
-  // at each iteration select an app with minimum path length
+  // at each iteration select an app with minimum path length, which is the
+  // only one whose length can change
   auto myInfinite = std::numeric_limits<double>::max();
-  while (true) {
-    auto it = std::min_element(aApps.begin(), aApps.end());
-    if (it->theRemainingPaths.empty()) {
-      break;
+  while (not myHeap.empty()) {
+    const auto myNdx = myHeap.top().second;
+    myHeap.pop();
+    auto& myCurApp = aApps[myNdx];
+    schedule(myCurApp, myNdx, aPaths, myInfinite);
+    if (not myCurApp.theRemainingPaths.empty()) {
+      myHeap.emplace(myCurApp.theRemainingPaths.theShortest, myNdx);
     }
-    schedule(*it, myInfinite);
   }
 }
 
 void EsNetwork::routeDrr(std::vector<AppDescriptor>& aApps,
+                         AppPaths&                   aPaths,
                          const double                aQuantum) {
   if (aQuantum <= 0) {
     throw std::runtime_error("invalid non-positive quantum value: " +
@@ -496,7 +702,7 @@ void EsNetwork::routeDrr(std::vector<AppDescriptor>& aApps,
   }
 
   // create an active list initialized with all (feasible) applications
-  std::list<std::size_t> myActiveApps;
+  std::vector<std::size_t> myActiveApps;
   for (std::size_t i = 0; i < aApps.size(); i++) {
     // only add apps with at least one path
     if (not aApps[i].theRemainingPaths.empty()) {
@@ -504,72 +710,81 @@ void EsNetwork::routeDrr(std::vector<AppDescriptor>& aApps,
     }
   }
 
-  // do the allocation using deficit round robin
-  auto myCurAppIt = myActiveApps.begin();
+  // do the allocation using deficit round robin: at every round the apps
+  // that still have feasible paths are compacted at the head of the active
+  // list, in the same order
   while (not myActiveApps.empty()) {
-    auto  myResidualCapacity = myQuanta[*myCurAppIt];
-    auto& myCurApp           = aApps[*myCurAppIt];
-
-    // loop until there are valid paths and capacity to be allocated
-    while (not myCurApp.theRemainingPaths.empty() and myResidualCapacity > 0) {
-      schedule(myCurApp, myResidualCapacity);
-    }
-
-    // check if there are feasible paths remaining for this app:
-    // - yes: move to the next app in the active list
-    // - no: remove this app from active list
-    // in both cases it is possible that myCurAppIt reaches the end of the
-    // list
-    if (not myCurApp.theRemainingPaths.empty()) {
-      ++myCurAppIt;
-    } else {
-      VLOG(2) << "remove from active list app w/ host " << myCurApp.theHost;
-      myCurAppIt = myActiveApps.erase(myCurAppIt);
-    }
+    std::size_t myNumActive = 0;
+    for (std::size_t i = 0; i < myActiveApps.size(); i++) {
+      auto  myResidualCapacity = myQuanta[myActiveApps[i]];
+      auto& myCurApp           = aApps[myActiveApps[i]];
+
+      // loop until there are valid paths and capacity to be allocated
+      while (not myCurApp.theRemainingPaths.empty() and
+             myResidualCapacity > 0) {
+        schedule(myCurApp, myActiveApps[i], aPaths, myResidualCapacity);
+      }
 
-    //  wrap-around at the end of the active list
-    if (myCurAppIt == myActiveApps.end()) {
-      myCurAppIt = myActiveApps.begin();
+      // keep the app in the active list only if there are feasible paths
+      // remaining
+      if (not myCurApp.theRemainingPaths.empty()) {
+        myActiveApps[myNumActive++] = myActiveApps[i];
+      } else {
+        VLOG(2) << "remove from active list app w/ host " << myCurApp.theHost;
+      }
     }
+    myActiveApps.resize(myNumActive);
   }
 }
 
-bool EsNetwork::schedule(AppDescriptor& aApp, double& aResidualCapacity) {
+bool EsNetwork::schedule(AppDescriptor&    aApp,
+                         const std::size_t aNdx,
+                         AppPaths&         aPaths,
+                         double&           aResidualCapacity) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::AppScheduling);
+
   // one more visit to this application
   aApp.theVisits++;
 
   // select the first of the shortest paths of the current app
-  const auto& myCandidate = aApp.theRemainingPaths.begin()->second.front();
+  const auto& aPool       = aPaths.pool();
+  auto&       myRemaining = aApp.theRemainingPaths;
+  assert(not myRemaining.empty());
+  const auto myBegin = aPool.begin(myRemaining.theNext);
+  const auto myEnd   = aPool.end(myRemaining.theNext);
+  const auto myHops  = [this, myBegin, myEnd]() {
+    AppDescriptor::Hops ret;
+    ret.reserve(myEnd - myBegin);
+    for (auto it = myBegin; it != myEnd; ++it) {
+      ret.emplace_back(theCsr.target(*it));
+    }
+    return ret;
+  };
   VLOG(2) << "host " << aApp.theHost << ", path {"
-          << ::toString(myCandidate,
+          << ::toString(myHops(),
                         ",",
-                        [](const auto& aEdge) {
-                          return std::to_string(aEdge.m_target);
-                        })
+                        [](const auto& aHop) { return std::to_string(aHop); })
           << "}";
 
   // check that all the edges still exist and find that with less capacity
   auto   myValidPath   = true;
   double myMinCapacity = std::numeric_limits<double>::max();
-  for (const auto& elem : myCandidate) {
-    EdgeDescriptor myEdge;
-    bool           myFound;
-    std::tie(myEdge, myFound) =
-        boost::edge(elem.m_source, elem.m_target, theGraph);
-    if (not myFound) {
+  for (auto it = myBegin; it != myEnd; ++it) {
+    if (not theCsr.enabled(*it)) {
       myValidPath = false;
       break;
     }
-    myMinCapacity = std::min(myMinCapacity,
-                             boost::get(boost::edge_weight, theGraph, myEdge));
+    myMinCapacity = std::min(myMinCapacity, theCsr.capacity(*it));
   }
 
-  // remove the path if it is not available anymore and return early
+  // remove the path if it is not available anymore and return early: if it
+  // was the last one with its length then find the next ones, if any
   if (not myValidPath) {
-    aApp.theRemainingPaths.begin()->second.pop_front();
-    if (aApp.theRemainingPaths.begin()->second.empty()) {
-      // no more same-length paths, remove entry from theRemainingPaths
-      aApp.theRemainingPaths.erase(aApp.theRemainingPaths.begin());
+    myRemaining.theNext++;
+    if (myRemaining.empty()) {
+      aPaths.refill(aNdx);
+    } else {
+      myRemaining.theShortest = aPool.size(myRemaining.theNext);
     }
     return false;
   }
@@ -579,20 +794,19 @@ bool EsNetwork::schedule(AppDescriptor& aApp, double& aResidualCapacity) {
   aResidualCapacity -= myAllocatedGross;
 
   // remove the gross capacity from all edges along the path
-  // if the capacity becomes zero, remove the edge, too
-  for (const auto& elem : myCandidate) {
-    assert(boost::get(boost::edge_weight, theGraph, elem) >= myAllocatedGross);
-    auto& myWeight = boost::get(boost::edge_weight, theGraph, elem) -=
-        myAllocatedGross;
-    if (myWeight == 0) {
-      VLOG(2) << "removing edge (" << elem.m_source << "," << elem.m_target
-              << ")";
-      boost::remove_edge(elem, theGraph);
+  // if the capacity becomes zero, disable the edge, too, until it has some
+  // capacity again
+  for (auto it = myBegin; it != myEnd; ++it) {
+    assert(theCsr.capacity(*it) >= myAllocatedGross);
+    if (removeCsrCapacity(*it, myAllocatedGross) == 0) {
+      VLOG(2) << "disabling edge (" << theCsr.source(*it) << ","
+              << theCsr.target(*it) << ")";
+      disableCsrEdge(*it, std::numeric_limits<double>::min());
     }
   }
 
   // add the allocation to the path
-  AppDescriptor::Output myOutput(myCandidate);
+  AppDescriptor::Output myOutput(myHops());
   VLOG(2) << "allocated gross capacity " << myAllocatedGross
           << " EPR-pairs/s for host " << aApp.theHost << " towards "
           << myOutput.theHops.back() << " along path {"
@@ -617,5 +831,153 @@ bool EsNetwork::schedule(AppDescriptor& aApp, double& aResidualCapacity) {
   return true;
 }
 
+EsNetwork::AppPaths::Peer::Peer(const unsigned long aDst,
+                                const std::size_t   aMaxHops)
+    : theDst(aDst)
+    , theMaxHops(aMaxHops)
+    , theCached()
+    , theGenerator()
+    , theNext(0)
+    , theChecked(0) {
+  // noop
+}
+
+// Since the k-shortest paths towards every peer are found in non-decreasing
+// order of length, the next paths of an app can be found when these are
+// exhausted by searching only until a longer one is found towards every peer.
+//
+// The searches are done on a copy of the CSR snapshot taken before the
+// allocation, which disables the edges with no residual capacity left.
+EsNetwork::AppPaths::AppPaths(EsNetwork&                  aNetwork,
+                              std::vector<AppDescriptor>& aApps,
+                              const std::size_t           aK,
+                              const AppHopLimitFunction&  aHopLimit)
+    : theNetwork(aNetwork)
+    , theApps(aApps)
+    , thePool()
+    , thePeers(aApps.size())
+    , theK(std::max<std::size_t>(1, aK))
+    , theTopologyVersion(aNetwork.topologyVersion())
+    , theTopology()
+    , theScratch() {
+  // use the paths in the cache, if possible, otherwise prepare the searches
+  std::vector<std::pair<std::size_t, Peer*>> myMissing;
+  for (std::size_t i = 0; i < theApps.size(); i++) {
+    const auto myMaxHops = aHopLimit(theApps[i]);
+    thePeers[i].reserve(theApps[i].thePeers.size());
+    for (const auto& myPeer : theApps[i].thePeers) {
+      auto& myEntry = thePeers[i].emplace_back(myPeer, myMaxHops);
+      if (not cached(theApps[i].theHost, myEntry)) {
+        myMissing.emplace_back(i, &myEntry);
+      }
+    }
+  }
+  if (myMissing.empty()) {
+    return;
+  }
+
+  // the ties between paths with the same length are broken by the ranks of
+  // the edges, i.e., by source, target and CSR edge identifier
+  theTopology = theNetwork.theCsr;
+  Instrumentation::count(Instrumentation::Counter::GraphCopies);
+
+  // the shortest paths towards all the peers are always needed: they are
+  // found in parallel by the task scheduler running this call, if any
+  for (const auto& [myNdx, myEntry] : myMissing) {
+    myEntry->theGenerator =
+        std::make_unique<KspGenerator>(theTopology,
+                                       theNetwork.theRanks,
+                                       theApps[myNdx].theHost,
+                                       myEntry->theDst,
+                                       theK,
+                                       myEntry->theMaxHops);
+  }
+  parallelFor(0,
+              myMissing.size(),
+              1,
+              [&myMissing](const std::size_t aFirst, const std::size_t aLast) {
+                CsrGraph::Scratch myScratch;
+                for (auto i = aFirst; i < aLast; i++) {
+                  myMissing[i].second->theGenerator->next(myScratch);
+                }
+              });
+}
+
+EsNetwork::AppPaths::~AppPaths() {
+  // noop
+}
+
+void EsNetwork::AppPaths::cache() const {
+  for (std::size_t i = 0; i < theApps.size(); i++) {
+    for (const auto& myPeer : thePeers[i]) {
+      if (not myPeer.theGenerator) {
+        continue;
+      }
+      const auto& myPaths = myPeer.paths();
+      auto        myK     = myPaths.size();
+      if (myPeer.theGenerator->done() and myPeer.theMaxHops == UNLIMITED_HOPS) {
+        myK = theK;
+      } else if (myK == 0) {
+        continue;
+      }
+      KspCache::Paths myHops(myPaths.size());
+      for (std::size_t j = 0; j < myPaths.size(); j++) {
+        for (const auto myEdge : myPaths[j]) {
+          myHops[j].emplace_back(theTopology.target(myEdge));
+        }
+      }
+      theNetwork.theKspCache->insert(
+          theTopologyVersion, theApps[i].theHost, myPeer.theDst, myK, myHops);
+    }
+  }
+}
+
+bool EsNetwork::AppPaths::hasNext(Peer& aPeer) {
+  return aPeer.theNext < aPeer.paths().size() or
+         (aPeer.theGenerator and aPeer.theGenerator->next(theScratch));
+}
+
+EsNetwork::Path EsNetwork::AppPaths::toPath(const CsrPath& aPath) const {
+  Path ret;
+  for (const auto myEdge : aPath) {
+    ret.emplace_back(theNetwork.theDescriptors[myEdge]);
+  }
+  return ret;
+}
+
+std::string EsNetwork::AppPaths::toString(const CsrPath& aPath) const {
+  return ::toString(aPath, ",", [this](const auto& aEdge) {
+    return std::to_string(theNetwork.theCsr.target(aEdge));
+  });
+}
+
+bool EsNetwork::AppPaths::cached(const unsigned long aHost, Peer& aPeer) {
+  if (aPeer.theMaxHops == 0) {
+    return true;
+  }
+  KspCache::Paths myHops;
+  if (not theNetwork.theKspCache->find(
+          theTopologyVersion, aHost, aPeer.theDst, theK, myHops)) {
+    return false;
+  }
+
+  // the edges are found in this graph, since the paths may have been found
+  // by another network with the same topology
+  for (const auto& myPath : myHops) {
+    if (myPath.size() > aPeer.theMaxHops) {
+      break;
+    }
+    auto& myEdges = aPeer.theCached.emplace_back();
+    auto  myPrev  = aHost;
+    for (const auto myHop : myPath) {
+      const auto myEdge = theNetwork.theCsr.findEdge(myPrev, myHop);
+      assert(myEdge.second);
+      myEdges.emplace_back(myEdge.first);
+      myPrev = myHop;
+    }
+  }
+  return true;
+}
+
 } // namespace qr
 } // namespace uiiit
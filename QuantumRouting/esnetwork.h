@@ -32,6 +32,24 @@ SOFTWARE.
 #pragma once
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/kspcache.h"
+#include "QuantumRouting/kspgenerator.h"
+#include "QuantumRouting/pathpool.h"
+#include "QuantumRouting/taskscheduler.h"
+
+#include "Support/tostring.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
 namespace uiiit {
 namespace qr {
@@ -46,6 +64,15 @@ std::vector<AppRouteAlgo> allAppRouteAlgos();
 std::string               toString(const AppRouteAlgo aAlgo);
 AppRouteAlgo              appRouteAlgofromString(const std::string& aAlgo);
 
+enum class FlowRouteAlgo {
+  Iterative = 0, // shortest path, pruning its bottleneck edge until feasible
+  Layered   = 1, // one-pass hop-layered search of the shortest feasible path
+};
+
+std::vector<FlowRouteAlgo> allFlowRouteAlgos();
+std::string                toString(const FlowRouteAlgo aAlgo);
+FlowRouteAlgo              flowRouteAlgofromString(const std::string& aAlgo);
+
 /**
  * @brief A network of quantum repeaters using Entanglement Swapping (ES) where
  * edges are characterized by their capacity only, in terms of EPR pairs that
@@ -87,6 +114,12 @@ class EsNetwork final : public CapacityNetwork
     std::string toString() const;
   };
 
+  //! Working memory of admissible(), which can be reused across queries.
+  struct QueryScratch {
+    CsrGraph::Scratch        theScratch;
+    CsrGraph::LayeredScratch theLayeredScratch;
+  };
+
   struct AppDescriptor {
     using Hops = std::vector<unsigned long>;
 
@@ -104,11 +137,29 @@ class EsNetwork final : public CapacityNetwork
     const double theFidelityThreshold;            //!< fidelity threshold
 
     // working variables
-    std::map<unsigned long, std::list<Path>> theRemainingPaths; //!< key: length
+    struct RemainingPaths {
+      //! \return true if there are no more paths.
+      bool empty() const noexcept {
+        return theNext == theEnd;
+      }
+
+      //! \return the number of paths.
+      std::size_t size() const noexcept {
+        return theEnd - theNext;
+      }
+
+      PathPool::PathId theNext     = 0; //!< the first path
+      PathPool::PathId theEnd      = 0; //!< one past the last path
+      std::size_t      theShortest = 0; //!< the length of the first path
+    };
+    //! in a PathPool, only those with the shortest length among the paths not
+    //! yet used, the next ones are found when these are exhausted
+    RemainingPaths theRemainingPaths;
 
     // output
     struct Output {
       explicit Output(const Path& aPath);
+      explicit Output(Hops&& aHops);
 
       Hops   theHops;
       double theNetRate   = 0; //!< in EPR-pairs/s
@@ -122,13 +173,46 @@ class EsNetwork final : public CapacityNetwork
     std::string toString() const;
 
    private:
-    double accumulate(
-        const std::function<double(const AppDescriptor::Output&)>& aFn) const;
+    template <class FN>
+    double accumulate(FN&& aFn) const {
+      return std::accumulate(
+          theAllocated.begin(),
+          theAllocated.end(),
+          0.0,
+          [&aFn](auto aLhs, const auto& aRhs) {
+            return std::accumulate(
+                aRhs.second.begin(),
+                aRhs.second.end(),
+                aLhs,
+                [&aFn](const auto aInnerLhs, const auto& aInnerRhs) {
+                  return aInnerLhs + aFn(aInnerRhs);
+                });
+          });
+    }
   };
 
   using FlowCheckFunction = std::function<bool(const FlowDescriptor&)>;
   using AppCheckFunction =
       std::function<bool(const AppDescriptor&, const Path&)>;
+  //! Maximum length, in hops, of the paths of an app, e.g., from its fidelity
+  //! threshold, see FidelityHopTable.
+  using AppHopLimitFunction = std::function<std::size_t(const AppDescriptor&)>;
+
+  /**
+   * @brief Check function that accepts every flow or path.
+   *
+   * The routing functions have overloads taking the check function as a
+   * template parameter, which can be inlined in the searches instead of
+   * being called through a std::function, and this is their default: with
+   * apps, the paths are then not even converted into the Path passed to
+   * the check functions.
+   */
+  struct AcceptAll {
+    template <class... ARGS>
+    constexpr bool operator()(const ARGS&...) const noexcept {
+      return true;
+    }
+  };
 
   /**
    * @brief Create a network with given links and assign random weights
@@ -154,6 +238,18 @@ class EsNetwork final : public CapacityNetwork
    */
   explicit EsNetwork(const WeightVector& aEdgeWeights);
 
+  /**
+   * @brief Create a network with given links and weights
+   *
+   * The default measurement probability is 1.
+   *
+   * @param aEdgeWeights The edges and weights of the network (src, dst, w).
+   * @param aMakeBidirectional If true then for each edge (A,B,w) two edges
+   * are added A->B and B->A, with the same weight.
+   */
+  explicit EsNetwork(const WeightVector& aEdgeWeights,
+                     const bool          aMakeBidirectional);
+
   /**
    * @brief Set the measurement probability.
    *
@@ -168,24 +264,57 @@ class EsNetwork final : public CapacityNetwork
     return theMeasurementProbability;
   }
 
+  /**
+   * @brief Set the cache of the k-shortest paths.
+   *
+   * By default every network has its own cache, which is shared by the
+   * searches of maxNetRate() and route() of apps. The same cache can be
+   * shared by multiple networks, e.g., those created from the same topology
+   * in different runs of an experiment, but then the order of the paths
+   * with the same length may be different from that found by a search
+   * in the network itself.
+   *
+   * @param aKspCache the new cache
+   *
+   * @throw std::runtime_error if aKspCache is null
+   */
+  void kspCache(const std::shared_ptr<KspCache>& aKspCache);
+
+  //! \return the cache of the k-shortest paths.
+  const std::shared_ptr<KspCache>& kspCache() const noexcept {
+    return theKspCache;
+  }
+
   /**
    * @brief Find the maximum net rate achievable from a node to another.
    *
-   * @param aApp The host application. Use only the information about the
-   * source node; ignore the other fields.
+   * @param aApp The host application. Only the source node is used to
+   * search the paths; the other fields are only passed to aCheckFunction and
+   * aHopLimit.
    * @param aPeer The candidate peer (destination node).
    * @param aCheckFunction Function to check if a potential path is valid.
+   * @param aHopLimit Function returning the maximum length of the paths of
+   * the app, which are not searched beyond it.
    * @return double The maximum net rate achievable, in EPR pairs/s, >= 0.
    *
    * The search is not full, so it is not guaranteed that the real maximum
    * value will be returned, but an approximation.
    */
   double maxNetRate(
-      const AppDescriptor&    aApp,
-      const unsigned long     aPeer,
-      const AppCheckFunction& aCheckFunction = [](const auto&, const auto&) {
-        return true;
-      }) const;
+      const AppDescriptor&       aApp,
+      const unsigned long        aPeer,
+      const AppCheckFunction&    aCheckFunction,
+      const AppHopLimitFunction& aHopLimit =
+          [](const auto&) { return UNLIMITED_HOPS; }) const;
+
+  //! Same as above, with a check function of any type, by default AcceptAll.
+  template <class PREDICATE = AcceptAll>
+  double maxNetRate(
+      const AppDescriptor&       aApp,
+      const unsigned long        aPeer,
+      PREDICATE&&                aCheckFunction = PREDICATE(),
+      const AppHopLimitFunction& aHopLimit =
+          [](const auto&) { return UNLIMITED_HOPS; }) const;
 
   /**
    * @brief Route the given flows in this network starting with current
@@ -209,17 +338,166 @@ class EsNetwork final : public CapacityNetwork
         return true;
       });
 
+  /**
+   * @brief Route the given flows with a given algorithm.
+   *
+   * Same as above, which uses FlowRouteAlgo::Iterative.
+   *
+   * Routing algorithms:
+   * - Iterative: find the shortest path in hops and, while the gross rate
+   *   is not feasible along the path, exclude its edge with smallest capacity
+   *   and search again; every search increments the Dijkstra counter
+   * - Layered: find the shortest path in hops whose bottleneck capacity is at
+   *   least the gross rate for that path length, in a single search
+   *
+   * Both algorithms select a path with the same length, if any. If the check
+   * function does not accept a path then it is assumed that it would not
+   * accept any longer ones, too, as it is the case of a fidelity threshold:
+   * under this assumption the admission decisions are the same. However, if
+   * there are multiple feasible paths with the same length, the two
+   * algorithms may select different ones.
+   *
+   * The searches do not go beyond aMaxHops: if the check function would
+   * reject all the paths longer than that, e.g., with a fidelity threshold
+   * and the limit found by fidelityMaxHops(), the admission decisions are the
+   * same as without a limit, but the flows that cannot be admitted are
+   * rejected without finding longer paths.
+   *
+   * @param aFlows the flows to be routed (admitted flows are modified)
+   * @param aAlgo the routing algorithm
+   * @param aCheckFunction the flow is considered feasible only if this
+   * function returns true, otherwise it is inadmissible; the default of the
+   * template overload below is to always accept the flow
+   * @param aMaxHops the maximum length of the paths, in hops
+   *
+   * @throw std::runtime_error if aFlows contain an ill-formed request, in which
+   * case we guarantee that the internal state is not changed
+   */
+  void route(std::vector<FlowDescriptor>& aFlows,
+             const FlowRouteAlgo          aAlgo,
+             const FlowCheckFunction&     aCheckFunction,
+             const std::size_t            aMaxHops = UNLIMITED_HOPS);
+
+  //! Same as above, with a check function of any type, which is called for
+  //! every candidate path of the iterative search.
+  template <class PREDICATE = AcceptAll>
+  void route(std::vector<FlowDescriptor>& aFlows,
+             const FlowRouteAlgo          aAlgo,
+             PREDICATE&&                  aCheckFunction = PREDICATE(),
+             const std::size_t            aMaxHops       = UNLIMITED_HOPS);
+
+  /**
+   * @brief Route the given flows with a given algorithm, searching the paths
+   * of windows of consecutive flows in parallel.
+   *
+   * The admission decisions, paths and Dijkstra counters are the same as
+   * with route(), i.e., as if the flows were routed one by one in the order
+   * in which they are passed.
+   *
+   * For every window, the paths of all the flows are first searched
+   * concurrently with the capacities at the start of the window, without
+   * changing them. Then the flows are admitted in order: the result of a
+   * flow is recomputed only if its search read the capacity of an edge
+   * used by one of the flows admitted before it in the same window, i.e.,
+   * with the iterative algorithm an edge of one of its candidate paths, and
+   * with the layered one an out-edge of a vertex reached.
+   *
+   * The searches are run by the workers of the task scheduler running the
+   * caller, if any, otherwise they are run by this thread.
+   *
+   * @param aFlows the flows to be routed (admitted flows are modified)
+   * @param aAlgo the routing algorithm
+   * @param aWindow the number of flows whose paths are searched together: if
+   * smaller than 2, same as route()
+   * @param aCheckFunction same as in route(), which must be thread-safe and
+   * only depend on the candidate flow passed, since it may be called more
+   * than once for the same path
+   * @param aMaxHops same as in route()
+   *
+   * @throw std::runtime_error if aFlows contain an ill-formed request, in which
+   * case we guarantee that the internal state is not changed
+   */
+  template <class PREDICATE = AcceptAll>
+  void routeBatch(std::vector<FlowDescriptor>& aFlows,
+                  const FlowRouteAlgo          aAlgo,
+                  const std::size_t            aWindow,
+                  PREDICATE&&                  aCheckFunction = PREDICATE(),
+                  const std::size_t            aMaxHops       = UNLIMITED_HOPS);
+
+  /**
+   * @brief Find whether a flow would be admitted with the current capacities,
+   * without changing them.
+   *
+   * The flow is routed in the same way as by route() with the same algorithm.
+   * The function only reads the network, hence it can be called concurrently
+   * from multiple threads, each with its own working memory, as long as the
+   * network is not modified at the same time, e.g., by commit().
+   *
+   * @param aFlow the flow, whose routing info is overwritten
+   * @param aAlgo the routing algorithm
+   * @param aScratch the working memory of the searches
+   * @param aCheckFunction same as in route(), which must be thread-safe if
+   * used concurrently
+   * @param aMaxHops same as in route()
+   * @return true if the flow is admitted, in which case the path and gross
+   * rate are saved into aFlow, which can be then passed to commit()
+   *
+   * @throw std::runtime_error if aFlow is an ill-formed request
+   */
+  bool admissible(FlowDescriptor&          aFlow,
+                  const FlowRouteAlgo      aAlgo,
+                  QueryScratch&            aScratch,
+                  const FlowCheckFunction& aCheckFunction,
+                  const std::size_t        aMaxHops = UNLIMITED_HOPS) const;
+
+  //! Same as above, with a check function of any type.
+  template <class PREDICATE = AcceptAll>
+  bool admissible(FlowDescriptor&     aFlow,
+                  const FlowRouteAlgo aAlgo,
+                  QueryScratch&       aScratch,
+                  PREDICATE&&         aCheckFunction = PREDICATE(),
+                  const std::size_t   aMaxHops       = UNLIMITED_HOPS) const;
+
+  /**
+   * @brief Reserve the capacities of flows found admissible with
+   * admissible(), all of them or none.
+   *
+   * The flows with an empty path are ignored. The capacities may have changed
+   * since the queries were made, so they are checked again against the sum of
+   * the gross rates of all the flows on every edge.
+   *
+   * @param aFlows the flows to be committed
+   *
+   * @throw std::runtime_error if the path of a flow does not exist or if there
+   * is not enough capacity left for all the flows, in which case we guarantee
+   * that the internal state is not changed
+   */
+  void commit(const std::vector<FlowDescriptor>& aFlows);
+
   /**
    * @brief Route the given elastic applications in the network.
    *
+   * The k-shortest paths from each app to its peers are found lazily: the
+   * next ones are only searched when all the remaining paths with the same
+   * length have been used, hence the cost depends on the number of paths
+   * used by the allocation rather than on aK. The result is the same as if
+   * all the aK paths were found in advance.
+   *
+   * If called from a task of a TaskScheduler, the shortest path towards every
+   * peer is found in parallel by its workers, while aCheckFunction is always
+   * called from this thread in the same order.
+   *
    * @param aApps the applications to be routed
    * @param aAlgo the algorithm to be used for resource allocation
    * @param aQuantum  the allocation quantum to be used (only used with DRR)
    * @param aRv a U[0,1] random variable (only used with Random)
    * @param aK the maximum number of paths to be found for each app and peer
-   * @param aCheckFunction the flow is considered feasible only if this
-   * function returns true, otherwise it is inadmissible; the default is to
-   * always accept the flow
+   * @param aCheckFunction a path is used only if this function returns true;
+   * the default of the template overload below is to accept all of them
+   * @param aHopLimit the maximum length of the paths of each app: the
+   * k-shortest paths longer than this are not searched, and if there is no
+   * path within the limit towards a peer then the search is skipped
+   * altogether; the default is no limit
    *
    * @throw std::runtime_error if aFlows contain an ill-formed request, in which
    * case we guarantee that the internal state is not changed
@@ -237,9 +515,22 @@ class EsNetwork final : public CapacityNetwork
       const double                aQuantum,
       support::RealRvInterface&   aRv,
       const std::size_t           aK,
-      const AppCheckFunction& aCheckFunction = [](const auto&, const auto&) {
-        return true;
-      });
+      const AppCheckFunction&     aCheckFunction,
+      const AppHopLimitFunction&  aHopLimit =
+          [](const auto&) { return UNLIMITED_HOPS; });
+
+  //! Same as above, with a check function of any type, which is called once
+  //! for every path found.
+  template <class PREDICATE = AcceptAll>
+  void route(
+      std::vector<AppDescriptor>& aApps,
+      const AppRouteAlgo          aAlgo,
+      const double                aQuantum,
+      support::RealRvInterface&   aRv,
+      const std::size_t           aK,
+      PREDICATE&&                 aCheckFunction = PREDICATE(),
+      const AppHopLimitFunction&  aHopLimit =
+          [](const auto&) { return UNLIMITED_HOPS; });
 
  private:
   //! \return the gross rate for a given path length, in num of edges.
@@ -248,30 +539,578 @@ class EsNetwork final : public CapacityNetwork
   //! \return the net rate for a given path length, in num of edges.
   double toNetRate(const double aGrossRate, const std::size_t aNumEdges) const;
 
+  //! \return the k-shortest paths in hops, using the cache if possible,
+  //! without those longer than aMaxHops, which are not searched at all.
+  //! aScratch is only used if the paths are not in the cache.
+  std::vector<Path> kShortestPaths(const unsigned long aSrc,
+                                   const unsigned long aDst,
+                                   const std::size_t   aK,
+                                   const std::size_t   aMaxHops,
+                                   CsrGraph::Scratch&  aScratch) const;
+
+  //! \throw std::runtime_error if the flow is an ill-formed request.
+  void checkFlow(const FlowDescriptor& aFlow) const;
+
+  //! \throw std::runtime_error if the algorithm is invalid or if the flows
+  //! contain an ill-formed request.
+  void checkFlows(const std::vector<FlowDescriptor>& aFlows,
+                  const FlowRouteAlgo                aAlgo) const;
+
+  //! \throw std::runtime_error if the apps contain an ill-formed request or
+  //! if aK is null.
+  void checkApps(const std::vector<AppDescriptor>& aApps,
+                 const std::size_t                 aK) const;
+
+  /**
+   * @brief Find the shortest path of a candidate flow, with the edges
+   * excluded in the working memory, and the gross rate needed along it.
+   *
+   * @return false if there is no path within aMaxHops.
+   */
+  bool shortestCandidate(FlowDescriptor&    aCandidate,
+                         const std::size_t  aMaxHops,
+                         CsrGraph::Scratch& aScratch) const;
+
+  //! \return true if the gross rate of the candidate is feasible along its
+  //! path, otherwise exclude the edge with smallest capacity from aScratch.
+  //! The edges of the path are added to aEdges, if not null.
+  bool feasible(const FlowDescriptor&          aCandidate,
+                CsrGraph::Scratch&             aScratch,
+                std::vector<CsrGraph::EdgeId>* aEdges) const;
+
+  /**
+   * @brief Find the shortest feasible path of a candidate flow and the gross
+   * rate needed along it.
+   *
+   * @return false if there is no feasible path within aMaxHops.
+   */
+  bool feasibleCandidate(FlowDescriptor&           aCandidate,
+                         const std::size_t         aMaxHops,
+                         CsrGraph::LayeredScratch& aScratch) const;
+
+  //! Route a single flow using FlowRouteAlgo::Iterative. The edges of the
+  //! candidate paths are added to aEdges, if not null.
+  template <class PREDICATE>
+  void routeIterative(FlowDescriptor&                aFlow,
+                      PREDICATE&                     aCheckFunction,
+                      const std::size_t              aMaxHops,
+                      CsrGraph::Scratch&             aScratch,
+                      std::vector<CsrGraph::EdgeId>* aEdges = nullptr) const;
+
+  //! Route a single flow using FlowRouteAlgo::Layered.
+  template <class PREDICATE>
+  void routeLayered(FlowDescriptor&           aFlow,
+                    PREDICATE&                aCheckFunction,
+                    const std::size_t         aMaxHops,
+                    CsrGraph::LayeredScratch& aScratch) const;
+
+  /**
+   * @brief Route a single flow with a given algorithm.
+   *
+   * @param aReads if not null, it is overwritten with the parts of the
+   * network whose capacities have been read by the search, see
+   * TouchedEdges::any()
+   */
+  template <class PREDICATE>
+  void routeFlow(FlowDescriptor&           aFlow,
+                 const FlowRouteAlgo       aAlgo,
+                 PREDICATE&                aCheckFunction,
+                 const std::size_t         aMaxHops,
+                 QueryScratch&             aScratch,
+                 std::vector<std::size_t>* aReads) const;
+
+  //! The edges whose capacity has been reduced by the flows admitted since
+  //! the start of a window of routeBatch().
+  class TouchedEdges final
+  {
+   public:
+    explicit TouchedEdges(const CsrGraph& aCsr);
+
+    //! Mark an edge as touched.
+    void add(const CsrGraph::EdgeId aEdge);
+
+    /**
+     * @return true if a search of a flow may have read the capacity of a
+     * touched edge.
+     *
+     * @param aAlgo the routing algorithm of the search
+     * @param aReads the edges of the candidate paths with
+     * FlowRouteAlgo::Iterative, the vertices reached with
+     * FlowRouteAlgo::Layered, whose out-edges have been read
+     */
+    bool any(const FlowRouteAlgo             aAlgo,
+             const std::vector<std::size_t>& aReads) const;
+
+    //! Unmark all the edges.
+    void clear();
+
+   private:
+    const CsrGraph&               theCsr;
+    std::vector<char>             theEdges;   //!< indexed by edge
+    std::vector<char>             theSources; //!< indexed by vertex
+    std::vector<CsrGraph::EdgeId> theTouched;
+  };
+
+  //! Remove the gross rate of an admitted flow from the edges along its path
+  //! and mark them as touched.
+  void reserve(const FlowDescriptor& aFlow, TouchedEdges& aTouched);
+
+  /**
+   * @brief The paths of the apps being routed, found as they are needed.
+   *
+   * For every app, the pool only contains the remaining paths with the
+   * shortest length, in the same order as if all the k-shortest paths
+   * towards its peers were found in advance, the invalid ones were
+   * discarded, and the others were sorted by length with a stable sort.
+   *
+   * The check function is only called by refill(), which is implemented by
+   * CheckedAppPaths: the scheduling strategies do not depend on its type, at
+   * the cost of an indirect call every time the remaining paths of an app
+   * with a given length are exhausted.
+   */
+  class AppPaths
+  {
+   public:
+    AppPaths(EsNetwork&                  aNetwork,
+             std::vector<AppDescriptor>& aApps,
+             const std::size_t           aK,
+             const AppHopLimitFunction&  aHopLimit);
+
+    virtual ~AppPaths();
+
+    //! \return the pool containing the remaining paths of the apps.
+    const PathPool& pool() const noexcept {
+      return thePool;
+    }
+
+    //! Add to the pool the next remaining paths of an app, which must have
+    //! none left, with the shortest length among those not yet used.
+    virtual void refill(const std::size_t aNdx) = 0;
+
+    //! Add the paths found with the searches to the cache, for the topology
+    //! before the allocation: for every peer these are the first ones that
+    //! would be found with a search of as many paths, or all of them if the
+    //! search is over without a length limit.
+    void cache() const;
+
+   protected:
+    using CsrPath = KspGenerator::Path;
+
+    struct Peer {
+      explicit Peer(const unsigned long aDst, const std::size_t aMaxHops);
+
+      //! \return the paths found so far.
+      const std::vector<CsrPath>& paths() const noexcept {
+        return theGenerator ? theGenerator->paths() : theCached;
+      }
+
+      const unsigned long           theDst;
+      const std::size_t             theMaxHops;
+      std::vector<CsrPath>          theCached;    //!< used if no generator
+      std::unique_ptr<KspGenerator> theGenerator; //!< null if paths cached
+      std::size_t                   theNext;      //!< next path not used
+      std::size_t                   theChecked;   //!< next path not checked
+    };
+
+    //! \return true if there is a path towards the peer not yet used, which
+    //! is searched if needed.
+    bool hasNext(Peer& aPeer);
+
+    //! \return a path in the CSR snapshot as a path in the graph.
+    Path toPath(const CsrPath& aPath) const;
+
+    //! \return the vertices traversed by a path, separated by commas.
+    std::string toString(const CsrPath& aPath) const;
+
+   private:
+    // use the paths in the cache, if any, within the maximum length
+    bool cached(const unsigned long aHost, Peer& aPeer);
+
+   protected:
+    EsNetwork&                     theNetwork;
+    std::vector<AppDescriptor>&    theApps;
+    PathPool                       thePool;
+    std::vector<std::vector<Peer>> thePeers; //!< for each app
+
+   private:
+    const std::size_t   theK;
+    const std::uint64_t theTopologyVersion; //!< before routing
+    CsrGraph            theTopology;
+    CsrGraph::Scratch   theScratch;
+  };
+
+  //! The paths of the apps being routed with a given type of check function.
+  template <class PREDICATE>
+  class CheckedAppPaths final : public AppPaths
+  {
+   public:
+    CheckedAppPaths(EsNetwork&                  aNetwork,
+                    std::vector<AppDescriptor>& aApps,
+                    const std::size_t           aK,
+                    PREDICATE&                  aCheckFunction,
+                    const AppHopLimitFunction&  aHopLimit)
+        : AppPaths(aNetwork, aApps, aK, aHopLimit)
+        , theCheckFunction(aCheckFunction) {
+      // noop
+    }
+
+    void refill(const std::size_t aNdx) override;
+
+   private:
+    // make the next path of a peer that is not used yet a valid one, if any,
+    // by discarding the invalid ones and searching more paths if needed
+    bool advance(const AppDescriptor& aApp, Peer& aPeer);
+
+   private:
+    PREDICATE& theCheckFunction;
+  };
+
+  //! Allocate the resources to the apps with the given algorithm, then add
+  //! the paths found to the cache and commit the CSR snapshot.
+  void allocate(std::vector<AppDescriptor>& aApps,
+                const AppRouteAlgo          aAlgo,
+                const double                aQuantum,
+                support::RealRvInterface&   aRv,
+                AppPaths&                   aPaths);
+
   //! Resource allocation of apps using random.
   void routeRandom(std::vector<AppDescriptor>& aApps,
+                   AppPaths&                   aPaths,
                    support::RealRvInterface&   aRv);
 
   //! Resource allocation of apps using best-fit.
-  void routeBestFit(std::vector<AppDescriptor>& aApps);
+  void routeBestFit(std::vector<AppDescriptor>& aApps, AppPaths& aPaths);
 
   //! Resource allocation of apps using DRR.
-  void routeDrr(std::vector<AppDescriptor>& aApps, const double aQuantum);
+  void routeDrr(std::vector<AppDescriptor>& aApps,
+                AppPaths&                   aPaths,
+                const double                aQuantum);
 
   /**
    * @brief Schedule one app.
    *
    * @param aApp the application to be allocated resources
+   * @param aNdx the index of the application
+   * @param aPaths the paths of the applications, which contain the remaining
+   * paths of aApp and find the next ones when these are exhausted
    * @param aResidualCapacity the maximum amount of gross capacity assigned to
    * this application, which is updated after the return of this call
    * @return true if the application is allocated resources
    * @return false otherwise
    */
-  bool schedule(AppDescriptor& aApp, double& aResidualCapacity);
+  bool schedule(AppDescriptor&    aApp,
+                const std::size_t aNdx,
+                AppPaths&         aPaths,
+                double&           aResidualCapacity);
 
  private:
-  double theMeasurementProbability;
+  double                    theMeasurementProbability;
+  std::shared_ptr<KspCache> theKspCache;
 };
 
+template <class PREDICATE>
+double EsNetwork::maxNetRate(const AppDescriptor&       aApp,
+                             const unsigned long        aPeer,
+                             PREDICATE&&                aCheckFunction,
+                             const AppHopLimitFunction& aHopLimit) const {
+  const auto        NUM_PATHS = 10u;
+  CsrGraph::Scratch myScratch;
+  const auto        myResult = kShortestPaths(
+      aApp.theHost, aPeer, NUM_PATHS, aHopLimit(aApp), myScratch);
+  assert(myResult.size() <= NUM_PATHS);
+
+  // return the maximum net rate found, 0 is always a possible output
+  auto ret = 0.0;
+  for (const auto& myPath : myResult) {
+    assert(not myPath.empty());
+    if (aCheckFunction(aApp, myPath) == false) {
+      // this path is invalid
+      continue;
+    }
+    ret = std::max(ret,
+                   toNetRate(minCapacity(myPath, theGraph), myPath.size()));
+  }
+  return ret;
+}
+
+template <class PREDICATE>
+void EsNetwork::route(std::vector<FlowDescriptor>& aFlows,
+                      const FlowRouteAlgo          aAlgo,
+                      PREDICATE&&                  aCheckFunction,
+                      const std::size_t            aMaxHops) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::FlowRouting);
+
+  // pre-condition checks
+  checkFlows(aFlows, aAlgo);
+
+  // working memory of the searches, reused across all the flows
+  QueryScratch myScratch;
+
+  for (auto& myFlow : aFlows) {
+    assert(myFlow.thePath.empty());
+    assert(myFlow.theGrossRate == 0);
+    VLOG(2) << "flow " << myFlow.toString();
+
+    routeFlow(myFlow, aAlgo, aCheckFunction, aMaxHops, myScratch, nullptr);
+
+    if (myFlow.thePath.empty()) {
+      VLOG(2) << "flow rejected " << myFlow.toString();
+
+    } else {
+      VLOG(2) << "flow admitted " << myFlow.toString();
+      // flow admissible: remove the gross capacity from the edges along the
+      // path and then move to the next flow in the list
+      removeCapacityFromPath(myFlow.theSrc,
+                             myFlow.thePath,
+                             myFlow.theGrossRate,
+                             std::nullopt);
+    }
+  }
+}
+
+template <class PREDICATE>
+void EsNetwork::routeBatch(std::vector<FlowDescriptor>& aFlows,
+                           const FlowRouteAlgo          aAlgo,
+                           const std::size_t            aWindow,
+                           PREDICATE&&                  aCheckFunction,
+                           const std::size_t            aMaxHops) {
+  if (aWindow < 2) {
+    route<PREDICATE&>(aFlows, aAlgo, aCheckFunction, aMaxHops);
+    return;
+  }
+
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::FlowRouting);
+
+  // pre-condition checks
+  checkFlows(aFlows, aAlgo);
+
+  // the flows of a window are split into chunks, each searched by a task
+  // with its own working memory, which is reused across all the windows
+  const auto myScheduler = TaskScheduler::current();
+  const auto myNumChunks =
+      std::min(aWindow,
+               myScheduler != nullptr ? 4 * myScheduler->numThreads() :
+                                        std::size_t(1));
+  std::vector<QueryScratch>             myScratches(myNumChunks);
+  std::vector<std::vector<std::size_t>> myReads(aWindow);
+  TouchedEdges                          myTouched(theCsr);
+
+  for (std::size_t myBegin = 0; myBegin < aFlows.size(); myBegin += aWindow) {
+    const auto N = std::min(aWindow, aFlows.size() - myBegin);
+
+    // search the paths of all the flows with the capacities at the start of
+    // the window, which are not changed until all the searches are done
+    parallelFor(
+        0,
+        myNumChunks,
+        1,
+        [&](const std::size_t aFirst, const std::size_t aLast) {
+          for (auto c = aFirst; c < aLast; c++) {
+            for (auto i = N * c / myNumChunks; i < N * (c + 1) / myNumChunks;
+                 i++) {
+              routeFlow(aFlows[myBegin + i],
+                        aAlgo,
+                        aCheckFunction,
+                        aMaxHops,
+                        myScratches[c],
+                        &myReads[i]);
+            }
+          }
+        });
+
+    // admit the flows in order: a flow is searched again only if its result
+    // may depend on the capacities reduced by the flows admitted before it
+    for (std::size_t i = 0; i < N; i++) {
+      auto& myFlow = aFlows[myBegin + i];
+      if (myTouched.any(aAlgo, myReads[i])) {
+        myFlow.thePath.clear();
+        myFlow.theGrossRate = 0;
+        myFlow.theDijsktra  = 0;
+        VLOG(2) << "flow " << myFlow.toString();
+        routeFlow(
+            myFlow, aAlgo, aCheckFunction, aMaxHops, myScratches[0], nullptr);
+      }
+
+      if (myFlow.thePath.empty()) {
+        VLOG(2) << "flow rejected " << myFlow.toString();
+
+      } else {
+        VLOG(2) << "flow admitted " << myFlow.toString();
+        reserve(myFlow, myTouched);
+      }
+    }
+    myTouched.clear();
+  }
+}
+
+template <class PREDICATE>
+bool EsNetwork::admissible(FlowDescriptor&     aFlow,
+                           const FlowRouteAlgo aAlgo,
+                           QueryScratch&       aScratch,
+                           PREDICATE&&         aCheckFunction,
+                           const std::size_t   aMaxHops) const {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::FlowRouting);
+
+  if (aAlgo != FlowRouteAlgo::Iterative and aAlgo != FlowRouteAlgo::Layered) {
+    throw std::runtime_error("invalid flow route algorithm: " +
+                             std::to_string(static_cast<int>(aAlgo)));
+  }
+  checkFlow(aFlow);
+
+  aFlow.thePath.clear();
+  aFlow.theGrossRate = 0;
+  aFlow.theDijsktra  = 0;
+  routeFlow(aFlow, aAlgo, aCheckFunction, aMaxHops, aScratch, nullptr);
+  return not aFlow.thePath.empty();
+}
+
+template <class PREDICATE>
+void EsNetwork::route(std::vector<AppDescriptor>& aApps,
+                      const AppRouteAlgo          aAlgo,
+                      const double                aQuantum,
+                      support::RealRvInterface&   aRv,
+                      const std::size_t           aK,
+                      PREDICATE&&                 aCheckFunction,
+                      const AppHopLimitFunction&  aHopLimit) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::AppRouting);
+
+  // pre-condition checks
+  checkApps(aApps, aK);
+
+  // find the shortest paths from every app towards each of its peers
+  CheckedAppPaths<std::remove_reference_t<PREDICATE>> myPaths(
+      *this, aApps, aK, aCheckFunction, aHopLimit);
+  for (std::size_t i = 0; i < aApps.size(); i++) {
+    myPaths.refill(i);
+  }
+
+  allocate(aApps, aAlgo, aQuantum, aRv, myPaths);
+}
+
+template <class PREDICATE>
+void EsNetwork::routeIterative(FlowDescriptor&                aFlow,
+                               PREDICATE&                     aCheckFunction,
+                               const std::size_t              aMaxHops,
+                               CsrGraph::Scratch&             aScratch,
+                               std::vector<CsrGraph::EdgeId>* aEdges) const {
+  // the edges removed during the search are only excluded in the working
+  // memory, hence there is no need to make a copy of the graph
+  theCsr.clearExcluded(aScratch);
+
+  // loop until either there is no path from the source to the destination
+  // or we find a candidate that can satisfy the flow requirements
+  while (true) {
+    aFlow.theDijsktra++;
+    FlowDescriptor myCandidate(aFlow);
+    if (not shortestCandidate(myCandidate, aMaxHops, aScratch)) {
+      return; // disconnected or too far
+    }
+
+    // if the flow is not admissible because of the external function
+    // we assume there is no need to continue the search, otherwise
+    // we check that the gross EPR rate is feasible along the path
+    // selected
+    if (not aCheckFunction(myCandidate)) {
+      return;
+    }
+
+    if (feasible(myCandidate, aScratch, aEdges)) {
+      // flow is admissible on the shortest path, break from loop
+      aFlow.movePathRateFrom(myCandidate);
+      return;
+    }
+  }
+}
+
+template <class PREDICATE>
+void EsNetwork::routeLayered(FlowDescriptor&           aFlow,
+                             PREDICATE&                aCheckFunction,
+                             const std::size_t         aMaxHops,
+                             CsrGraph::LayeredScratch& aScratch) const {
+  aFlow.theDijsktra++;
+  FlowDescriptor myCandidate(aFlow);
+  if (feasibleCandidate(myCandidate, aMaxHops, aScratch) and
+      aCheckFunction(myCandidate)) {
+    aFlow.movePathRateFrom(myCandidate);
+  }
+}
+
+template <class PREDICATE>
+void EsNetwork::routeFlow(FlowDescriptor&           aFlow,
+                          const FlowRouteAlgo       aAlgo,
+                          PREDICATE&                aCheckFunction,
+                          const std::size_t         aMaxHops,
+                          QueryScratch&             aScratch,
+                          std::vector<std::size_t>* aReads) const {
+  if (aReads != nullptr) {
+    aReads->clear();
+  }
+  if (aAlgo == FlowRouteAlgo::Iterative) {
+    routeIterative(
+        aFlow, aCheckFunction, aMaxHops, aScratch.theScratch, aReads);
+  } else {
+    routeLayered(aFlow, aCheckFunction, aMaxHops, aScratch.theLayeredScratch);
+    if (aReads != nullptr) {
+      const auto& myVisited = aScratch.theLayeredScratch.theVisited;
+      aReads->assign(myVisited.begin(), myVisited.end());
+    }
+  }
+}
+
+template <class PREDICATE>
+void EsNetwork::CheckedAppPaths<PREDICATE>::refill(const std::size_t aNdx) {
+  auto& myApp       = theApps[aNdx];
+  auto& myRemaining = myApp.theRemainingPaths;
+  assert(myRemaining.empty());
+
+  auto myShortest = std::numeric_limits<std::size_t>::max();
+  for (auto& myPeer : thePeers[aNdx]) {
+    if (advance(myApp, myPeer)) {
+      myShortest = std::min(myShortest, myPeer.paths()[myPeer.theNext].size());
+    }
+  }
+
+  myRemaining.theNext = thePool.numPaths();
+  for (auto& myPeer : thePeers[aNdx]) {
+    while (advance(myApp, myPeer) and
+           myPeer.paths()[myPeer.theNext].size() == myShortest) {
+      for (const auto myEdge : myPeer.paths()[myPeer.theNext]) {
+        thePool.addEdge(myEdge);
+      }
+      thePool.close();
+      myPeer.theNext++;
+    }
+  }
+  myRemaining.theEnd = thePool.numPaths();
+  if (not myRemaining.empty()) {
+    myRemaining.theShortest = myShortest;
+  }
+}
+
+template <class PREDICATE>
+bool EsNetwork::CheckedAppPaths<PREDICATE>::advance(
+    const AppDescriptor& aApp, Peer& aPeer) {
+  while (aPeer.theChecked == aPeer.theNext) {
+    if (not hasNext(aPeer)) {
+      return false;
+    }
+
+    // the paths are only converted if they are checked
+    const auto& myPath  = aPeer.paths()[aPeer.theNext];
+    auto        myValid = true;
+    if constexpr (not std::is_same_v<std::decay_t<PREDICATE>, AcceptAll>) {
+      myValid = theCheckFunction(aApp, toPath(myPath));
+    }
+    VLOG(2) << aApp.theHost << " -> " << aPeer.theDst << ": "
+            << (myValid ? "valid" : "invalid") << " path found ["
+            << myPath.size() << "] {" << toString(myPath) << "}";
+    if (not myValid) {
+      aPeer.theNext++;
+    }
+    aPeer.theChecked = aPeer.theNext + (myValid ? 1 : 0);
+  }
+  return true;
+}
+
 } // namespace qr
 } // namespace uiiit
@@ -0,0 +1,225 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Discrete-event simulation engine.
+ *
+ * The pending events are kept in a binary heap ordered by time, and the events
+ * with the same time are executed in the order in which they were scheduled.
+ * Every type of event has its own handler, which can schedule new events.
+ *
+ * The statistics can be collected only after a warm-up period, and those that
+ * are time-weighted can be updated by a function called whenever the
+ * simulated clock advances, or by means of support::SummaryWeightedStat
+ * objects bound to clock().
+ *
+ * @tparam EVENTS The types of events, which must be all different.
+ */
+template <class... EVENTS>
+class EventEngine final
+{
+ public:
+  using Event = std::variant<EVENTS...>;
+
+  /**
+   * @brief Create an engine with the clock at 0 and no pending events.
+   *
+   * @param aWarmup The duration of the warm-up period.
+   *
+   * @throw std::runtime_error if the warm-up duration is negative.
+   */
+  explicit EventEngine(const double aWarmup)
+      : theWarmup(aWarmup)
+      , theNow(0)
+      , theNextId(0)
+      , theNumExecuted(0)
+      , theHeap()
+      , theHandlers()
+      , theAdvanceFunction() {
+    if (aWarmup < 0) {
+      throw std::runtime_error("invalid negative warm-up duration: " +
+                               std::to_string(aWarmup));
+    }
+  }
+
+  //! Set the handler of the events of type E.
+  template <class E>
+  void handler(std::function<void(E&)> aHandler) {
+    std::get<std::function<void(E&)>>(theHandlers) = std::move(aHandler);
+  }
+
+  /**
+   * @brief Set a function called whenever the clock advances.
+   *
+   * The function is called before executing an event with a time greater than
+   * the current one and at the end of run(), with the start and end of the
+   * period elapsed, both after the warm-up period. For instance, this can be
+   * used to integrate over time a quantity that only changes upon events.
+   */
+  void onAdvance(std::function<void(double aFrom, double aTo)> aFunction) {
+    theAdvanceFunction = std::move(aFunction);
+  }
+
+  /**
+   * @brief Schedule an event.
+   *
+   * @param aTime The time of the event.
+   * @param aEvent The event.
+   *
+   * @throw std::runtime_error if aTime is in the past.
+   */
+  template <class E>
+  void schedule(const double aTime, E&& aEvent) {
+    if (aTime < theNow) {
+      throw std::runtime_error("cannot schedule an event at time " +
+                               std::to_string(aTime) + " in the past (now " +
+                               std::to_string(theNow) + ")");
+    }
+    theHeap.emplace_back(
+        Item{aTime, theNextId++, Event(std::forward<E>(aEvent))});
+    std::push_heap(theHeap.begin(), theHeap.end(), std::greater<Item>());
+  }
+
+  /**
+   * @brief Execute all the events up to a given time, included.
+   *
+   * At the end the clock is advanced to aEnd, even if there are no events.
+   *
+   * @param aEnd The end time of the simulation.
+   * @return the number of events executed.
+   *
+   * @throw std::runtime_error if aEnd is in the past or there is no handler
+   * for an event.
+   */
+  std::size_t run(const double aEnd) {
+    if (aEnd < theNow) {
+      throw std::runtime_error("cannot run until time " +
+                               std::to_string(aEnd) + " in the past (now " +
+                               std::to_string(theNow) + ")");
+    }
+    const auto myNumExecuted = theNumExecuted;
+    while (not theHeap.empty() and theHeap.front().theTime <= aEnd) {
+      std::pop_heap(theHeap.begin(), theHeap.end(), std::greater<Item>());
+      auto myEvent = std::move(theHeap.back().theEvent);
+      advance(theHeap.back().theTime);
+      theHeap.pop_back();
+      std::visit([this](auto& aEvent) { execute(aEvent); }, myEvent);
+      theNumExecuted++;
+    }
+    advance(aEnd);
+    return theNumExecuted - myNumExecuted;
+  }
+
+  //! \return the current time.
+  double now() const noexcept {
+    return theNow;
+  }
+
+  //! \return the current time, by reference.
+  const double& clock() const noexcept {
+    return theNow;
+  }
+
+  //! \return the duration of the warm-up period.
+  double warmup() const noexcept {
+    return theWarmup;
+  }
+
+  //! \return true if the warm-up period is over.
+  bool warm() const noexcept {
+    return theNow >= theWarmup;
+  }
+
+  //! \return the number of events scheduled and not executed yet.
+  std::size_t numPending() const noexcept {
+    return theHeap.size();
+  }
+
+  //! \return the number of events executed so far.
+  std::size_t numExecuted() const noexcept {
+    return theNumExecuted;
+  }
+
+ private:
+  struct Item {
+    double        theTime;
+    std::uint64_t theId; //!< to break ties in order of scheduling
+    Event         theEvent;
+
+    bool operator>(const Item& aOther) const noexcept {
+      return std::tie(theTime, theId) > std::tie(aOther.theTime, aOther.theId);
+    }
+  };
+
+  void advance(const double aTime) {
+    if (theAdvanceFunction and aTime > theWarmup and aTime > theNow) {
+      theAdvanceFunction(std::max(theNow, theWarmup), aTime);
+    }
+    theNow = aTime;
+  }
+
+  template <class E>
+  void execute(E& aEvent) {
+    const auto& myHandler = std::get<std::function<void(E&)>>(theHandlers);
+    if (not myHandler) {
+      throw std::runtime_error("no handler set for an event type");
+    }
+    myHandler(aEvent);
+  }
+
+ private:
+  const double                                  theWarmup;
+  double                                        theNow;
+  std::uint64_t                                 theNextId;
+  std::size_t                                   theNumExecuted;
+  std::vector<Item>                             theHeap;
+  std::tuple<std::function<void(EVENTS&)>...>   theHandlers;
+  std::function<void(double aFrom, double aTo)> theAdvanceFunction;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,80 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/fidelityhoptable.h"
+#include "QuantumRouting/qrutils.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace uiiit {
+namespace qr {
+
+FidelityHopTable::FidelityHopTable(const double               p1,
+                                   const double               p2,
+                                   const double               eta,
+                                   const std::vector<double>& aFidelityInits,
+                                   const std::vector<double>& aThresholds)
+    : theMaxHops() {
+  if (not(p1 > 0 and p1 <= 1) or not(p2 > 0 and p2 <= 1)) {
+    throw std::runtime_error("invalid reliability of the operations: p1 " +
+                             std::to_string(p1) + ", p2 " + std::to_string(p2));
+  }
+  if (not(eta >= 0.5 and eta <= 1)) {
+    throw std::runtime_error("invalid measurement probability: " +
+                             std::to_string(eta));
+  }
+  for (const auto myFidelityInit : aFidelityInits) {
+    if (not(myFidelityInit >= 0 and myFidelityInit <= 1)) {
+      throw std::runtime_error("invalid local fidelity: " +
+                               std::to_string(myFidelityInit));
+    }
+    for (const auto myThreshold : aThresholds) {
+      theMaxHops.emplace(
+          std::make_pair(myFidelityInit, myThreshold),
+          fidelityMaxHops(p1, p2, eta, myFidelityInit, myThreshold));
+    }
+  }
+}
+
+std::size_t FidelityHopTable::operator()(const double aFidelityInit,
+                                         const double aThreshold) const {
+  const auto it = theMaxHops.find(std::make_pair(aFidelityInit, aThreshold));
+  if (it == theMaxHops.end()) {
+    throw std::runtime_error("no hop limit for local fidelity " +
+                             std::to_string(aFidelityInit) + " and threshold " +
+                             std::to_string(aThreshold));
+  }
+  return it->second;
+}
+
+} // namespace qr
+} // namespace uiiit
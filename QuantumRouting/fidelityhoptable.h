@@ -0,0 +1,93 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Maximum path length, in number of edges, for every combination of
+ * local entanglement fidelity and end-to-end fidelity threshold of a
+ * campaign, see fidelityMaxHops().
+ *
+ * The table is computed once, then it can be used to bound the searches of
+ * the paths, which can stop as soon as the limit is reached instead of
+ * finding longer paths that would be rejected by the fidelity threshold.
+ */
+class FidelityHopTable final
+{
+ public:
+  /**
+   * @brief Compute the limits for all the combinations of the values passed.
+   *
+   * @param p1 the reliability on one-qubit operations
+   * @param p2 the reliability of two-qubit operations
+   * @param eta the probability of a wrong measurement
+   * @param aFidelityInits the local entanglement fidelities
+   * @param aThresholds the end-to-end fidelity thresholds
+   *
+   * @throw std::runtime_error if p1, p2, eta, or any of the fidelities are out
+   * of the ranges of fidelitySwapping().
+   */
+  explicit FidelityHopTable(const double               p1,
+                            const double               p2,
+                            const double               eta,
+                            const std::vector<double>& aFidelityInits,
+                            const std::vector<double>& aThresholds);
+
+  /**
+   * @return the maximum number of edges of a path with the given local
+   * fidelity and end-to-end threshold, std::numeric_limits<std::size_t>::max()
+   * if there is no limit.
+   *
+   * @throw std::runtime_error if the combination is not in the table.
+   */
+  std::size_t operator()(const double aFidelityInit,
+                         const double aThreshold) const;
+
+  //! \return the number of combinations in the table.
+  std::size_t size() const noexcept {
+    return theMaxHops.size();
+  }
+
+ private:
+  // key: (local fidelity, threshold)
+  std::map<std::pair<double, double>, std::size_t> theMaxHops;
+};
+
+} // namespace qr
+} // namespace uiiit
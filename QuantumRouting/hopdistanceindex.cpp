@@ -0,0 +1,152 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/hopdistanceindex.h"
+#include "QuantumRouting/instrumentation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace uiiit {
+namespace qr {
+
+HopDistanceIndex::HopDistanceIndex(const CsrGraph&                   aGraph,
+                                   const std::vector<unsigned long>& aTargets)
+    : theNumVertices(aGraph.numVertices())
+    , theTargets()
+    , theDistances() {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Reachability);
+
+  const auto V = theNumVertices;
+  for (const auto myTarget : aTargets) {
+    if (myTarget < V) {
+      theTargets.emplace_back(myTarget);
+    }
+  }
+  std::sort(theTargets.begin(), theTargets.end());
+  theTargets.erase(std::unique(theTargets.begin(), theTargets.end()),
+                   theTargets.end());
+
+  // in-edges of every vertex, i.e., the enabled edges of the reversed graph
+  std::vector<std::size_t> myOffsets(V + 1, 0);
+  for (std::size_t u = 0; u < V; u++) {
+    const auto myRange = aGraph.outEdges(u);
+    for (auto e = myRange.first; e < myRange.second; e++) {
+      if (aGraph.enabled(e)) {
+        myOffsets[aGraph.target(e) + 1]++;
+      }
+    }
+  }
+  for (std::size_t v = 0; v < V; v++) {
+    myOffsets[v + 1] += myOffsets[v];
+  }
+  std::vector<std::size_t> mySources(myOffsets.back());
+  std::vector<std::size_t> myNext(myOffsets.begin(), myOffsets.end() - 1);
+  for (std::size_t u = 0; u < V; u++) {
+    const auto myRange = aGraph.outEdges(u);
+    for (auto e = myRange.first; e < myRange.second; e++) {
+      if (aGraph.enabled(e)) {
+        mySources[myNext[aGraph.target(e)]++] = u;
+      }
+    }
+  }
+
+  // one breadth-first search per target, each filling its own row
+  theDistances.assign(theTargets.size() * V, INFINITE_DISTANCE);
+  Instrumentation::LocalCounter myRelaxed(
+      Instrumentation::Counter::EdgesRelaxed);
+  std::vector<std::size_t> myQueue;
+  myQueue.reserve(V);
+  for (std::size_t t = 0; t < theTargets.size(); t++) {
+    Instrumentation::count(Instrumentation::Counter::PathSearches);
+    const auto myRow = theDistances.begin() + t * V;
+    myQueue.clear();
+    myQueue.emplace_back(theTargets[t]);
+    myRow[theTargets[t]] = 0;
+    for (std::size_t myHead = 0; myHead < myQueue.size(); myHead++) {
+      const auto v = myQueue[myHead];
+      for (auto i = myOffsets[v]; i < myOffsets[v + 1]; i++) {
+        ++myRelaxed;
+        const auto u = mySources[i];
+        if (myRow[u] == INFINITE_DISTANCE) {
+          if (myRow[v] + 1 >= INFINITE_DISTANCE) {
+            throw std::range_error(
+                "hop distance too large for a hop distance index: " +
+                std::to_string(myRow[v] + 1));
+          }
+          myRow[u] = myRow[v] + 1;
+          myQueue.emplace_back(u);
+        }
+      }
+    }
+  }
+}
+
+std::vector<unsigned long>
+HopDistanceIndex::closest(const unsigned long       aSrc,
+                          const unsigned long       aNum,
+                          support::RealRvInterface& aRv) const {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Reachability);
+
+  std::vector<unsigned long> ret;
+  if (aNum == 0) {
+    return ret;
+  }
+  assert(aSrc < theNumVertices);
+
+  // add a tiny floating point variation to the distances to break ties, as
+  // in CapacityNetwork::closestNodes(): since the targets are visited in
+  // increasing order, so are those with the same distance and variation
+  std::vector<std::pair<double, unsigned long>> myDestinations;
+  myDestinations.reserve(theTargets.size());
+  for (std::size_t t = 0; t < theTargets.size(); t++) {
+    const auto myDistance = distance(aSrc, t);
+    if (theTargets[t] != aSrc and myDistance != INFINITE_DISTANCE) {
+      myDestinations.emplace_back(myDistance + aRv() * .1, theTargets[t]);
+    }
+  }
+
+  // only the first aNum destinations need to be sorted
+  const auto myNum = std::min<std::size_t>(aNum, myDestinations.size());
+  std::partial_sort(myDestinations.begin(),
+                    myDestinations.begin() + myNum,
+                    myDestinations.end());
+  for (std::size_t i = 0; i < myNum; i++) {
+    ret.emplace_back(myDestinations[i].second);
+  }
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,117 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/csrgraph.h"
+#include "Support/random.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Distance, in hops, from every vertex of a graph to each of a small
+ * set of targets, e.g., the data centers that can be assigned to the apps.
+ *
+ * The distances are found once, with a breadth-first search from each
+ * target on the reversed graph following the edges enabled at the time of
+ * construction, and they are stored in a compact matrix with one row per
+ * target. Then the targets closest to a vertex are found without searching
+ * the graph, only looking at the targets.
+ */
+class HopDistanceIndex final
+{
+ public:
+  //! Distance of the vertices that cannot reach a target.
+  static constexpr std::uint16_t INFINITE_DISTANCE =
+      std::numeric_limits<std::uint16_t>::max();
+
+  /**
+   * @brief Find the distances of all the vertices from the targets.
+   *
+   * @param aGraph The graph.
+   * @param aTargets The targets, duplicates and vertices not in the graph
+   * are ignored.
+   *
+   * @throw std::range_error if a distance cannot be represented with 16
+   * bits, i.e., it is INFINITE_DISTANCE or more, which is only possible if
+   * the graph has more than INFINITE_DISTANCE vertices.
+   */
+  explicit HopDistanceIndex(const CsrGraph&                   aGraph,
+                            const std::vector<unsigned long>& aTargets);
+
+  //! \return the targets, in increasing order.
+  const std::vector<unsigned long>& targets() const noexcept {
+    return theTargets;
+  }
+
+  //! \return the distance, in hops, from a vertex to the i-th target.
+  std::uint16_t distance(const std::size_t aVertex,
+                         const std::size_t i) const noexcept {
+    return theDistances[i * theNumVertices + aVertex];
+  }
+
+  /**
+   * @brief Find the aNum targets closest to a source vertex.
+   *
+   * The targets are sorted by distance from aSrc, with ties broken at
+   * random, excluding aSrc itself and those that cannot be reached from it.
+   *
+   * The result is statistically equivalent, but not identical, to that of
+   * CapacityNetwork::closestNodes() with the targets as white list: the
+   * random variable is drawn once per reachable target, in increasing order
+   * of target, while closestNodes() draws it once per reachable node,
+   * including those not in the white list. Therefore, with the same aRv, the
+   * ties may be broken differently and aRv is left in a different state.
+   *
+   * @param aSrc Source vertex.
+   * @param aNum Number of closest targets to find.
+   * @param aRv A r.v. in [0,1] to break ties.
+   * @return the closest targets, by increasing distance.
+   * @post the size of the returned vector is smaller than or equal to aNum
+   */
+  std::vector<unsigned long> closest(const unsigned long       aSrc,
+                                     const unsigned long       aNum,
+                                     support::RealRvInterface& aRv) const;
+
+ private:
+  const std::size_t          theNumVertices;
+  std::vector<unsigned long> theTargets;
+  std::vector<std::uint16_t> theDistances; //!< size: targets x vertices
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,129 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/instrumentation.h"
+
+#include <sstream>
+
+namespace uiiit {
+namespace qr {
+
+Instrumentation::Instrumentation()
+    : theTimes()
+    , theCounters() {
+  for (auto& myTime : theTimes) {
+    myTime = 0;
+  }
+  for (auto& myCounter : theCounters) {
+    myCounter = 0;
+  }
+}
+
+Instrumentation::Instrumentation(const Instrumentation& aOther)
+    : Instrumentation() {
+  *this = aOther;
+}
+
+Instrumentation& Instrumentation::operator=(const Instrumentation& aOther) {
+  for (std::size_t i = 0; i < NUM_PHASES; i++) {
+    theTimes[i] = aOther.theTimes[i].load(std::memory_order_relaxed);
+  }
+  for (std::size_t i = 0; i < NUM_COUNTERS; i++) {
+    theCounters[i] = aOther.theCounters[i].load(std::memory_order_relaxed);
+  }
+  return *this;
+}
+
+double Instrumentation::time(const Phase aPhase) const {
+  return theTimes[static_cast<std::size_t>(aPhase)].load(
+             std::memory_order_relaxed) *
+         1e-9;
+}
+
+std::uint64_t Instrumentation::value(const Counter aCounter) const {
+  return theCounters[static_cast<std::size_t>(aCounter)].load(
+      std::memory_order_relaxed);
+}
+
+const std::vector<std::string>& Instrumentation::names() {
+  static const std::vector<std::string> myNames({
+      "num-path-searches",
+      "num-edges-relaxed",
+      "num-graph-copies",
+      "num-allocations",
+      "time-topology",
+      "time-reachability",
+      "time-peer-assignment",
+      "time-assignment-solve",
+      "time-ksp",
+      "time-flow-routing",
+      "time-app-routing",
+      "time-app-scheduling",
+      "time-mecqkd-allocation",
+  });
+  static_assert(NUM_COUNTERS + NUM_PHASES == 13);
+  return myNames;
+}
+
+std::string Instrumentation::toCsv() const {
+  std::stringstream myStream;
+  for (std::size_t i = 0; i < NUM_COUNTERS; i++) {
+    myStream << (i == 0 ? "" : ",") << value(static_cast<Counter>(i));
+  }
+  for (std::size_t i = 0; i < NUM_PHASES; i++) {
+    myStream << ',' << time(static_cast<Phase>(i));
+  }
+  return myStream.str();
+}
+
+std::string Instrumentation::toString() const {
+  if (not enabled()) {
+    return "costs not collected";
+  }
+  std::stringstream myStream;
+  myStream << value(Counter::PathSearches) << " path searches, "
+           << value(Counter::EdgesRelaxed) << " edges relaxed, "
+           << value(Counter::GraphCopies) << " graph copies, "
+           << value(Counter::Allocations) << " allocations; time (s) in "
+           << "topology " << time(Phase::Topology) << ", reachability "
+           << time(Phase::Reachability) << ", peer assignment "
+           << time(Phase::PeerAssignment) << " (solve "
+           << time(Phase::AssignmentSolve) << "), k-shortest paths "
+           << time(Phase::Ksp) << ", flow routing "
+           << time(Phase::FlowRouting) << ", app routing "
+           << time(Phase::AppRouting) << " (scheduling "
+           << time(Phase::AppScheduling) << "), MEC QKD allocation "
+           << time(Phase::MecQkdAllocation);
+  return myStream.str();
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,270 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Costs of the routing functions, i.e., the time spent in every phase
+ * and the number of elementary operations.
+ *
+ * The costs are added to the active Instrumentation of the calling thread,
+ * if any, which is set with a Scope object, e.g., for the whole run of an
+ * experiment. The tasks of a TaskScheduler inherit the active
+ * Instrumentation of the thread pushing them, hence they contribute to the
+ * costs of the same run even if executed by other workers.
+ *
+ * The costs are only collected if compiled with QR_INSTRUMENTATION defined,
+ * otherwise all the functions are no-ops: the costs are always zero.
+ *
+ * The time of a phase includes that of the phases nested in it, e.g., the
+ * peer assignment includes the search of the k-shortest paths, and it is
+ * summed over all the threads running the phase at the same time.
+ */
+class Instrumentation final
+{
+ public:
+  enum class Phase : std::size_t {
+    Topology         = 0, //!< network generation with the factories
+    Reachability     = 1, //!< reachable/closest nodes
+    PeerAssignment   = 2, //!< assignment of the peers to the apps
+    AssignmentSolve  = 3, //!< assignment problem solver, e.g., Hungarian
+    Ksp              = 4, //!< k-shortest paths search, including the cache
+    FlowRouting      = 5, //!< routing of flows
+    AppRouting       = 6, //!< routing of apps
+    AppScheduling    = 7, //!< EsNetwork::schedule() during app routing
+    MecQkdAllocation = 8, //!< allocation of MEC QKD apps
+  };
+  static constexpr std::size_t NUM_PHASES = 9;
+
+  enum class Counter : std::size_t {
+    PathSearches = 0, //!< single-source searches and k-shortest paths
+    EdgesRelaxed = 1, //!< edges scanned by the single-source searches
+    GraphCopies  = 2, //!< graphs built from the edges of another one
+    Allocations  = 3, //!< (re-)allocations of the working memory of searches
+  };
+  static constexpr std::size_t NUM_COUNTERS = 4;
+
+  //! Make the given object the active one in this thread, until destroyed.
+  class Scope final
+  {
+   public:
+    //! If aInstrumentation is null, then no costs are collected in this
+    //! thread until destroyed.
+    explicit Scope(Instrumentation* aInstrumentation) noexcept
+#ifdef QR_INSTRUMENTATION
+        : thePrevious(theActive) {
+      theActive = aInstrumentation;
+    }
+#else
+    {
+      (void)aInstrumentation;
+    }
+#endif
+
+    explicit Scope(Instrumentation& aInstrumentation) noexcept
+        : Scope(&aInstrumentation) {
+      // noop
+    }
+
+    ~Scope() {
+#ifdef QR_INSTRUMENTATION
+      theActive = thePrevious;
+#endif
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+#ifdef QR_INSTRUMENTATION
+    Instrumentation* const thePrevious;
+#endif
+  };
+
+  //! Add the time from construction to destruction to a phase.
+  class Timer final
+  {
+   public:
+    explicit Timer(const Phase aPhase) noexcept
+#ifdef QR_INSTRUMENTATION
+        : theInstrumentation(theActive)
+        , thePhase(aPhase)
+        , theStart(theInstrumentation != nullptr ?
+                       std::chrono::steady_clock::now() :
+                       std::chrono::steady_clock::time_point()) {
+      // noop
+    }
+#else
+    {
+      (void)aPhase;
+    }
+#endif
+
+    ~Timer() {
+#ifdef QR_INSTRUMENTATION
+      if (theInstrumentation != nullptr) {
+        const auto myElapsed = std::chrono::steady_clock::now() - theStart;
+        theInstrumentation->theTimes[static_cast<std::size_t>(thePhase)]
+            .fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           myElapsed)
+                           .count(),
+                       std::memory_order_relaxed);
+      }
+#endif
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+   private:
+#ifdef QR_INSTRUMENTATION
+    Instrumentation* const                      theInstrumentation;
+    const Phase                                 thePhase;
+    const std::chrono::steady_clock::time_point theStart;
+#endif
+  };
+
+  //! Counter incremented locally, e.g., in an inner loop, and added to the
+  //! active Instrumentation when destroyed.
+  class LocalCounter final
+  {
+   public:
+    explicit LocalCounter(const Counter aCounter) noexcept
+#ifdef QR_INSTRUMENTATION
+        : theCounter(aCounter)
+        , theValue(0) {
+      // noop
+    }
+#else
+    {
+      (void)aCounter;
+    }
+#endif
+
+    ~LocalCounter() {
+#ifdef QR_INSTRUMENTATION
+      count(theCounter, theValue);
+#endif
+    }
+
+    LocalCounter(const LocalCounter&) = delete;
+    LocalCounter& operator=(const LocalCounter&) = delete;
+
+    void operator++() noexcept {
+#ifdef QR_INSTRUMENTATION
+      ++theValue;
+#endif
+    }
+
+   private:
+#ifdef QR_INSTRUMENTATION
+    const Counter theCounter;
+    std::uint64_t theValue;
+#endif
+  };
+
+  //! Create an object with all costs equal to zero.
+  Instrumentation();
+
+  Instrumentation(const Instrumentation& aOther);
+  Instrumentation& operator=(const Instrumentation& aOther);
+
+  //! \return true if compiled with QR_INSTRUMENTATION defined.
+  static constexpr bool enabled() noexcept {
+#ifdef QR_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  //! \return the active object of this thread, null if there is none.
+  static Instrumentation* active() noexcept {
+#ifdef QR_INSTRUMENTATION
+    return theActive;
+#else
+    return nullptr;
+#endif
+  }
+
+  //! Add a value to a counter of the active object, if any.
+  static void count(const Counter aCounter, const std::uint64_t aValue = 1) {
+#ifdef QR_INSTRUMENTATION
+    if (theActive != nullptr) {
+      theActive->theCounters[static_cast<std::size_t>(aCounter)].fetch_add(
+          aValue, std::memory_order_relaxed);
+    }
+#else
+    (void)aCounter;
+    (void)aValue;
+#endif
+  }
+
+  //! \return the time spent in a phase, in s.
+  double time(const Phase aPhase) const;
+
+  //! \return the value of a counter.
+  std::uint64_t value(const Counter aCounter) const;
+
+  //! \return the names of the columns of toCsv().
+  static const std::vector<std::string>& names();
+
+  //! \return the counters followed by the times of the phases, in CSV format.
+  std::string toCsv() const;
+
+  //! \return a human-readable string.
+  std::string toString() const;
+
+ private:
+#ifdef QR_INSTRUMENTATION
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                "the costs must be lock-free to be used in the hot paths");
+
+  static inline thread_local Instrumentation* theActive = nullptr;
+#endif
+
+  std::array<std::atomic<std::uint64_t>, NUM_PHASES>   theTimes; //!< in ns
+  std::array<std::atomic<std::uint64_t>, NUM_COUNTERS> theCounters;
+};
+
+} // namespace qr
+} // namespace uiiit
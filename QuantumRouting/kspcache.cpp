@@ -0,0 +1,130 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/kspcache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+KspCache::KspCache(const std::size_t aMaxTopologies)
+    : theMaxTopologies(aMaxTopologies)
+    , theMutex()
+    , theTopologies()
+    , theHits(0)
+    , theMisses(0) {
+  if (theMaxTopologies == 0) {
+    throw std::runtime_error("invalid zero size of k-shortest paths cache");
+  }
+}
+
+bool KspCache::find(const std::uint64_t aTopology,
+                    const unsigned long aSrc,
+                    const unsigned long aDst,
+                    const std::size_t   aK,
+                    Paths&              aPaths) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+
+  const auto it = std::find_if(
+      theTopologies.begin(), theTopologies.end(), [aTopology](const auto& t) {
+        return t.first == aTopology;
+      });
+  if (it != theTopologies.end()) {
+    // move the topology to the front, even if the pair is not found
+    theTopologies.splice(theTopologies.begin(), theTopologies, it);
+    const auto jt = it->second.find({aSrc, aDst});
+    if (jt != it->second.end() and
+        (aK <= jt->second.theK or
+         jt->second.thePaths.size() < jt->second.theK)) {
+      theHits++;
+      const auto myNum = std::min(aK, jt->second.thePaths.size());
+      aPaths.assign(jt->second.thePaths.begin(),
+                    jt->second.thePaths.begin() + myNum);
+      return true;
+    }
+  }
+  theMisses++;
+  return false;
+}
+
+void KspCache::insert(const std::uint64_t aTopology,
+                      const unsigned long aSrc,
+                      const unsigned long aDst,
+                      const std::size_t   aK,
+                      const Paths&        aPaths) {
+  assert(aPaths.size() <= aK);
+  const std::lock_guard<std::mutex> myLock(theMutex);
+
+  auto it = std::find_if(
+      theTopologies.begin(), theTopologies.end(), [aTopology](const auto& t) {
+        return t.first == aTopology;
+      });
+  if (it == theTopologies.end()) {
+    if (theTopologies.size() == theMaxTopologies) {
+      theTopologies.pop_back();
+    }
+    theTopologies.emplace_front(aTopology, Entries());
+  } else {
+    theTopologies.splice(theTopologies.begin(), theTopologies, it);
+  }
+
+  auto& myEntry = theTopologies.front().second[{aSrc, aDst}];
+  if (aK > myEntry.theK) {
+    myEntry.theK     = aK;
+    myEntry.thePaths = aPaths;
+  }
+}
+
+void KspCache::clear() {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  theTopologies.clear();
+}
+
+std::size_t KspCache::numTopologies() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theTopologies.size();
+}
+
+std::size_t KspCache::hits() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theHits;
+}
+
+std::size_t KspCache::misses() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theMisses;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,137 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Cache of the k-shortest paths, in number of hops, between pairs of
+ * nodes of networks with a given topology.
+ *
+ * The entries are grouped by topology version, i.e., an identifier of the
+ * set of edges of the network, so that the same cache can be shared by
+ * multiple networks with the same topology. Only the most recently used
+ * topologies are retained.
+ *
+ * For every pair of nodes only the search with the largest k is retained,
+ * since its first paths are those that would be found with a smaller k. If
+ * the search found fewer paths than requested, then there are no others
+ * and the entry is valid for any k.
+ *
+ * All the methods are thread-safe.
+ */
+class KspCache final
+{
+ public:
+  //! Nodes traversed by a path, not including the source.
+  using Hops  = std::vector<unsigned long>;
+  using Paths = std::vector<Hops>;
+
+  /**
+   * @brief Create an empty cache.
+   *
+   * @param aMaxTopologies The maximum number of topologies retained.
+   *
+   * @throw std::runtime_error if aMaxTopologies is zero.
+   */
+  explicit KspCache(const std::size_t aMaxTopologies = 16);
+
+  /**
+   * @brief Find the k-shortest paths from a source to a destination.
+   *
+   * @param aTopology The topology version of the network.
+   * @param aSrc The source node.
+   * @param aDst The destination node.
+   * @param aK The maximum number of paths.
+   * @param aPaths The paths found, if any, in the same order as the search.
+   * @return true if the paths are in the cache.
+   */
+  bool find(const std::uint64_t aTopology,
+            const unsigned long aSrc,
+            const unsigned long aDst,
+            const std::size_t   aK,
+            Paths&              aPaths);
+
+  /**
+   * @brief Add the result of a k-shortest paths search to the cache.
+   *
+   * @param aTopology The topology version of the network.
+   * @param aSrc The source node.
+   * @param aDst The destination node.
+   * @param aK The maximum number of paths of the search.
+   * @param aPaths The paths found.
+   */
+  void insert(const std::uint64_t aTopology,
+              const unsigned long aSrc,
+              const unsigned long aDst,
+              const std::size_t   aK,
+              const Paths&        aPaths);
+
+  //! Remove all the entries.
+  void clear();
+
+  //! \return the number of topologies in the cache.
+  std::size_t numTopologies() const;
+
+  //! \return the number of successful lookups.
+  std::size_t hits() const;
+
+  //! \return the number of failed lookups.
+  std::size_t misses() const;
+
+ private:
+  struct Entry {
+    std::size_t theK = 0;
+    Paths       thePaths;
+  };
+  using Entries = std::map<std::pair<unsigned long, unsigned long>, Entry>;
+
+  const std::size_t theMaxTopologies;
+
+  mutable std::mutex theMutex;
+  // most recently used first
+  std::list<std::pair<std::uint64_t, Entries>> theTopologies;
+  std::size_t                                  theHits;
+  std::size_t                                  theMisses;
+};
+
+} // namespace qr
+} // namespace uiiit
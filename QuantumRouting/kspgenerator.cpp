@@ -0,0 +1,174 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/kspgenerator.h"
+#include "QuantumRouting/instrumentation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace uiiit {
+namespace qr {
+
+KspGenerator::KspGenerator(const CsrGraph&                 aGraph,
+                           const std::vector<std::size_t>& aRanks,
+                           const std::size_t               aSrc,
+                           const std::size_t               aDst,
+                           const std::size_t               aK,
+                           const std::size_t               aMaxHops)
+    : theGraph(aGraph)
+    , theSrc(aSrc)
+    , theDst(aDst)
+    , theK(std::max<std::size_t>(1, aK))
+    , theMaxHops(aMaxHops)
+    , theDestinations({aDst})
+    , theA()
+    , theB(Less{&aRanks})
+    , theDone(aSrc == aDst or aMaxHops == 0) {
+  if (aSrc >= aGraph.numVertices() or aDst >= aGraph.numVertices()) {
+    throw std::runtime_error("invalid vertices for the k-shortest paths: " +
+                             std::to_string(aSrc) + " -> " +
+                             std::to_string(aDst) + " with " +
+                             std::to_string(aGraph.numVertices()) +
+                             " vertices");
+  }
+  if (aRanks.size() != aGraph.numEdges()) {
+    throw std::runtime_error("invalid number of edge ranks: " +
+                             std::to_string(aRanks.size()) + " instead of " +
+                             std::to_string(aGraph.numEdges()));
+  }
+}
+
+bool KspGenerator::next(CsrGraph::Scratch& aScratch) {
+  if (theDone or theA.size() >= theK) {
+    theDone = true;
+    return false;
+  }
+
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Ksp);
+
+  // the first path is the shortest one
+  if (theA.empty()) {
+    Path myPath;
+    theGraph.clearExcluded(aScratch);
+    if (not search(theSrc, theMaxHops, aScratch, myPath)) {
+      theDone = true;
+      return false;
+    }
+    theA.emplace_back(std::move(myPath));
+    return true;
+  }
+
+  // add to the candidates the deviations from the last path found at each of
+  // its vertices, i.e., the shortest paths from there that do not use the
+  // next edges of the paths found with the same root, nor the vertices of
+  // the root itself; since the candidates longer than the maximum length
+  // would never be selected they are not searched
+  const auto& myLast = theA.back();
+  for (std::size_t i = 0; i < myLast.size(); i++) {
+    theGraph.clearExcluded(aScratch);
+    for (const auto& myPath : theA) {
+      if (myPath.size() > i and
+          std::equal(myLast.begin(), myLast.begin() + i, myPath.begin())) {
+        theGraph.exclude(myPath[i], aScratch);
+      }
+    }
+    for (std::size_t j = 0; j < i; j++) {
+      theGraph.excludeVertex(theGraph.source(myLast[j]), aScratch);
+    }
+
+    Path myCandidate(myLast.begin(), myLast.begin() + i);
+    if (search(theGraph.source(myLast[i]),
+               theMaxHops - i,
+               aScratch,
+               myCandidate)) {
+      theB.emplace(std::move(myCandidate));
+    }
+  }
+
+  if (theB.empty()) {
+    theDone = true;
+    return false;
+  }
+  theA.emplace_back(std::move(theB.extract(theB.begin()).value()));
+  return true;
+}
+
+bool KspGenerator::search(const std::size_t  aSpur,
+                          const std::size_t  aMaxHops,
+                          CsrGraph::Scratch& aScratch,
+                          Path&              aPath) const {
+  static const auto NO_CAPACITY = -std::numeric_limits<double>::infinity();
+  assert(aSpur != theDst);
+
+  theGraph.shortestPathTree(
+      aSpur, NO_CAPACITY, theDestinations, aScratch, aMaxHops);
+  const auto& myPredecessors = aScratch.thePredecessors;
+  if (myPredecessors[theDst] == theDst) {
+    return false;
+  }
+
+  // the edges are those that have been relaxed, i.e., the first ones not
+  // excluded between each vertex and its predecessor
+  const auto myBegin = aPath.size();
+  for (auto v = theDst; v != aSpur; v = myPredecessors[v]) {
+    [[maybe_unused]] auto myFound = false;
+    EdgeId                myEdge;
+    std::tie(myEdge, myFound) =
+        theGraph.findEdge(myPredecessors[v], v, aScratch);
+    assert(myFound);
+    aPath.emplace_back(myEdge);
+  }
+  std::reverse(aPath.begin() + myBegin, aPath.end());
+  return true;
+}
+
+bool KspGenerator::Less::operator()(const Path& aLhs,
+                                    const Path& aRhs) const {
+  if (aLhs.size() != aRhs.size()) {
+    return aLhs.size() < aRhs.size();
+  }
+  return std::lexicographical_compare(
+      aLhs.begin(),
+      aLhs.end(),
+      aRhs.begin(),
+      aRhs.end(),
+      [this](const EdgeId aFirst, const EdgeId aSecond) {
+        return (*theRanks)[aFirst] < (*theRanks)[aSecond];
+      });
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,136 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/csrgraph.h"
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Search of the k-shortest loopless paths, in hops, between two
+ * vertices of a CsrGraph with Yen's algorithm, one path at a time.
+ *
+ * The paths are only found when requested with next(), hence the cost of the
+ * search depends on the number of paths actually used, rather than on k.
+ *
+ * The paths are found in the same order as boost::yen_ksp() with unit weights
+ * on the adjacency list from which the snapshot was made, provided that the
+ * ties between the candidate paths with the same length are broken in the
+ * same way, i.e., by comparing lexicographically the ranks of their edges
+ * given by the caller: with boost::yen_ksp() these are the positions of the
+ * edge descriptors sorted with their operator<.
+ *
+ * The graph and the ranks are not copied, hence they must outlive this object
+ * and they must not be modified while paths are still searched.
+ */
+class KspGenerator final
+{
+ public:
+  using EdgeId = CsrGraph::EdgeId;
+  //! Edges traversed by a path, from the source.
+  using Path = std::vector<EdgeId>;
+
+  /**
+   * @brief Prepare the search, without finding any path yet.
+   *
+   * @param aGraph The graph, only the enabled edges of which are used.
+   * @param aRanks The rank of every edge, used to break the ties.
+   * @param aSrc The source vertex.
+   * @param aDst The destination vertex.
+   * @param aK The maximum number of paths, at least one is searched even if
+   * zero.
+   * @param aMaxHops The maximum length of the paths: the longer ones are not
+   * searched at all.
+   *
+   * @throw std::runtime_error if the vertices do not exist or if the number of
+   * ranks does not match the number of edges.
+   */
+  explicit KspGenerator(const CsrGraph&                 aGraph,
+                        const std::vector<std::size_t>& aRanks,
+                        const std::size_t               aSrc,
+                        const std::size_t               aDst,
+                        const std::size_t               aK,
+                        const std::size_t               aMaxHops);
+
+  /**
+   * @brief Find the next path.
+   *
+   * @param aScratch The working memory of the searches.
+   * @return true if a path has been added to paths(), false if the search is
+   * over: k paths have been found or there are no more paths within the
+   * maximum length.
+   */
+  bool next(CsrGraph::Scratch& aScratch);
+
+  //! \return the paths found so far, in non-decreasing order of length.
+  const std::vector<Path>& paths() const noexcept {
+    return theA;
+  }
+
+  //! \return true if next() cannot find other paths.
+  bool done() const noexcept {
+    return theDone;
+  }
+
+ private:
+  // shortest path from aSpur to the destination, with at most aMaxHops edges,
+  // with the exclusions in aScratch, appended to aPath
+  bool search(const std::size_t  aSpur,
+              const std::size_t  aMaxHops,
+              CsrGraph::Scratch& aScratch,
+              Path&              aPath) const;
+
+  // same order as the candidates in boost::yen_ksp(), i.e., by length first
+  struct Less {
+    bool operator()(const Path& aLhs, const Path& aRhs) const;
+    const std::vector<std::size_t>* theRanks;
+  };
+
+ private:
+  const CsrGraph&               theGraph;
+  const std::size_t             theSrc;
+  const std::size_t             theDst;
+  const std::size_t             theK;
+  const std::size_t             theMaxHops;
+  const std::set<unsigned long> theDestinations; //!< only theDst
+  std::vector<Path>             theA;            //!< paths found
+  std::set<Path, Less>          theB;            //!< candidates
+  bool                          theDone;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -30,11 +30,14 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/mecqkdnetwork.h"
+#include "QuantumRouting/instrumentation.h"
 
 #include "Support/split.h"
 #include "Support/tostring.h"
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <boost/graph/subgraph.hpp>
 #include <fstream>
 #include <glog/logging.h>
@@ -46,6 +49,180 @@ SOFTWARE.
 namespace uiiit {
 namespace qr {
 
+namespace {
+
+/**
+ * @brief Cache of the constrained shortest paths from a user node towards the
+ * edge nodes with a given capacity requirement.
+ *
+ * A search only depends on the edges that discover the vertices it visits,
+ * i.e., the edges of its shortest-path tree: as long as the capacity of these
+ * edges does not drop below the requirement, the other edges can be removed
+ * or decrease their capacity, and a new search would return exactly the same
+ * paths as before. Capacity increases are not tracked, hence the cache is
+ * only valid as long as capacities are only removed from the network.
+ */
+class PathTreeCache final
+{
+ public:
+  using Paths = std::map<unsigned long, std::vector<unsigned long>>;
+
+  explicit PathTreeCache(const CsrGraph& aCsr)
+      : theCsr(aCsr)
+      , theEntries()
+      , theUsers(aCsr.numEdges())
+      , theNextVersion(0)
+      , theHits(0)
+      , theMisses(0) {
+    // noop
+  }
+
+  //! \return the paths found for the given source and capacity, if any.
+  const Paths* find(const unsigned long aSource, const double aCapacity) {
+    const auto it = theEntries.find({aSource, aCapacity});
+    if (it == theEntries.end()) {
+      theMisses++;
+      return nullptr;
+    }
+    theHits++;
+    return &it->second.thePaths;
+  }
+
+  /**
+   * @brief Add the result of a search.
+   *
+   * @param aSource The source node.
+   * @param aCapacity The capacity requirement of the search.
+   * @param aScratch The working memory of the search just done.
+   * @param aPaths The paths found.
+   * @return the paths added.
+   */
+  const Paths& insert(const unsigned long      aSource,
+                      const double             aCapacity,
+                      const CsrGraph::Scratch& aScratch,
+                      const Paths&             aPaths) {
+    const Key  myKey{aSource, aCapacity};
+    const auto myVersion = theNextVersion++;
+    auto&      myEntry   = theEntries[myKey];
+    myEntry.thePaths     = aPaths;
+    myEntry.theVersion   = myVersion;
+
+    // the tree edge of a vertex is the first one in the out-edges of its
+    // predecessor that satisfies the capacity requirement
+    for (const auto v : aScratch.theVisited) {
+      const auto u = aScratch.thePredecessors[v];
+      if (u == v) {
+        continue; // source
+      }
+      const auto myEdges = theCsr.outEdges(u);
+      auto       e       = myEdges.first;
+      while (not(theCsr.target(e) == v and theCsr.enabled(e) and
+                 theCsr.capacity(e) >= aCapacity)) {
+        e++;
+        assert(e < myEdges.second);
+      }
+      theUsers[e].emplace_back(myKey, myVersion);
+    }
+    return myEntry.thePaths;
+  }
+
+  /**
+   * @brief Remove the entries whose searches may be affected by a reduction
+   * of the capacity of the given edges, which must have been already applied.
+   */
+  void update(const std::vector<CsrGraph::EdgeId>& aEdges) {
+    for (const auto e : aEdges) {
+      auto& myUsers = theUsers[e];
+      auto  myKept  = myUsers.begin();
+      for (const auto& myUser : myUsers) {
+        const auto it = theEntries.find(myUser.first);
+        if (it == theEntries.end() or it->second.theVersion != myUser.second) {
+          continue; // stale
+        }
+        if (not theCsr.enabled(e) or theCsr.capacity(e) < myUser.first.second) {
+          theEntries.erase(it);
+        } else {
+          *myKept++ = myUser;
+        }
+      }
+      myUsers.erase(myKept, myUsers.end());
+    }
+  }
+
+  //! \return the number of searches found in the cache.
+  std::size_t hits() const noexcept {
+    return theHits;
+  }
+
+  //! \return the number of searches not found in the cache.
+  std::size_t misses() const noexcept {
+    return theMisses;
+  }
+
+ private:
+  using Key = std::pair<unsigned long, double>; // source, capacity
+  struct Entry {
+    Paths         thePaths;
+    std::uint64_t theVersion = 0;
+  };
+
+  const CsrGraph&                                         theCsr;
+  std::map<Key, Entry>                                    theEntries;
+  std::vector<std::vector<std::pair<Key, std::uint64_t>>> theUsers;
+  std::uint64_t                                           theNextVersion;
+  std::size_t                                             theHits;
+  std::size_t                                             theMisses;
+};
+
+/**
+ * @brief Return the first candidate with minimum value among those feasible,
+ * or the first one if none is feasible.
+ *
+ * The feasibility checks are selected at compile time, so that the loop body
+ * only has the comparison with the current minimum.
+ *
+ * @param aCandidates The candidates.
+ * @param aValues The values to be minimized, one per candidate.
+ * @return the index of the candidate found.
+ */
+template <bool CHECK_PATH, bool CHECK_RESIDUAL, class CANDIDATES>
+std::size_t argMin(const CANDIDATES&          aCandidates,
+                   const std::vector<double>& aValues) noexcept {
+  const auto  N           = aValues.size();
+  const auto* myPathSizes = aCandidates.thePathSizes.data();
+  const auto* myResiduals = aCandidates.theResiduals.data();
+  const auto* myValues    = aValues.data();
+
+  std::size_t ret   = 0;
+  auto        myMin = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < N; i++) {
+    const auto myFeasible = (not CHECK_PATH or myPathSizes[i] > 0) and
+                            (not CHECK_RESIDUAL or myResiduals[i] >= 0);
+    const auto myValue =
+        myFeasible ? myValues[i] : std::numeric_limits<double>::infinity();
+    if (myValue < myMin) {
+      myMin = myValue;
+      ret   = i;
+    }
+  }
+  return ret;
+}
+
+std::vector<double>
+appWeights(const std::vector<MecQkdWorkload::AppInfo>& aAppInfo) {
+  if (aAppInfo.empty()) {
+    throw std::runtime_error("invalid empty MecQkd workload");
+  }
+  std::vector<double> ret;
+  ret.reserve(aAppInfo.size());
+  for (const auto& myAppInfo : aAppInfo) {
+    ret.emplace_back(myAppInfo.theWeight);
+  }
+  return ret;
+}
+
+} // namespace
+
 std::vector<MecQkdAlgo> allMecQkdAlgos() {
   static const std::vector<MecQkdAlgo> myAlgos({
       MecQkdAlgo::Random,
@@ -116,13 +293,9 @@ MecQkdWorkload::MecQkdWorkload(const std::vector<AppInfo>& aAppInfo,
     : theAppInfo(aAppInfo)
     , theRv(aRv)
     , theRegions()
-    , theWeights(aAppInfo.size()) {
-  if (aAppInfo.empty()) {
-    throw std::runtime_error("invalid empty MecQkd workload");
-  }
-  for (std::size_t i = 0; i < aAppInfo.size(); i++) {
-    theRegions.emplace(aAppInfo[i].theRegion);
-    theWeights[i] = aAppInfo[i].theWeight;
+    , theSampler(appWeights(aAppInfo)) {
+  for (const auto& myAppInfo : aAppInfo) {
+    theRegions.emplace(myAppInfo.theRegion);
   }
 
   if (VLOG_IS_ON(1)) {
@@ -164,16 +337,16 @@ MecQkdWorkload MecQkdWorkload::fromCsvFile(const std::string&        aFilename,
 }
 
 MecQkdWorkload::AppInfo MecQkdWorkload::operator()() {
-  const auto res = support::sampleWeighted(theAppInfo, theWeights, 1, theRv);
-  assert(res.size() == 1);
-  return res[0];
+  const auto myIndex = theSampler(theRv);
+  assert(myIndex < theAppInfo.size());
+  return theAppInfo[myIndex];
 }
 
-std::string MecQkdNetwork::EdgeNode::toString() const {
+std::string MecQkdNetwork::Candidates::toString(const std::size_t i) const {
   std::stringstream ret;
-  ret << "#" << theId << ", residual " << theResidual << " (tot "
-      << theAvailable << "), path [" << thePathSize << "] {"
-      << ::toStringStd(thePath, ",") << "} " << (feasible() ? "v" : "x");
+  ret << "#" << theIds[i] << ", residual " << theResiduals[i] << " (tot "
+      << theAvailable[i] << "), path [" << thePathSizes[i] << "] {"
+      << ::toStringStd(*thePaths[i], ",") << "} " << (feasible(i) ? "v" : "x");
   return ret.str();
 }
 
@@ -212,6 +385,12 @@ MecQkdNetwork::MecQkdNetwork(const WeightVector& aEdgeWeights)
   // noop
 }
 
+MecQkdNetwork::MecQkdNetwork(const WeightVector& aEdgeWeights,
+                             const bool          aMakeBidirectional)
+    : CapacityNetwork(aEdgeWeights, aMakeBidirectional) {
+  // noop
+}
+
 void MecQkdNetwork::userNodes(const std::set<unsigned long>& aUserNodes) {
   const auto V = boost::num_vertices(theGraph);
   for (const auto& v : aUserNodes) {
@@ -249,9 +428,44 @@ double MecQkdNetwork::totProcessing() const {
       [](auto aSum, const auto& aElem) { return aSum + aElem.second; });
 }
 
+MecQkdNetwork::Snapshot MecQkdNetwork::snapshot() const {
+  return Snapshot{CapacityNetwork::snapshot(), theEdgeProcessing};
+}
+
+void MecQkdNetwork::restore(const Snapshot& aSnapshot) {
+  if (not std::equal(
+          aSnapshot.theEdgeProcessing.begin(),
+          aSnapshot.theEdgeProcessing.end(),
+          theEdgeProcessing.begin(),
+          theEdgeProcessing.end(),
+          [](const auto& lhs, const auto& rhs) {
+            return lhs.first == rhs.first;
+          })) {
+    throw std::runtime_error(
+        "cannot restore a snapshot with edge nodes " +
+        ::toString(aSnapshot.theEdgeProcessing,
+                   ",",
+                   [](const auto& elem) { return std::to_string(elem.first); }) +
+        " into a network with edge nodes " +
+        ::toString(theEdgeProcessing, ",", [](const auto& elem) {
+          return std::to_string(elem.first);
+        }));
+  }
+  CapacityNetwork::restore(aSnapshot.theCapacities);
+
+  // the keys are the same, hence the values are overwritten in place
+  auto it = theEdgeProcessing.begin();
+  for (const auto& elem : aSnapshot.theEdgeProcessing) {
+    (it++)->second = elem.second;
+  }
+}
+
 void MecQkdNetwork::allocate(std::vector<Allocation>&  aApps,
                              const MecQkdAlgo          aAlgo,
                              support::RealRvInterface& aRv) {
+  const Instrumentation::Timer myTimer(
+      Instrumentation::Phase::MecQkdAllocation);
+
   static const auto EPSILON = 1e-5;
   if (theUserNodes.empty()) {
     throw std::runtime_error("invalid empty set of user nodes");
@@ -272,11 +486,9 @@ void MecQkdNetwork::allocate(std::vector<Allocation>&  aApps,
                  });
   }
 
-  std::vector<EdgeNode> myCandidates;
-  for (auto& elem : theEdgeProcessing) {
-    myCandidates.emplace_back(
-        EdgeNode{elem.first, elem.second, 0, 0, std::vector<unsigned long>()});
-  }
+  Candidates myCandidates;
+  initCandidates(myCandidates);
+  const auto N = myCandidates.size();
 
   // special allocation with SpfStatic
   if (aAlgo == MecQkdAlgo::SpfStatic) {
@@ -284,66 +496,256 @@ void MecQkdNetwork::allocate(std::vector<Allocation>&  aApps,
     return;
   }
 
+  // working memory and output of the constrained shortest path searches,
+  // reused across all the applications, whose results are cached since the
+  // applications share a few user nodes and rates
+  CsrGraph::Scratch                                   myScratch;
+  std::map<unsigned long, std::vector<unsigned long>> mySearchPaths;
+  std::vector<CsrGraph::EdgeId>                       myEdges;
+  PathTreeCache                                       myCache(theCsr);
   for (auto& myApp : aApps) {
-    // compute, for each candidate, the residual capacity, which can be
-    // negative, and the constrained shortest path length, which can be empty
-    const auto myPaths = cspf(myApp.theUserNode, myApp.theRate, theEdgeNodes);
-    assert(myPaths.size() == theEdgeNodes.size());
-    for (auto& myCandidate : myCandidates) {
-      const auto it = myPaths.find(myCandidate.theId);
-      assert(it != myPaths.end());
-      myCandidate.thePath = it->second;
-      myCandidate.thePathSize =
-          it->second.empty() ? 0.0 : (it->second.size() + aRv() * 0.1);
-
-      myCandidate.theResidual = myCandidate.theAvailable - myApp.theLoad;
+    // find the constrained shortest paths to the edge nodes, unless cached
+    auto myCached = myCache.find(myApp.theUserNode, myApp.theRate);
+    if (myCached == nullptr) {
+      cspf(myApp.theUserNode,
+           myApp.theRate,
+           theEdgeNodes,
+           myScratch,
+           mySearchPaths);
+      myCached = &myCache.insert(
+          myApp.theUserNode, myApp.theRate, myScratch, mySearchPaths);
     }
+    const auto mySelected = assign(myApp, *myCached, aAlgo, aRv, myCandidates);
+    if (mySelected < N) {
+      const auto& myPath = *myCandidates.thePaths[mySelected];
 
-    if (VLOG_IS_ON(2)) {
-      LOG(INFO) << "candidates for " << myApp.toString();
-      for (const auto& myCandidate : myCandidates) {
-        LOG(INFO) << myCandidate.toString();
+      // update the available processing capacity on the node selected
+      auto& myAvailable = myCandidates.theAvailable[mySelected];
+      assert(myAvailable >= myApp.theLoad);
+      myAvailable -= myApp.theLoad;
+
+      // update the network capacities and then the cache, whose entries
+      // cannot be used while finding the edges
+      assert(myPath.size() == myApp.thePathLength);
+      myEdges.clear();
+      auto mySrc = myApp.theUserNode;
+      for (const auto myDst : myPath) {
+        [[maybe_unused]] auto myFound = false;
+        CsrGraph::EdgeId      myEdge;
+        std::tie(myEdge, myFound) = theCsr.findEdge(mySrc, myDst, myScratch);
+        assert(myFound);
+        myEdges.emplace_back(myEdge);
+        mySrc = myDst;
       }
+      removeCapacityFromPath(
+          myApp.theUserNode, myPath, myApp.theRate, EPSILON);
+      myCache.update(myEdges);
     }
 
-    auto mySelected = selectCandidate(myCandidates, aAlgo, aRv);
-    if (mySelected != myCandidates.end() and mySelected->feasible()) {
-      // save the allocation data into the output
-      myApp.theAllocated  = true;
-      myApp.theEdgeNode   = mySelected->theId;
-      myApp.thePathLength = static_cast<std::size_t>(mySelected->thePathSize);
+    VLOG(1) << myApp.toString();
+  }
 
-      // update the available processing capacity on the node selected
-      assert(mySelected->theAvailable >= myApp.theLoad);
-      mySelected->theAvailable -= myApp.theLoad;
+  VLOG(1) << "constrained shortest path searches: " << myCache.misses()
+          << ", found in cache: " << myCache.hits();
 
-      // update the network capacities
-      assert(mySelected->thePath.size() == myApp.thePathLength);
-      removeCapacityFromPath(myApp.theUserNode,
-                             mySelected->thePath,
-                             myApp.theRate,
-                             EPSILON,
-                             theGraph);
+  // update the edge node available processing power after the allocation
+  auto it = theEdgeProcessing.begin();
+  for (std::size_t i = 0; i < N; i++, ++it) {
+    assert(it->first == myCandidates.theIds[i]);
+    it->second = myCandidates.theAvailable[i];
+  }
+}
+
+bool MecQkdNetwork::admissible(Allocation&               aApp,
+                               const MecQkdAlgo          aAlgo,
+                               support::RealRvInterface& aRv,
+                               QueryScratch&             aScratch) const {
+  const Instrumentation::Timer myTimer(
+      Instrumentation::Phase::MecQkdAllocation);
+
+  if (theUserNodes.empty()) {
+    throw std::runtime_error("invalid empty set of user nodes");
+  }
+  if (theEdgeNodes.empty()) {
+    throw std::runtime_error("invalid empty set of edge nodes");
+  }
+
+  aApp.theAllocated  = false;
+  aApp.theEdgeNode   = 0;
+  aApp.thePathLength = 0;
+  aApp.thePath.clear();
+
+  // with SpfStatic use the shortest path to the closest edge node, as in
+  // allocateSpfStatic()
+  if (aAlgo == MecQkdAlgo::SpfStatic) {
+    cspf(aApp.theUserNode,
+         0,
+         theEdgeNodes,
+         aScratch.theScratch,
+         aScratch.thePaths);
+    const auto min = std::min_element(
+        aScratch.thePaths.begin(),
+        aScratch.thePaths.end(),
+        [](const auto& aLhs, const auto& aRhs) {
+          return aLhs.second.size() < aRhs.second.size();
+        });
+    assert(min != aScratch.thePaths.end());
+    if (min->second.empty()) {
+      return false;
+    }
+    const auto myAvailable = theEdgeProcessing.find(min->first)->second;
+    if (aApp.theRate <= minCapacity(aApp.theUserNode, min->second) and
+        aApp.theLoad < myAvailable) {
+      aApp.theAllocated  = true;
+      aApp.theEdgeNode   = min->first;
+      aApp.thePathLength = min->second.size();
+      aApp.thePath       = min->second;
     }
+    return aApp.theAllocated;
+  }
 
-    VLOG(1) << myApp.toString();
+  auto& myCandidates = aScratch.theCandidates;
+  initCandidates(myCandidates);
+  cspf(aApp.theUserNode,
+       aApp.theRate,
+       theEdgeNodes,
+       aScratch.theScratch,
+       aScratch.thePaths);
+  return assign(aApp, aScratch.thePaths, aAlgo, aRv, myCandidates) <
+         myCandidates.size();
+}
+
+void MecQkdNetwork::commit(const std::vector<Allocation>& aApps) {
+  // first pass: add up the rates on every edge and the loads on every edge
+  // node, throw if needed
+  const auto                         V = theCsr.numVertices();
+  std::map<CsrGraph::EdgeId, double> myDemands;
+  std::map<unsigned long, double>    myLoads;
+  for (const auto& myApp : aApps) {
+    if (not myApp.theAllocated) {
+      continue;
+    }
+    if (theEdgeProcessing.count(myApp.theEdgeNode) == 0) {
+      throw std::runtime_error("Invalid edge node: " +
+                               std::to_string(myApp.theEdgeNode));
+    }
+    if (myApp.thePath.empty() or myApp.thePath.back() != myApp.theEdgeNode) {
+      throw std::runtime_error("Invalid path for " + myApp.toString());
+    }
+    myLoads[myApp.theEdgeNode] += myApp.theLoad;
+    auto mySrc = myApp.theUserNode;
+    for (const auto myDst : myApp.thePath) {
+      if (mySrc >= V or myDst >= V) {
+        throw std::runtime_error("Invalid path for " + myApp.toString());
+      }
+      const auto myEdge = theCsr.findEdge(mySrc, myDst);
+      if (not myEdge.second) {
+        throw std::runtime_error("edge not in the graph: (" +
+                                 std::to_string(mySrc) + "," +
+                                 std::to_string(myDst) + ")");
+      }
+      myDemands[myEdge.first] += myApp.theRate;
+      mySrc = myDst;
+    }
+  }
+  for (const auto& elem : myLoads) {
+    const auto myAvailable = theEdgeProcessing.find(elem.first)->second;
+    if (myAvailable < elem.second) {
+      throw std::runtime_error(
+          "cannot reserve load " + std::to_string(elem.second) + " > " +
+          std::to_string(myAvailable) + " on edge node " +
+          std::to_string(elem.first));
+    }
+  }
+  for (const auto& elem : myDemands) {
+    if (theCsr.capacity(elem.first) < elem.second) {
+      throw std::runtime_error(
+          "cannot reserve capacity " + std::to_string(elem.second) + " > " +
+          std::to_string(theCsr.capacity(elem.first)) + " for edge (" +
+          std::to_string(theCsr.source(elem.first)) + "," +
+          std::to_string(theCsr.target(elem.first)) + ")");
+    }
   }
 
-  // update the edge node available processing power after the allocation
-  for (const auto& myCandidate : myCandidates) {
-    auto it = theEdgeProcessing.find(myCandidate.theId);
-    assert(it != theEdgeProcessing.end());
-    it->second = myCandidate.theAvailable;
+  // second pass: no checks, just do the job; the edges are not pruned, as
+  // with SpfStatic, since the other algorithms ignore them anyway
+  for (const auto& elem : myLoads) {
+    theEdgeProcessing.find(elem.first)->second -= elem.second;
   }
+  for (const auto& myApp : aApps) {
+    if (myApp.theAllocated) {
+      removeCapacityFromPath(
+          myApp.theUserNode, myApp.thePath, myApp.theRate, std::nullopt);
+    }
+  }
+}
+
+void MecQkdNetwork::initCandidates(Candidates& aCandidates) const {
+  aCandidates.theIds.clear();
+  aCandidates.theAvailable.clear();
+  for (auto& elem : theEdgeProcessing) {
+    aCandidates.theIds.emplace_back(elem.first);
+    aCandidates.theAvailable.emplace_back(elem.second);
+  }
+  const auto N = aCandidates.size();
+  aCandidates.theResiduals.resize(N);
+  aCandidates.thePathSizes.resize(N);
+  aCandidates.thePaths.resize(N);
+  aCandidates.theFeasible.reserve(N);
+}
+
+std::size_t MecQkdNetwork::assign(
+    Allocation&                                                aApp,
+    const std::map<unsigned long, std::vector<unsigned long>>& aPaths,
+    const MecQkdAlgo                                           aAlgo,
+    support::RealRvInterface&                                  aRv,
+    Candidates&                                                aCandidates) {
+  // compute, for each candidate, the residual capacity, which can be
+  // negative, and the constrained shortest path length, which can be empty;
+  // the paths are sorted by edge node, like the candidates
+  const auto N = aCandidates.size();
+  assert(aPaths.size() == N);
+  auto it = aPaths.begin();
+  for (std::size_t i = 0; i < N; i++, ++it) {
+    assert(it->first == aCandidates.theIds[i]);
+    aCandidates.thePaths[i] = &it->second;
+    aCandidates.thePathSizes[i] =
+        it->second.empty() ? 0.0 : (it->second.size() + aRv() * 0.1);
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    aCandidates.theResiduals[i] = aCandidates.theAvailable[i] - aApp.theLoad;
+  }
+
+  if (VLOG_IS_ON(2)) {
+    LOG(INFO) << "candidates for " << aApp.toString();
+    for (std::size_t i = 0; i < N; i++) {
+      LOG(INFO) << aCandidates.toString(i);
+    }
+  }
+
+  const auto mySelected = selectCandidate(aCandidates, aAlgo, aRv);
+  if (mySelected >= N or not aCandidates.feasible(mySelected)) {
+    return N;
+  }
+
+  // save the allocation data into the output
+  aApp.theAllocated = true;
+  aApp.theEdgeNode  = aCandidates.theIds[mySelected];
+  aApp.thePathLength =
+      static_cast<std::size_t>(aCandidates.thePathSizes[mySelected]);
+  aApp.thePath = *aCandidates.thePaths[mySelected];
+  return mySelected;
 }
 
-MecQkdNetwork::Candidates::iterator
-MecQkdNetwork::selectCandidate(std::vector<EdgeNode>&    aCandidates,
+std::size_t
+MecQkdNetwork::selectCandidate(Candidates&               aCandidates,
                                const MecQkdAlgo          aAlgo,
                                support::RealRvInterface& aRv) {
-  // return immediately a pointer beyond the end if there are no candidates
-  if (aCandidates.begin() == aCandidates.end()) {
-    return aCandidates.end();
+  const auto N = aCandidates.size();
+
+  // return immediately if there are no candidates
+  if (N == 0) {
+    return N;
   }
 
   // random algorithms
@@ -351,76 +753,37 @@ MecQkdNetwork::selectCandidate(std::vector<EdgeNode>&    aCandidates,
     // with non-blind: retrieve the intersection of edge nodes that feasible
     // according to both rate and processing constraints
     // with blind: just return a candidate truly at random
-    std::set<Candidates::iterator> myFilteredCandidates;
-    for (auto it = aCandidates.begin(); it != aCandidates.end(); ++it) {
-      if (aAlgo == MecQkdAlgo::RandomBlind or it->feasible()) {
-        myFilteredCandidates.emplace(it);
+    auto& myFeasible = aCandidates.theFeasible;
+    myFeasible.clear();
+    for (std::size_t i = 0; i < N; i++) {
+      if (aAlgo == MecQkdAlgo::RandomBlind or aCandidates.feasible(i)) {
+        myFeasible.emplace_back(i);
       }
     }
-    if (myFilteredCandidates.empty()) {
-      return aCandidates.end();
+    if (myFeasible.empty()) {
+      return N;
     }
-    return support::choice(myFilteredCandidates, aRv);
+    return support::choice(myFeasible, aRv);
   }
 
-  // for the other algorithms, just loop through the vector and keep an iterator
-  // to the current best solution found to be returned at the end
-  assert(aAlgo == MecQkdAlgo::BestFit or aAlgo == MecQkdAlgo::BestFitBlind or
-         aAlgo == MecQkdAlgo::Spf or aAlgo == MecQkdAlgo::SpfBlind);
-  struct Compare {
-    Compare(const MecQkdAlgo aAlgo)
-        : theAlgo(aAlgo) {
-      // noop
-    }
-    Candidates::iterator best(const Candidates::iterator aLhs,
-                              const Candidates::iterator aRhs) const noexcept {
-      assert(theAlgo != MecQkdAlgo::Random and
-             theAlgo != MecQkdAlgo::RandomBlind);
-      switch (theAlgo) {
-        case MecQkdAlgo::Random:
-          return aLhs;
-        case MecQkdAlgo::Spf:
-          return (aRhs->feasible() and
-                  (not aLhs->feasible() or
-                   aLhs->thePathSize > aRhs->thePathSize)) ?
-                     aRhs :
-                     aLhs;
-        case MecQkdAlgo::BestFit:
-          return (aRhs->feasible() and
-                  (not aLhs->feasible() or
-                   aLhs->theResidual > aRhs->theResidual)) ?
-                     aRhs :
-                     aLhs;
-        case MecQkdAlgo::SpfBlind:
-          return (aRhs->feasiblePath() and
-                  (not aLhs->feasiblePath() or
-                   aLhs->thePathSize > aRhs->thePathSize)) ?
-                     aRhs :
-                     aLhs;
-        case MecQkdAlgo::BestFitBlind:
-          return (aRhs->feasibleResidual() and
-                  (not aLhs->feasibleResidual() or
-                   aLhs->theResidual > aRhs->theResidual)) ?
-                     aRhs :
-                     aLhs;
-        case MecQkdAlgo::RandomBlind:
-          return aLhs;
-        case MecQkdAlgo::SpfStatic:
-          assert(false);
-          return aLhs;
-      }
-      assert(false);
-      return aLhs;
-    }
-    const MecQkdAlgo theAlgo;
-  };
-  Compare              myCmp(aAlgo);
-  Candidates::iterator myBest = aCandidates.begin();
-  for (auto myCurr = aCandidates.begin() + 1; myCurr != aCandidates.end();
-       ++myCurr) {
-    myBest = myCmp.best(myBest, myCurr);
+  // for the other algorithms, return the first candidate with minimum path
+  // size or residual among those that are feasible, or the first one if none
+  switch (aAlgo) {
+    case MecQkdAlgo::Spf:
+      return argMin<true, true>(aCandidates, aCandidates.thePathSizes);
+    case MecQkdAlgo::BestFit:
+      return argMin<true, true>(aCandidates, aCandidates.theResiduals);
+    case MecQkdAlgo::SpfBlind:
+      return argMin<true, false>(aCandidates, aCandidates.thePathSizes);
+    case MecQkdAlgo::BestFitBlind:
+      return argMin<false, true>(aCandidates, aCandidates.theResiduals);
+    case MecQkdAlgo::Random:
+    case MecQkdAlgo::RandomBlind:
+    case MecQkdAlgo::SpfStatic:
+      break;
   }
-  return myBest;
+  assert(false);
+  return N;
 }
 
 void MecQkdNetwork::allocateSpfStatic(std::vector<Allocation>& aApps) {
@@ -428,6 +791,8 @@ void MecQkdNetwork::allocateSpfStatic(std::vector<Allocation>& aApps) {
 
   // find the static paths for the source nodes of the applications
   std::map<unsigned long, std::vector<unsigned long>> myStatic;
+  std::map<unsigned long, std::vector<unsigned long>> myPaths;
+  CsrGraph::Scratch                                   myScratch;
   for (const auto& myApp : aApps) {
     auto cur =
         myStatic.emplace(myApp.theUserNode, std::vector<unsigned long>());
@@ -435,7 +800,7 @@ void MecQkdNetwork::allocateSpfStatic(std::vector<Allocation>& aApps) {
       // static path already found for this source node
       continue;
     }
-    const auto myPaths = cspf(cur.first->first, 0, theEdgeNodes);
+    cspf(cur.first->first, 0, theEdgeNodes, myScratch, myPaths);
     const auto min     = std::min_element(
         myPaths.begin(), myPaths.end(), [](const auto& aLhs, const auto& aRhs) {
           return aLhs.second.size() < aRhs.second.size();
@@ -479,6 +844,7 @@ void MecQkdNetwork::allocateSpfStatic(std::vector<Allocation>& aApps) {
       myApp.theAllocated  = true;
       myApp.theEdgeNode   = myEdgeNode;
       myApp.thePathLength = myCandidate->second.size();
+      myApp.thePath       = myCandidate->second;
 
       // remove the load from the target edge node
       myProcIt->second -= myApp.theLoad;
@@ -487,8 +853,7 @@ void MecQkdNetwork::allocateSpfStatic(std::vector<Allocation>& aApps) {
       removeCapacityFromPath(myApp.theUserNode,
                              myCandidate->second,
                              myApp.theRate,
-                             std::nullopt,
-                             theGraph);
+                             std::nullopt);
     }
     VLOG(1) << myApp.toString();
   }
@@ -31,6 +31,7 @@ SOFTWARE.
 
 #pragma once
 
+#include "QuantumRouting/aliassampler.h"
 #include "QuantumRouting/capacitynetwork.h"
 
 namespace uiiit {
@@ -68,7 +69,8 @@ class MecQkdWorkload final
    * @param aAppInfo The info to be copied into this data structure.
    * @param aRv The r.v. to draw randomly the apps.
    *
-   * @throw std::runtime_error if no apps are passed.
+   * @throw std::runtime_error if no apps are passed or their weights are
+   * invalid.
    */
   MecQkdWorkload(const std::vector<AppInfo>& aAppInfo,
                  support::RealRvInterface&   aRv);
@@ -101,7 +103,7 @@ class MecQkdWorkload final
   const std::vector<AppInfo> theAppInfo;
   support::RealRvInterface&  theRv;
   std::set<unsigned long>    theRegions; // never changed after construction
-  std::vector<double>        theWeights; // same
+  const AliasSampler         theSampler; // built from the app weights
 };
 
 /**
@@ -109,29 +111,33 @@ class MecQkdWorkload final
  */
 class MecQkdNetwork final : public CapacityNetwork
 {
-  // used within allocate()
-  struct EdgeNode {
+  // used within allocate(): the candidate edge nodes, with one array per
+  // attribute so that they can be scored with tight loops
+  struct Candidates {
     // initialized from theEdgeProcessing
-    unsigned long theId        = 0;
-    double        theAvailable = 0;
+    std::vector<unsigned long> theIds;
+    std::vector<double>        theAvailable;
 
     // working variables
-    double                     theResidual = 0;
-    double                     thePathSize = 0;
-    std::vector<unsigned long> thePath; //!< the path from user to edge
+    std::vector<double> theResiduals;
+    std::vector<double> thePathSizes; //!< zero if there is no path
+    std::vector<const std::vector<unsigned long>*> thePaths; //!< user to edge
+    std::vector<std::size_t> theFeasible; //!< used for random selection
 
-    bool feasiblePath() const noexcept {
-      return thePathSize > 0;
+    std::size_t size() const noexcept {
+      return theIds.size();
     }
-    bool feasibleResidual() const noexcept {
-      return theResidual >= 0;
+    bool feasiblePath(const std::size_t i) const noexcept {
+      return thePathSizes[i] > 0;
     }
-    bool feasible() const noexcept {
-      return feasiblePath() and feasibleResidual();
+    bool feasibleResidual(const std::size_t i) const noexcept {
+      return theResiduals[i] >= 0;
     }
-    std::string toString() const;
+    bool feasible(const std::size_t i) const noexcept {
+      return feasiblePath(i) and feasibleResidual(i);
+    }
+    std::string toString(const std::size_t i) const;
   };
-  using Candidates = std::vector<EdgeNode>;
 
  public:
   struct Allocation {
@@ -144,6 +150,7 @@ class MecQkdNetwork final : public CapacityNetwork
     bool          theAllocated = false; //!< true if the user has been allocated
     unsigned long theEdgeNode  = 0;     //!< the target edge user node assigned
     std::size_t   thePathLength = 0;    //!< the path length from user to edge
+    std::vector<unsigned long> thePath; //!< hops from user to edge
 
     explicit Allocation(const unsigned long aUserNode,
                         const double        aRate,
@@ -157,6 +164,22 @@ class MecQkdNetwork final : public CapacityNetwork
     }
   };
 
+  /**
+   * @brief The state of the network changed by allocate(): the residual
+   * capacities and the processing available on the edge nodes.
+   */
+  struct Snapshot {
+    CapacityNetwork::Snapshot       theCapacities;
+    std::map<unsigned long, double> theEdgeProcessing;
+  };
+
+  //! Working memory of admissible(), which can be reused across queries.
+  struct QueryScratch {
+    Candidates                                          theCandidates;
+    CsrGraph::Scratch                                   theScratch;
+    std::map<unsigned long, std::vector<unsigned long>> thePaths;
+  };
+
   /**
    * @brief Create a network with given links and assign random weights
    *
@@ -181,6 +204,18 @@ class MecQkdNetwork final : public CapacityNetwork
    */
   explicit MecQkdNetwork(const WeightVector& aEdgeWeights);
 
+  /**
+   * @brief Create a network with given links and weights
+   *
+   * The default measurement probability is 1.
+   *
+   * @param aEdgeWeights The edges and weights of the network (src, dst, w).
+   * @param aMakeBidirectional If true then for each edge (A,B,w) two edges
+   * are added A->B and B->A, with the same weight.
+   */
+  explicit MecQkdNetwork(const WeightVector& aEdgeWeights,
+                         const bool          aMakeBidirectional);
+
   /**
    * @brief Set the identifiers of user nodes.
    *
@@ -214,26 +249,101 @@ class MecQkdNetwork final : public CapacityNetwork
                 const MecQkdAlgo          aAlgo,
                 support::RealRvInterface& aRv);
 
+  /**
+   * @brief Find whether a user request would be allocated with the current
+   * resources, without changing them.
+   *
+   * The request is evaluated in the same way as the first one passed to
+   * allocate() with the same algorithm. The function only reads the network,
+   * hence it can be called concurrently from multiple threads, each with its
+   * own working memory and r.v., as long as the network is not modified at
+   * the same time, e.g., by commit().
+   *
+   * @param aApp The user request, whose output fields are overwritten.
+   * @param aAlgo The algorithm to be used.
+   * @param aRv A r.v. in [0,1] to break ties.
+   * @param aScratch The working memory.
+   * @return true if the request is allocated, in which case aApp can be then
+   * passed to commit().
+   */
+  bool admissible(Allocation&               aApp,
+                  const MecQkdAlgo          aAlgo,
+                  support::RealRvInterface& aRv,
+                  QueryScratch&             aScratch) const;
+
+  /**
+   * @brief Reserve the resources of user requests found admissible with
+   * admissible(), all of them or none.
+   *
+   * The requests not allocated are ignored. The resources may have changed
+   * since the queries were made, so they are checked again against the sum of
+   * the rates of all the requests on every edge and of their loads on every
+   * edge node.
+   *
+   * @param aApps The user requests to be committed.
+   *
+   * @throw std::runtime_error if the path or edge node of a request does not
+   * exist or if there are not enough resources left for all the requests, in
+   * which case we guarantee that the internal state is not changed.
+   */
+  void commit(const std::vector<Allocation>& aApps);
+
   //! @return the total processing power of the edge nodes.
   double totProcessing() const;
 
+  //! @return the current state, which can be restored after allocate().
+  Snapshot snapshot() const;
+
+  /**
+   * @brief Bring the network back to the state of a snapshot, so that the
+   * same initial conditions can be used with different algorithms.
+   *
+   * @param aSnapshot The state, which must have been taken from this network.
+   *
+   * @throw std::runtime_error if the snapshot is from a network with a
+   * different number of nodes or edges, or with different edge nodes.
+   */
+  void restore(const Snapshot& aSnapshot);
+
  private:
   std::set<unsigned long>         theUserNodes;
   std::map<unsigned long, double> theEdgeProcessing;
   std::set<unsigned long>         theEdgeNodes;
 
+  //! Initialize the candidates with the current edge node availability.
+  void initCandidates(Candidates& aCandidates) const;
+
+  /**
+   * @brief Select the edge node of a user request and save it into the output
+   * fields, if feasible.
+   *
+   * @param aApp The user request.
+   * @param aPaths The constrained shortest paths to all the edge nodes.
+   * @param aAlgo The algorithm used, other than MecQkdAlgo::SpfStatic.
+   * @param aRv A r.v. in [0,1] to break ties.
+   * @param aCandidates The candidates, initialized with initCandidates().
+   * @return the index of the candidate selected, or the number of candidates
+   * if the request cannot be allocated.
+   */
+  static std::size_t
+  assign(Allocation&                                                aApp,
+         const std::map<unsigned long, std::vector<unsigned long>>& aPaths,
+         const MecQkdAlgo                                           aAlgo,
+         support::RealRvInterface&                                  aRv,
+         Candidates& aCandidates);
+
   /**
    * @brief Select the candidate edge node to be assigned.
    *
    * @param aCandidates The possible edge nodes.
    * @param aAlgo The algorithm used.
    * @param aRv A r.v. in [0,1] to break ties.
-   * @return std::vector<EdgeNode>::const_iterator
+   * @return the index of the candidate selected, which may be unfeasible,
+   * or the number of candidates if none can be selected.
    */
-  static Candidates::iterator
-  selectCandidate(std::vector<EdgeNode>&    aCandidates,
-                  const MecQkdAlgo          aAlgo,
-                  support::RealRvInterface& aRv);
+  static std::size_t selectCandidate(Candidates&               aCandidates,
+                                     const MecQkdAlgo          aAlgo,
+                                     support::RealRvInterface& aRv);
 
   /**
    * @brief Allocate using MecQkdAlgo::SpfStatic.
@@ -32,10 +32,13 @@ SOFTWARE.
 #pragma once
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/edgelist.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/qrutils.h"
 
 #include "QuantumRouting/poissonpointprocess.h"
 #include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/topologycache.h"
 #include "Support/random.h"
 
 #include <glog/logging.h>
@@ -60,6 +63,8 @@ namespace qr {
  * @param aThreshold The threshold to add an edge between two nodes.
  * @param aLinkProbability The probability that an edge is added.
  * @param aCoordinates The coordinateds of the nodes in a grid.
+ * @param aCache The cache of the topologies generated: the edge
+ * capacities are drawn from aEprRv even if the topology is found in there.
  * @return std::unique_ptr<CapacityNetwork> The network created.
  * @throw std::runtime_error if the network could not be generated.
  */
@@ -71,9 +76,20 @@ makeCapacityNetworkPpp(support::RealRvInterface& aEprRv,
                        const double              aGridLength,
                        const double              aThreshold,
                        const double              aLinkProbability,
-                       std::vector<Coordinate>&  aCoordinates) {
+                       std::vector<Coordinate>&  aCoordinates,
+                       const TopologyCache&      aCache = TopologyCache()) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Topology);
+
   const auto MANY_TRIES = 1000000u;
 
+  const auto myKey = TopologyCache::key(
+      "ppp", aSeed, {aMu, aGridLength, aThreshold, aLinkProbability});
+  TopologyCache::Topology myTopology;
+  if (aCache.load(myKey, myTopology)) {
+    myTopology.theCoordinates.swap(aCoordinates);
+    return std::make_unique<NETWORK>(myTopology.theEdges, aEprRv, true);
+  }
+
   auto myPppSeed = aSeed;
   for (unsigned myTry = 0; myTry < MANY_TRIES; myTry++) {
     auto myCoordinates =
@@ -81,6 +97,9 @@ makeCapacityNetworkPpp(support::RealRvInterface& aEprRv,
     const auto myEdges =
         findLinks(myCoordinates, aThreshold, aLinkProbability, aSeed);
     if (qr::bigraphConnected(myEdges)) {
+      myTopology.theEdges       = myEdges;
+      myTopology.theCoordinates = myCoordinates;
+      aCache.save(myKey, myTopology);
       myCoordinates.swap(aCoordinates);
       return std::make_unique<NETWORK>(myEdges, aEprRv, true);
 
@@ -111,6 +130,9 @@ makeCapacityNetworkPpp(support::RealRvInterface& aEprRv,
  * compared to longer ones.
  * @param aBeta The larger this value, the higher the edge density.
  * @param aCoordinates The coordinateds of the nodes in a grid.
+ * @param aCache The cache of the topologies generated: the edge
+ * capacities are computed with aCapacityLambda even if the topology is found
+ * in there.
  * @return std::unique_ptr<CapacityNetwork> The network created.
  * @throw std::range_error if aAlpha or aBeta are not in (0,1].
  * @throw std::runtime_error if the network could not be generated.
@@ -123,25 +145,11 @@ std::unique_ptr<NETWORK> makeCapacityNetworkWaxman(
     const double                               aL,
     const double                               aAlpha,
     const double                               aBeta,
-    std::vector<Coordinate>&                   aCoordinates) {
-  if (aAlpha <= 0 or aAlpha > 1) {
-    throw std::range_error(
-        "Value of alpha not in (0,1] in Waxman model network generation: " +
-        std::to_string(aAlpha));
-  }
-  if (aBeta <= 0 or aBeta > 1) {
-    throw std::range_error(
-        "Value of beta not in (0,1] in Waxman model network generation: " +
-        std::to_string(aBeta));
-  }
-  if (aL < 0) {
-    throw std::range_error(
-        "Negative value of L in Waxman model network generation: " +
-        std::to_string(aL));
-  }
-  if (aNodes == 0) {
-    throw std::range_error("Empty network");
-  }
+    std::vector<Coordinate>&                   aCoordinates,
+    const TopologyCache&                       aCache = TopologyCache()) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Topology);
+
+  checkWaxmanParameters(aNodes, aL, aAlpha, aBeta);
   const auto MANY_TRIES = 1000000u;
 
   const auto myProbLambda = [aAlpha, aBeta, aL](const double d) {
@@ -149,16 +157,32 @@ std::unique_ptr<NETWORK> makeCapacityNetworkWaxman(
   };
   const auto myGridLength = aL / std::sqrt(2.0);
 
+  // the cache only contains the edges (i, j) with i < j
+  const auto myKey =
+      TopologyCache::key("waxman", aSeed, {double(aNodes), aL, aAlpha, aBeta});
+  TopologyCache::Topology myTopology;
+  if (aCache.load(myKey, myTopology)) {
+    if (myTopology.theCoordinates.size() != aNodes) {
+      throw std::runtime_error(
+          "Invalid number of nodes in cached topology: " +
+          std::to_string(myTopology.theCoordinates.size()));
+    }
+    CapacityNetwork::WeightVector myEdges;
+    for (const auto& myEdge : myTopology.theEdges) {
+      const auto myCapacity = aCapacityLambda(
+          distance(myTopology.theCoordinates.at(myEdge.first),
+                   myTopology.theCoordinates.at(myEdge.second)));
+      myEdges.push_back({myEdge.first, myEdge.second, myCapacity});
+      myEdges.push_back({myEdge.second, myEdge.first, myCapacity});
+    }
+    myTopology.theCoordinates.swap(aCoordinates);
+    return std::make_unique<NETWORK>(myEdges);
+  }
+
   for (unsigned myTry = 0; myTry < MANY_TRIES; myTry++) {
 
     // assign nodes to their coordinates
-    support::UniformRv      myRvX(0, myGridLength, aSeed, 0, myTry);
-    support::UniformRv      myRvY(0, myGridLength, aSeed, 1, myTry);
-    std::vector<Coordinate> myCoordinates(aNodes, Coordinate{0, 0, 0});
-    for (auto& myNode : myCoordinates) {
-      std::get<0>(myNode) = myRvX();
-      std::get<1>(myNode) = myRvY();
-    }
+    auto myCoordinates = waxmanCoordinates(aNodes, myGridLength, aSeed, myTry);
 
     // create edges
     CapacityNetwork::WeightVector myEdges;
@@ -187,6 +211,12 @@ std::unique_ptr<NETWORK> makeCapacityNetworkWaxman(
     }
 
     if (myNodes.size() == aNodes and bigraphConnected(myEdgesUnweighted)) {
+      myTopology.theEdges.clear();
+      for (std::size_t i = 0; i < myEdgesUnweighted.size(); i += 2) {
+        myTopology.theEdges.emplace_back(myEdgesUnweighted[i]);
+      }
+      myTopology.theCoordinates = myCoordinates;
+      aCache.save(myKey, myTopology);
       myCoordinates.swap(aCoordinates);
       return std::make_unique<NETWORK>(myEdges);
 
@@ -197,7 +227,103 @@ std::unique_ptr<NETWORK> makeCapacityNetworkWaxman(
 
   throw std::runtime_error("Could not find a connected network after " +
                            std::to_string(MANY_TRIES) + " tries");
-} // namespace qr
+}
+
+/**
+ * @brief Create a network using the Waxman model, as
+ * makeCapacityNetworkWaxman(), drawing the edges in parallel.
+ *
+ * The coordinates of the nodes are drawn in the same way, but the edges are
+ * drawn with findWaxmanLinks(), i.e., with a counter-based pseudo-random
+ * number generator: the network does not depend on the number of threads,
+ * but it is different from that created by makeCapacityNetworkWaxman() with
+ * the same seed. The network is created directly from the edges (i, j) with
+ * i < j, which are also those saved into the cache.
+ *
+ * @tparam NETWORK The type of network to be create.
+ * @param aCapacityLambda The function to determine the capacity from the
+ * actual distance between the nodes.
+ * @param aSeed The seed for random number generation.
+ * @param aNodes The number of nodes.
+ * @param aL The maximum distance between two nodes.
+ * @param aAlpha The larger this value, the higher the density of short edges
+ * compared to longer ones.
+ * @param aBeta The larger this value, the higher the edge density.
+ * @param aCoordinates The coordinateds of the nodes in a grid.
+ * @param aNumThreads The number of threads used if not called from a task of
+ * a TaskScheduler, if 0 use the hardware concurrency.
+ * @param aCache The cache of the topologies generated: the edge
+ * capacities are computed with aCapacityLambda even if the topology is found
+ * in there.
+ * @return std::unique_ptr<CapacityNetwork> The network created.
+ * @throw std::range_error if aAlpha or aBeta are not in (0,1].
+ * @throw std::runtime_error if the network could not be generated.
+ */
+template <class NETWORK>
+std::unique_ptr<NETWORK> makeCapacityNetworkWaxmanParallel(
+    const std::function<double(const double)>& aCapacityLambda,
+    const std::size_t                          aSeed,
+    const std::size_t                          aNodes,
+    const double                               aL,
+    const double                               aAlpha,
+    const double                               aBeta,
+    std::vector<Coordinate>&                   aCoordinates,
+    const std::size_t                          aNumThreads,
+    const TopologyCache&                       aCache = TopologyCache()) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Topology);
+
+  checkWaxmanParameters(aNodes, aL, aAlpha, aBeta);
+  const auto MANY_TRIES = 1000000u;
+
+  const auto myGridLength = aL / std::sqrt(2.0);
+
+  const auto myKey = TopologyCache::key(
+      "waxman-parallel", aSeed, {double(aNodes), aL, aAlpha, aBeta});
+  TopologyCache::Topology myTopology;
+  auto                    myFound = aCache.load(myKey, myTopology);
+  if (myFound and myTopology.theCoordinates.size() != aNodes) {
+    throw std::runtime_error("Invalid number of nodes in cached topology: " +
+                             std::to_string(myTopology.theCoordinates.size()));
+  }
+
+  for (unsigned myTry = 0; not myFound and myTry < MANY_TRIES; myTry++) {
+    auto myCoordinates = waxmanCoordinates(aNodes, myGridLength, aSeed, myTry);
+    auto myConnected   = false;
+    auto myEdges       = findWaxmanLinks(myCoordinates,
+                                         aL,
+                                         aAlpha,
+                                         aBeta,
+                                         aSeed,
+                                         myTry,
+                                         aNumThreads,
+                                         myConnected);
+    if (myConnected) {
+      myTopology.theEdges.swap(myEdges);
+      myTopology.theCoordinates.swap(myCoordinates);
+      aCache.save(myKey, myTopology);
+      myFound = true;
+
+    } else {
+      VLOG(1) << "graph with seed " << myTry << " not connected, try again";
+    }
+  }
+  if (not myFound) {
+    throw std::runtime_error("Could not find a connected network after " +
+                             std::to_string(MANY_TRIES) + " tries");
+  }
+
+  CapacityNetwork::WeightVector myEdges;
+  myEdges.reserve(myTopology.theEdges.size());
+  for (const auto& myEdge : myTopology.theEdges) {
+    myEdges.emplace_back(
+        myEdge.first,
+        myEdge.second,
+        aCapacityLambda(distance(myTopology.theCoordinates[myEdge.first],
+                                 myTopology.theCoordinates[myEdge.second])));
+  }
+  myTopology.theCoordinates.swap(aCoordinates);
+  return std::make_unique<NETWORK>(myEdges, true);
+}
 
 /**
  * @brief Create a network from a GraphML file.
@@ -214,6 +340,8 @@ std::unique_ptr<NETWORK>
 makeCapacityNetworkGraphMl(support::RealRvInterface& aEprRv,
                            std::ifstream&            aGraphMl,
                            std::vector<Coordinate>&  aCoordinates) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Topology);
+
   const auto myEdges = findLinks(aGraphMl, aCoordinates);
   for (const auto& myEdge : myEdges) {
     VLOG(2) << '(' << myEdge.first << ',' << myEdge.second << ')';
@@ -225,5 +353,61 @@ makeCapacityNetworkGraphMl(support::RealRvInterface& aEprRv,
   throw std::runtime_error("The GraphML network is not fully connected");
 }
 
+/**
+ * @brief Create a network from a GraphML file converted with convertGraphMl().
+ *
+ * @tparam NETWORK The type of the network created.
+ * @param aEprRv The r.v. to draw the capacity of the edges.
+ * @param aFilename The name of the converted file.
+ * @param aCoordinates The coordinateds of the nodes in a grid.
+ * @return std::unique_ptr<NETWORK> The network created, which is the same as
+ * that created from the original GraphML file.
+ * @throw std::runtime_error if the network in the file is not connected.
+ */
+template <class NETWORK>
+std::unique_ptr<NETWORK>
+makeCapacityNetworkGraphMl(support::RealRvInterface& aEprRv,
+                           const std::string&        aFilename,
+                           std::vector<Coordinate>&  aCoordinates) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Topology);
+
+  const auto myEdges = loadConvertedGraphMl(aFilename, aCoordinates);
+  if (bigraphConnected(myEdges)) {
+    return std::make_unique<NETWORK>(myEdges, aEprRv, true);
+  }
+
+  throw std::runtime_error("The GraphML network is not fully connected");
+}
+
+/**
+ * @brief Create a network from an edge list file.
+ *
+ * @tparam NETWORK The type of the network created.
+ * @param aFilename The file with the edges and their weights, in the format
+ * read by loadEdgeList().
+ * @return std::unique_ptr<NETWORK> The network created.
+ * @throw std::runtime_error if the file is not valid or the network is not
+ * fully connected.
+ */
+template <class NETWORK>
+std::unique_ptr<NETWORK>
+makeCapacityNetworkEdgeList(const std::string& aFilename) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::Topology);
+
+  const auto myEdges = loadEdgeList(aFilename);
+
+  std::vector<std::pair<unsigned long, unsigned long>> myEdgesUnweighted;
+  myEdgesUnweighted.reserve(myEdges.size());
+  for (const auto& myEdge : myEdges) {
+    myEdgesUnweighted.emplace_back(std::get<0>(myEdge), std::get<1>(myEdge));
+  }
+  if (bigraphConnected(myEdgesUnweighted)) {
+    return std::make_unique<NETWORK>(myEdges);
+  }
+
+  throw std::runtime_error("The network in " + aFilename +
+                           " is not fully connected");
+}
+
 } // namespace qr
 } // namespace uiiit
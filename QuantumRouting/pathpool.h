@@ -0,0 +1,97 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/csrgraph.h"
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Pool of paths, each stored as a contiguous sequence of edge
+ * identifiers of a CsrGraph.
+ *
+ * Paths are only appended, one edge at a time, and they are identified by
+ * consecutive integers starting from 0. All the memory is released at once
+ * when the pool is destroyed.
+ */
+class PathPool final
+{
+ public:
+  using EdgeId = CsrGraph::EdgeId;
+  using PathId = std::size_t;
+
+  //! Create an empty pool.
+  PathPool();
+
+  //! Append an edge to the path currently being added.
+  void addEdge(const EdgeId aEdge) {
+    theEdges.emplace_back(aEdge);
+  }
+
+  //! Terminate the path currently being added and return its identifier.
+  PathId close();
+
+  //! \return the number of paths in the pool.
+  std::size_t numPaths() const noexcept {
+    return theOffsets.size() - 1;
+  }
+
+  //! \return the number of edges of a path.
+  std::size_t size(const PathId aPath) const noexcept {
+    assert(aPath < numPaths());
+    return theOffsets[aPath + 1] - theOffsets[aPath];
+  }
+
+  //! \return the first edge of a path.
+  const EdgeId* begin(const PathId aPath) const noexcept {
+    assert(aPath < numPaths());
+    return theEdges.data() + theOffsets[aPath];
+  }
+
+  //! \return one past the last edge of a path.
+  const EdgeId* end(const PathId aPath) const noexcept {
+    assert(aPath < numPaths());
+    return theEdges.data() + theOffsets[aPath + 1];
+  }
+
+ private:
+  std::vector<EdgeId>      theEdges;
+  std::vector<std::size_t> theOffsets; //!< numPaths() + 1 elements
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -30,6 +30,9 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/peerassignment.h"
+#include "QuantumRouting/capacitatedassignment.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/taskscheduler.h"
 
 #include "Support/tostring.h"
 #include "hungarian-algorithm-cpp/Hungarian.h"
@@ -39,16 +42,78 @@ SOFTWARE.
 
 #include <iterator>
 #include <numeric>
+#include <optional>
 #include <stdexcept>
+#include <thread>
 
 namespace uiiit {
 namespace qr {
 
+namespace {
+
+//! \return the number of threads to be used, replacing 0 with the hardware
+//! concurrency.
+std::size_t numThreads(const std::size_t aNumThreads) {
+  return aNumThreads > 0 ? aNumThreads :
+                           std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Find the max net rate from every app to every candidate peer.
+ *
+ * The net rates are found in parallel, unless aNumThreads is 1, by the
+ * workers of the task scheduler running the caller, if any, or by
+ * aNumThreads threads otherwise. Every row is written by only one thread,
+ * so the result does not depend on the number of threads. The net rates are
+ * found with a fixed fidelity threshold of 0.5 for all the apps, which is
+ * also passed to aHopLimit: the paths longer than the limit, which the check
+ * function would reject, are not searched.
+ *
+ * @return the net rates, with one row per app and one column per peer.
+ */
+std::vector<std::vector<double>>
+findNetRates(const EsNetwork&                                 aNetwork,
+             const std::vector<PeerAssignment::AppDescriptor>& aApps,
+             const std::vector<unsigned long>&                 aCandidatePeers,
+             const EsNetwork::AppCheckFunction&                aCheckFunction,
+             const EsNetwork::AppHopLimitFunction&             aHopLimit,
+             const std::size_t                                 aNumThreads) {
+  std::vector<std::vector<double>> ret(
+      aApps.size(), std::vector<double>(aCandidatePeers.size()));
+
+  const auto myRows = [&](const std::size_t aFirst, const std::size_t aLast) {
+    for (auto s = aFirst; s < aLast; s++) {
+      const EsNetwork::AppDescriptor myApp(aApps[s].theHost, {}, 1, 0.5);
+      const auto                     myMaxHops = aHopLimit(myApp);
+      for (unsigned long d = 0; d < aCandidatePeers.size(); d++) {
+        ret[s][d] = aNetwork.maxNetRate(myApp,
+                                        aCandidatePeers[d],
+                                        aCheckFunction,
+                                        [myMaxHops](const auto&) {
+                                          return myMaxHops;
+                                        });
+        VLOG(2) << s << '/' << aApps.size() << " " << d << '/'
+                << (aCandidatePeers.size()) << " net-rate " << ret[s][d];
+      }
+    }
+  };
+  if (aNumThreads == 1) {
+    myRows(0, aApps.size());
+  } else {
+    parallelFor(0, aApps.size(), aNumThreads, myRows);
+  }
+
+  return ret;
+}
+
+} // namespace
+
 std::vector<PeerAssignmentAlgo> allPeerAssignmentAlgos() {
   static const std::vector<PeerAssignmentAlgo> myAlgos({
       PeerAssignmentAlgo::Random,
       PeerAssignmentAlgo::ShortestPath,
       PeerAssignmentAlgo::LoadBalancing,
+      PeerAssignmentAlgo::LoadBalancingMcf,
   });
   return myAlgos;
 }
@@ -61,6 +126,8 @@ std::string toString(const PeerAssignmentAlgo aAlgo) {
       return "shortest-path";
     case PeerAssignmentAlgo::LoadBalancing:
       return "load-balancing";
+    case PeerAssignmentAlgo::LoadBalancingMcf:
+      return "load-balancing-mcf";
     default:; /* fall-through */
   }
   return "unknown";
@@ -73,6 +140,8 @@ PeerAssignmentAlgo peerAssignmentAlgofromString(const std::string& aAlgo) {
     return PeerAssignmentAlgo::ShortestPath;
   } else if (aAlgo == "load-balancing") {
     return PeerAssignmentAlgo::LoadBalancing;
+  } else if (aAlgo == "load-balancing-mcf") {
+    return PeerAssignmentAlgo::LoadBalancingMcf;
   }
   throw std::runtime_error(
       "invalid peer assignment algorithm: " + aAlgo + " (valid options are: " +
@@ -83,18 +152,23 @@ PeerAssignmentAlgo peerAssignmentAlgofromString(const std::string& aAlgo) {
 }
 
 std::unique_ptr<PeerAssignment>
-makePeerAssignment(const EsNetwork&                   aNetwork,
-                   const PeerAssignmentAlgo           aAlgo,
-                   support::RealRvInterface&          aRv,
-                   const EsNetwork::AppCheckFunction& aCheckFunction) {
+makePeerAssignment(const EsNetwork&                      aNetwork,
+                   const PeerAssignmentAlgo              aAlgo,
+                   support::RealRvInterface&             aRv,
+                   const EsNetwork::AppCheckFunction&    aCheckFunction,
+                   const std::size_t                     aNumThreads,
+                   const EsNetwork::AppHopLimitFunction& aHopLimit) {
   switch (aAlgo) {
     case PeerAssignmentAlgo::Random:
       return std::make_unique<PeerAssignmentRandom>(aNetwork, aRv);
     case PeerAssignmentAlgo::ShortestPath:
       return std::make_unique<PeerAssignmentShortestPath>(aNetwork, aRv);
     case PeerAssignmentAlgo::LoadBalancing:
-      return std::make_unique<PeerAssignmentLoadBalancing>(aNetwork,
-                                                           aCheckFunction);
+      return std::make_unique<PeerAssignmentLoadBalancing>(
+          aNetwork, aCheckFunction, aNumThreads, aHopLimit);
+    case PeerAssignmentAlgo::LoadBalancingMcf:
+      return std::make_unique<PeerAssignmentLoadBalancingMcf>(
+          aNetwork, aCheckFunction, aNumThreads, aHopLimit);
     default:; /* fall-through */
   }
   throw std::runtime_error("invalid peer assignment algorithm: " +
@@ -141,6 +215,8 @@ std::vector<EsNetwork::AppDescriptor> PeerAssignmentRandom::assign(
     const std::vector<AppDescriptor>& aApps,
     const unsigned long               aNumPeers,
     const std::vector<unsigned long>& aCandidatePeers) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::PeerAssignment);
+
   throwIfDuplicates(aCandidatePeers);
   std::vector<EsNetwork::AppDescriptor> ret;
   std::transform(aApps.cbegin(),
@@ -167,29 +243,48 @@ std::vector<EsNetwork::AppDescriptor> PeerAssignmentShortestPath::assign(
     const std::vector<AppDescriptor>& aApps,
     const unsigned long               aNumPeers,
     const std::vector<unsigned long>& aCandidatePeers) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::PeerAssignment);
+
   throwIfDuplicates(aCandidatePeers);
-  std::set<unsigned long>               myDataCenters(aCandidatePeers.begin(),
-                                        aCandidatePeers.end());
+
+  // find the distances to the data centers once for all the apps, unless
+  // they are too large for the index: then search from every app's host
+  std::optional<HopDistanceIndex> myIndex;
+  try {
+    myIndex.emplace(theNetwork.hopDistanceIndex(aCandidatePeers));
+  } catch (const std::range_error& aErr) {
+    VLOG(1) << aErr.what() << ": finding the closest peers of every app";
+  }
+  const std::set<unsigned long> myDataCenters(aCandidatePeers.begin(),
+                                              aCandidatePeers.end());
+
   std::vector<EsNetwork::AppDescriptor> ret;
-  std::transform(aApps.cbegin(),
-                 aApps.cend(),
-                 std::back_inserter(ret),
-                 [&myDataCenters, aNumPeers, this](const auto& aApp) {
-                   return EsNetwork::AppDescriptor(
-                       aApp.theHost,
-                       theNetwork.closestNodes(
-                           aApp.theHost, aNumPeers, theRv, myDataCenters),
-                       aApp.thePriority,
-                       aApp.theFidelityThreshold);
-                 });
+  std::transform(
+      aApps.cbegin(),
+      aApps.cend(),
+      std::back_inserter(ret),
+      [&myIndex, &myDataCenters, aNumPeers, this](const auto& aApp) {
+        return EsNetwork::AppDescriptor(
+            aApp.theHost,
+            myIndex.has_value() ?
+                myIndex->closest(aApp.theHost, aNumPeers, theRv) :
+                theNetwork.closestNodes(
+                    aApp.theHost, aNumPeers, theRv, myDataCenters),
+            aApp.thePriority,
+            aApp.theFidelityThreshold);
+      });
   return ret;
 }
 
 PeerAssignmentLoadBalancing::PeerAssignmentLoadBalancing(
-    const EsNetwork&                   aNetwork,
-    const EsNetwork::AppCheckFunction& aCheckFunction)
+    const EsNetwork&                      aNetwork,
+    const EsNetwork::AppCheckFunction&    aCheckFunction,
+    const std::size_t                     aNumThreads,
+    const EsNetwork::AppHopLimitFunction& aHopLimit)
     : PeerAssignment(aNetwork, PeerAssignmentAlgo::LoadBalancing)
-    , theCheckFunction(aCheckFunction) {
+    , theCheckFunction(aCheckFunction)
+    , theNumThreads(numThreads(aNumThreads))
+    , theHopLimit(aHopLimit) {
   // noop
 }
 
@@ -197,6 +292,8 @@ std::vector<EsNetwork::AppDescriptor> PeerAssignmentLoadBalancing::assign(
     const std::vector<AppDescriptor>& aApps,
     const unsigned long               aNumPeers,
     const std::vector<unsigned long>& aCandidatePeers) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::PeerAssignment);
+
   throwIfDuplicates(aCandidatePeers);
 
   // return immediately if there are no data centers, a.k.a. peer candidates
@@ -220,18 +317,18 @@ std::vector<EsNetwork::AppDescriptor> PeerAssignmentLoadBalancing::assign(
 
   // the maximum profit in each row, which will be used to tranform the
   // problem into a cost-minimization
+  const auto myNetRates = findNetRates(theNetwork,
+                                       aApps,
+                                       aCandidatePeers,
+                                       theCheckFunction,
+                                       theHopLimit,
+                                       theNumThreads);
   std::vector<double> myPerRowMaxValues(aApps.size(), 0.0);
   for (unsigned long s = 0; s < aApps.size(); s++) {
     for (unsigned long d = 0; d < aCandidatePeers.size(); d++) {
-      const auto myNetRate = theNetwork.maxNetRate(
-          EsNetwork::AppDescriptor(aApps[s].theHost, {}, 1, 0.5),
-          aCandidatePeers[d],
-          theCheckFunction);
-      myPerRowMaxValues[s] = std::max(myPerRowMaxValues[s], myNetRate);
-      VLOG(2) << s << '/' << aApps.size() << " " << d << '/'
-              << (aCandidatePeers.size()) << " net-rate " << myNetRate;
+      myPerRowMaxValues[s] = std::max(myPerRowMaxValues[s], myNetRates[s][d]);
       for (unsigned long c = 0; c < C; c++) {
-        myDistMatrix[s][d * C + c] = -myNetRate;
+        myDistMatrix[s][d * C + c] = -myNetRates[s][d];
       }
     }
   }
@@ -250,8 +347,11 @@ std::vector<EsNetwork::AppDescriptor> PeerAssignmentLoadBalancing::assign(
   for (unsigned long myIteration = 0; myIteration < aNumPeers; myIteration++) {
     // solve assignment problem
     std::vector<int> myAssignment;
-    const auto       myCost =
-        hungarian::HungarianAlgorithm::Solve(myDistMatrix, myAssignment);
+    const auto       myCost = [&myDistMatrix, &myAssignment]() {
+      const Instrumentation::Timer mySolveTimer(
+          Instrumentation::Phase::AssignmentSolve);
+      return hungarian::HungarianAlgorithm::Solve(myDistMatrix, myAssignment);
+    }();
     const auto myProfit = aApps.size() * mySumMax - myCost;
     assert(myProfit >= 0);
     assert(myAssignment.size() == aApps.size());
@@ -317,5 +417,79 @@ std::vector<EsNetwork::AppDescriptor> PeerAssignmentLoadBalancing::assign(
   return ret;
 }
 
+PeerAssignmentLoadBalancingMcf::PeerAssignmentLoadBalancingMcf(
+    const EsNetwork&                      aNetwork,
+    const EsNetwork::AppCheckFunction&    aCheckFunction,
+    const std::size_t                     aNumThreads,
+    const EsNetwork::AppHopLimitFunction& aHopLimit)
+    : PeerAssignment(aNetwork, PeerAssignmentAlgo::LoadBalancingMcf)
+    , theCheckFunction(aCheckFunction)
+    , theNumThreads(numThreads(aNumThreads))
+    , theHopLimit(aHopLimit) {
+  // noop
+}
+
+std::vector<EsNetwork::AppDescriptor> PeerAssignmentLoadBalancingMcf::assign(
+    const std::vector<AppDescriptor>& aApps,
+    const unsigned long               aNumPeers,
+    const std::vector<unsigned long>& aCandidatePeers) {
+  const Instrumentation::Timer myTimer(Instrumentation::Phase::PeerAssignment);
+
+  throwIfDuplicates(aCandidatePeers);
+
+  // return immediately if there are no data centers, a.k.a. peer candidates
+  if (aCandidatePeers.empty()) {
+    return std::vector<EsNetwork::AppDescriptor>();
+  }
+
+  // keep the current peer assigned: the inner vectors will grow by
+  // at most one unit at every iteration (#iterations = aNumPeers)
+  std::vector<std::vector<unsigned long>> myCurAssign(aApps.size());
+
+  // same capacity of data centers as with PeerAssignmentLoadBalancing
+  const auto C = 1 + (aApps.size() * aNumPeers - 1) / aCandidatePeers.size();
+  assert(C > 0);
+  VLOG(2) << "num-apps " << aApps.size() << ", num-peers " << aNumPeers
+          << ", num-data-centers " << aCandidatePeers.size() << ", C " << C;
+
+  CapacitatedAssignment mySolver(
+      findNetRates(theNetwork,
+                   aApps,
+                   aCandidatePeers,
+                   theCheckFunction,
+                   theHopLimit,
+                   theNumThreads),
+      std::vector<std::size_t>(aCandidatePeers.size(), C));
+
+  // at every iteration add at most one peer to each app
+  for (unsigned long myIteration = 0; myIteration < aNumPeers; myIteration++) {
+    const auto myAssignment = [&mySolver]() {
+      const Instrumentation::Timer mySolveTimer(
+          Instrumentation::Phase::AssignmentSolve);
+      return mySolver.next();
+    }();
+    assert(myAssignment.size() == aApps.size());
+    for (unsigned long a = 0; a < aApps.size(); a++) {
+      if (myAssignment[a] != CapacitatedAssignment::UNASSIGNED) {
+        VLOG(2) << "[" << myIteration << "] end user #" << a << "\tsrc "
+                << aApps[a].theHost << "\tdst "
+                << aCandidatePeers[myAssignment[a]];
+        myCurAssign[a].emplace_back(aCandidatePeers[myAssignment[a]]);
+      }
+    }
+  }
+
+  // copy the last assignment to the return value
+  std::vector<EsNetwork::AppDescriptor> ret;
+  for (unsigned long a = 0; a < aApps.size(); a++) {
+    ret.emplace_back(aApps[a].theHost,
+                     myCurAssign[a],
+                     aApps[a].thePriority,
+                     aApps[a].theFidelityThreshold);
+  }
+
+  return ret;
+}
+
 } // namespace qr
 } // namespace uiiit
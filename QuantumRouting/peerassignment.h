@@ -47,9 +47,10 @@ namespace qr {
 //
 
 enum class PeerAssignmentAlgo : unsigned int {
-  Random        = 0,
-  ShortestPath  = 1,
-  LoadBalancing = 2,
+  Random           = 0,
+  ShortestPath     = 1,
+  LoadBalancing    = 2,
+  LoadBalancingMcf = 3,
 };
 
 std::vector<PeerAssignmentAlgo> allPeerAssignmentAlgos();
@@ -68,14 +69,22 @@ class PeerAssignment;
  * @param aAlgo The assignment algorithm to be used.
  * @param aRv A random variable in [0,1] that might be used by the algorithm.
  * @param aCheckFunction The function that checks if a given path is valid.
+ * @param aNumThreads The number of threads that might be used by the
+ * algorithm, if 0 use the hardware concurrency.
+ * @param aHopLimit Function returning the maximum length of the paths of an
+ * app, which are not searched beyond it by the algorithm. It is called with
+ * the same app descriptors as aCheckFunction.
  * @return std::unique_ptr<PeerAssignment> The peer assignment object.
  * @throw std::runtime_error if aAlgo is not known.
  */
-std::unique_ptr<PeerAssignment>
-makePeerAssignment(const EsNetwork&                   aNetwork,
-                   const PeerAssignmentAlgo           aAlgo,
-                   support::RealRvInterface&          aRv,
-                   const EsNetwork::AppCheckFunction& aCheckFunction);
+std::unique_ptr<PeerAssignment> makePeerAssignment(
+    const EsNetwork&                      aNetwork,
+    const PeerAssignmentAlgo              aAlgo,
+    support::RealRvInterface&             aRv,
+    const EsNetwork::AppCheckFunction&    aCheckFunction,
+    const std::size_t                     aNumThreads = 1,
+    const EsNetwork::AppHopLimitFunction& aHopLimit =
+        [](const auto&) { return EsNetwork::UNLIMITED_HOPS; });
 
 //
 // peer assignment classes
@@ -165,9 +174,26 @@ class PeerAssignmentShortestPath final : public PeerAssignment
 class PeerAssignmentLoadBalancing final : public PeerAssignment
 {
  public:
+  /**
+   * @brief Construct a new load balancing peer assignment.
+   *
+   * @param aNetwork The reference quantum network for peer assignment.
+   * @param aCheckFunction The function that checks if a given path is valid,
+   * which must be thread-safe if aNumThreads is not 1.
+   * @param aNumThreads The number of threads used to find the net rates
+   * between apps and candidate peers, if 0 use the hardware concurrency.
+   * If not 1 and assign() is called from a task of a TaskScheduler, the
+   * workers of the latter are used instead.
+   * @param aHopLimit Function returning the maximum length of the paths of
+   * an app, which are not searched beyond it when finding the net rates. It
+   * is called with the same app descriptors as aCheckFunction.
+   */
   PeerAssignmentLoadBalancing(
-      const EsNetwork&                   aNetwork,
-      const EsNetwork::AppCheckFunction& aCheckFunction);
+      const EsNetwork&                      aNetwork,
+      const EsNetwork::AppCheckFunction&    aCheckFunction,
+      const std::size_t                     aNumThreads = 1,
+      const EsNetwork::AppHopLimitFunction& aHopLimit =
+          [](const auto&) { return EsNetwork::UNLIMITED_HOPS; });
 
   //! Assign peers as the result of a generalized assignment problem.
   std::vector<EsNetwork::AppDescriptor>
@@ -176,7 +202,61 @@ class PeerAssignmentLoadBalancing final : public PeerAssignment
          const std::vector<unsigned long>& aCandidatePeers) override;
 
  private:
-  const EsNetwork::AppCheckFunction theCheckFunction;
+  const EsNetwork::AppCheckFunction    theCheckFunction;
+  const std::size_t                    theNumThreads;
+  const EsNetwork::AppHopLimitFunction theHopLimit;
+};
+
+/**
+ * @brief Same problem as PeerAssignmentLoadBalancing, but solved without
+ * replicating the data centers.
+ *
+ * Instead of solving an assignment problem with C copies of every data center
+ * with the Hungarian algorithm, a capacitated assignment problem is solved on
+ * the original apps x data centers net rates as a min-cost flow, where every
+ * data center has capacity C, warm-starting every iteration from the
+ * previous one.
+ *
+ * The total net rate is the same as PeerAssignmentLoadBalancing at the first
+ * iteration, but the assignment may be different if there are multiple
+ * optimal ones. Furthermore, only the assignments with positive net rate
+ * consume the capacity of the data centers, hence the subsequent iterations
+ * may differ, too.
+ */
+class PeerAssignmentLoadBalancingMcf final : public PeerAssignment
+{
+ public:
+  /**
+   * @brief Construct a new load balancing peer assignment.
+   *
+   * @param aNetwork The reference quantum network for peer assignment.
+   * @param aCheckFunction The function that checks if a given path is valid,
+   * which must be thread-safe if aNumThreads is not 1.
+   * @param aNumThreads The number of threads used to find the net rates
+   * between apps and candidate peers, if 0 use the hardware concurrency.
+   * If not 1 and assign() is called from a task of a TaskScheduler, the
+   * workers of the latter are used instead.
+   * @param aHopLimit Function returning the maximum length of the paths of
+   * an app, which are not searched beyond it when finding the net rates. It
+   * is called with the same app descriptors as aCheckFunction.
+   */
+  PeerAssignmentLoadBalancingMcf(
+      const EsNetwork&                      aNetwork,
+      const EsNetwork::AppCheckFunction&    aCheckFunction,
+      const std::size_t                     aNumThreads = 1,
+      const EsNetwork::AppHopLimitFunction& aHopLimit =
+          [](const auto&) { return EsNetwork::UNLIMITED_HOPS; });
+
+  //! Assign peers as the result of capacitated assignment problems.
+  std::vector<EsNetwork::AppDescriptor>
+  assign(const std::vector<AppDescriptor>& aApps,
+         const unsigned long               aNumPeers,
+         const std::vector<unsigned long>& aCandidatePeers) override;
+
+ private:
+  const EsNetwork::AppCheckFunction    theCheckFunction;
+  const std::size_t                    theNumThreads;
+  const EsNetwork::AppHopLimitFunction theHopLimit;
 };
 
 } // namespace qr
@@ -30,6 +30,9 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/disjointsets.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/random.h"
 
 #include <glog/logging.h>
@@ -39,10 +42,13 @@ SOFTWARE.
 #include <boost/graph/graph_utility.hpp>
 #include <boost/graph/graphml.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <memory>
-#include <set>
+#include <stdexcept>
+#include <string>
 
 namespace uiiit {
 namespace qr {
@@ -67,10 +73,81 @@ findLinks(const std::vector<Coordinate>& aItems,
           nullptr;
 
   std::vector<std::pair<unsigned long, unsigned long>> ret;
-  for (unsigned long i = 0; i < aItems.size(); i++) {
-    for (unsigned long j = 0; j < i; j++) {
-      if (distance(aItems[i], aItems[j]) < aThreshold and
-          (myRv.get() == nullptr or (*myRv)() < aProbability)) {
+  const auto                                           N = aItems.size();
+  if (N == 0 or not(aThreshold > 0)) {
+    return ret;
+  }
+
+  // put the items into a uniform grid on the x-y plane, with cells slightly
+  // larger than the threshold, to absorb rounding errors: two items can only
+  // be linked if they are in the same cell or in adjacent ones; the cell size
+  // is increased if needed so that there are not many more cells than items
+  auto myMinX = std::get<0>(aItems[0]);
+  auto myMinY = std::get<1>(aItems[0]);
+  auto myMaxX = myMinX;
+  auto myMaxY = myMinY;
+  for (const auto& myItem : aItems) {
+    myMinX = std::min(myMinX, std::get<0>(myItem));
+    myMinY = std::min(myMinY, std::get<1>(myItem));
+    myMaxX = std::max(myMaxX, std::get<0>(myItem));
+    myMaxY = std::max(myMaxY, std::get<1>(myItem));
+  }
+  const auto myMaxCells = static_cast<double>(
+      std::max<std::size_t>(1, std::ceil(std::sqrt(static_cast<double>(N)))));
+  const auto myCellSize =
+      std::max(aThreshold * (1 + 1e-9),
+               std::max(myMaxX - myMinX, myMaxY - myMinY) / myMaxCells);
+  const auto myCell = [&](const double aValue, const double aMin) {
+    return std::min(static_cast<std::size_t>((aValue - aMin) / myCellSize),
+                    static_cast<std::size_t>(myMaxCells));
+  };
+  const auto X = myCell(myMaxX, myMinX) + 1;
+  const auto Y = myCell(myMaxY, myMinY) + 1;
+
+  // items sorted by cell, then by index, with the offset of every cell
+  std::vector<std::size_t>   myCells(N);
+  std::vector<std::size_t>   myOffsets(X * Y + 1, 0);
+  std::vector<unsigned long> myItems(N);
+  for (std::size_t i = 0; i < N; i++) {
+    myCells[i] = myCell(std::get<0>(aItems[i]), myMinX) +
+                 X * myCell(std::get<1>(aItems[i]), myMinY);
+    myOffsets[myCells[i] + 1]++;
+  }
+  for (std::size_t c = 0; c < X * Y; c++) {
+    myOffsets[c + 1] += myOffsets[c];
+  }
+  {
+    auto myNext = myOffsets;
+    for (std::size_t i = 0; i < N; i++) {
+      myItems[myNext[myCells[i]]++] = i;
+    }
+  }
+
+  // the links are returned, and the random variables drawn, in the same
+  // order as if all the pairs (i, j) with j < i were checked
+  std::vector<unsigned long> myNeighbors;
+  for (unsigned long i = 0; i < N; i++) {
+    const auto myX = myCells[i] % X;
+    const auto myY = myCells[i] / X;
+    myNeighbors.clear();
+    for (auto y = myY > 0 ? myY - 1 : 0; y <= std::min(myY + 1, Y - 1); y++) {
+      for (auto x = myX > 0 ? myX - 1 : 0; x <= std::min(myX + 1, X - 1);
+           x++) {
+        const auto c = x + X * y;
+        for (auto k = myOffsets[c]; k < myOffsets[c + 1]; k++) {
+          const auto j = myItems[k];
+          if (j >= i) {
+            break; // items are sorted by index within the cell
+          }
+          if (distance(aItems[i], aItems[j]) < aThreshold) {
+            myNeighbors.emplace_back(j);
+          }
+        }
+      }
+    }
+    std::sort(myNeighbors.begin(), myNeighbors.end());
+    for (const auto j : myNeighbors) {
+      if (myRv.get() == nullptr or (*myRv)() < aProbability) {
         ret.push_back({i, j});
       }
     }
@@ -78,6 +155,100 @@ findLinks(const std::vector<Coordinate>& aItems,
   return ret;
 }
 
+void checkWaxmanParameters(const std::size_t aNodes,
+                           const double      aL,
+                           const double      aAlpha,
+                           const double      aBeta) {
+  if (aAlpha <= 0 or aAlpha > 1) {
+    throw std::range_error(
+        "Value of alpha not in (0,1] in Waxman model network generation: " +
+        std::to_string(aAlpha));
+  }
+  if (aBeta <= 0 or aBeta > 1) {
+    throw std::range_error(
+        "Value of beta not in (0,1] in Waxman model network generation: " +
+        std::to_string(aBeta));
+  }
+  if (aL < 0) {
+    throw std::range_error(
+        "Negative value of L in Waxman model network generation: " +
+        std::to_string(aL));
+  }
+  if (aNodes == 0) {
+    throw std::range_error("Empty network");
+  }
+}
+
+std::vector<Coordinate> waxmanCoordinates(const std::size_t   aNodes,
+                                          const double        aGridLength,
+                                          const std::uint64_t aSeed,
+                                          const std::uint64_t aTry) {
+  support::UniformRv      myRvX(0, aGridLength, aSeed, 0, aTry);
+  support::UniformRv      myRvY(0, aGridLength, aSeed, 1, aTry);
+  std::vector<Coordinate> ret(aNodes, Coordinate{0, 0, 0});
+  for (auto& myNode : ret) {
+    std::get<0>(myNode) = myRvX();
+    std::get<1>(myNode) = myRvY();
+  }
+  return ret;
+}
+
+std::vector<std::pair<unsigned long, unsigned long>>
+findWaxmanLinks(const std::vector<Coordinate>& aItems,
+                const double                   aL,
+                const double                   aAlpha,
+                const double                   aBeta,
+                const std::uint64_t            aSeed,
+                const std::uint64_t            aTry,
+                const std::size_t              aNumThreads,
+                bool&                          aConnected) {
+  const auto N = aItems.size();
+
+  // the i-th row contains the items j > i linked to i; the rows i and
+  // N - 1 - i are drawn by the same task, so that all the tasks draw about
+  // the same number of pairs
+  std::vector<std::vector<unsigned long>> myRows(N);
+  const auto myDrawRow = [&](const std::size_t i) {
+    for (auto j = i + 1; j < N; j++) {
+      const auto myEdgeProb =
+          aBeta * std::exp(-distance(aItems[i], aItems[j]) / (aAlpha * aL));
+      assert(myEdgeProb >= 0 and myEdgeProb <= 1);
+      if (counterUniform(aSeed, aTry, i, j) < myEdgeProb) {
+        myRows[i].emplace_back(j);
+      }
+    }
+  };
+  parallelFor(
+      0,
+      (N + 1) / 2,
+      aNumThreads,
+      [N, &myDrawRow](const std::size_t aFirst, const std::size_t aLast) {
+        for (auto i = aFirst; i < aLast; i++) {
+          myDrawRow(i);
+          if (N - 1 - i != i) {
+            myDrawRow(N - 1 - i);
+          }
+        }
+      });
+
+  // collect the links, merging the sets of items that they connect
+  std::size_t myNumLinks = 0;
+  for (const auto& myRow : myRows) {
+    myNumLinks += myRow.size();
+  }
+  std::vector<std::pair<unsigned long, unsigned long>> ret;
+  ret.reserve(myNumLinks);
+  DisjointSets mySets(N);
+  for (std::size_t i = 0; i < N; i++) {
+    for (const auto j : myRows[i]) {
+      ret.emplace_back(i, j);
+      mySets.merge(i, j);
+    }
+  }
+  aConnected = N > 1 and mySets.numSets() == 1;
+  return ret;
+}
+
 std::vector<std::pair<unsigned long, unsigned long>>
 findLinks(std::istream& aGraphMl, std::vector<Coordinate>& aCoordinates) {
   struct VertexData {
@@ -122,15 +293,42 @@ findLinks(std::istream& aGraphMl, std::vector<Coordinate>& aCoordinates) {
         std::make_tuple(myLongitudes[myVertex], myLatitudes[myVertex], 0.0);
   }
 
-  // fill the return value
-  std::vector<std::pair<unsigned long, unsigned long>> ret;
-  std::set<std::string>                                myFound;
+  // fill the return value, without duplicate edges
+  std::vector<std::pair<unsigned long, unsigned long>> myEdges;
+  myEdges.reserve(boost::num_edges(myGraph));
   for (const auto& myEdge : boost::make_iterator_range(boost::edges(myGraph))) {
-    if (myFound
-            .emplace(std::to_string(myEdge.m_source) +
-                     std::to_string(myEdge.m_target))
-            .second) {
-      ret.push_back({myEdge.m_source, myEdge.m_target});
+    myEdges.push_back({myEdge.m_source, myEdge.m_target});
+  }
+  const auto myDuplicates = findDuplicateEdges(myEdges);
+  std::vector<std::pair<unsigned long, unsigned long>> ret;
+  ret.reserve(myEdges.size());
+  for (std::size_t i = 0; i < myEdges.size(); i++) {
+    if (not myDuplicates[i]) {
+      ret.emplace_back(myEdges[i]);
+    }
+  }
+  return ret;
+}
+
+std::vector<bool> findDuplicateEdges(
+    const std::vector<std::pair<unsigned long, unsigned long>>& aEdges) {
+  // sort the positions by edge and then by position, so that the first
+  // occurrence of every edge comes before its duplicates
+  std::vector<std::size_t> myPositions(aEdges.size());
+  for (std::size_t i = 0; i < aEdges.size(); i++) {
+    myPositions[i] = i;
+  }
+  std::sort(myPositions.begin(),
+            myPositions.end(),
+            [&aEdges](const std::size_t aLhs, const std::size_t aRhs) {
+              return aEdges[aLhs] < aEdges[aRhs] or
+                     (aEdges[aLhs] == aEdges[aRhs] and aLhs < aRhs);
+            });
+
+  std::vector<bool> ret(aEdges.size(), false);
+  for (std::size_t i = 1; i < myPositions.size(); i++) {
+    if (aEdges[myPositions[i]] == aEdges[myPositions[i - 1]]) {
+      ret[myPositions[i]] = true;
     }
   }
   return ret;
@@ -138,6 +336,7 @@ findLinks(std::istream& aGraphMl, std::vector<Coordinate>& aCoordinates) {
 
 bool bigraphConnected(
     const std::vector<std::pair<unsigned long, unsigned long>>& aEdges) {
+  Instrumentation::count(Instrumentation::Counter::GraphCopies);
 
   // count the number of connected vertices
   using Graph =
@@ -199,5 +398,29 @@ double fidelitySwapping(const double        p1,
              std::pow((4.0 * F - 1.0) / 3.0, L);
 }
 
+std::size_t fidelityMaxHops(const double p1,
+                            const double p2,
+                            const double eta,
+                            const double F,
+                            const double aThreshold) {
+  if (F < aThreshold) {
+    return 0;
+  }
+
+  // the fidelity tends to 1/4 with the number of swaps, unless there are no
+  // impairments at all, in which case it is always F
+  if (aThreshold <= 1.0 / 4.0 or
+      (p1 * p1 * p2 * (4 * eta * eta - 1) / 3.0 >= 1 and F >= 1)) {
+    return std::numeric_limits<std::size_t>::max();
+  }
+
+  // a path with ret edges has ret - 1 swaps
+  std::size_t ret = 1;
+  while (fidelitySwapping(p1, p2, eta, ret, F) >= aThreshold) {
+    ret++;
+  }
+  return ret;
+}
+
 } // namespace qr
 } // namespace uiiit
\ No newline at end of file
@@ -32,6 +32,7 @@ SOFTWARE.
 #pragma once
 
 #include <cinttypes>
+#include <cstddef>
 #include <istream>
 #include <tuple>
 #include <utility>
@@ -72,6 +73,85 @@ findLinks(const std::vector<Coordinate>& aItems,
           const double                   aProbability = 1,
           const unsigned long            aSeed        = 0);
 
+/**
+ * @brief Return a pseudo-random number uniformly distributed in [0, 1) that
+ * only depends on the given key.
+ *
+ * Unlike a stream of a r.v., the numbers can be drawn in any order, e.g., by
+ * different threads, without changing their values.
+ */
+inline double counterUniform(const std::uint64_t aSeed,
+                             const std::uint64_t aStream,
+                             const std::uint64_t aFirst,
+                             const std::uint64_t aSecond) {
+  // splitmix64 finalizer applied to every component of the key in turn
+  const auto myMix = [](std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  };
+  const auto x = myMix(myMix(myMix(myMix(aSeed) ^ aStream) ^ aFirst) ^ aSecond);
+  return static_cast<double>(x >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @throw std::range_error if the parameters of the Waxman model are invalid,
+ * i.e., aAlpha or aBeta are not in (0,1], aL is negative or aNodes is null.
+ */
+void checkWaxmanParameters(const std::size_t aNodes,
+                           const double      aL,
+                           const double      aAlpha,
+                           const double      aBeta);
+
+/**
+ * @brief Return the coordinates of the nodes of a Waxman graph, drawn
+ * uniformly on a square grid.
+ *
+ * @param aNodes the number of nodes
+ * @param aGridLength the edge size of the grid
+ * @param aSeed the pseudo-random number generator seed to use
+ * @param aTry the attempt of the network generation with the same seed
+ */
+std::vector<Coordinate> waxmanCoordinates(const std::size_t   aNodes,
+                                          const double        aGridLength,
+                                          const std::uint64_t aSeed,
+                                          const std::uint64_t aTry);
+
+/**
+ * @brief Draw the links of a Waxman graph between the given items.
+ *
+ * Two items i < j at distance d are linked with probability
+ * aBeta * exp(-d / (aAlpha * aL)), which is compared to
+ * counterUniform(aSeed, aTry, i, j): the pairs are drawn in parallel, by
+ * the workers of the task scheduler running the caller, if any, and the
+ * links do not depend on the number of threads.
+ *
+ * @param aItems the coordinates of the items
+ * @param aL the maximum distance between two items
+ * @param aAlpha the larger this value, the higher the density of short links
+ * compared to longer ones
+ * @param aBeta the larger this value, the higher the link density
+ * @param aSeed the pseudo-random number generator seed to use
+ * @param aTry the attempt of the network generation with the same seed
+ * @param aNumThreads the number of threads used if not called from a task of
+ * a TaskScheduler, if 0 use the hardware concurrency
+ * @param aConnected set to true if every item has at least one link and the
+ * graph is connected, which is found with union-find while the links are
+ * collected
+ *
+ * @return the links (i, j), with i < j, in lexicographic order
+ */
+std::vector<std::pair<unsigned long, unsigned long>>
+findWaxmanLinks(const std::vector<Coordinate>& aItems,
+                const double                   aL,
+                const double                   aAlpha,
+                const double                   aBeta,
+                const std::uint64_t            aSeed,
+                const std::uint64_t            aTry,
+                const std::size_t              aNumThreads,
+                bool&                          aConnected);
+
 /**
  * @brief Return the links between vertices as read from a GraphML file.
  *
@@ -83,6 +163,16 @@ findLinks(const std::vector<Coordinate>& aItems,
 std::vector<std::pair<unsigned long, unsigned long>>
 findLinks(std::istream& aGraphMl, std::vector<Coordinate>& aCoordinates);
 
+/**
+ * @brief Find the edges that are equal to a previous one in the same vector.
+ *
+ * @param aEdges The edges (src, dst).
+ * @return a vector with the same size as aEdges, where an element is true if
+ * the corresponding edge is a duplicate.
+ */
+std::vector<bool> findDuplicateEdges(
+    const std::vector<std::pair<unsigned long, unsigned long>>& aEdges);
+
 /**
  * @brief Detect if the bidirectional graph defined by the given edges is
  * connected.
@@ -114,5 +204,30 @@ double fidelitySwapping(const double        p1,
                         const unsigned long L,
                         const double        F);
 
+/**
+ * @brief Return the maximum length of a path such that the fidelity of the
+ * end-to-end entangled pair is not smaller than a given threshold.
+ *
+ * Since the fidelity does not increase with the number of swaps, every path
+ * longer than the limit returned would be rejected by the same comparison
+ * with fidelitySwapping(), hence the searches of paths can stop at this limit.
+ *
+ * @param p1 the reliability on one-qubit operations
+ * @param p2 the reliability of two-qubit operations
+ * @param eta the probability of a wrong measurement
+ * @param F the local entanglement fidelity
+ * @param aThreshold the minimum end-to-end fidelity
+ * @return the maximum number of edges of a path, which is 0 if F is smaller
+ * than the threshold, or std::numeric_limits<std::size_t>::max() if there is
+ * no limit
+ *
+ * @pre same as fidelitySwapping()
+ */
+std::size_t fidelityMaxHops(const double p1,
+                            const double p2,
+                            const double eta,
+                            const double F,
+                            const double aThreshold);
+
 } // namespace qr
 } // namespace uiiit
\ No newline at end of file
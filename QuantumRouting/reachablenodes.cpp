@@ -0,0 +1,77 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/reachablenodes.h"
+
+namespace uiiit {
+namespace qr {
+
+CompactReachableNodes::CompactReachableNodes(const std::size_t aNumNodes)
+    : theNumNodes(aNumNodes)
+    , theWords((aNumNodes + 63) / 64)
+    , theBits(theNumNodes * theWords, 0) {
+  // noop
+}
+
+std::size_t
+CompactReachableNodes::count(const std::size_t aSrc) const noexcept {
+  std::size_t ret = 0;
+  for (std::size_t w = 0; w < theWords; w++) {
+    ret += __builtin_popcountll(theBits[aSrc * theWords + w]);
+  }
+  return ret;
+}
+
+std::vector<unsigned long>
+CompactReachableNodes::peers(const std::size_t aSrc) const {
+  std::vector<unsigned long> ret;
+  ret.reserve(count(aSrc));
+  for (std::size_t w = 0; w < theWords; w++) {
+    for (auto myWord = theBits[aSrc * theWords + w]; myWord != 0;
+         myWord &= myWord - 1) {
+      ret.emplace_back(w * 64 + __builtin_ctzll(myWord));
+    }
+  }
+  return ret;
+}
+
+std::map<unsigned long, std::set<unsigned long>>
+CompactReachableNodes::toMap() const {
+  std::map<unsigned long, std::set<unsigned long>> ret;
+  for (std::size_t mySrc = 0; mySrc < theNumNodes; mySrc++) {
+    const auto myPeers = peers(mySrc);
+    ret.emplace(mySrc, std::set<unsigned long>(myPeers.begin(), myPeers.end()));
+  }
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,92 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Compact representation of the set of nodes reachable from every
+ * node of a network.
+ *
+ * The sets are stored in a square bit matrix, with one row per source node
+ * packed into 64-bit words.
+ */
+class CompactReachableNodes final
+{
+ public:
+  //! Create an empty set for the given number of nodes.
+  explicit CompactReachableNodes(const std::size_t aNumNodes);
+
+  //! \return the number of nodes.
+  std::size_t numNodes() const noexcept {
+    return theNumNodes;
+  }
+
+  //! \return true if aDst is in the set of aSrc.
+  bool reachable(const std::size_t aSrc,
+                 const std::size_t aDst) const noexcept {
+    return (theBits[aSrc * theWords + aDst / 64] >> (aDst % 64)) & 1u;
+  }
+
+  //! Add aDst to the set of aSrc.
+  void set(const std::size_t aSrc, const std::size_t aDst) noexcept {
+    theBits[aSrc * theWords + aDst / 64] |= std::uint64_t(1) << (aDst % 64);
+  }
+
+  //! \return the number of nodes in the set of aSrc.
+  std::size_t count(const std::size_t aSrc) const noexcept;
+
+  //! \return the nodes in the set of aSrc, in increasing order.
+  std::vector<unsigned long> peers(const std::size_t aSrc) const;
+
+  //! \return the same sets, as returned by CapacityNetwork::reachableNodes().
+  std::map<unsigned long, std::set<unsigned long>> toMap() const;
+
+  bool operator==(const CompactReachableNodes& aOther) const noexcept {
+    return theNumNodes == aOther.theNumNodes and theBits == aOther.theBits;
+  }
+
+ private:
+  std::size_t                theNumNodes;
+  std::size_t                theWords; //!< number of words per row
+  std::vector<std::uint64_t> theBits;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,431 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/resultsink.h"
+
+#include <boost/filesystem.hpp>
+
+#include <glog/logging.h>
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'Q', 'R', 'S', 'I', 'N', 'K', 0, 0};
+constexpr std::size_t         HEADER_SIZE = MAGIC.size() + 8;
+
+// code of a cell saved verbatim, without adding it to the dictionary
+constexpr std::uint64_t LITERAL = 0;
+
+// minimum size of a cell in a record payload, i.e., its code
+constexpr std::size_t MIN_CELL_SIZE = 1;
+
+using Dictionaries = std::vector<std::vector<std::string>>;
+
+// dictionary of the cells of a column while writing, with their indices
+using Encoding = std::unordered_map<std::string, std::size_t>;
+
+void putDouble(std::string& aBuffer, const double aValue) {
+  aBuffer.append(reinterpret_cast<const char*>(&aValue), sizeof(aValue));
+}
+
+void putVarint(std::string& aBuffer, std::uint64_t aValue) {
+  while (aValue >= 0x80) {
+    aBuffer.push_back(static_cast<char>((aValue & 0x7f) | 0x80));
+    aValue >>= 7;
+  }
+  aBuffer.push_back(static_cast<char>(aValue));
+}
+
+// read a varint from a stream and return false if incomplete
+bool getVarint(std::istream& aStream, std::uint64_t& aValue) {
+  aValue = 0;
+  for (unsigned myShift = 0; myShift < 64; myShift += 7) {
+    const auto myByte = aStream.get();
+    if (myByte == std::istream::traits_type::eof()) {
+      return false;
+    }
+    aValue |= static_cast<std::uint64_t>(myByte & 0x7f) << myShift;
+    if ((myByte & 0x80) == 0) {
+      return true;
+    }
+  }
+  throw std::runtime_error("corrupted record in result file");
+}
+
+// sequential reader of the fields of a record payload
+class Cursor final
+{
+ public:
+  explicit Cursor(const std::string& aBuffer)
+      : theBuffer(aBuffer)
+      , thePos(0) {
+    // noop
+  }
+
+  double getDouble() {
+    check(sizeof(double));
+    double ret;
+    std::memcpy(&ret, theBuffer.data() + thePos, sizeof(double));
+    thePos += sizeof(double);
+    return ret;
+  }
+
+  std::uint64_t getVarint() {
+    std::uint64_t ret = 0;
+    for (unsigned myShift = 0; myShift < 64; myShift += 7) {
+      check(1);
+      const auto myByte = static_cast<unsigned char>(theBuffer[thePos++]);
+      ret |= static_cast<std::uint64_t>(myByte & 0x7f) << myShift;
+      if ((myByte & 0x80) == 0) {
+        return ret;
+      }
+    }
+    throw std::runtime_error("corrupted record in result file");
+  }
+
+  std::string getString(const std::size_t aSize) {
+    check(aSize);
+    const auto ret = theBuffer.substr(thePos, aSize);
+    thePos += aSize;
+    return ret;
+  }
+
+  //! \return the number of bytes not read yet.
+  std::size_t left() const noexcept {
+    return theBuffer.size() - thePos;
+  }
+
+ private:
+  void check(const std::size_t aSize) const {
+    if (left() < aSize) {
+      throw std::runtime_error("corrupted record in result file");
+    }
+  }
+
+ private:
+  const std::string& theBuffer;
+  std::size_t        thePos;
+};
+
+// append the code of a cell, followed by the cell unless in the dictionary,
+// to which the cell is added if there is room
+void putCell(std::string& aBuffer, const std::string& aCell, Encoding& aDict) {
+  const auto it = aDict.find(aCell);
+  if (it != aDict.end()) {
+    putVarint(aBuffer, it->second + 1);
+    return;
+  }
+  auto myCode = LITERAL;
+  if (aDict.size() < ResultFile::MAX_DICTIONARY) {
+    myCode = aDict.size() + 1;
+    aDict.emplace(aCell, aDict.size());
+  }
+  putVarint(aBuffer, myCode);
+  putVarint(aBuffer, aCell.size());
+  aBuffer.append(aCell);
+}
+
+// read a cell saved with putCell()
+std::string getCell(Cursor& aCursor, std::vector<std::string>& aDictionary) {
+  const auto myCode = aCursor.getVarint();
+  if (myCode == LITERAL or myCode == aDictionary.size() + 1) {
+    const auto myLength = aCursor.getVarint();
+    auto       ret      = aCursor.getString(myLength);
+    if (myCode != LITERAL) {
+      aDictionary.emplace_back(ret);
+    }
+    return ret;
+  }
+  if (myCode > aDictionary.size()) {
+    throw std::runtime_error("corrupted record in result file");
+  }
+  return aDictionary[myCode - 1];
+}
+
+// read the header of a result file and return false if incomplete
+bool readHeader(std::istream& aStream, const std::string& aFilename) {
+  std::array<char, MAGIC.size()> myMagic;
+  std::uint64_t                  myVersion = 0;
+  aStream.read(myMagic.data(), myMagic.size());
+  aStream.read(reinterpret_cast<char*>(&myVersion), sizeof(myVersion));
+  if (not aStream) {
+    return false;
+  }
+  if (myMagic != MAGIC) {
+    throw std::runtime_error("not a result file: " + aFilename);
+  }
+  if (myVersion != ResultFile::VERSION) {
+    throw std::runtime_error("unsupported version " +
+                             std::to_string(myVersion) +
+                             " of result file: " + aFilename);
+  }
+  return true;
+}
+
+// read the records that follow the header of a result file, which has the
+// given size, and return the offset just after the last complete one
+std::uint64_t
+readRecords(std::istream&                                         aStream,
+            const std::uint64_t                                   aFileSize,
+            Dictionaries&                                         aDictionaries,
+            std::vector<std::string>&                             aKeyDictionary,
+            const std::function<void(const ResultFile::Record&)>& aCallback) {
+  std::uint64_t ret = HEADER_SIZE;
+  std::string   myPayload;
+  while (true) {
+    std::uint64_t mySize = 0;
+    if (not getVarint(aStream, mySize)) {
+      break; // incomplete record, or end of file
+    }
+    const auto myHeaderSize = static_cast<std::uint64_t>(aStream.tellg()) - ret;
+    if (mySize > aFileSize - ret - myHeaderSize) {
+      break; // incomplete record
+    }
+    myPayload.resize(mySize);
+    aStream.read(&myPayload[0], mySize);
+    if (not aStream) {
+      break; // incomplete record
+    }
+
+    Cursor             myCursor(myPayload);
+    ResultFile::Record myRecord;
+    myRecord.theSeed      = myCursor.getVarint();
+    myRecord.theDuration  = myCursor.getDouble();
+    myRecord.theKey       = getCell(myCursor, aKeyDictionary);
+    const auto myNumCells = myCursor.getVarint();
+    if (myNumCells > myCursor.left() / MIN_CELL_SIZE) {
+      throw std::runtime_error("corrupted record in result file");
+    }
+    if (aDictionaries.size() < myNumCells) {
+      aDictionaries.resize(myNumCells);
+    }
+    myRecord.theCells.reserve(myNumCells);
+    for (std::size_t j = 0; j < myNumCells; j++) {
+      myRecord.theCells.emplace_back(getCell(myCursor, aDictionaries[j]));
+    }
+    if (myCursor.left() != 0) {
+      throw std::runtime_error("corrupted record in result file");
+    }
+
+    ret += myHeaderSize + mySize;
+    aCallback(myRecord);
+  }
+  return ret;
+}
+
+} // namespace
+
+ResultFile::ResultFile(const std::string& aFilename, const bool aResume)
+    : theFilename(aFilename)
+    , theMutex()
+    , theStream()
+    , theSeeds()
+    , theKey()
+    , theSize(0)
+    , theRecords()
+    , theDictionaries()
+    , theKeyDictionary() {
+  if (theFilename.empty()) {
+    return;
+  }
+
+  std::uint64_t myValidSize = 0;
+  if (aResume and boost::filesystem::exists(theFilename)) {
+    const auto    myFileSize = boost::filesystem::file_size(theFilename);
+    std::ifstream myStream(theFilename, std::ios::binary);
+    if (not myStream) {
+      throw std::runtime_error("could not open result file for reading: " +
+                               theFilename);
+    }
+    if (readHeader(myStream, theFilename)) {
+      Dictionaries             myDictionaries;
+      std::vector<std::string> myKeyDictionary;
+      myValidSize = readRecords(myStream,
+                                myFileSize,
+                                myDictionaries,
+                                myKeyDictionary,
+                                [this](const auto& aRecord) {
+                                  if (theSize > 0) {
+                                    checkKey(aRecord.theKey);
+                                  }
+                                  theSeeds.emplace(aRecord.theSeed);
+                                  theKey = aRecord.theKey;
+                                  theSize++;
+                                });
+      theDictionaries.resize(myDictionaries.size());
+      for (std::size_t j = 0; j < myDictionaries.size(); j++) {
+        for (std::size_t k = 0; k < myDictionaries[j].size(); k++) {
+          theDictionaries[j].emplace(myDictionaries[j][k], k);
+        }
+      }
+      for (std::size_t k = 0; k < myKeyDictionary.size(); k++) {
+        theKeyDictionary.emplace(myKeyDictionary[k], k);
+      }
+    }
+    LOG_IF(WARNING, myValidSize < myFileSize)
+        << "discarding " << (myFileSize - myValidSize)
+        << " bytes of an incomplete record at the end of " << theFilename;
+    VLOG(1) << "resuming from " << theSize << " records in " << theFilename;
+  }
+
+  if (myValidSize == 0) {
+    theStream.open(theFilename, std::ios::binary | std::ios::trunc);
+    std::uint64_t myVersion = VERSION;
+    theStream.write(MAGIC.data(), MAGIC.size());
+    theStream.write(reinterpret_cast<const char*>(&myVersion),
+                    sizeof(myVersion));
+    theStream.flush();
+  } else {
+    boost::filesystem::resize_file(theFilename, myValidSize);
+    theStream.open(theFilename, std::ios::binary | std::ios::app);
+  }
+  if (not theStream) {
+    throw std::runtime_error("could not open result file for writing: " +
+                             theFilename);
+  }
+}
+
+void ResultFile::append(Record&& aRecord) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  checkKey(aRecord.theKey);
+  theKey = aRecord.theKey;
+  if (theFilename.empty()) {
+    theSeeds.emplace(aRecord.theSeed);
+    theRecords.emplace_back(std::move(aRecord));
+  } else {
+    writeRecord(aRecord);
+    theSeeds.emplace(aRecord.theSeed);
+  }
+  theSize++;
+}
+
+bool ResultFile::contains(const std::size_t aSeed,
+                          const std::string& aKey) const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  checkKey(aKey);
+  return theSeeds.count(aSeed) > 0;
+}
+
+std::size_t ResultFile::size() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theSize;
+}
+
+void ResultFile::forEach(
+    const std::function<void(const Record&)>& aCallback) const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  if (theFilename.empty()) {
+    for (const auto& myRecord : theRecords) {
+      aCallback(myRecord);
+    }
+    return;
+  }
+
+  std::ifstream myStream(theFilename, std::ios::binary);
+  if (not myStream or not readHeader(myStream, theFilename)) {
+    throw std::runtime_error("could not read result file: " + theFilename);
+  }
+  Dictionaries             myDictionaries;
+  std::vector<std::string> myKeyDictionary;
+  readRecords(myStream,
+              boost::filesystem::file_size(theFilename),
+              myDictionaries,
+              myKeyDictionary,
+              aCallback);
+}
+
+void ResultFile::toCsv(std::ostream& aStream) const {
+  forEach([&aStream](const Record& aRecord) {
+    for (const auto& myCell : aRecord.theCells) {
+      aStream << myCell << ',';
+    }
+    aStream << aRecord.theDuration << '\n';
+  });
+}
+
+std::vector<std::string> ResultFile::splitCsv(const std::string& aLine) {
+  std::vector<std::string> ret;
+  std::size_t              myBegin = 0;
+  while (true) {
+    const auto myEnd = aLine.find(',', myBegin);
+    ret.emplace_back(aLine.substr(myBegin, myEnd - myBegin));
+    if (myEnd == std::string::npos) {
+      break;
+    }
+    myBegin = myEnd + 1;
+  }
+  return ret;
+}
+
+void ResultFile::checkKey(const std::string& aKey) const {
+  if (theSize > 0 and aKey != theKey) {
+    throw std::runtime_error(
+        "the runs in " + (theFilename.empty() ? "memory" : theFilename) +
+        " have different parameters: " + theKey + " vs. " + aKey);
+  }
+}
+
+void ResultFile::writeRecord(const Record& aRecord) {
+  std::string myPayload;
+  putVarint(myPayload, aRecord.theSeed);
+  putDouble(myPayload, aRecord.theDuration);
+  putCell(myPayload, aRecord.theKey, theKeyDictionary);
+  putVarint(myPayload, aRecord.theCells.size());
+  if (theDictionaries.size() < aRecord.theCells.size()) {
+    theDictionaries.resize(aRecord.theCells.size());
+  }
+  for (std::size_t j = 0; j < aRecord.theCells.size(); j++) {
+    putCell(myPayload, aRecord.theCells[j], theDictionaries[j]);
+  }
+
+  // the record is written with a single operation, then flushed so that it
+  // survives the process being killed
+  std::string myFrame;
+  myFrame.reserve(sizeof(std::uint64_t) + myPayload.size());
+  putVarint(myFrame, myPayload.size());
+  myFrame.append(myPayload);
+  theStream.write(myFrame.data(), myFrame.size());
+  theStream.flush();
+  if (not theStream) {
+    throw std::runtime_error("could not write to result file: " +
+                             theFilename);
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
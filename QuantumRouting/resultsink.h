@@ -0,0 +1,276 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief File of experiment results, where every run is appended as soon as
+ * it finishes.
+ *
+ * A record contains the seed, key and duration of a run and the CSV cells of
+ * its parameters and output, which are dictionary-encoded column by column:
+ * a cell equal to one already seen in the same column is saved as its code
+ * in the dictionary, hence the parameters, which are often the same for all
+ * the runs of a campaign, take typically one byte per column. The
+ * dictionaries have a bounded size, cells that do not fit are saved
+ * verbatim.
+ *
+ * The key identifies the parameters of a run other than its seed, including
+ * those that are not saved among the cells: all the records in a file must
+ * have the same key, so that resuming with different parameters fails
+ * instead of mixing the results of two configurations in the same file.
+ *
+ * The file format is binary, where integers are saved as unsigned LEB128
+ * varints and floating point numbers in 8 bytes in host byte order:
+ * - magic string: 8 bytes, "QRSINK" padded with zeros;
+ * - format version: 64-bit unsigned integer;
+ * - a sequence of records, each made of the payload size followed by the
+ *   payload: seed, duration, key, number of cells, then the cells; the key
+ *   and every cell are saved as a code: 0 if saved verbatim, the index in
+ *   the dictionary plus one if already in the dictionary, the size of the
+ *   dictionary plus one if added to it; those saved verbatim or added to the
+ *   dictionary are followed by their length and characters; the key has a
+ *   dictionary of its own.
+ *
+ * Since records are written with a single operation, a process killed
+ * while writing may only leave an incomplete record at the end of the file,
+ * which is discarded when resuming.
+ *
+ * If the file name is empty then the records are only kept in memory.
+ *
+ * All the methods are thread-safe.
+ */
+class ResultFile final
+{
+ public:
+  //! The version of the file format.
+  static constexpr std::uint64_t VERSION = 2;
+
+  //! The maximum number of entries in the dictionary of a column, so that
+  //! codes take one byte.
+  static constexpr std::size_t MAX_DICTIONARY = 127;
+
+  struct Record {
+    std::size_t              theSeed = 0;
+    std::string              theKey;
+    double                   theDuration = 0;
+    std::vector<std::string> theCells;
+  };
+
+  /**
+   * @brief Open a result file.
+   *
+   * @param aFilename The name of the file. If empty, the records are kept
+   * in memory.
+   * @param aResume If true, the records already in the file are kept and
+   * new ones are appended to them, otherwise the file is overwritten.
+   *
+   * @throw std::runtime_error if the file cannot be opened, or if resuming
+   * from a file which is corrupted, has another format version, or has
+   * records with different keys.
+   */
+  ResultFile(const std::string& aFilename, const bool aResume);
+
+  ResultFile(const ResultFile&) = delete;
+  ResultFile& operator=(const ResultFile&) = delete;
+
+  /**
+   * @brief Add a record and save it to the file.
+   *
+   * @throw std::runtime_error if the record cannot be written, or if its
+   * key is different from that of the records already in the file.
+   */
+  void append(Record&& aRecord);
+
+  /**
+   * @brief Check if a run has been saved already.
+   *
+   * @param aSeed The seed of the run.
+   * @param aKey The key of the run.
+   *
+   * @return true if there is a record with the given seed.
+   *
+   * @throw std::runtime_error if the records in the file have another key.
+   */
+  bool contains(const std::size_t aSeed, const std::string& aKey) const;
+
+  //! \return the number of records.
+  std::size_t size() const;
+
+  /**
+   * @brief Call a function on all the records, in the order they were added.
+   *
+   * The records are read back from the file one at a time.
+   *
+   * @throw std::runtime_error if the file cannot be read.
+   */
+  void forEach(const std::function<void(const Record&)>& aCallback) const;
+
+  /**
+   * @brief Write all the records as CSV lines: the cells, then the duration.
+   */
+  void toCsv(std::ostream& aStream) const;
+
+  //! \return the cells of a CSV line.
+  static std::vector<std::string> splitCsv(const std::string& aLine);
+
+ private:
+  using Dictionary = std::unordered_map<std::string, std::size_t>;
+
+  void checkKey(const std::string& aKey) const;
+  void writeRecord(const Record& aRecord);
+
+ private:
+  const std::string       theFilename;
+  mutable std::mutex      theMutex;
+  std::ofstream           theStream;
+  std::set<std::size_t>   theSeeds;
+  std::string             theKey; // of all the records
+  std::size_t             theSize;
+  std::list<Record>       theRecords; // only if the file name is empty
+  std::vector<Dictionary> theDictionaries; // one per column
+  Dictionary              theKeyDictionary;
+};
+
+/**
+ * @brief Collect the results of the runs of an experiment into a
+ * ResultFile.
+ *
+ * Replacement of support::ExperimentData with the same interface, where
+ * every run is saved as soon as its Raii object finishes.
+ *
+ * @tparam PARAMETERS The input of a run, with a theSeed member, a toCsv()
+ * method, and a key() method returning all the parameters that determine
+ * the output, except the seed.
+ * @tparam OUTPUT The output of a run, with a toCsv() method.
+ */
+template <class PARAMETERS, class OUTPUT>
+class ResultSink final
+{
+ public:
+  class Raii final
+  {
+   public:
+    Raii(ResultSink& aSink, PARAMETERS&& aParameters)
+        : theSink(aSink)
+        , theParameters(std::move(aParameters))
+        , theStart(std::chrono::steady_clock::now()) {
+      // noop
+    }
+
+    //! \return the input parameters of the run.
+    const PARAMETERS& in() const noexcept {
+      return theParameters;
+    }
+
+    //! Save the output of the run.
+    void finish(OUTPUT&& aOutput) {
+      const std::chrono::duration<double> myDuration =
+          std::chrono::steady_clock::now() - theStart;
+      theSink.theFile.append(ResultFile::Record{
+          theParameters.theSeed,
+          theParameters.key(),
+          myDuration.count(),
+          ResultFile::splitCsv(theParameters.toCsv() + ',' +
+                               aOutput.toCsv())});
+    }
+
+   private:
+    ResultSink&                                 theSink;
+    const PARAMETERS                            theParameters;
+    const std::chrono::steady_clock::time_point theStart;
+  };
+
+  /**
+   * @brief Create a sink.
+   *
+   * @param aFilename The result file. If empty, results are kept in memory.
+   * @param aResume True to keep the results already in the file.
+   *
+   * @throw std::runtime_error if the file cannot be opened or resumed.
+   */
+  explicit ResultSink(const std::string& aFilename = std::string(),
+                      const bool         aResume   = false)
+      : theFile(aFilename, aResume) {
+    // noop
+  }
+
+  /**
+   * @brief Check if a run has been saved already.
+   *
+   * @return true if the run with the seed of the given parameters has been
+   * saved already.
+   *
+   * @throw std::runtime_error if the runs saved have other parameters.
+   */
+  bool contains(const PARAMETERS& aParameters) const {
+    return theFile.contains(aParameters.theSeed, aParameters.key());
+  }
+
+  //! \return the number of runs saved.
+  std::size_t size() const {
+    return theFile.size();
+  }
+
+  //! Call a function on all the runs saved, in the order they were saved.
+  void forEach(
+      const std::function<void(const ResultFile::Record&)>& aCallback) const {
+    theFile.forEach(aCallback);
+  }
+
+  //! Write all the results in CSV format.
+  void toCsv(std::ostream& aStream) const {
+    theFile.toCsv(aStream);
+  }
+
+ private:
+  ResultFile theFile;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,125 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/shard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+namespace uiiit {
+namespace qr {
+
+Shard::Shard()
+    : theIndex(0)
+    , theCount(1) {
+  // noop
+}
+
+Shard::Shard(const std::size_t aIndex, const std::size_t aCount)
+    : theIndex(aIndex)
+    , theCount(aCount) {
+  if (aCount == 0) {
+    throw std::runtime_error("invalid null number of shards");
+  }
+  if (aIndex >= aCount) {
+    throw std::runtime_error("invalid shard " + toString() +
+                             ": the index must be smaller than the count");
+  }
+}
+
+Shard Shard::fromString(const std::string& aValue) {
+  const auto mySlash = aValue.find('/');
+  const auto myValid = [](const std::string& aNumber) {
+    return not aNumber.empty() and
+           std::all_of(aNumber.begin(), aNumber.end(), [](const char c) {
+             return c >= '0' and c <= '9';
+           });
+  };
+  if (mySlash == std::string::npos or not myValid(aValue.substr(0, mySlash)) or
+      not myValid(aValue.substr(mySlash + 1))) {
+    throw std::runtime_error("invalid shard '" + aValue +
+                             "': expected i/n, with 0 <= i < n");
+  }
+  return Shard(std::stoull(aValue.substr(0, mySlash)),
+               std::stoull(aValue.substr(mySlash + 1)));
+}
+
+std::string Shard::toString() const {
+  return std::to_string(theIndex) + "/" + std::to_string(theCount);
+}
+
+std::vector<std::size_t> Shard::assign(const std::vector<double>& aCosts,
+                                       const std::size_t          aCount) {
+  if (aCount == 0) {
+    throw std::runtime_error("invalid null number of shards");
+  }
+  for (const auto myCost : aCosts) {
+    if (not std::isfinite(myCost) or myCost < 0) {
+      throw std::runtime_error("invalid task cost: " + std::to_string(myCost));
+    }
+  }
+
+  // indices of the tasks in decreasing order of cost
+  std::vector<std::size_t> myTasks(aCosts.size());
+  std::iota(myTasks.begin(), myTasks.end(), 0);
+  std::stable_sort(myTasks.begin(),
+                   myTasks.end(),
+                   [&aCosts](const auto lhs, const auto rhs) {
+                     return aCosts[lhs] > aCosts[rhs];
+                   });
+
+  // min-heap of the shards, by total cost, then by number of tasks, so that
+  // tasks with zero cost are spread, too, and finally by index
+  using Load = std::tuple<double, std::size_t, std::size_t>;
+  std::priority_queue<Load, std::vector<Load>, std::greater<Load>> myLoads;
+  for (std::size_t i = 0; i < aCount; i++) {
+    myLoads.emplace(0.0, 0, i);
+  }
+
+  std::vector<std::size_t> ret(aCosts.size(), 0);
+  for (const auto myTask : myTasks) {
+    auto myLoad = myLoads.top();
+    myLoads.pop();
+    ret[myTask] = std::get<2>(myLoad);
+    std::get<0>(myLoad) += aCosts[myTask];
+    std::get<1>(myLoad)++;
+    myLoads.emplace(myLoad);
+  }
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
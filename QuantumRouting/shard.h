@@ -0,0 +1,141 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief One of the shards in which the tasks of an experiment campaign are
+ * split to be run on different hosts.
+ *
+ * The tasks are assigned to the shards based on an estimate of their cost,
+ * so that all the shards have about the same total cost. The assignment only
+ * depends on the costs and the number of shards, hence every host finds the
+ * same one independently from the others.
+ */
+class Shard final
+{
+ public:
+  //! Create the only shard of a campaign, which contains all the tasks.
+  Shard();
+
+  /**
+   * @brief Create a shard.
+   *
+   * @param aIndex The index of the shard, from 0.
+   * @param aCount The number of shards.
+   *
+   * @throw std::runtime_error if aCount is zero or aIndex is not smaller than
+   * aCount.
+   */
+  explicit Shard(const std::size_t aIndex, const std::size_t aCount);
+
+  /**
+   * @brief Create a shard from a string "i/n".
+   *
+   * @param aValue The string, where i is the index of the shard, from 0, and n
+   * is the number of shards.
+   *
+   * @throw std::runtime_error if the string is malformed or does not identify
+   * a valid shard.
+   */
+  static Shard fromString(const std::string& aValue);
+
+  //! \return the index of the shard, from 0.
+  std::size_t index() const noexcept {
+    return theIndex;
+  }
+
+  //! \return the number of shards.
+  std::size_t count() const noexcept {
+    return theCount;
+  }
+
+  //! \return the shard as "i/n".
+  std::string toString() const;
+
+  /**
+   * @brief Assign tasks to shards, with the longest-processing-time rule.
+   *
+   * The tasks are taken in decreasing order of cost, and by index if they
+   * have the same cost, and each is assigned to the shard with the smallest
+   * total cost so far; ties are broken by the number of tasks and then by
+   * the index of the shards. Thus, tasks with the same cost are assigned in
+   * round-robin order.
+   *
+   * @param aCosts The estimated costs of the tasks.
+   * @param aCount The number of shards.
+   * @return the index of the shard of every task.
+   *
+   * @throw std::runtime_error if aCount is zero or if any cost is negative or
+   * not finite.
+   */
+  static std::vector<std::size_t> assign(const std::vector<double>& aCosts,
+                                         const std::size_t          aCount);
+
+  /**
+   * @brief Keep only the tasks assigned to this shard.
+   *
+   * @param aTasks All the tasks of the campaign.
+   * @param aCost The function returning the estimated cost of a task.
+   * @return the tasks of this shard, in the same order as in aTasks.
+   */
+  template <class TASK, class COST>
+  std::vector<TASK> select(std::vector<TASK>&& aTasks, COST&& aCost) const {
+    std::vector<double> myCosts;
+    myCosts.reserve(aTasks.size());
+    for (const auto& myTask : aTasks) {
+      myCosts.emplace_back(aCost(myTask));
+    }
+    const auto        myShards = assign(myCosts, theCount);
+    std::vector<TASK> ret;
+    for (std::size_t i = 0; i < aTasks.size(); i++) {
+      if (myShards[i] == theIndex) {
+        ret.emplace_back(std::move(aTasks[i]));
+      }
+    }
+    return ret;
+  }
+
+ private:
+  std::size_t theIndex;
+  std::size_t theCount;
+};
+
+} // namespace qr
+} // namespace uiiit
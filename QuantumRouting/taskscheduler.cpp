@@ -0,0 +1,296 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/taskscheduler.h"
+#include "QuantumRouting/instrumentation.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+// the scheduler and index of the worker running in this thread, if any
+thread_local TaskScheduler* theCurrentScheduler = nullptr;
+thread_local std::size_t    theCurrentWorker    = 0;
+
+std::size_t hardwareConcurrency() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace
+
+TaskScheduler::TaskScheduler(const std::size_t aNumThreads)
+    : theWorkers()
+    , theQueued(0)
+    , theNextWorker(0)
+    , theMutex()
+    , theTaskAdded()
+    , theAllDone()
+    , theSubmitted()
+    , thePending(0)
+    , theErrors()
+    , theStop(false)
+    , theThreads() {
+  const auto myNumThreads =
+      aNumThreads > 0 ? aNumThreads : hardwareConcurrency();
+  for (std::size_t i = 0; i < myNumThreads; i++) {
+    theWorkers.emplace_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < myNumThreads; i++) {
+    theThreads.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theStop = true;
+  }
+  theTaskAdded.notify_all();
+  for (auto& myThread : theThreads) {
+    myThread.join();
+  }
+}
+
+void TaskScheduler::submit(Task&& aTask) {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    thePending++;
+  }
+  push(nullptr, [this, myTask = std::move(aTask)]() {
+    std::string myError;
+    auto        myFailed = false;
+    try {
+      myTask();
+    } catch (const std::exception& aErr) {
+      myError  = aErr.what();
+      myFailed = true;
+    } catch (...) {
+      myError  = "unknown exception";
+      myFailed = true;
+    }
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    if (myFailed) {
+      theErrors.emplace_back(std::move(myError));
+    }
+    if (--thePending == 0) {
+      theAllDone.notify_all();
+    }
+  });
+}
+
+std::vector<std::string> TaskScheduler::wait() {
+  std::unique_lock<std::mutex> myLock(theMutex);
+  theAllDone.wait(myLock, [this]() { return thePending == 0; });
+  std::vector<std::string> ret;
+  ret.swap(theErrors);
+  return ret;
+}
+
+void TaskScheduler::parallelFor(const std::size_t    aBegin,
+                                const std::size_t    aEnd,
+                                const RangeFunction& aBody) {
+  if (aEnd <= aBegin) {
+    return;
+  }
+  const auto N           = aEnd - aBegin;
+  const auto myNumChunks = std::min(N, 4 * numThreads());
+  const auto mySelf      = current() == this ? theCurrentWorker : numThreads();
+  if (myNumChunks == 1) {
+    aBody(aBegin, aEnd);
+    return;
+  }
+
+  // the state of the loop outlives its tasks, since it is only released
+  // after all of them have finished
+  struct Group {
+    std::atomic<std::size_t> theLeft;
+    std::mutex               theMutex;
+    std::exception_ptr       theError;
+  };
+  Group myGroup;
+  myGroup.theLeft = myNumChunks;
+
+  for (std::size_t c = 0; c < myNumChunks; c++) {
+    const auto myFirst = aBegin + N * c / myNumChunks;
+    const auto myLast  = aBegin + N * (c + 1) / myNumChunks;
+    auto&      myWorker =
+        mySelf < numThreads() ? *theWorkers[mySelf] :
+                                *theWorkers[theNextWorker++ % numThreads()];
+    push(&myWorker, [&myGroup, &aBody, myFirst, myLast]() {
+      try {
+        aBody(myFirst, myLast);
+      } catch (...) {
+        const std::lock_guard<std::mutex> myLock(myGroup.theMutex);
+        if (not myGroup.theError) {
+          myGroup.theError = std::current_exception();
+        }
+      }
+      myGroup.theLeft--; // the group must not be used after this
+    });
+  }
+
+  // help executing the tasks of this and other loops until done
+  while (myGroup.theLeft > 0) {
+    if (not runOne(mySelf, false)) {
+      std::this_thread::yield();
+    }
+  }
+  if (myGroup.theError) {
+    std::rethrow_exception(myGroup.theError);
+  }
+}
+
+TaskScheduler* TaskScheduler::current() noexcept {
+  return theCurrentScheduler;
+}
+
+void TaskScheduler::push(Worker* aWorker, Task&& aTask) {
+  // the costs of the task are added to those of the thread pushing it, even
+  // if the task is stolen by another worker
+  if (Instrumentation::enabled()) {
+    aTask = [myInstrumentation = Instrumentation::active(),
+             myTask            = std::move(aTask)]() {
+      const Instrumentation::Scope myScope(myInstrumentation);
+      myTask();
+    };
+  }
+
+  if (aWorker == nullptr) {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theSubmitted.emplace_back(std::move(aTask));
+    theQueued++;
+  } else {
+    {
+      const std::lock_guard<std::mutex> myLock(aWorker->theMutex);
+      aWorker->theTasks.emplace_back(std::move(aTask));
+    }
+    theQueued++;
+
+    // a worker that has just found no tasks is either waiting or will see
+    // the new one when checking before waiting
+    const std::lock_guard<std::mutex> myLock(theMutex);
+  }
+  theTaskAdded.notify_one();
+}
+
+bool TaskScheduler::runOne(const std::size_t aSelf, const bool aSubmitted) {
+  const auto N = numThreads();
+  Task       myTask;
+
+  // own tasks, most recent first
+  if (aSelf < N) {
+    auto&                             myWorker = *theWorkers[aSelf];
+    const std::lock_guard<std::mutex> myLock(myWorker.theMutex);
+    if (not myWorker.theTasks.empty()) {
+      myTask = std::move(myWorker.theTasks.back());
+      myWorker.theTasks.pop_back();
+    }
+  }
+
+  // steal the oldest task of another worker, which finishes the work
+  // already started before starting new one
+  for (std::size_t i = 1; not myTask and i <= N; i++) {
+    const auto myVictim = (aSelf + i) % N;
+    if (myVictim == aSelf) {
+      continue;
+    }
+    auto&                             myWorker = *theWorkers[myVictim];
+    const std::lock_guard<std::mutex> myLock(myWorker.theMutex);
+    if (not myWorker.theTasks.empty()) {
+      myTask = std::move(myWorker.theTasks.front());
+      myWorker.theTasks.pop_front();
+    }
+  }
+
+  // tasks submitted from outside, in order
+  if (not myTask and aSubmitted) {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    if (not theSubmitted.empty()) {
+      myTask = std::move(theSubmitted.front());
+      theSubmitted.pop_front();
+    }
+  }
+
+  if (not myTask) {
+    return false;
+  }
+  theQueued--;
+  myTask();
+  return true;
+}
+
+void TaskScheduler::workerLoop(const std::size_t aSelf) {
+  theCurrentScheduler = this;
+  theCurrentWorker    = aSelf;
+  while (true) {
+    if (runOne(aSelf, true)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> myLock(theMutex);
+    theTaskAdded.wait(myLock, [this]() { return theStop or theQueued > 0; });
+    if (theStop and theQueued == 0) {
+      return;
+    }
+  }
+}
+
+void parallelFor(const std::size_t                   aBegin,
+                 const std::size_t                   aEnd,
+                 const std::size_t                   aNumThreads,
+                 const TaskScheduler::RangeFunction& aBody) {
+  const auto myCurrent = TaskScheduler::current();
+  if (myCurrent != nullptr) {
+    myCurrent->parallelFor(aBegin, aEnd, aBody);
+    return;
+  }
+
+  const auto N            = aEnd > aBegin ? aEnd - aBegin : 0;
+  const auto myNumThreads = std::min(
+      N, aNumThreads > 0 ? aNumThreads : hardwareConcurrency());
+  if (myNumThreads <= 1) {
+    if (N > 0) {
+      aBody(aBegin, aEnd);
+    }
+    return;
+  }
+
+  // this thread takes part in the execution
+  TaskScheduler myScheduler(myNumThreads - 1);
+  myScheduler.parallelFor(aBegin, aEnd, aBody);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,175 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Pool of threads executing tasks with work stealing.
+ *
+ * Every worker has its own queue of tasks: new tasks created by a worker,
+ * e.g., the iterations of a parallelFor() called from within a task, are
+ * executed by the same worker in last-in first-out order, unless stolen in
+ * first-in first-out order by other workers that have nothing else to do.
+ * The tasks submitted from outside the pool, e.g., the runs of an
+ * experiment, are executed in the order of submission.
+ *
+ * A worker waiting for the end of a parallelFor() executes the pending
+ * tasks of the loops, but not those submitted from outside, hence nested
+ * loops never deadlock and are not delayed by unrelated tasks.
+ */
+class TaskScheduler final
+{
+ public:
+  using Task = std::function<void()>;
+
+  //! Body of a parallel loop, called with a range [aFirst, aLast).
+  using RangeFunction =
+      std::function<void(const std::size_t aFirst, const std::size_t aLast)>;
+
+  /**
+   * @brief Start the workers.
+   *
+   * @param aNumThreads The number of workers, if 0 use the hardware
+   * concurrency.
+   */
+  explicit TaskScheduler(const std::size_t aNumThreads);
+
+  //! Execute all the tasks left, then stop the workers.
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  //! \return the number of workers.
+  std::size_t numThreads() const noexcept {
+    return theWorkers.size();
+  }
+
+  /**
+   * @brief Add a task to be executed by any worker.
+   *
+   * The exceptions thrown by the task are returned by wait().
+   */
+  void submit(Task&& aTask);
+
+  /**
+   * @brief Wait until all the tasks submitted have been executed.
+   *
+   * Must not be called from a task.
+   *
+   * @return the messages of the exceptions thrown by the tasks.
+   */
+  std::vector<std::string> wait();
+
+  /**
+   * @brief Call a function on sub-ranges of [aBegin, aEnd) in parallel and
+   * wait until all of them are done.
+   *
+   * The calling thread takes part in the execution.
+   *
+   * @throw the first exception thrown by aBody, after all the sub-ranges
+   * have been executed.
+   */
+  void parallelFor(const std::size_t    aBegin,
+                   const std::size_t    aEnd,
+                   const RangeFunction& aBody);
+
+  //! \return the scheduler running the current task, or nullptr if the
+  //! calling thread is not a worker.
+  static TaskScheduler* current() noexcept;
+
+ private:
+  struct Worker {
+    std::mutex       theMutex;
+    std::deque<Task> theTasks;
+  };
+
+  // add a task to the queue of a worker, or of the scheduler if null
+  void push(Worker* aWorker, Task&& aTask);
+
+  // execute one task, if any, and return true; aSelf is the index of the
+  // calling worker, or numThreads() if not a worker
+  bool runOne(const std::size_t aSelf, const bool aSubmitted);
+
+  void workerLoop(const std::size_t aSelf);
+
+ private:
+  std::vector<std::unique_ptr<Worker>> theWorkers;
+  std::atomic<std::size_t>             theQueued; //!< in any queue
+  std::atomic<std::size_t>             theNextWorker;
+
+  std::mutex               theMutex;
+  std::condition_variable  theTaskAdded;
+  std::condition_variable  theAllDone;
+  std::deque<Task>         theSubmitted;
+  std::size_t              thePending; //!< submitted and not finished
+  std::vector<std::string> theErrors;
+  bool                     theStop;
+
+  std::vector<std::thread> theThreads;
+};
+
+/**
+ * @brief Call a function on sub-ranges of [aBegin, aEnd), possibly in
+ * parallel.
+ *
+ * If called from a task of a TaskScheduler, the sub-ranges are executed by
+ * its workers, otherwise aNumThreads threads are used.
+ *
+ * @param aBegin The first index.
+ * @param aEnd The index after the last one.
+ * @param aNumThreads The number of threads used when not called from a
+ * task: if 0 use the hardware concurrency, if 1 call aBody in this thread.
+ * @param aBody The function called on every sub-range.
+ *
+ * @throw the first exception thrown by aBody.
+ */
+void parallelFor(const std::size_t                   aBegin,
+                 const std::size_t                   aEnd,
+                 const std::size_t                   aNumThreads,
+                 const TaskScheduler::RangeFunction& aBody);
+
+} // namespace qr
+} // namespace uiiit
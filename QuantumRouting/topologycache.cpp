@@ -0,0 +1,263 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/topologycache.h"
+
+#include <boost/filesystem.hpp>
+
+#include <glog/logging.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'Q', 'R', 'T', 'O', 'P', 'O', 0, 0};
+constexpr std::size_t         HEADER_SIZE = MAGIC.size() + 4 * 8;
+
+//! \return the size rounded up to the next multiple of 8.
+std::uint64_t padded(const std::uint64_t aSize) noexcept {
+  return (aSize + 7) / 8 * 8;
+}
+
+//! \return the 64-bit FNV-1a hash of a string.
+std::uint64_t fnv1a(const std::string& aString) noexcept {
+  std::uint64_t ret = 14695981039346656037ull;
+  for (const auto c : aString) {
+    ret ^= static_cast<unsigned char>(c);
+    ret *= 1099511628211ull;
+  }
+  return ret;
+}
+
+template <class T>
+void write(std::ostream& aStream, const T* aData, const std::size_t aSize) {
+  aStream.write(reinterpret_cast<const char*>(aData), sizeof(T) * aSize);
+}
+
+template <class T>
+void read(std::istream& aStream, T* aData, const std::size_t aSize) {
+  aStream.read(reinterpret_cast<char*>(aData), sizeof(T) * aSize);
+}
+
+} // namespace
+
+TopologyCache::TopologyCache()
+    : theDirectory() {
+  // noop
+}
+
+TopologyCache::TopologyCache(const std::string& aDirectory)
+    : theDirectory(aDirectory) {
+  if (enabled()) {
+    boost::system::error_code myError;
+    boost::filesystem::create_directories(theDirectory, myError);
+    if (myError) {
+      throw std::runtime_error("cannot create the topology cache directory " +
+                               theDirectory + ": " + myError.message());
+    }
+  }
+}
+
+bool TopologyCache::load(const std::string& aKey, Topology& aTopology) const {
+  if (not enabled()) {
+    return false;
+  }
+  if (readFile(filename(aKey), aKey, aTopology)) {
+    VLOG(1) << "topology loaded from cache: " << aKey;
+    return true;
+  }
+  VLOG(1) << "topology not found in cache: " << aKey;
+  return false;
+}
+
+void TopologyCache::save(const std::string& aKey,
+                         const Topology&    aTopology) const {
+  if (not enabled()) {
+    return;
+  }
+  writeFile(filename(aKey), aKey, aTopology);
+  VLOG(1) << "topology saved to cache: " << aKey;
+}
+
+std::string TopologyCache::filename(const std::string& aKey) const {
+  std::stringstream ret;
+  ret << theDirectory << "/topo-" << std::hex << std::setw(16)
+      << std::setfill('0') << fnv1a(aKey) << ".bin";
+  return ret.str();
+}
+
+bool TopologyCache::readFile(const std::string& aFilename,
+                             const std::string& aKey,
+                             Topology&          aTopology) {
+  std::ifstream myStream(aFilename, std::ios::binary | std::ios::ate);
+  if (not myStream) {
+    return false;
+  }
+  const auto myFileSize = static_cast<std::uint64_t>(myStream.tellg());
+  myStream.seekg(0);
+
+  const auto myCorrupted = [&aFilename](const std::string& aReason) {
+    return std::runtime_error("corrupted topology cache file " + aFilename +
+                              ": " + aReason);
+  };
+
+  // header
+  std::array<char, MAGIC.size()> myMagic;
+  std::array<std::uint64_t, 4>   myHeader; // version, key, edges, coordinates
+  read(myStream, myMagic.data(), myMagic.size());
+  read(myStream, myHeader.data(), myHeader.size());
+  if (not myStream or myMagic != MAGIC) {
+    throw myCorrupted("invalid header");
+  }
+  if (myHeader[0] != VERSION) {
+    VLOG(1) << "ignoring topology cache file " << aFilename
+            << " with version " << myHeader[0];
+    return false;
+  }
+  const auto myKeySize        = myHeader[1];
+  const auto myNumEdges       = myHeader[2];
+  const auto myNumCoordinates = myHeader[3];
+  const auto myRemainingSize  = myFileSize - HEADER_SIZE;
+  if (myFileSize < HEADER_SIZE or myKeySize > myRemainingSize or
+      myNumEdges > myRemainingSize / 16 or
+      myNumCoordinates > myRemainingSize / 24 or
+      padded(myKeySize) + 16 * myNumEdges + 24 * myNumCoordinates !=
+          myRemainingSize) {
+    throw myCorrupted("invalid size");
+  }
+
+  // key, which may differ in case of hash collisions
+  std::string myKey(padded(myKeySize), '\0');
+  read(myStream, myKey.data(), myKey.size());
+  myKey.resize(myKeySize);
+  if (myKey != aKey) {
+    VLOG(1) << "topology cache file " << aFilename << " has key " << myKey
+            << " instead of " << aKey;
+    return false;
+  }
+
+  // arrays
+  std::vector<std::uint64_t> myEdges(2 * myNumEdges);
+  std::vector<double>        myCoordinates(3 * myNumCoordinates);
+  read(myStream, myEdges.data(), myEdges.size());
+  read(myStream, myCoordinates.data(), myCoordinates.size());
+  if (not myStream) {
+    throw myCorrupted("cannot read the data");
+  }
+
+  aTopology.theEdges.resize(myNumEdges);
+  for (std::size_t i = 0; i < myNumEdges; i++) {
+    aTopology.theEdges[i] = {myEdges[2 * i], myEdges[2 * i + 1]};
+  }
+  aTopology.theCoordinates.resize(myNumCoordinates);
+  for (std::size_t i = 0; i < myNumCoordinates; i++) {
+    aTopology.theCoordinates[i] = {myCoordinates[3 * i],
+                                   myCoordinates[3 * i + 1],
+                                   myCoordinates[3 * i + 2]};
+  }
+  return true;
+}
+
+void TopologyCache::writeFile(const std::string& aFilename,
+                              const std::string& aKey,
+                              const Topology&    aTopology) {
+  std::stringstream myTmpFilename;
+  myTmpFilename << aFilename << ".tmp-" << ::getpid() << '-'
+                << std::this_thread::get_id();
+
+  std::vector<std::uint64_t> myEdges;
+  myEdges.reserve(2 * aTopology.theEdges.size());
+  for (const auto& myEdge : aTopology.theEdges) {
+    myEdges.emplace_back(myEdge.first);
+    myEdges.emplace_back(myEdge.second);
+  }
+  std::vector<double> myCoordinates;
+  myCoordinates.reserve(3 * aTopology.theCoordinates.size());
+  for (const auto& myCoordinate : aTopology.theCoordinates) {
+    myCoordinates.emplace_back(std::get<0>(myCoordinate));
+    myCoordinates.emplace_back(std::get<1>(myCoordinate));
+    myCoordinates.emplace_back(std::get<2>(myCoordinate));
+  }
+  std::string myKey(aKey);
+  myKey.resize(padded(aKey.size()), '\0');
+  const std::array<std::uint64_t, 4> myHeader{VERSION,
+                                              aKey.size(),
+                                              aTopology.theEdges.size(),
+                                              aTopology.theCoordinates.size()};
+
+  {
+    std::ofstream myStream(myTmpFilename.str(),
+                           std::ios::binary | std::ios::trunc);
+    write(myStream, MAGIC.data(), MAGIC.size());
+    write(myStream, myHeader.data(), myHeader.size());
+    write(myStream, myKey.data(), myKey.size());
+    write(myStream, myEdges.data(), myEdges.size());
+    write(myStream, myCoordinates.data(), myCoordinates.size());
+    if (not myStream) {
+      std::remove(myTmpFilename.str().c_str());
+      throw std::runtime_error("cannot write the topology cache file " +
+                               myTmpFilename.str());
+    }
+  }
+
+  if (std::rename(myTmpFilename.str().c_str(), aFilename.c_str()) != 0) {
+    std::remove(myTmpFilename.str().c_str());
+    throw std::runtime_error("cannot rename the topology cache file to " +
+                             aFilename + ": " + std::strerror(errno));
+  }
+}
+
+std::string TopologyCache::key(const std::string&         aGenerator,
+                               const std::size_t          aSeed,
+                               const std::vector<double>& aParameters) {
+  std::stringstream ret;
+  ret << aGenerator << ",seed=" << aSeed << std::setprecision(17);
+  for (const auto myParameter : aParameters) {
+    ret << ',' << myParameter;
+  }
+  return ret.str();
+}
+
+} // namespace qr
+} // namespace uiiit
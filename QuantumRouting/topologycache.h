@@ -0,0 +1,164 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/qrutils.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief On-disk cache of generated network topologies.
+ *
+ * Every topology is saved into a separate file in the cache directory,
+ * identified by a key that must contain the name of the generator and all
+ * its parameters, including the seed.
+ *
+ * The file format is binary, with fixed-size fields in host byte order, all
+ * aligned to 8 bytes, so that the arrays can be read with a single operation
+ * or memory-mapped:
+ * - magic string: 8 bytes, "QRTOPO" padded with zeros;
+ * - format version: 64-bit unsigned integer;
+ * - length of the key, number of edges, number of coordinates: 64-bit
+ *   unsigned integers;
+ * - key: padded with zeros to a multiple of 8 bytes;
+ * - edges: pairs of 64-bit unsigned integers;
+ * - coordinates: triples of 64-bit floating point numbers.
+ *
+ * Files are written to a temporary file first and then renamed, hence
+ * concurrent users of the same directory never see partial files.
+ */
+class TopologyCache final
+{
+ public:
+  using Edges = std::vector<std::pair<unsigned long, unsigned long>>;
+
+  //! The version of the file format.
+  static constexpr std::uint64_t VERSION = 1;
+
+  struct Topology {
+    Edges                   theEdges;
+    std::vector<Coordinate> theCoordinates;
+  };
+
+  //! Create a disabled cache: nothing is ever loaded or saved.
+  TopologyCache();
+
+  /**
+   * @brief Create a cache in the given directory, if not empty.
+   *
+   * @param aDirectory The directory containing the topologies, which is
+   * created if it does not exist. If empty, the cache is disabled.
+   * @throw std::runtime_error if the directory cannot be created.
+   */
+  explicit TopologyCache(const std::string& aDirectory);
+
+  //! \return true if the cache is enabled.
+  bool enabled() const noexcept {
+    return not theDirectory.empty();
+  }
+
+  /**
+   * @brief Load a topology from the cache.
+   *
+   * @param aKey The key of the topology.
+   * @param aTopology The topology loaded, only changed if found.
+   * @return true if the topology was found, false if the cache is disabled,
+   * there is no file with the given key, or the file has been saved with
+   * another version of the format.
+   * @throw std::runtime_error if the file is corrupted.
+   */
+  bool load(const std::string& aKey, Topology& aTopology) const;
+
+  /**
+   * @brief Save a topology into the cache, if enabled.
+   *
+   * @param aKey The key of the topology.
+   * @param aTopology The topology to be saved.
+   * @throw std::runtime_error if the file cannot be written.
+   */
+  void save(const std::string& aKey, const Topology& aTopology) const;
+
+  //! \return the name of the file where a topology is saved.
+  std::string filename(const std::string& aKey) const;
+
+  /**
+   * @brief Read a topology from a file in the cache format.
+   *
+   * @param aFilename The name of the file.
+   * @param aKey The key expected in the file.
+   * @param aTopology The topology read, only changed if found.
+   * @return true if the topology was found, false if the file does not
+   * exist, has another key, or has been saved with another version of the
+   * format.
+   * @throw std::runtime_error if the file is corrupted.
+   */
+  static bool readFile(const std::string& aFilename,
+                       const std::string& aKey,
+                       Topology&          aTopology);
+
+  /**
+   * @brief Write a topology to a file in the cache format.
+   *
+   * @param aFilename The name of the file, which is replaced atomically.
+   * @param aKey The key of the topology.
+   * @param aTopology The topology to be saved.
+   * @throw std::runtime_error if the file cannot be written.
+   */
+  static void writeFile(const std::string& aFilename,
+                        const std::string& aKey,
+                        const Topology&    aTopology);
+
+  /**
+   * @brief Make the key of a topology.
+   *
+   * @param aGenerator The name of the generator.
+   * @param aSeed The seed of the generator.
+   * @param aParameters All the other parameters, printed without loss of
+   * precision.
+   * @return the key.
+   */
+  static std::string key(const std::string&         aGenerator,
+                         const std::size_t          aSeed,
+                         const std::vector<double>& aParameters);
+
+ private:
+  const std::string theDirectory;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Merge the CSV outputs of the shards of an experiment campaign.
+
+The shards are run with the same options, except --shard i/n and --output,
+e.g., on different hosts. The merged output contains one row per seed, in
+increasing order of seed, and it is checked that the seeds in the shards cover
+the full range [seed-start, seed-end) exactly once.
+
+Since the result of a run only depends on its seed and parameters, the merged
+output is the same as that of a single-host run, apart from the order of the
+rows and the last columns, which report the duration of the run and, if
+collected, the time spent in each phase: this can be checked by passing the
+output of a single-host run with --reference, with --ignore-last set to the
+number of such columns.
+"""
+
+import argparse
+import sys
+
+
+def read_rows(filenames):
+    """Return the rows of the CSV files, as (seed, fields, filename)."""
+    rows = []
+    for filename in filenames:
+        with open(filename, "r") as infile:
+            for lineno, line in enumerate(infile, start=1):
+                line = line.rstrip("\n")
+                if not line:
+                    continue
+                fields = line.split(",")
+                try:
+                    seed = int(fields[0])
+                except ValueError:
+                    raise RuntimeError(f"{filename}:{lineno}: invalid seed '{fields[0]}'")
+                rows.append((seed, fields, f"{filename}:{lineno}"))
+    return rows
+
+
+def ranges(seeds):
+    """Return a compact representation of a sorted list of seeds."""
+    ret = []
+    for seed in seeds:
+        if ret and ret[-1][1] == seed - 1:
+            ret[-1][1] = seed
+        else:
+            ret.append([seed, seed])
+    return ",".join(str(a) if a == b else f"{a}-{b}" for a, b in ret)
+
+
+def merge(rows, seed_start, seed_end):
+    """Return the rows sorted by seed, after checking the coverage."""
+    errors = []
+    by_seed = {}
+    num_fields = None
+    for seed, fields, where in rows:
+        if num_fields is None:
+            num_fields = len(fields)
+        elif len(fields) != num_fields:
+            errors.append(f"{where}: {len(fields)} columns instead of {num_fields}")
+        if seed < seed_start or seed >= seed_end:
+            errors.append(f"{where}: seed {seed} out of [{seed_start}, {seed_end})")
+        elif seed in by_seed:
+            errors.append(f"{where}: seed {seed} already in {by_seed[seed][1]}")
+        else:
+            by_seed[seed] = (fields, where)
+
+    missing = [seed for seed in range(seed_start, seed_end) if seed not in by_seed]
+    if missing:
+        errors.append(f"missing seeds: {ranges(missing)}")
+
+    if errors:
+        raise RuntimeError("\n".join(errors))
+
+    return [by_seed[seed][0] for seed in sorted(by_seed)]
+
+
+def compare(merged, reference, ignore_last):
+    """Check that the rows are the same, except the last ignore_last columns."""
+    expected = {seed: fields for seed, fields, _ in reference}
+    errors = []
+    if len(expected) != len(merged) or len(reference) != len(merged):
+        errors.append(
+            f"{len(merged)} rows merged vs. {len(reference)} in the reference"
+        )
+    for fields in merged:
+        seed = int(fields[0])
+        if seed not in expected:
+            errors.append(f"seed {seed} not in the reference")
+        elif expected[seed][:-ignore_last] != fields[:-ignore_last]:
+            errors.append(f"seed {seed} has different results from the reference")
+    if errors:
+        raise RuntimeError("\n".join(errors))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Merge the CSV outputs of the shards of a campaign",
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+    )
+    parser.add_argument("--seed-start", type=int, default=0, help="First seed used")
+    parser.add_argument(
+        "--seed-end", type=int, default=1, help="Next seed after the last one used"
+    )
+    parser.add_argument(
+        "--output", type=str, default="", help="Output file name, stdout if empty"
+    )
+    parser.add_argument(
+        "--reference",
+        type=str,
+        default="",
+        help="Output of a single-host run to be compared with, if not empty",
+    )
+    parser.add_argument(
+        "--ignore-last",
+        type=int,
+        default=1,
+        help="Number of last columns, depending on the host, not compared",
+    )
+    parser.add_argument("shards", type=str, nargs="+", help="Output files of the shards")
+    args = parser.parse_args()
+
+    try:
+        if args.ignore_last < 1:
+            raise RuntimeError("--ignore-last must be at least 1")
+        merged = merge(read_rows(args.shards), args.seed_start, args.seed_end)
+        if args.reference:
+            compare(merged, read_rows([args.reference]), args.ignore_last)
+
+        outfile = open(args.output, "w") if args.output else sys.stdout
+        for fields in merged:
+            outfile.write(",".join(fields) + "\n")
+        if args.output:
+            outfile.close()
+
+    except (OSError, RuntimeError) as err:
+        print(err, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,120 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/aliassampler.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestAliasSampler : public ::testing::Test {};
+
+TEST_F(TestAliasSampler, test_invalid) {
+  ASSERT_THROW(AliasSampler(std::vector<double>()), std::runtime_error);
+  ASSERT_THROW(AliasSampler({0, 0, 0}), std::runtime_error);
+  ASSERT_THROW(AliasSampler({1, -1, 2}), std::runtime_error);
+
+  support::UniformRv myRv(0, 1, 42, 0, 0);
+  AliasSampler       mySampler({1, 0, 1, 0});
+  ASSERT_EQ(4, mySampler.size());
+  ASSERT_EQ(2, mySampler.sample(2, myRv).size());
+  ASSERT_THROW(mySampler.sample(3, myRv), std::runtime_error);
+}
+
+TEST_F(TestAliasSampler, test_deterministic) {
+  // the tables are: column 0 is taken with probability 2/3, otherwise its
+  // alias 1 is taken; column 1 is always taken
+  support::DeterministicRv<std::vector<double>> myRv(
+      std::vector<double>({0.1, 0.4, 0.25, 0.9, 0.3, 0.999}));
+  AliasSampler             mySampler({1, 2});
+  std::vector<std::size_t> myIndices;
+  for (std::size_t i = 0; i < 6; i++) {
+    myIndices.emplace_back(mySampler(myRv));
+  }
+  ASSERT_EQ(std::vector<std::size_t>({0, 1, 0, 1, 0, 1}), myIndices);
+}
+
+TEST_F(TestAliasSampler, test_distribution) {
+  const std::vector<double> myWeights({3, 0, 1, 4, 2, 0.5, 0, 9.5});
+  AliasSampler              mySampler(myWeights);
+  support::UniformRv        myRv(0, 1, 42, 0, 0);
+
+  const std::size_t   N = 200000;
+  std::vector<double> myCounts(myWeights.size(), 0);
+  for (std::size_t i = 0; i < N; i++) {
+    myCounts[mySampler(myRv)]++;
+  }
+  for (std::size_t i = 0; i < myWeights.size(); i++) {
+    ASSERT_NEAR(myWeights[i] / 20, myCounts[i] / N, 0.005) << "index " << i;
+  }
+}
+
+TEST_F(TestAliasSampler, test_sample_without_replacement) {
+  const std::vector<double> myWeights({1, 2, 0, 7});
+  AliasSampler              mySampler(myWeights);
+  support::UniformRv        myRv(0, 1, 42, 0, 0);
+
+  // the second index is drawn with probability proportional to the weights
+  // of the indices left
+  const std::size_t                N = 200000;
+  std::vector<std::vector<double>> myCounts(4, std::vector<double>(4, 0));
+  for (std::size_t i = 0; i < N; i++) {
+    const auto mySample = mySampler.sample(2, myRv);
+    ASSERT_EQ(2, mySample.size());
+    ASSERT_NE(mySample[0], mySample[1]);
+    myCounts[mySample[0]][mySample[1]]++;
+  }
+  for (std::size_t i = 0; i < 4; i++) {
+    for (std::size_t j = 0; j < 4; j++) {
+      const auto myExpected =
+          i == j ? 0.0 :
+                   myWeights[i] / 10 * myWeights[j] / (10 - myWeights[i]);
+      ASSERT_NEAR(myExpected, myCounts[i][j] / N, 0.005)
+          << "indices " << i << ", " << j;
+    }
+  }
+
+  // all the weights left are drawn, in any order
+  AliasSampler mySkewedSampler({1e-30, 1, 1e-30});
+  for (std::size_t i = 0; i < 100; i++) {
+    auto mySample = mySkewedSampler.sample(3, myRv);
+    std::sort(mySample.begin(), mySample.end());
+    ASSERT_EQ(std::vector<std::size_t>({0, 1, 2}), mySample);
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
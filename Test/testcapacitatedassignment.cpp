@@ -0,0 +1,184 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitatedassignment.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestCapacitatedAssignment : public ::testing::Test {
+  using Profits = std::vector<std::vector<double>>;
+
+  //! \return the max total profit found by exhaustive search.
+  static double bruteForce(const Profits&                  aProfits,
+                           const std::vector<std::size_t>& aCapacities) {
+    auto                                     myLoads = aCapacities;
+    std::function<double(const std::size_t)> myVisit =
+        [&](const std::size_t r) -> double {
+      if (r == aProfits.size()) {
+        return 0;
+      }
+      auto ret = myVisit(r + 1); // row not assigned
+      for (std::size_t c = 0; c < aCapacities.size(); c++) {
+        if (aProfits[r][c] > 0 and myLoads[c] > 0) {
+          myLoads[c]--;
+          ret = std::max(ret, aProfits[r][c] + myVisit(r + 1));
+          myLoads[c]++;
+        }
+      }
+      return ret;
+    };
+    return myVisit(0);
+  }
+};
+
+TEST_F(TestCapacitatedAssignment, test_invalid) {
+  ASSERT_THROW(CapacitatedAssignment(Profits({{1, 2}, {1}}), {1, 1}),
+               std::runtime_error);
+  ASSERT_THROW(CapacitatedAssignment(Profits({{1, -2}}), {1, 1}),
+               std::runtime_error);
+  ASSERT_NO_THROW(CapacitatedAssignment(Profits(), {1, 1}));
+}
+
+TEST_F(TestCapacitatedAssignment, test_example) {
+  // the second row must go to the second column to maximize the profit
+  CapacitatedAssignment mySolver(Profits({{4, 3}, {4, 1}, {0, 0}}), {1, 2});
+  ASSERT_EQ(3, mySolver.numRows());
+  ASSERT_EQ(2, mySolver.numColumns());
+
+  ASSERT_EQ(std::vector<long>({1, 0, CapacitatedAssignment::UNASSIGNED}),
+            mySolver.next());
+  ASSERT_EQ(0, mySolver.capacity(0));
+  ASSERT_EQ(1, mySolver.capacity(1));
+
+  // only the second column is left, and the first row already has it
+  ASSERT_EQ(std::vector<long>({CapacitatedAssignment::UNASSIGNED,
+                               1,
+                               CapacitatedAssignment::UNASSIGNED}),
+            mySolver.next());
+  ASSERT_EQ(0, mySolver.capacity(1));
+
+  ASSERT_EQ(std::vector<long>(3, CapacitatedAssignment::UNASSIGNED),
+            mySolver.next());
+}
+
+TEST_F(TestCapacitatedAssignment, test_random_same_as_brute_force) {
+  support::UniformRv myRv(0, 1, 42, 0, 0);
+  for (std::size_t myRun = 0; myRun < 200; myRun++) {
+    const std::size_t R = 1 + 6 * myRv();
+    const std::size_t C = 1 + 3 * myRv();
+    Profits           myProfits(R, std::vector<double>(C, 0));
+    for (auto& myRow : myProfits) {
+      for (auto& myProfit : myRow) {
+        // some pairs are not allowed and some profits are the same
+        myProfit = myRv() < 0.2 ? 0 : static_cast<int>(1 + 10 * myRv());
+      }
+    }
+    std::vector<std::size_t> myCapacities(C);
+    for (auto& myCapacity : myCapacities) {
+      myCapacity = 3 * myRv();
+    }
+
+    // check all the iterations, each against the residual problem
+    CapacitatedAssignment mySolver(myProfits, myCapacities);
+    for (std::size_t myIteration = 0; myIteration < 3; myIteration++) {
+      const auto myExpected = bruteForce(myProfits, myCapacities);
+      const auto myAssignment = mySolver.next();
+      ASSERT_EQ(R, myAssignment.size());
+      double myProfit = 0;
+      for (std::size_t r = 0; r < R; r++) {
+        if (myAssignment[r] != CapacitatedAssignment::UNASSIGNED) {
+          const auto c = myAssignment[r];
+          ASSERT_LT(c, C);
+          ASSERT_GT(myProfits[r][c], 0);
+          ASSERT_GT(myCapacities[c], 0);
+          myProfit += myProfits[r][c];
+          myProfits[r][c] = 0;
+          myCapacities[c]--;
+        }
+      }
+      ASSERT_FLOAT_EQ(myExpected, myProfit)
+          << "run " << myRun << ", iteration " << myIteration;
+      for (std::size_t c = 0; c < C; c++) {
+        ASSERT_EQ(myCapacities[c], mySolver.capacity(c));
+      }
+    }
+  }
+}
+
+TEST_F(TestCapacitatedAssignment, test_random_real_profits) {
+  // the reduced costs may be slightly negative because of round-off, which
+  // must remain within the tolerance with profits of any magnitude
+  support::UniformRv myRv(0, 1, 42, 0, 0);
+  for (const double myScale : {1e-6, 1.0, 1e6}) {
+    for (std::size_t myRun = 0; myRun < 100; myRun++) {
+      const std::size_t R = 1 + 7 * myRv();
+      const std::size_t C = 1 + 3 * myRv();
+      Profits           myProfits(R, std::vector<double>(C, 0));
+      for (auto& myRow : myProfits) {
+        for (auto& myProfit : myRow) {
+          myProfit = myRv() < 0.2 ? 0 : myScale * myRv();
+        }
+      }
+      std::vector<std::size_t> myCapacities(C);
+      for (auto& myCapacity : myCapacities) {
+        myCapacity = 3 * myRv();
+      }
+
+      CapacitatedAssignment mySolver(myProfits, myCapacities);
+      for (std::size_t myIteration = 0; myIteration < 3; myIteration++) {
+        const auto myExpected   = bruteForce(myProfits, myCapacities);
+        const auto myAssignment = mySolver.next();
+        double     myProfit     = 0;
+        for (std::size_t r = 0; r < R; r++) {
+          if (myAssignment[r] != CapacitatedAssignment::UNASSIGNED) {
+            const auto c = myAssignment[r];
+            myProfit += myProfits[r][c];
+            myProfits[r][c] = 0;
+            myCapacities[c]--;
+          }
+        }
+        ASSERT_NEAR(myExpected, myProfit, 1e-9 * myScale)
+            << "scale " << myScale << ", run " << myRun << ", iteration "
+            << myIteration;
+      }
+    }
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
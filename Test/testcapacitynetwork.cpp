@@ -38,10 +38,13 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <ctime>
+#include <map>
 #include <optional>
 #include <set>
 #include <stdexcept>
+#include <tuple>
 
 namespace uiiit {
 namespace qr {
@@ -98,6 +101,13 @@ struct TestCapacityNetwork : public ::testing::Test {
     });
   }
 
+  static CapacityNetwork::WeightVector
+  sortedWeights(const CapacityNetwork& aNetwork) {
+    auto ret = aNetwork.weights();
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
   using Vec = std::vector<unsigned long>;
   using Set = std::set<unsigned long>;
   Set vecToSet(const Vec& aVec) {
@@ -198,6 +208,69 @@ TEST_F(TestCapacityNetwork, test_reachable_nodes) {
   }
 }
 
+TEST_F(TestCapacityNetwork, test_reachable_nodes_compact) {
+  // random network with more than 64 nodes, to have multiple batches
+  const std::size_t             V = 150;
+  support::UniformRv            myEdgeRv(0, 1, 42, 0, 0);
+  CapacityNetwork::WeightVector myWeights;
+  for (std::size_t i = 0; i < V; i++) {
+    for (std::size_t j = 0; j < V; j++) {
+      if (i != j and myEdgeRv() < 0.01) {
+        myWeights.emplace_back(i, j, 1);
+      }
+    }
+  }
+  myWeights.emplace_back(V - 1, 0, 1);
+  CapacityNetwork myNetwork(myWeights);
+  ASSERT_EQ(V, myNetwork.numNodes());
+
+  // find all the distances with constrained shortest paths
+  std::set<unsigned long> myAllNodes;
+  for (std::size_t i = 0; i < V; i++) {
+    myAllNodes.emplace(i);
+  }
+  std::vector<std::vector<std::size_t>> myDistances(V);
+  std::size_t                           myExpectedDiameter = 0;
+  for (std::size_t i = 0; i < V; i++) {
+    for (const auto& elem : myNetwork.cspf(i, 0, myAllNodes)) {
+      myDistances[i].emplace_back(elem.second.size());
+      myExpectedDiameter = std::max(myExpectedDiameter, elem.second.size());
+    }
+  }
+
+  for (const auto& myRange : std::vector<std::pair<std::size_t, std::size_t>>(
+           {{0, 99}, {1, 1}, {2, 4}, {3, 99}, {99, 99}})) {
+    std::size_t myDiameter  = 0;
+    const auto  myReachable = myNetwork.reachableNodesCompact(
+        myRange.first, myRange.second, myDiameter);
+    ASSERT_EQ(myExpectedDiameter, myDiameter);
+    ASSERT_EQ(V, myReachable.numNodes());
+    for (std::size_t i = 0; i < V; i++) {
+      for (std::size_t j = 0; j < V; j++) {
+        const auto d = myDistances[i][j];
+        ASSERT_EQ(d > 0 and d >= myRange.first and d <= myRange.second,
+                  myReachable.reachable(i, j))
+            << i << "->" << j << " at distance " << d;
+      }
+    }
+
+    // same results with multiple threads and the map-based API
+    for (const auto myNumThreads : {0, 2, 3}) {
+      ASSERT_EQ(myReachable,
+                myNetwork.reachableNodesCompact(
+                    myRange.first, myRange.second, myDiameter, myNumThreads));
+      ASSERT_EQ(myExpectedDiameter, myDiameter);
+    }
+    ASSERT_EQ(myReachable.toMap(),
+              myNetwork.reachableNodes(
+                  myRange.first, myRange.second, myDiameter));
+  }
+
+  std::size_t myDiameter = 0;
+  ASSERT_THROW(myNetwork.reachableNodesCompact(3, 2, myDiameter),
+               std::runtime_error);
+}
+
 TEST_F(TestCapacityNetwork, test_closest_nodes) {
   support::UniformRv myRv(0, 1, 42, 0, 0);
   CapacityNetwork    myNetwork(exampleEdgeWeights());
@@ -320,6 +393,55 @@ TEST_F(TestCapacityNetwork, test_make_capacity_network_waxman) {
   }
 }
 
+TEST_F(TestCapacityNetwork, test_make_capacity_network_waxman_parallel) {
+  const std::size_t       myNodes       = 50;
+  const double            myMaxDistance = 100;
+  const auto              myCapacity    = [myMaxDistance](const double d) {
+    return 100e3 * std::exp(-d / myMaxDistance);
+  };
+  std::vector<Coordinate> myCoordinates;
+  const auto myNetwork = makeCapacityNetworkWaxmanParallel<CapacityNetwork>(
+      myCapacity, 42, myNodes, myMaxDistance, 0.5, 0.5, myCoordinates, 1);
+
+  ASSERT_EQ(myNodes, myNetwork->numNodes());
+  ASSERT_EQ(myNodes, myCoordinates.size());
+  ASSERT_GT(myNetwork->numEdges(), 0);
+  ASSERT_EQ(0, myNetwork->numEdges() % 2);
+  ASSERT_GT(myNetwork->totalCapacity(), 0);
+  ASSERT_LT(myNetwork->totalCapacity() / myNetwork->numEdges(), 100e3);
+
+  // the edges are bidirectional, with the same capacity in both directions
+  const auto myWeights = myNetwork->weights();
+  std::map<std::pair<unsigned long, unsigned long>, double> myEdges;
+  for (const auto& [mySrc, myDst, myWeight] : myWeights) {
+    ASSERT_TRUE(myEdges.emplace(std::make_pair(mySrc, myDst), myWeight).second);
+    ASSERT_FLOAT_EQ(
+        myCapacity(distance(myCoordinates[mySrc], myCoordinates[myDst])),
+        myWeight);
+  }
+  for (const auto& [mySrc, myDst, myWeight] : myWeights) {
+    const auto it = myEdges.find({myDst, mySrc});
+    ASSERT_TRUE(it != myEdges.end());
+    ASSERT_EQ(myWeight, it->second);
+  }
+
+  // the network does not depend on the number of threads
+  for (const std::size_t myNumThreads : {0, 4}) {
+    std::vector<Coordinate> myOtherCoordinates;
+    const auto              myOther =
+        makeCapacityNetworkWaxmanParallel<CapacityNetwork>(myCapacity,
+                                                           42,
+                                                           myNodes,
+                                                           myMaxDistance,
+                                                           0.5,
+                                                           0.5,
+                                                           myOtherCoordinates,
+                                                           myNumThreads);
+    ASSERT_EQ(myWeights, myOther->weights());
+    ASSERT_EQ(myCoordinates, myOtherCoordinates);
+  }
+}
+
 TEST_F(TestCapacityNetwork, test_cspf) {
   CapacityNetwork         myNetwork(exampleEdgeWeights());
   std::set<unsigned long> myDestinations({3, 4});
@@ -335,6 +457,37 @@ TEST_F(TestCapacityNetwork, test_cspf) {
   myDestinations = std::set<unsigned long>({0, 1, 2, 4});
   ASSERT_EQ(CspfRes({{0, {}}, {1, {}}, {2, {}}, {4, {}}}),
             myNetwork.cspf(3, 0, myDestinations));
+
+  // limit on the number of hops
+  myDestinations = std::set<unsigned long>({3, 4});
+  ASSERT_EQ(CspfRes({{3, {}}, {4, {4}}}),
+            myNetwork.cspf(0, 0, myDestinations, 1));
+  ASSERT_EQ(CspfRes({{3, {}}, {4, {}}}),
+            myNetwork.cspf(0, 2, myDestinations, 2));
+  ASSERT_EQ(CspfRes({{3, {1, 2, 3}}, {4, {}}}),
+            myNetwork.cspf(0, 2, myDestinations, 3));
+  ASSERT_EQ(CspfRes({{3, {}}, {4, {}}}),
+            myNetwork.cspf(0, 0, myDestinations, 0));
+}
+
+TEST_F(TestCapacityNetwork, test_cspf_scratch) {
+  CapacityNetwork         myNetwork(exampleEdgeWeights());
+  std::set<unsigned long> myDestinations({3, 4});
+  using CspfRes = std::map<unsigned long, std::vector<unsigned long>>;
+
+  CsrGraph::Scratch myScratch;
+  CspfRes           myPaths;
+  for (const auto myCapacity : {0.0, 1.0, 2.0, 99.0}) {
+    myNetwork.cspf(0, myCapacity, myDestinations, myScratch, myPaths);
+    ASSERT_EQ(myNetwork.cspf(0, myCapacity, myDestinations), myPaths);
+  }
+
+  // change the destinations
+  myDestinations = std::set<unsigned long>({0, 1, 2, 4});
+  myNetwork.cspf(3, 0, myDestinations, myScratch, myPaths);
+  ASSERT_EQ(CspfRes({{0, {}}, {1, {}}, {2, {}}, {4, {}}}), myPaths);
+  myNetwork.cspf(0, 0, myDestinations, myScratch, myPaths);
+  ASSERT_EQ(CspfRes({{0, {}}, {1, {1}}, {2, {1, 2}}, {4, {4}}}), myPaths);
 }
 
 TEST_F(TestCapacityNetwork, test_remove_capacity_from_path) {
@@ -344,56 +497,213 @@ TEST_F(TestCapacityNetwork, test_remove_capacity_from_path) {
   ASSERT_EQ(Set({1, 2, 3, 4}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
 
   // cannot remove that much capacity from 0->1
-  ASSERT_THROW(CapacityNetwork::removeCapacityFromPath(
-                   0, Vec({1}), 99.0, std::nullopt, myNetwork.theGraph),
-               std::runtime_error);
+  ASSERT_THROW(
+      myNetwork.removeCapacityFromPath(0, Vec({1}), 99.0, std::nullopt),
+      std::runtime_error);
 
   // edge does not exist
-  ASSERT_THROW(CapacityNetwork::removeCapacityFromPath(
-                   0, Vec({2}), 1.0, std::nullopt, myNetwork.theGraph),
+  ASSERT_THROW(myNetwork.removeCapacityFromPath(0, Vec({2}), 1.0, std::nullopt),
                std::runtime_error);
 
   // node does not exist
-  ASSERT_THROW(CapacityNetwork::removeCapacityFromPath(
-                   99, Vec({1}), 1.0, std::nullopt, myNetwork.theGraph),
-               std::runtime_error);
-  ASSERT_THROW(CapacityNetwork::removeCapacityFromPath(
-                   0, Vec({99}), 1.0, std::nullopt, myNetwork.theGraph),
-               std::runtime_error);
-  ASSERT_THROW(CapacityNetwork::removeCapacityFromPath(
-                   0, Vec({1, 99}), 1.0, std::nullopt, myNetwork.theGraph),
-               std::runtime_error);
+  ASSERT_THROW(
+      myNetwork.removeCapacityFromPath(99, Vec({1}), 1.0, std::nullopt),
+      std::runtime_error);
+  ASSERT_THROW(
+      myNetwork.removeCapacityFromPath(0, Vec({99}), 1.0, std::nullopt),
+      std::runtime_error);
+  ASSERT_THROW(
+      myNetwork.removeCapacityFromPath(0, Vec({1, 99}), 1.0, std::nullopt),
+      std::runtime_error);
 
   // remove completely the capacity from 0->1, but leave the edge
-  CapacityNetwork::removeCapacityFromPath(
-      0, Vec({1}), 4.0, std::nullopt, myNetwork.theGraph);
+  myNetwork.removeCapacityFromPath(0, Vec({1}), 4.0, std::nullopt);
   ASSERT_FLOAT_EQ(13.0, myNetwork.totalCapacity());
   ASSERT_EQ(Set({1, 2, 3, 4}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
 
   // add some capacity to 0->1
-  CapacityNetwork::removeCapacityFromPath(
-      0, Vec({1}), -1.0, std::nullopt, myNetwork.theGraph);
+  myNetwork.removeCapacityFromPath(0, Vec({1}), -1.0, std::nullopt);
   ASSERT_FLOAT_EQ(14.0, myNetwork.totalCapacity());
 
   // remove completely the capacity from 0->1 and prune the edge, too
-  CapacityNetwork::removeCapacityFromPath(
-      0, Vec({1}), 1.0, 0.1, myNetwork.theGraph);
+  myNetwork.removeCapacityFromPath(0, Vec({1}), 1.0, 0.1);
   ASSERT_FLOAT_EQ(13.0, myNetwork.totalCapacity());
   ASSERT_EQ(Set({3, 4}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
 
   // remove capacity from 1->4->3 and prune the edges, as needed
-  CapacityNetwork::removeCapacityFromPath(
-      0, Vec({4, 3}), 1.0, 0.1, myNetwork.theGraph);
+  myNetwork.removeCapacityFromPath(0, Vec({4, 3}), 1.0, 0.1);
   ASSERT_FLOAT_EQ(11.0, myNetwork.totalCapacity());
   ASSERT_EQ(Set({}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
 
   // remove all edges, the graph is now empty
-  CapacityNetwork::removeCapacityFromPath(
-      4, Vec({3}), 0.0, 99, myNetwork.theGraph);
-  CapacityNetwork::removeCapacityFromPath(
-      1, Vec({2, 3}), 0.0, 99, myNetwork.theGraph);
+  myNetwork.removeCapacityFromPath(4, Vec({3}), 0.0, 99);
+  myNetwork.removeCapacityFromPath(1, Vec({2, 3}), 0.0, 99);
   ASSERT_FLOAT_EQ(0.0, myNetwork.totalCapacity());
   ASSERT_EQ(0, myNetwork.numEdges());
+  ASSERT_EQ(std::vector<double>(5, 0), myNetwork.nodeCapacities());
+}
+
+TEST_F(TestCapacityNetwork, test_add_capacity_after_prune) {
+  std::size_t     myDiameter;
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  ASSERT_EQ(5, myNetwork.numEdges());
+
+  // prune 0->4 with a residual capacity of 0.25
+  myNetwork.removeCapacityFromPath(0, Vec({4}), 0.75, 0.5);
+  ASSERT_EQ(4, myNetwork.numEdges());
+  ASSERT_FLOAT_EQ(16.0, myNetwork.totalCapacity());
+  ASSERT_EQ(Set({1, 2, 3}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
+
+  // the residual capacity is positive but still below the prune threshold
+  myNetwork.addCapacityToPath(0, Vec({4}), 0.125);
+  ASSERT_EQ(4, myNetwork.numEdges());
+  ASSERT_FLOAT_EQ(16.0, myNetwork.totalCapacity());
+  ASSERT_EQ(Set({1, 2, 3}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
+
+  // the residual capacity reaches the prune threshold
+  myNetwork.addCapacityToPath(0, Vec({4}), 0.125);
+  ASSERT_EQ(5, myNetwork.numEdges());
+  ASSERT_FLOAT_EQ(16.5, myNetwork.totalCapacity());
+  ASSERT_EQ(Set({1, 2, 3, 4}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
+
+  // the snapshot restores the prune threshold, too
+  myNetwork.removeCapacityFromPath(0, Vec({4}), 0.25, 0.5);
+  ASSERT_EQ(4, myNetwork.numEdges());
+  const auto mySnapshot = myNetwork.snapshot();
+  myNetwork.addCapacityToPath(0, Vec({4}), 0.25);
+  ASSERT_EQ(5, myNetwork.numEdges());
+  myNetwork.restore(mySnapshot);
+  ASSERT_EQ(4, myNetwork.numEdges());
+  myNetwork.addCapacityToPath(0, Vec({4}), 0.125);
+  ASSERT_EQ(4, myNetwork.numEdges());
+  ASSERT_FLOAT_EQ(16.0, myNetwork.totalCapacity());
+}
+
+TEST_F(TestCapacityNetwork, test_aggregate_capacities) {
+  const std::size_t             V = 50;
+  support::UniformRv            myRv(0, 1, 42, 0, 0);
+  CapacityNetwork::WeightVector myWeights;
+  for (std::size_t i = 0; i < V; i++) {
+    for (std::size_t j = 0; j < V; j++) {
+      if (i != j and myRv() < 0.1) {
+        myWeights.emplace_back(i, j, 1 + myRv() * 100);
+      }
+    }
+  }
+  CapacityNetwork myNetwork(myWeights);
+
+  // the aggregates must match those computed from scratch from the weights
+  const auto myCheck = [&myNetwork]() {
+    std::vector<double> myNodeCapacities(myNetwork.numNodes(), 0);
+    double              myTotalCapacity = 0;
+    for (const auto& elem : myNetwork.weights()) {
+      myNodeCapacities[std::get<0>(elem)] += std::get<2>(elem);
+      myTotalCapacity += std::get<2>(elem);
+    }
+    ASSERT_NEAR(myTotalCapacity, myNetwork.totalCapacity(), 1e-6);
+    ASSERT_EQ(myNodeCapacities.size(), myNetwork.nodeCapacities().size());
+    for (std::size_t i = 0; i < myNodeCapacities.size(); i++) {
+      ASSERT_NEAR(myNodeCapacities[i], myNetwork.nodeCapacities()[i], 1e-6);
+    }
+  };
+  myCheck();
+
+  // remove and add back capacity on random edges, which are pruned if their
+  // residual capacity becomes small
+  for (std::size_t i = 0; i < 10000; i++) {
+    const auto myEdges = myNetwork.weights();
+    if (myEdges.empty()) {
+      break;
+    }
+    const auto& myEdge =
+        myEdges[std::min<std::size_t>(myEdges.size() - 1,
+                                      myRv() * myEdges.size())];
+    const auto  myCapacity = std::get<2>(myEdge) * (myRv() - 0.3);
+    myNetwork.removeCapacityFromPath(
+        std::get<0>(myEdge), Vec({std::get<1>(myEdge)}), myCapacity, 0.5);
+    if (i % 100 == 0) {
+      myCheck();
+    }
+  }
+  myCheck();
+}
+
+TEST_F(TestCapacityNetwork, test_snapshot) {
+  std::size_t     myDiameter;
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  const auto      myWeights  = sortedWeights(myNetwork);
+  const auto      myVersion  = myNetwork.topologyVersion();
+  const auto      mySnapshot = myNetwork.snapshot();
+
+  // restoring an untouched network does not change anything
+  myNetwork.restore(mySnapshot);
+  ASSERT_EQ(myWeights, sortedWeights(myNetwork));
+  ASSERT_EQ(myVersion, myNetwork.topologyVersion());
+
+  for (auto i = 0; i < 3; i++) {
+    // remove capacity from 0->1->2 and prune 0->4->3
+    myNetwork.removeCapacityFromPath(0, Vec({1, 2}), 1.0, std::nullopt);
+    myNetwork.removeCapacityFromPath(0, Vec({4, 3}), 1.0, 0.5);
+    ASSERT_FLOAT_EQ(13.0, myNetwork.totalCapacity());
+    ASSERT_EQ(4, myNetwork.numEdges());
+    ASSERT_NE(myVersion, myNetwork.topologyVersion());
+    ASSERT_EQ(Set({1, 2, 3}), myNetwork.reachableNodes(0, 99, myDiameter)[0]);
+
+    // the pruned edge is added back
+    myNetwork.restore(mySnapshot);
+    ASSERT_EQ(myWeights, sortedWeights(myNetwork));
+    ASSERT_EQ(myVersion, myNetwork.topologyVersion());
+    ASSERT_FLOAT_EQ(17.0, myNetwork.totalCapacity());
+    ASSERT_EQ(std::vector<double>({5, 4, 4, 0, 4}), myNetwork.nodeCapacities());
+    ASSERT_EQ(5, myNetwork.numEdges());
+    ASSERT_EQ(Set({1, 2, 3, 4}),
+              myNetwork.reachableNodes(0, 99, myDiameter)[0]);
+    ASSERT_EQ(1.0, myNetwork.minCapacity(0, Vec({4, 3})));
+  }
+
+  // a snapshot can be taken after some edges have been removed, too
+  myNetwork.removeCapacityFromPath(2, Vec({3}), 4.0, 0.5);
+  const auto myOtherWeights  = sortedWeights(myNetwork);
+  const auto myOtherSnapshot = myNetwork.snapshot();
+  myNetwork.restore(mySnapshot);
+  ASSERT_EQ(myWeights, sortedWeights(myNetwork));
+  myNetwork.restore(myOtherSnapshot);
+  ASSERT_EQ(myOtherWeights, sortedWeights(myNetwork));
+  ASSERT_FLOAT_EQ(13.0, myNetwork.totalCapacity());
+
+  // snapshots cannot be restored into a different network
+  CapacityNetwork myAnotherNetwork(anotherExampleEdgeWeights());
+  ASSERT_THROW(myAnotherNetwork.restore(mySnapshot), std::runtime_error);
+}
+
+TEST_F(TestCapacityNetwork, test_edge_ranks) {
+  // the edges of a node are added by decreasing target, with a parallel one
+  const CapacityNetwork::WeightVector myWeights({
+      {0, 3, 1},
+      {0, 2, 1},
+      {0, 1, 1},
+      {1, 3, 1},
+      {2, 3, 2},
+      {2, 3, 1},
+  });
+  CapacityNetwork myNetwork(myWeights);
+  const auto&     myCsr   = myNetwork.theCsr;
+  const auto&     myRanks = myNetwork.theRanks;
+  ASSERT_EQ(myWeights.size(), myRanks.size());
+  ASSERT_EQ(std::set<std::size_t>({0, 1, 2, 3, 4, 5}),
+            std::set<std::size_t>(myRanks.begin(), myRanks.end()));
+
+  // the ranks follow the source, then the target, then the CSR identifier,
+  // and they do not depend on where the edges are in the memory
+  for (CsrGraph::EdgeId e = 0; e < myRanks.size(); e++) {
+    for (CsrGraph::EdgeId f = 0; f < myRanks.size(); f++) {
+      ASSERT_EQ(std::make_tuple(myCsr.source(e), myCsr.target(e), e) <
+                    std::make_tuple(myCsr.source(f), myCsr.target(f), f),
+                myRanks[e] < myRanks[f])
+          << e << ' ' << f;
+    }
+  }
+  ASSERT_EQ(myRanks, CapacityNetwork(myWeights).theRanks);
 }
 
 } // namespace qr
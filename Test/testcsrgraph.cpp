@@ -0,0 +1,438 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/csrgraph.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/property_map/property_map.hpp>
+
+#include <glog/logging.h>
+
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestCsrGraph : public ::testing::Test {
+  using Graph =
+      boost::adjacency_list<boost::listS,
+                            boost::vecS,
+                            boost::bidirectionalS,
+                            boost::no_property,
+                            boost::property<boost::edge_weight_t, double>>;
+
+  //   /--> 1 -- >2 -+
+  //  /              v
+  // 0               3   all weights are 4, except 0->4 which is 1
+  //  \              ^
+  //   \---> 4 ------+
+  CsrGraph::WeightVector exampleEdgeWeights() {
+    return CsrGraph::WeightVector({
+        {0, 1, 4},
+        {0, 4, 1},
+        {1, 2, 4},
+        {2, 3, 4},
+        {4, 3, 4},
+    });
+  }
+
+  // random graph with many paths of the same length between any two nodes,
+  // with edges sorted by source node and random capacities in [0,1]
+  CsrGraph::WeightVector randomEdgeWeights(const std::size_t aNodes,
+                                           const double      aProb,
+                                           const std::size_t aSeed) {
+    CsrGraph::WeightVector ret;
+    support::UniformRv     myEdgeRv(0, 1, aSeed, 0, 0);
+    support::UniformRv     myCapacityRv(0, 1, aSeed, 1, 0);
+    for (std::size_t i = 0; i < aNodes; i++) {
+      for (std::size_t j = 0; j < aNodes; j++) {
+        if (i != j and myEdgeRv() < aProb) {
+          ret.emplace_back(i, j, myCapacityRv());
+        }
+      }
+    }
+    return ret;
+  }
+};
+
+TEST_F(TestCsrGraph, test_ctor) {
+  CsrGraph myEmpty;
+  ASSERT_EQ(0, myEmpty.numVertices());
+  ASSERT_EQ(0, myEmpty.numEdges());
+
+  const auto myEdges = exampleEdgeWeights();
+  CsrGraph   myGraph(6, myEdges);
+  ASSERT_EQ(6, myGraph.numVertices());
+  ASSERT_EQ(5, myGraph.numEdges());
+
+  using Range = std::pair<CsrGraph::EdgeId, CsrGraph::EdgeId>;
+  EXPECT_EQ(Range(0, 2), myGraph.outEdges(0));
+  EXPECT_EQ(Range(2, 3), myGraph.outEdges(1));
+  EXPECT_EQ(Range(3, 4), myGraph.outEdges(2));
+  EXPECT_EQ(Range(4, 4), myGraph.outEdges(3));
+  EXPECT_EQ(Range(4, 5), myGraph.outEdges(4));
+  EXPECT_EQ(Range(5, 5), myGraph.outEdges(5));
+
+  for (CsrGraph::EdgeId e = 0; e < myGraph.numEdges(); e++) {
+    const auto& myEdge = myEdges[e];
+    EXPECT_EQ(std::get<0>(myEdge), myGraph.source(e));
+    EXPECT_EQ(std::get<1>(myEdge), myGraph.target(e));
+    EXPECT_EQ(std::get<2>(myEdge), myGraph.capacity(e));
+    EXPECT_TRUE(myGraph.enabled(e));
+  }
+
+  // edges not sorted by source
+  ASSERT_THROW(CsrGraph(5, CsrGraph::WeightVector({{1, 0, 1}, {0, 1, 1}})),
+               std::runtime_error);
+
+  // non-existing vertices
+  ASSERT_THROW(CsrGraph(2, CsrGraph::WeightVector({{0, 2, 1}})),
+               std::runtime_error);
+  ASSERT_THROW(CsrGraph(2, CsrGraph::WeightVector({{2, 0, 1}})),
+               std::runtime_error);
+}
+
+TEST_F(TestCsrGraph, test_find_edge) {
+  CsrGraph myGraph(3,
+                   CsrGraph::WeightVector({
+                       {0, 1, 1},
+                       {0, 2, 2},
+                       {0, 1, 3},
+                       {2, 0, 4},
+                   }));
+
+  using Found = std::pair<CsrGraph::EdgeId, bool>;
+  EXPECT_EQ(Found(0, true), myGraph.findEdge(0, 1));
+  EXPECT_EQ(Found(1, true), myGraph.findEdge(0, 2));
+  EXPECT_EQ(Found(3, true), myGraph.findEdge(2, 0));
+  EXPECT_FALSE(myGraph.findEdge(1, 0).second);
+  EXPECT_FALSE(myGraph.findEdge(0, 0).second);
+
+  // disabling the first edge makes the parallel one visible
+  myGraph.disable(0);
+  EXPECT_FALSE(myGraph.enabled(0));
+  EXPECT_EQ(Found(2, true), myGraph.findEdge(0, 1));
+  myGraph.disable(2);
+  EXPECT_FALSE(myGraph.findEdge(0, 1).second);
+
+  // enabling an edge again makes it visible
+  myGraph.enable(2);
+  EXPECT_TRUE(myGraph.enabled(2));
+  EXPECT_EQ(Found(2, true), myGraph.findEdge(0, 1));
+
+  // capacities can be changed
+  myGraph.capacity(1, 42);
+  EXPECT_EQ(42, myGraph.capacity(1));
+}
+
+TEST_F(TestCsrGraph, test_hop_distances) {
+  CsrGraph                 myGraph(6, exampleEdgeWeights());
+  std::vector<std::size_t> myDistances;
+  const auto               INF = CsrGraph::INFINITE_DISTANCE;
+
+  myGraph.hopDistances(0, myDistances);
+  EXPECT_EQ(std::vector<std::size_t>({0, 1, 2, 2, 1, INF}), myDistances);
+
+  myGraph.hopDistances(3, myDistances);
+  EXPECT_EQ(std::vector<std::size_t>({INF, INF, INF, 0, INF, INF}),
+            myDistances);
+
+  // remove 0->4
+  myGraph.disable(1);
+  myGraph.hopDistances(0, myDistances);
+  EXPECT_EQ(std::vector<std::size_t>({0, 1, 2, 3, INF, INF}), myDistances);
+}
+
+TEST_F(TestCsrGraph, test_shortest_path_tree) {
+  CsrGraph                 myGraph(6, exampleEdgeWeights());
+  std::vector<std::size_t> myPredecessors;
+
+  myGraph.shortestPathTree(0, 0, myPredecessors);
+  EXPECT_EQ(std::vector<std::size_t>({0, 0, 1, 4, 0, 5}), myPredecessors);
+
+  myGraph.shortestPathTree(0, 2, myPredecessors);
+  EXPECT_EQ(std::vector<std::size_t>({0, 0, 1, 2, 4, 5}), myPredecessors);
+
+  myGraph.disable(0);
+  myGraph.shortestPathTree(0, 0, myPredecessors);
+  EXPECT_EQ(std::vector<std::size_t>({0, 1, 2, 4, 0, 5}), myPredecessors);
+}
+
+TEST_F(TestCsrGraph, test_shortest_path_tree_same_as_dijkstra) {
+  const std::size_t V = 50;
+  for (std::size_t mySeed = 0; mySeed < 10; mySeed++) {
+    const auto myEdges = randomEdgeWeights(V, 0.1, mySeed);
+    CsrGraph   myCsr(V, myEdges);
+
+    for (const auto myMinCapacity : {0.0, 0.25, 0.5}) {
+      // reference graph with only the edges with enough capacity
+      Graph myGraph(V);
+      for (const auto& myEdge : myEdges) {
+        if (std::get<2>(myEdge) >= myMinCapacity) {
+          boost::add_edge(std::get<0>(myEdge), std::get<1>(myEdge), myGraph);
+        }
+      }
+
+      for (std::size_t mySource = 0; mySource < V; mySource++) {
+        std::vector<std::size_t> myExpected(V);
+        boost::dijkstra_shortest_paths(
+            myGraph,
+            mySource,
+            boost::predecessor_map(myExpected.data())
+                .weight_map(
+                    boost::make_static_property_map<Graph::edge_descriptor>(
+                        1)));
+
+        std::vector<std::size_t> myActual;
+        myCsr.shortestPathTree(mySource, myMinCapacity, myActual);
+        ASSERT_EQ(myExpected, myActual)
+            << "seed " << mySeed << ", min capacity " << myMinCapacity
+            << ", source " << mySource;
+      }
+    }
+  }
+}
+
+TEST_F(TestCsrGraph, test_shortest_path_tree_early_termination) {
+  const std::size_t V = 50;
+  CsrGraph::Scratch myScratch;
+  for (std::size_t mySeed = 0; mySeed < 10; mySeed++) {
+    // use a different number of vertices to test scratch reuse
+    const auto myNumVertices = V + mySeed % 2;
+    const auto myEdges       = randomEdgeWeights(myNumVertices, 0.1, mySeed);
+    CsrGraph   myCsr(myNumVertices, myEdges);
+
+    support::UniformIntRv<unsigned long> myDestRv(
+        0, myNumVertices - 1, mySeed, 0, 0);
+    for (const auto myMinCapacity : {0.0, 0.25, 0.5}) {
+      for (std::size_t mySource = 0; mySource < myNumVertices; mySource++) {
+        std::set<unsigned long> myDestinations;
+        for (std::size_t i = 0; i < 3; i++) {
+          myDestinations.emplace(myDestRv());
+        }
+
+        std::vector<std::size_t> myExpected;
+        myCsr.shortestPathTree(mySource, myMinCapacity, myExpected);
+        myCsr.shortestPathTree(
+            mySource, myMinCapacity, myDestinations, myScratch);
+        const auto& myActual = myScratch.thePredecessors;
+        ASSERT_EQ(myNumVertices, myActual.size());
+
+        // all the vertices along the paths must have the same predecessors
+        for (const auto myDestination : myDestinations) {
+          for (auto v = myDestination; v != mySource; v = myExpected[v]) {
+            ASSERT_EQ(myExpected[v], myActual[v])
+                << "seed " << mySeed << ", min capacity " << myMinCapacity
+                << ", source " << mySource << ", destination "
+                << myDestination;
+            if (myExpected[v] == v) {
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TestCsrGraph, test_shortest_path_tree_max_hops) {
+  const std::size_t V = 50;
+  CsrGraph::Scratch myScratch;
+  for (std::size_t mySeed = 0; mySeed < 10; mySeed++) {
+    const auto myEdges = randomEdgeWeights(V, 0.1, mySeed);
+    CsrGraph   myCsr(V, myEdges);
+
+    std::set<unsigned long> myAll;
+    for (std::size_t v = 0; v < V; v++) {
+      myAll.emplace(v);
+    }
+
+    for (const auto myMinCapacity : {0.0, 0.5}) {
+      for (std::size_t mySource = 0; mySource < V; mySource++) {
+        std::vector<std::size_t> myExpected;
+        myCsr.shortestPathTree(mySource, myMinCapacity, myExpected);
+        std::vector<std::size_t> myDistances(V, CsrGraph::INFINITE_DISTANCE);
+        myDistances[mySource] = 0;
+        for (std::size_t v = 0; v < V; v++) {
+          std::size_t myLength = 0;
+          auto        u        = v;
+          for (; u != mySource and myExpected[u] != u; u = myExpected[u]) {
+            myLength++;
+          }
+          if (u == mySource) {
+            myDistances[v] = myLength;
+          }
+        }
+
+        // only the vertices within the limit are discovered, with the same
+        // predecessors as in the unbounded search
+        for (const std::size_t myMaxHops : {0, 1, 2, 3}) {
+          myCsr.shortestPathTree(
+              mySource, myMinCapacity, myAll, myScratch, myMaxHops);
+          const auto& myActual = myScratch.thePredecessors;
+          for (std::size_t v = 0; v < V; v++) {
+            ASSERT_EQ(myDistances[v] <= myMaxHops ? myExpected[v] : v,
+                      myActual[v])
+                << "seed " << mySeed << ", min capacity " << myMinCapacity
+                << ", source " << mySource << ", max hops " << myMaxHops
+                << ", vertex " << v;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TestCsrGraph, test_shortest_feasible_path) {
+  CsrGraph                   myGraph(6, exampleEdgeWeights());
+  CsrGraph::LayeredScratch   myScratch;
+  std::vector<unsigned long> myPath;
+  using Path = std::vector<unsigned long>;
+
+  const auto find = [&](const std::size_t aSrc,
+                        const std::size_t aDst,
+                        const auto&       aMinCapacity,
+                        const std::size_t aMaxHops =
+                            CsrGraph::INFINITE_DISTANCE) {
+    return myGraph.shortestFeasiblePath(
+        aSrc, aDst, aMinCapacity, myScratch, myPath, aMaxHops);
+  };
+
+  // constant requirement
+  const auto myConstant = [](const double aValue) {
+    return [aValue](const std::size_t) { return aValue; };
+  };
+  ASSERT_TRUE(find(0, 3, myConstant(1)));
+  ASSERT_EQ(Path({4, 3}), myPath);
+  ASSERT_TRUE(find(0, 3, myConstant(2)));
+  ASSERT_EQ(Path({1, 2, 3}), myPath);
+  ASSERT_FALSE(find(0, 3, myConstant(5)));
+  ASSERT_TRUE(myPath.empty());
+  ASSERT_FALSE(find(3, 0, myConstant(0)));
+  ASSERT_FALSE(find(0, 5, myConstant(0)));
+
+  // limit on the number of hops
+  ASSERT_FALSE(find(0, 3, myConstant(1), 1));
+  ASSERT_TRUE(myPath.empty());
+  ASSERT_TRUE(find(0, 3, myConstant(1), 2));
+  ASSERT_EQ(Path({4, 3}), myPath);
+  ASSERT_FALSE(find(0, 3, myConstant(2), 2));
+  ASSERT_TRUE(find(0, 3, myConstant(2), 3));
+  ASSERT_EQ(Path({1, 2, 3}), myPath);
+  ASSERT_FALSE(find(0, 3, myConstant(0), 0));
+
+  // requirement increasing with the number of hops
+  const auto myLinear = [](const double aValue) {
+    return [aValue](const std::size_t aHops) { return aValue * aHops; };
+  };
+  ASSERT_TRUE(find(0, 3, myLinear(0.5)));
+  ASSERT_EQ(Path({4, 3}), myPath);
+  ASSERT_TRUE(find(0, 3, myLinear(1)));
+  ASSERT_EQ(Path({1, 2, 3}), myPath);
+  ASSERT_FALSE(find(0, 3, myLinear(1.5)));
+
+  // disabled edges are not used
+  myGraph.disable(2);
+  ASSERT_FALSE(find(0, 3, myLinear(1)));
+}
+
+TEST_F(TestCsrGraph, test_shortest_feasible_path_random) {
+  const std::size_t        V = 50;
+  CsrGraph::LayeredScratch myScratch;
+  for (std::size_t mySeed = 0; mySeed < 10; mySeed++) {
+    const auto myEdges = randomEdgeWeights(V, 0.1, mySeed);
+    CsrGraph   myGraph(V, myEdges);
+
+    for (const auto myFactor : {1.0, 1.1, 1.5}) {
+      const auto myMinCapacity = [myFactor](const std::size_t aHops) {
+        return 0.1 * std::pow(myFactor, aHops - 1);
+      };
+
+      for (std::size_t mySource = 0; mySource < V; mySource++) {
+        for (std::size_t myTarget = 0; myTarget < V; myTarget++) {
+          if (mySource == myTarget) {
+            continue;
+          }
+
+          // brute force: the shortest feasible path has length h iff h is
+          // the smallest value such that the shortest path with minimum
+          // capacity aMinCapacity(h) has length h
+          std::size_t              myExpected = 0;
+          std::vector<std::size_t> myPredecessors;
+          for (std::size_t h = 1; h < V and myExpected == 0; h++) {
+            myGraph.shortestPathTree(
+                mySource, myMinCapacity(h), myPredecessors);
+            std::size_t myLength = 0;
+            for (auto v = myTarget; v != mySource and myPredecessors[v] != v;
+                 v      = myPredecessors[v]) {
+              myLength++;
+            }
+            if (myPredecessors[myTarget] != myTarget and myLength <= h) {
+              myExpected = h;
+            }
+          }
+
+          std::vector<unsigned long> myPath;
+          const auto                 myFound = myGraph.shortestFeasiblePath(
+              mySource, myTarget, myMinCapacity, myScratch, myPath);
+          ASSERT_EQ(myExpected > 0, myFound);
+          ASSERT_EQ(myExpected, myPath.size());
+          if (not myFound) {
+            continue;
+          }
+
+          // check that the path is feasible
+          ASSERT_EQ(myTarget, myPath.back());
+          auto mySrc = mySource;
+          for (const auto myDst : myPath) {
+            const auto myEdge = myGraph.findEdge(mySrc, myDst);
+            ASSERT_TRUE(myEdge.second);
+            ASSERT_GE(myGraph.capacity(myEdge.first),
+                      myMinCapacity(myPath.size()));
+            mySrc = myDst;
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
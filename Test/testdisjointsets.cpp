@@ -0,0 +1,105 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/disjointsets.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <set>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestDisjointSets : public ::testing::Test {};
+
+TEST_F(TestDisjointSets, test_merge) {
+  DisjointSets mySets(6);
+  ASSERT_EQ(6, mySets.numSets());
+  for (std::size_t i = 0; i < 6; i++) {
+    ASSERT_EQ(i, mySets.find(i));
+  }
+
+  ASSERT_TRUE(mySets.merge(0, 1));
+  ASSERT_TRUE(mySets.merge(2, 3));
+  ASSERT_TRUE(mySets.merge(3, 1));
+  ASSERT_FALSE(mySets.merge(0, 2));
+  ASSERT_FALSE(mySets.merge(4, 4));
+  ASSERT_EQ(3, mySets.numSets());
+
+  EXPECT_EQ(mySets.find(0), mySets.find(3));
+  EXPECT_EQ(mySets.find(1), mySets.find(2));
+  EXPECT_NE(mySets.find(0), mySets.find(4));
+  EXPECT_NE(mySets.find(0), mySets.find(5));
+  EXPECT_NE(mySets.find(4), mySets.find(5));
+}
+
+TEST_F(TestDisjointSets, test_random_merges) {
+  // compare with the sets found by merging explicitly the sets of elements
+  const std::size_t                    N = 100;
+  support::UniformIntRv<unsigned long> myRv(0, N - 1, 42, 0, 0);
+  DisjointSets                         mySets(N);
+  std::vector<std::set<std::size_t>*>  myExpected(N);
+  std::vector<std::set<std::size_t>>   myStorage(N);
+  for (std::size_t i = 0; i < N; i++) {
+    myStorage[i].insert(i);
+    myExpected[i] = &myStorage[i];
+  }
+  auto myNumSets = N;
+  for (std::size_t k = 0; k < 80; k++) {
+    const auto myLhs    = myRv();
+    const auto myRhs    = myRv();
+    const auto myMerged = myExpected[myLhs] != myExpected[myRhs];
+    if (myMerged) {
+      auto myOld = myExpected[myRhs];
+      myExpected[myLhs]->insert(myOld->begin(), myOld->end());
+      for (const auto myElem : *myOld) {
+        myExpected[myElem] = myExpected[myLhs];
+      }
+      myOld->clear();
+      myNumSets--;
+    }
+    ASSERT_EQ(myMerged, mySets.merge(myLhs, myRhs));
+    ASSERT_EQ(myNumSets, mySets.numSets());
+  }
+
+  for (std::size_t i = 0; i < N; i++) {
+    for (std::size_t j = 0; j < N; j++) {
+      ASSERT_EQ(myExpected[i] == myExpected[j],
+                mySets.find(i) == mySets.find(j))
+          << i << ", " << j;
+    }
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
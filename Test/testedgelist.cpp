@@ -0,0 +1,147 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/edgelist.h"
+#include "QuantumRouting/networkfactory.h"
+#include "Support/random.h"
+
+#include "Details/examplenetwork.h"
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestEdgeList : public ::testing::Test {
+  TestEdgeList()
+      : theFilename(
+            (boost::filesystem::current_path() / "removeme.edges").string()) {
+    // noop
+  }
+
+  void TearDown() override {
+    boost::filesystem::remove(theFilename);
+  }
+
+  void write(const std::string& aContent) const {
+    std::ofstream(theFilename) << aContent;
+  }
+
+  const std::string theFilename;
+};
+
+TEST_F(TestEdgeList, test_load_save) {
+  using W = CapacityNetwork::WeightVector;
+
+  write("# comment\n"
+        "0 1 1.5\n"
+        "\n"
+        "1,0,1.5\r\n"
+        "  1\t2   1e3 \n"
+        "2 1 0.1");
+  const W myExpected({{0, 1, 1.5}, {1, 0, 1.5}, {1, 2, 1e3}, {2, 1, 0.1}});
+  ASSERT_EQ(myExpected, loadEdgeList(theFilename));
+
+  saveEdgeList(theFilename, myExpected);
+  ASSERT_EQ(myExpected, loadEdgeList(theFilename));
+
+  write("");
+  ASSERT_EQ(W(), loadEdgeList(theFilename));
+
+  for (const auto& myInvalid : std::vector<std::string>({
+           "0 1\n",
+           "0 1 x\n",
+           "0 -1 2\n",
+           "0 1 2 3\n",
+           "0 1 2x\n",
+           "99999999999999999999999 1 2\n",
+       })) {
+    write("0 1 2\n" + myInvalid);
+    ASSERT_THROW(loadEdgeList(theFilename), std::runtime_error) << myInvalid;
+  }
+
+  boost::filesystem::remove(theFilename);
+  ASSERT_THROW(loadEdgeList(theFilename), std::runtime_error);
+}
+
+TEST_F(TestEdgeList, test_make_network) {
+  // save and reload a network
+  support::UniformRv      myRv(1, 10, 42, 0, 0);
+  std::vector<Coordinate> myCoordinates;
+  const auto              myNetwork = makeCapacityNetworkPpp<CapacityNetwork>(
+      myRv, 42, 30, 60, 20, 0.9, myCoordinates);
+
+  saveEdgeList(theFilename, myNetwork->weights());
+  const auto myLoaded =
+      makeCapacityNetworkEdgeList<CapacityNetwork>(theFilename);
+  ASSERT_EQ(myNetwork->weights(), myLoaded->weights());
+
+  // disconnected network
+  write("0 1 1\n1 0 1\n2 3 1\n3 2 1\n");
+  ASSERT_THROW(makeCapacityNetworkEdgeList<CapacityNetwork>(theFilename),
+               std::runtime_error);
+}
+
+TEST_F(TestEdgeList, test_convert_graphml) {
+  std::stringstream myGraphMl;
+  myGraphMl << exampleNetwork();
+  convertGraphMl(myGraphMl, theFilename);
+
+  std::stringstream myOriginal;
+  myOriginal << exampleNetwork();
+  std::vector<Coordinate> myExpectedCoordinates;
+  const auto myExpectedLinks = findLinks(myOriginal, myExpectedCoordinates);
+
+  std::vector<Coordinate> myCoordinates;
+  ASSERT_EQ(myExpectedLinks, loadConvertedGraphMl(theFilename, myCoordinates));
+  ASSERT_EQ(myExpectedCoordinates, myCoordinates);
+
+  support::UniformRv myRv(1, 10, 42, 0, 0);
+  const auto         myNetwork = makeCapacityNetworkGraphMl<CapacityNetwork>(
+      myRv, theFilename, myCoordinates);
+  support::UniformRv myExpectedRv(1, 10, 42, 0, 0);
+  CapacityNetwork    myExpected(myExpectedLinks, myExpectedRv, true);
+  ASSERT_EQ(myExpected.weights(), myNetwork->weights());
+
+  ASSERT_THROW(
+      loadConvertedGraphMl(theFilename + ".notexisting", myCoordinates),
+      std::runtime_error);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -30,6 +30,7 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/esnetwork.h"
+#include "QuantumRouting/taskscheduler.h"
 #include "Support/random.h"
 #include "Support/tostring.h"
 
@@ -37,9 +38,11 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <ctime>
 #include <set>
 #include <stdexcept>
+#include <thread>
 
 #define ROUTE_DRR(q, k)                                                        \
   myNetwork.route(myApps, AppRouteAlgo::Drr, q, myRouteRv, k)
@@ -78,6 +81,15 @@ TEST_F(TestEsNetwork, test_app_route_algo) {
   ASSERT_THROW(appRouteAlgofromString("not-existing-algo"), std::runtime_error);
 }
 
+TEST_F(TestEsNetwork, test_flow_route_algo) {
+  for (const auto& myAlgo : allFlowRouteAlgos()) {
+    ASSERT_EQ(myAlgo, flowRouteAlgofromString(toString(myAlgo)));
+  }
+  ASSERT_EQ("unknown", toString(static_cast<FlowRouteAlgo>(999)));
+  ASSERT_THROW(flowRouteAlgofromString("not-existing-algo"),
+               std::runtime_error);
+}
+
 TEST_F(TestEsNetwork, test_measurement_probability) {
   EsNetwork myNetwork(exampleEdgeWeights());
   ASSERT_FLOAT_EQ(1, myNetwork.measurementProbability());
@@ -202,6 +214,80 @@ TEST_F(TestEsNetwork, test_route_flows) {
   ASSERT_THROW(myNetwork.route(myFlows), std::runtime_error);
 }
 
+TEST_F(TestEsNetwork, test_admissible) {
+  using Flows = std::vector<EsNetwork::FlowDescriptor>;
+  const Flows myFlows({
+      {0, 3, 1.0},
+      {0, 3, 2.0},
+      {1, 3, 3.0},
+      {0, 2, 5.0},
+      {3, 0, 1.0},
+  });
+
+  for (const auto myAlgo :
+       {FlowRouteAlgo::Iterative, FlowRouteAlgo::Layered}) {
+    // the flows are admitted or not as if they were the only ones routed
+    std::vector<Flows> myExpected;
+    for (const auto& myFlow : myFlows) {
+      EsNetwork myNetwork(exampleEdgeWeights());
+      myExpected.emplace_back(Flows({myFlow}));
+      myNetwork.route(myExpected.back(), myAlgo);
+    }
+
+    // concurrent queries on the same network
+    EsNetwork                myNetwork(exampleEdgeWeights());
+    std::vector<std::thread> myThreads;
+    std::vector<char>        myMatch(4, false);
+    for (std::size_t t = 0; t < myMatch.size(); t++) {
+      myThreads.emplace_back([&, t]() {
+        EsNetwork::QueryScratch myScratch;
+        auto                    myGood = true;
+        for (auto i = 0; i < 100; i++) {
+          for (std::size_t j = 0; j < myFlows.size(); j++) {
+            auto        myFlow = myFlows[j];
+            const auto& myOther = myExpected[j][0];
+            const auto  myAdmitted =
+                myNetwork.admissible(myFlow, myAlgo, myScratch);
+            myGood = myGood and myAdmitted == not myOther.thePath.empty() and
+                     myFlow.thePath == myOther.thePath and
+                     myFlow.theGrossRate == myOther.theGrossRate;
+          }
+        }
+        myMatch[t] = myGood;
+      });
+    }
+    for (auto& myThread : myThreads) {
+      myThread.join();
+    }
+    ASSERT_EQ(std::vector<char>(myMatch.size(), true), myMatch);
+    ASSERT_FLOAT_EQ(17, myNetwork.totalCapacity());
+
+    // commit the first two flows, then the first one does not fit anymore on
+    // its previous path
+    EsNetwork::QueryScratch myScratch;
+    Flows                   myAdmitted({myFlows[0], myFlows[1]});
+    ASSERT_TRUE(myNetwork.admissible(myAdmitted[0], myAlgo, myScratch));
+    ASSERT_TRUE(myNetwork.admissible(myAdmitted[1], myAlgo, myScratch));
+    myNetwork.commit(myAdmitted);
+    ASSERT_FLOAT_EQ(17 - 2 - 6, myNetwork.totalCapacity());
+    auto myFlow = myFlows[0];
+    ASSERT_TRUE(myNetwork.admissible(myFlow, myAlgo, myScratch));
+    ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlow.thePath);
+
+    // the same flows cannot be committed twice, nor a non-existing path
+    ASSERT_THROW(myNetwork.commit(myAdmitted), std::runtime_error);
+    myAdmitted[1].thePath = {2, 3};
+    ASSERT_THROW(myNetwork.commit(myAdmitted), std::runtime_error);
+    ASSERT_FLOAT_EQ(17 - 2 - 6, myNetwork.totalCapacity());
+
+    // flows not admitted are ignored
+    Flows myRejected({myFlows[4]});
+    ASSERT_FALSE(myNetwork.admissible(myRejected[0], myAlgo, myScratch));
+    myNetwork.commit(myRejected);
+    ASSERT_FLOAT_EQ(17 - 2 - 6, myNetwork.totalCapacity());
+  }
+}
+
 TEST_F(TestEsNetwork, test_add_capacity_to_edge) {
   EsNetwork myNetwork(exampleEdgeWeights());
   myNetwork.measurementProbability(0.5);
@@ -267,6 +353,230 @@ TEST_F(TestEsNetwork, test_route_flows_another) {
   ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
 }
 
+TEST_F(TestEsNetwork, test_route_flows_layered) {
+  EsNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+
+  // no route existing and then a unfeasible and a feasible route
+  std::vector<EsNetwork::FlowDescriptor> myFlows({
+      {3, 0, 1.0},
+      {0, 3, 1.0},
+  });
+  myNetwork.route(myFlows, FlowRouteAlgo::Layered);
+  ASSERT_EQ(2, myFlows.size());
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+  ASSERT_EQ(1, myFlows[0].theDijsktra);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[1].thePath);
+  ASSERT_FLOAT_EQ(4, myFlows[1].theGrossRate);
+  ASSERT_EQ(1, myFlows[1].theDijsktra);
+
+  // request with smaller capacity, but cannot be admitted due to constraint
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myNetwork.route(myFlows, FlowRouteAlgo::Layered, [](const auto& aFlow) {
+    return aFlow.thePath.size() == 1;
+  });
+  ASSERT_EQ(1, myFlows.size());
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+
+  // same request without constrating can be admitted
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myNetwork.route(myFlows, FlowRouteAlgo::Layered);
+  ASSERT_EQ(1, myFlows.size());
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(1, myFlows[0].theGrossRate);
+  ASSERT_EQ(EsNetwork::WeightVector({
+                {0, 1, 0},
+                {1, 2, 0},
+                {2, 3, 0},
+                {0, 4, 0},
+                {4, 3, 3},
+            }),
+            myNetwork.weights());
+
+  ASSERT_THROW(myNetwork.route(myFlows, static_cast<FlowRouteAlgo>(999)),
+               std::runtime_error);
+}
+
+TEST_F(TestEsNetwork, test_route_flows_algos_same_admission) {
+  const std::size_t V = 30;
+  for (std::size_t mySeed = 0; mySeed < 5; mySeed++) {
+    // random graph with random capacities, which includes a ring so that
+    // all the nodes are connected
+    support::UniformRv      myEdgeRv(0, 1, mySeed, 0, 0);
+    support::UniformRv      myCapacityRv(1, 10, mySeed, 1, 0);
+    EsNetwork::WeightVector myWeights;
+    for (std::size_t i = 0; i < V; i++) {
+      for (std::size_t j = 0; j < V; j++) {
+        if (i != j and (myEdgeRv() < 0.1 or j == (i + 1) % V)) {
+          myWeights.emplace_back(i, j, myCapacityRv());
+        }
+      }
+    }
+
+    // each flow is routed on a fresh network
+    support::UniformIntRv<unsigned long> myNodeRv(0, V - 1, mySeed, 2, 0);
+    support::UniformRv                   myRateRv(1, 10, mySeed, 3, 0);
+    for (std::size_t i = 0; i < 100; i++) {
+      const auto mySrc = myNodeRv();
+      const auto myDst = myNodeRv();
+      if (mySrc == myDst) {
+        continue;
+      }
+      const auto myRate     = myRateRv();
+      const auto myMaxHops  = 1 + i % 5;
+      const auto myCheckFun = [myMaxHops](const auto& aFlow) {
+        return aFlow.thePath.size() <= myMaxHops;
+      };
+
+      using Flows = std::vector<EsNetwork::FlowDescriptor>;
+      Flows     myIterative({{mySrc, myDst, myRate}});
+      Flows     myLayered({{mySrc, myDst, myRate}});
+      EsNetwork myIterativeNetwork(myWeights);
+      EsNetwork myLayeredNetwork(myWeights);
+      myIterativeNetwork.measurementProbability(0.9);
+      myLayeredNetwork.measurementProbability(0.9);
+      myIterativeNetwork.route(
+          myIterative, FlowRouteAlgo::Iterative, myCheckFun);
+      myLayeredNetwork.route(myLayered, FlowRouteAlgo::Layered, myCheckFun);
+
+      ASSERT_EQ(myIterative[0].thePath.size(), myLayered[0].thePath.size())
+          << "seed " << mySeed << ", flow " << myIterative[0].toString();
+      ASSERT_FLOAT_EQ(myIterative[0].theGrossRate, myLayered[0].theGrossRate);
+      ASSERT_FLOAT_EQ(myIterativeNetwork.totalCapacity(),
+                      myLayeredNetwork.totalCapacity());
+    }
+  }
+}
+
+TEST_F(TestEsNetwork, test_route_flows_max_hops) {
+  const std::size_t V = 30;
+  for (std::size_t mySeed = 0; mySeed < 5; mySeed++) {
+    support::UniformRv      myEdgeRv(0, 1, mySeed, 0, 0);
+    support::UniformRv      myCapacityRv(1, 10, mySeed, 1, 0);
+    EsNetwork::WeightVector myWeights;
+    for (std::size_t i = 0; i < V; i++) {
+      for (std::size_t j = 0; j < V; j++) {
+        if (i != j and (myEdgeRv() < 0.1 or j == (i + 1) % V)) {
+          myWeights.emplace_back(i, j, myCapacityRv());
+        }
+      }
+    }
+
+    // the same flows are routed with a check function rejecting the paths
+    // that are too long and with a hop limit: the decisions are the same
+    support::UniformIntRv<unsigned long> myNodeRv(0, V - 1, mySeed, 2, 0);
+    support::UniformRv                   myRateRv(1, 10, mySeed, 3, 0);
+    using Flows = std::vector<EsNetwork::FlowDescriptor>;
+    for (const auto myAlgo : allFlowRouteAlgos()) {
+      for (const std::size_t myMaxHops : {0, 1, 3, 5}) {
+        const auto myCheckFun = [myMaxHops](const auto& aFlow) {
+          return aFlow.thePath.size() <= myMaxHops;
+        };
+        Flows myChecked;
+        for (std::size_t i = 0; i < 100; i++) {
+          const auto mySrc = myNodeRv();
+          const auto myDst = myNodeRv();
+          if (mySrc != myDst) {
+            myChecked.emplace_back(mySrc, myDst, myRateRv());
+          }
+        }
+        Flows     myLimited(myChecked);
+        EsNetwork myCheckedNetwork(myWeights);
+        EsNetwork myLimitedNetwork(myWeights);
+        myCheckedNetwork.measurementProbability(0.9);
+        myLimitedNetwork.measurementProbability(0.9);
+        myCheckedNetwork.route(myChecked, myAlgo, myCheckFun);
+        myLimitedNetwork.route(
+            myLimited, myAlgo, [](const auto&) { return true; }, myMaxHops);
+
+        ASSERT_EQ(myChecked.size(), myLimited.size());
+        for (std::size_t i = 0; i < myChecked.size(); i++) {
+          ASSERT_EQ(myChecked[i].thePath, myLimited[i].thePath)
+              << "seed " << mySeed << ", algo " << toString(myAlgo)
+              << ", max hops " << myMaxHops << ", flow "
+              << myChecked[i].toString();
+          ASSERT_EQ(myChecked[i].theDijsktra, myLimited[i].theDijsktra);
+          ASSERT_LE(myLimited[i].thePath.size(), myMaxHops);
+        }
+        ASSERT_FLOAT_EQ(myCheckedNetwork.totalCapacity(),
+                        myLimitedNetwork.totalCapacity());
+      }
+    }
+  }
+}
+
+TEST_F(TestEsNetwork, test_route_flows_batch) {
+  const std::size_t V = 30;
+  for (std::size_t mySeed = 0; mySeed < 5; mySeed++) {
+    support::UniformRv      myEdgeRv(0, 1, mySeed, 0, 0);
+    support::UniformRv      myCapacityRv(1, 10, mySeed, 1, 0);
+    EsNetwork::WeightVector myWeights;
+    for (std::size_t i = 0; i < V; i++) {
+      for (std::size_t j = 0; j < V; j++) {
+        if (i != j and (myEdgeRv() < 0.1 or j == (i + 1) % V)) {
+          myWeights.emplace_back(i, j, myCapacityRv());
+        }
+      }
+    }
+
+    // the same flows are routed one by one and in windows, both with and
+    // without a task scheduler: the decisions are the same
+    support::UniformIntRv<unsigned long> myNodeRv(0, V - 1, mySeed, 2, 0);
+    support::UniformRv                   myRateRv(1, 10, mySeed, 3, 0);
+    using Flows = std::vector<EsNetwork::FlowDescriptor>;
+    Flows myFlows;
+    for (std::size_t i = 0; i < 200; i++) {
+      const auto mySrc = myNodeRv();
+      const auto myDst = myNodeRv();
+      if (mySrc != myDst) {
+        myFlows.emplace_back(mySrc, myDst, myRateRv());
+      }
+    }
+    const auto myCheckFun = [](const auto& aFlow) {
+      return aFlow.thePath.size() <= 4;
+    };
+
+    for (const auto myAlgo : allFlowRouteAlgos()) {
+      Flows     myExpected(myFlows);
+      EsNetwork myExpectedNetwork(myWeights);
+      myExpectedNetwork.measurementProbability(0.9);
+      myExpectedNetwork.route(myExpected, myAlgo, myCheckFun, 5);
+
+      for (const std::size_t myWindow : {0, 1, 2, 7, 64, 500}) {
+        for (const std::size_t myNumThreads : {0, 4}) {
+          Flows     myActual(myFlows);
+          EsNetwork myActualNetwork(myWeights);
+          myActualNetwork.measurementProbability(0.9);
+          if (myNumThreads == 0) {
+            myActualNetwork.routeBatch(
+                myActual, myAlgo, myWindow, myCheckFun, 5);
+          } else {
+            TaskScheduler myScheduler(myNumThreads);
+            myScheduler.submit([&]() {
+              myActualNetwork.routeBatch(
+                  myActual, myAlgo, myWindow, myCheckFun, 5);
+            });
+            ASSERT_TRUE(myScheduler.wait().empty());
+          }
+
+          ASSERT_EQ(myExpected.size(), myActual.size());
+          for (std::size_t i = 0; i < myExpected.size(); i++) {
+            ASSERT_EQ(myExpected[i].thePath, myActual[i].thePath)
+                << "seed " << mySeed << ", algo " << toString(myAlgo)
+                << ", window " << myWindow << ", threads " << myNumThreads
+                << ", flow " << myExpected[i].toString();
+            ASSERT_EQ(myExpected[i].theGrossRate, myActual[i].theGrossRate);
+            ASSERT_EQ(myExpected[i].theDijsktra, myActual[i].theDijsktra);
+          }
+          ASSERT_EQ(myExpectedNetwork.weights(), myActualNetwork.weights());
+        }
+      }
+    }
+  }
+}
+
 TEST_F(TestEsNetwork, test_route_apps_drr) {
   EsNetwork myNetwork(exampleEdgeWeights());
   myNetwork.measurementProbability(0.5);
@@ -471,6 +781,140 @@ TEST_F(TestEsNetwork, test_route_apps_bft) {
   ASSERT_FLOAT_EQ(4, myApps[2].grossRate());
 }
 
+TEST_F(TestEsNetwork, test_add_capacity_to_exhausted_edge) {
+  EsNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  support::UniformRv myRouteRv(0, 1, 42, 0, 0);
+  const auto         myCapacityTot = myNetwork.totalCapacity();
+  const auto         myVersion     = myNetwork.topologyVersion();
+  const auto         myMakeApps    = []() {
+    return Apps({
+        {0, {3}, 1, 0},
+        {1, {2, 3}, 1, 0},
+        {2, {3}, 1, 0},
+    });
+  };
+
+  // the apps exhaust 0->4, 1->2, and 2->3
+  auto myApps = myMakeApps();
+  ROUTE_BFT(99);
+  const auto myAllocated = myApps;
+  ASSERT_EQ(2, myNetwork.numEdges());
+  ASSERT_NE(myVersion, myNetwork.topologyVersion());
+  ASSERT_FLOAT_EQ(
+      0, myNetwork.maxNetRate(EsNetwork::AppDescriptor(0, {}, 1, 0.5), 3));
+
+  // the apps depart: the edges exhausted are enabled again
+  ASSERT_NO_THROW(myNetwork.addCapacityToPath(0, {4, 3}, 1));
+  ASSERT_NO_THROW(myNetwork.addCapacityToPath(1, {2}, 4));
+  ASSERT_NO_THROW(myNetwork.addCapacityToPath(2, {3}, 4));
+  ASSERT_EQ(5, myNetwork.numEdges());
+  ASSERT_EQ(myVersion, myNetwork.topologyVersion());
+  ASSERT_FLOAT_EQ(myCapacityTot, myNetwork.totalCapacity());
+  ASSERT_EQ(0, myNetwork.outDegree().first);
+  ASSERT_EQ(2, myNetwork.outDegree().second);
+  ASSERT_FLOAT_EQ(
+      1, myNetwork.maxNetRate(EsNetwork::AppDescriptor(0, {}, 1, 0.5), 3));
+
+  // the same apps are allocated in the same way
+  myApps = myMakeApps();
+  ROUTE_BFT(99);
+  ASSERT_EQ(myAllocated.size(), myApps.size());
+  for (std::size_t i = 0; i < myApps.size(); i++) {
+    ASSERT_EQ(myAllocated[i].toString(), myApps[i].toString());
+  }
+}
+
+TEST_F(TestEsNetwork, test_snapshot) {
+  const auto myMakeApps = []() {
+    return Apps({
+        {0, {3}, 1, 0},
+        {1, {2, 3}, 1, 0},
+        {2, {3}, 1, 0},
+        {0, {2}, 1, 0},
+    });
+  };
+
+  // one network is restored before each algorithm, the other one is created
+  EsNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  const auto mySnapshot = myNetwork.snapshot();
+  for (const auto myAlgo :
+       {AppRouteAlgo::Random, AppRouteAlgo::BestFit, AppRouteAlgo::Drr}) {
+    EsNetwork myExpectedNetwork(exampleEdgeWeights());
+    myExpectedNetwork.measurementProbability(0.5);
+    support::UniformRv myExpectedRv(0, 1, 42, 0, 0);
+    auto               myExpected = myMakeApps();
+    myExpectedNetwork.route(myExpected, myAlgo, 1, myExpectedRv, 99);
+
+    myNetwork.restore(mySnapshot);
+    support::UniformRv myRouteRv(0, 1, 42, 0, 0);
+    auto               myApps = myMakeApps();
+    myNetwork.route(myApps, myAlgo, 1, myRouteRv, 99);
+
+    ASSERT_EQ(myExpected.size(), myApps.size());
+    for (std::size_t i = 0; i < myApps.size(); i++) {
+      ASSERT_EQ(myExpected[i].toString(), myApps[i].toString())
+          << toString(myAlgo);
+    }
+    ASSERT_FLOAT_EQ(myExpectedNetwork.totalCapacity(),
+                    myNetwork.totalCapacity());
+    ASSERT_EQ(myExpectedNetwork.topologyVersion(),
+              myNetwork.topologyVersion());
+  }
+}
+
+TEST_F(TestEsNetwork, test_ksp_cache) {
+  // same as the example, plus an edge not used to reach 3 from 0
+  auto myWeights = exampleEdgeWeights();
+  myWeights.emplace_back(3, 4, 1);
+  EsNetwork myNetwork(myWeights);
+  myNetwork.measurementProbability(0.5);
+  support::UniformRv myRouteRv(0, 1, 42, 0, 0);
+  ASSERT_THROW(myNetwork.kspCache(nullptr), std::runtime_error);
+
+  // the topology version does not depend on the capacities
+  for (auto& elem : myWeights) {
+    std::get<2>(elem) = 100;
+  }
+  EsNetwork myAnotherNetwork(myWeights);
+  ASSERT_EQ(myNetwork.topologyVersion(), myAnotherNetwork.topologyVersion());
+  ASSERT_NE(myNetwork.topologyVersion(),
+            EsNetwork(exampleEdgeWeights()).topologyVersion());
+
+  // the paths found by maxNetRate() are reused when routing apps
+  const auto myCache = myNetwork.kspCache();
+  ASSERT_FLOAT_EQ(
+      1, myNetwork.maxNetRate(EsNetwork::AppDescriptor(0, {}, 1, 0.5), 3));
+  ASSERT_EQ(0, myCache->hits());
+  ASSERT_EQ(1, myCache->misses());
+  auto myApps = Apps({{0, {3}, 1, 0}});
+  ROUTE_DRR(1, 2);
+  ASSERT_EQ(1, myCache->hits());
+  ASSERT_EQ(1, myCache->misses());
+  ASSERT_EQ(1, myApps[0].theAllocated.size());
+
+  // all the edges from 0 have been removed
+  ASSERT_NE(myAnotherNetwork.topologyVersion(), myNetwork.topologyVersion());
+  ASSERT_EQ(EsNetwork::WeightVector({{4, 3, 3}, {3, 4, 1}}),
+            myNetwork.weights());
+  ASSERT_EQ(EsNetwork(myNetwork.weights()).topologyVersion(),
+            myNetwork.topologyVersion());
+  ASSERT_FLOAT_EQ(
+      0, myNetwork.maxNetRate(EsNetwork::AppDescriptor(0, {}, 1, 0.5), 3));
+  ASSERT_EQ(1, myCache->hits());
+  ASSERT_EQ(2, myCache->misses());
+
+  // a network with the same topology can share the cache
+  myAnotherNetwork.kspCache(myCache);
+  ASSERT_EQ(myCache, myAnotherNetwork.kspCache());
+  ASSERT_FLOAT_EQ(100,
+                  myAnotherNetwork.maxNetRate(
+                      EsNetwork::AppDescriptor(0, {}, 1, 0.5), 3));
+  ASSERT_EQ(2, myCache->hits());
+  ASSERT_EQ(2, myCache->misses());
+}
+
 TEST_F(TestEsNetwork, test_max_net_rate) {
   EsNetwork myNetwork(exampleEdgeWeights());
   myNetwork.measurementProbability(0.5);
@@ -506,5 +950,204 @@ TEST_F(TestEsNetwork, test_max_net_rate) {
       myNetwork.maxNetRate(EsNetwork::AppDescriptor(3, myNoPeers, 1, 0.5), 0));
 }
 
+TEST_F(TestEsNetwork, test_max_net_rate_max_hops) {
+  EsNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  const EsNetwork::AppDescriptor myApp(0, {}, 1, 0.5);
+  const auto                     myAlwaysTrue = [](const auto&, const auto&) {
+    return true;
+  };
+  const auto myLimit = [](const std::size_t aMaxHops) {
+    return [aMaxHops](const auto&) { return aMaxHops; };
+  };
+
+  // path 0-1-2-3, min capacity = 4 and 2 swaps
+  ASSERT_FLOAT_EQ(1, myNetwork.maxNetRate(myApp, 3, myAlwaysTrue, myLimit(3)));
+
+  // path 0-4-3, min capacity = 1 and 1 swap
+  ASSERT_FLOAT_EQ(0.5,
+                  myNetwork.maxNetRate(myApp, 3, myAlwaysTrue, myLimit(2)));
+
+  // no path within the limit
+  ASSERT_FLOAT_EQ(0, myNetwork.maxNetRate(myApp, 3, myAlwaysTrue, myLimit(1)));
+  ASSERT_FLOAT_EQ(0, myNetwork.maxNetRate(myApp, 3, myAlwaysTrue, myLimit(0)));
+
+  // the paths in the cache are also limited
+  ASSERT_FLOAT_EQ(1, myNetwork.maxNetRate(myApp, 3));
+  ASSERT_FLOAT_EQ(0.5,
+                  myNetwork.maxNetRate(myApp, 3, myAlwaysTrue, myLimit(2)));
+}
+
+TEST_F(TestEsNetwork, test_route_apps_max_hops) {
+  for (const auto myAlgo : allAppRouteAlgos()) {
+    for (const std::size_t myMaxHops : {1, 2, 3}) {
+      support::UniformRv myCheckedRv(0, 1, 42, 0, 0);
+      support::UniformRv myLimitedRv(0, 1, 42, 0, 0);
+      // same apps routed with a check function and with a hop limit
+      Apps myCheckedApps({{0, {2, 3}, 1, 0}, {1, {3}, 1, 0}, {4, {3}, 2, 0}});
+      Apps myLimitedApps(myCheckedApps);
+      EsNetwork myCheckedNetwork(exampleEdgeWeights());
+      EsNetwork myLimitedNetwork(exampleEdgeWeights());
+      myCheckedNetwork.measurementProbability(0.5);
+      myLimitedNetwork.measurementProbability(0.5);
+      myCheckedNetwork.route(myCheckedApps,
+                             myAlgo,
+                             1.4,
+                             myCheckedRv,
+                             99,
+                             [myMaxHops](const auto&, const auto& aPath) {
+                               return aPath.size() <= myMaxHops;
+                             });
+      myLimitedNetwork.route(
+          myLimitedApps,
+          myAlgo,
+          1.4,
+          myLimitedRv,
+          99,
+          [](const auto&, const auto&) { return true; },
+          [myMaxHops](const auto&) { return myMaxHops; });
+
+      ASSERT_EQ(myCheckedNetwork.weights(), myLimitedNetwork.weights())
+          << toString(myAlgo) << ", max hops " << myMaxHops;
+      for (std::size_t i = 0; i < myCheckedApps.size(); i++) {
+        ASSERT_EQ(myCheckedApps[i].theAllocated.size(),
+                  myLimitedApps[i].theAllocated.size());
+        ASSERT_FLOAT_EQ(myCheckedApps[i].netRate(),
+                        myLimitedApps[i].netRate());
+        for (const auto& elem : myLimitedApps[i].theAllocated) {
+          for (const auto& myOutput : elem.second) {
+            ASSERT_LE(myOutput.theHops.size(), myMaxHops);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TestEsNetwork, test_check_function_types) {
+  static_assert(EsNetwork::AcceptAll()(0, 1.0), "always true");
+
+  const auto myAppCheck = [](const auto&, const auto& aPath) {
+    return aPath.size() <= 3;
+  };
+  const auto myFlowCheck = [](const auto& aFlow) {
+    return aFlow.thePath.size() <= 3;
+  };
+  const EsNetwork::AppCheckFunction  myAppFunction  = myAppCheck;
+  const EsNetwork::FlowCheckFunction myFlowFunction = myFlowCheck;
+  const EsNetwork::AppCheckFunction  myAppTrue = [](const auto&, const auto&) {
+    return true;
+  };
+  const EsNetwork::FlowCheckFunction myFlowTrue = [](const auto&) {
+    return true;
+  };
+
+  const std::size_t V = 30;
+  for (std::size_t mySeed = 0; mySeed < 5; mySeed++) {
+    // random graph with random capacities, which includes a ring so that
+    // all the nodes are connected
+    support::UniformRv      myEdgeRv(0, 1, mySeed, 0, 0);
+    support::UniformRv      myCapacityRv(1, 10, mySeed, 1, 0);
+    EsNetwork::WeightVector myWeights;
+    for (std::size_t i = 0; i < V; i++) {
+      for (std::size_t j = 0; j < V; j++) {
+        if (i != j and (myEdgeRv() < 0.1 or j == (i + 1) % V)) {
+          myWeights.emplace_back(i, j, myCapacityRv());
+        }
+      }
+    }
+
+    // the same apps and flows are routed in four networks: with a check
+    // function as a std::function or a lambda, and without a check function
+    // as a std::function always returning true or with the default
+    using Flows        = std::vector<EsNetwork::FlowDescriptor>;
+    const auto myCache = std::make_shared<KspCache>();
+
+    std::vector<std::unique_ptr<EsNetwork>> myNetworks;
+    std::vector<Apps>                       myApps(4);
+    std::vector<Flows>                      myFlows(4);
+    for (std::size_t j = 0; j < 4; j++) {
+      myNetworks.emplace_back(std::make_unique<EsNetwork>(myWeights));
+      myNetworks.back()->measurementProbability(0.9);
+      myNetworks.back()->kspCache(myCache);
+    }
+    support::UniformIntRv<unsigned long> myNodeRv(0, V - 1, mySeed, 2, 0);
+    support::UniformRv                   myRateRv(1, 10, mySeed, 3, 0);
+    for (std::size_t i = 0; i < 10; i++) {
+      const auto                 myHost = myNodeRv();
+      std::vector<unsigned long> myPeers;
+      for (const auto myPeer : {myNodeRv(), myNodeRv()}) {
+        if (myPeer != myHost and
+            std::find(myPeers.begin(), myPeers.end(), myPeer) ==
+                myPeers.end()) {
+          myPeers.emplace_back(myPeer);
+        }
+      }
+      const auto myDst  = (myHost + 1 + i) % V;
+      const auto myRate = myRateRv();
+      for (std::size_t j = 0; j < 4; j++) {
+        myApps[j].emplace_back(myHost, myPeers, 1, 0);
+        myFlows[j].emplace_back(myHost, myDst, myRate);
+      }
+    }
+
+    // the paths of the apps are found only once, by maxNetRate(), and then
+    // they are taken from the cache by all the networks, so that the paths
+    // with the same length are in the same order
+    for (const auto& myApp : myApps[0]) {
+      for (const auto myPeer : myApp.thePeers) {
+        ASSERT_FLOAT_EQ(
+            myNetworks[0]->maxNetRate(myApp, myPeer, myAppFunction),
+            myNetworks[0]->maxNetRate(myApp, myPeer, myAppCheck));
+        ASSERT_FLOAT_EQ(myNetworks[0]->maxNetRate(myApp, myPeer, myAppTrue),
+                        myNetworks[0]->maxNetRate(myApp, myPeer));
+      }
+    }
+
+    support::UniformRv myRv0(0, 1, mySeed, 4, 0);
+    support::UniformRv myRv1(0, 1, mySeed, 4, 0);
+    support::UniformRv myRv2(0, 1, mySeed, 4, 0);
+    support::UniformRv myRv3(0, 1, mySeed, 4, 0);
+    const auto         myAlgo = allAppRouteAlgos()[mySeed % 3];
+    myNetworks[0]->route(myApps[0], myAlgo, 1, myRv0, 5, myAppFunction);
+    myNetworks[1]->route(myApps[1], myAlgo, 1, myRv1, 5, myAppCheck);
+    myNetworks[2]->route(myApps[2], myAlgo, 1, myRv2, 5, myAppTrue);
+    myNetworks[3]->route(myApps[3], myAlgo, 1, myRv3, 5);
+
+    const auto myAlgoFlows = mySeed % 2 == 0 ? FlowRouteAlgo::Iterative :
+                                               FlowRouteAlgo::Layered;
+    myNetworks[0]->route(myFlows[0], myAlgoFlows, myFlowFunction);
+    myNetworks[1]->route(myFlows[1], myAlgoFlows, myFlowCheck);
+    myNetworks[2]->route(myFlows[2], myAlgoFlows, myFlowTrue);
+    myNetworks[3]->route(myFlows[3], myAlgoFlows);
+
+    for (const std::size_t j : {0, 2}) {
+      ASSERT_EQ(myNetworks[j]->weights(), myNetworks[j + 1]->weights())
+          << "seed " << mySeed << ", network " << j;
+      for (std::size_t i = 0; i < myApps[j].size(); i++) {
+        const auto& myLhs = myApps[j][i];
+        const auto& myRhs = myApps[j + 1][i];
+        ASSERT_EQ(myLhs.theVisits, myRhs.theVisits);
+        ASSERT_EQ(myLhs.theAllocated.size(), myRhs.theAllocated.size());
+        for (const auto& elem : myLhs.theAllocated) {
+          const auto& myOutputs = myRhs.theAllocated.at(elem.first);
+          ASSERT_EQ(elem.second.size(), myOutputs.size());
+          for (std::size_t k = 0; k < myOutputs.size(); k++) {
+            ASSERT_EQ(elem.second[k].theHops, myOutputs[k].theHops);
+            ASSERT_FLOAT_EQ(elem.second[k].theNetRate,
+                            myOutputs[k].theNetRate);
+          }
+        }
+      }
+      for (std::size_t i = 0; i < myFlows[j].size(); i++) {
+        ASSERT_EQ(myFlows[j][i].thePath, myFlows[j + 1][i].thePath);
+        ASSERT_FLOAT_EQ(myFlows[j][i].theGrossRate,
+                        myFlows[j + 1][i].theGrossRate);
+        ASSERT_EQ(myFlows[j][i].theDijsktra, myFlows[j + 1][i].theDijsktra);
+      }
+    }
+  }
+}
+
 } // namespace qr
 } // namespace uiiit
@@ -0,0 +1,146 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/eventengine.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestEventEngine : public ::testing::Test {
+  struct Arrival {
+    int theId;
+  };
+  struct Departure {
+    std::string theName;
+  };
+  using Engine = EventEngine<Arrival, Departure>;
+};
+
+TEST_F(TestEventEngine, test_order) {
+  ASSERT_THROW(Engine(-1), std::runtime_error);
+
+  Engine                   myEngine(0);
+  std::vector<std::string> myExecuted;
+  myEngine.handler<Arrival>([&](Arrival& aArrival) {
+    myExecuted.emplace_back(std::to_string(aArrival.theId) + "@" +
+                            std::to_string(myEngine.now()));
+    if (aArrival.theId < 3) {
+      // events scheduled by a handler, also at the current time
+      myEngine.schedule(myEngine.now() + 1.0, Arrival{aArrival.theId + 1});
+      myEngine.schedule(myEngine.now(), Departure{"d"});
+    }
+  });
+  myEngine.handler<Departure>([&](Departure& aDeparture) {
+    myExecuted.emplace_back(aDeparture.theName + "@" +
+                            std::to_string(myEngine.now()));
+  });
+
+  myEngine.schedule(2.5, Departure{"x"});
+  myEngine.schedule(1.0, Arrival{1});
+  myEngine.schedule(2.5, Departure{"y"}); // same time: after x
+  ASSERT_EQ(3, myEngine.numPending());
+
+  ASSERT_EQ(6, myEngine.run(2.5));
+  EXPECT_EQ(std::vector<std::string>({
+                "1@1.000000",
+                "d@1.000000",
+                "2@2.000000",
+                "d@2.000000",
+                "x@2.500000",
+                "y@2.500000",
+            }),
+            myExecuted);
+  EXPECT_EQ(2.5, myEngine.now());
+  ASSERT_EQ(1, myEngine.numPending());
+
+  ASSERT_THROW(myEngine.schedule(2.0, Arrival{99}), std::runtime_error);
+  ASSERT_THROW(myEngine.run(1.0), std::runtime_error);
+
+  // the clock advances even if there are no events
+  ASSERT_EQ(0, myEngine.run(2.9));
+  EXPECT_EQ(2.9, myEngine.now());
+
+  myExecuted.clear();
+  ASSERT_EQ(1, myEngine.run(100));
+  EXPECT_EQ(std::vector<std::string>({"3@3.000000"}), myExecuted);
+  EXPECT_EQ(100, myEngine.now());
+  EXPECT_EQ(0, myEngine.numPending());
+  EXPECT_EQ(7, myEngine.numExecuted());
+}
+
+TEST_F(TestEventEngine, test_no_handler) {
+  Engine myEngine(0);
+  myEngine.handler<Arrival>([](Arrival&) {});
+  myEngine.schedule(1, Arrival{0});
+  myEngine.schedule(2, Departure{""});
+  ASSERT_THROW(myEngine.run(10), std::runtime_error);
+  EXPECT_EQ(1, myEngine.numExecuted());
+}
+
+TEST_F(TestEventEngine, test_warmup_time_weighted) {
+  // number of active items, which arrive at 1, 2, 3, 4 and leave after 2.5
+  Engine myEngine(2);
+  int    myActive   = 0;
+  double myIntegral = 0;
+  double myPeriod   = 0;
+  myEngine.onAdvance([&](const double aFrom, const double aTo) {
+    ASSERT_GE(aFrom, 2);
+    ASSERT_GT(aTo, aFrom);
+    myIntegral += myActive * (aTo - aFrom);
+    myPeriod += aTo - aFrom;
+  });
+  std::vector<bool> myWarm;
+  myEngine.handler<Arrival>([&](Arrival&) {
+    myWarm.emplace_back(myEngine.warm());
+    myActive++;
+    myEngine.schedule(myEngine.now() + 2.5, Departure{""});
+  });
+  myEngine.handler<Departure>([&](Departure&) { myActive--; });
+  for (auto t : {1, 2, 3, 4}) {
+    myEngine.schedule(t, Arrival{t});
+  }
+
+  ASSERT_EQ(8, myEngine.run(10));
+  EXPECT_EQ(std::vector<bool>({false, true, true, true}), myWarm);
+  EXPECT_EQ(0, myActive);
+  EXPECT_DOUBLE_EQ(8, myPeriod);
+  // [2,3]: 2, [3,3.5]: 3, [3.5,4]: 2, [4,4.5]: 3, [4.5,5.5]: 2, [5.5,6.5]: 1
+  EXPECT_DOUBLE_EQ(9, myIntegral);
+}
+
+} // namespace qr
+} // namespace uiiit
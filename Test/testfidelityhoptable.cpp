@@ -0,0 +1,83 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/fidelityhoptable.h"
+#include "QuantumRouting/qrutils.h"
+
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestFidelityHopTable : public ::testing::Test {};
+
+TEST_F(TestFidelityHopTable, test_lookup) {
+  const std::vector<double> myFidelityInits({0.95, 0.98, 1.0});
+  const std::vector<double> myThresholds({0.25, 0.7, 0.9, 0.96});
+  const FidelityHopTable    myTable(
+      0.99, 0.99, 0.99, myFidelityInits, myThresholds);
+
+  ASSERT_EQ(myFidelityInits.size() * myThresholds.size(), myTable.size());
+  for (const auto myFidelityInit : myFidelityInits) {
+    for (const auto myThreshold : myThresholds) {
+      ASSERT_EQ(fidelityMaxHops(0.99, 0.99, 0.99, myFidelityInit, myThreshold),
+                myTable(myFidelityInit, myThreshold));
+    }
+  }
+
+  ASSERT_EQ(0, myTable(0.95, 0.96));
+  ASSERT_EQ(std::numeric_limits<std::size_t>::max(), myTable(0.95, 0.25));
+
+  // combinations not in the table
+  ASSERT_THROW(myTable(0.97, 0.9), std::runtime_error);
+  ASSERT_THROW(myTable(0.95, 0.8), std::runtime_error);
+}
+
+TEST_F(TestFidelityHopTable, test_empty) {
+  const FidelityHopTable myTable(1, 1, 1, {}, {0.9});
+  ASSERT_EQ(0, myTable.size());
+  ASSERT_THROW(myTable(1, 0.9), std::runtime_error);
+}
+
+TEST_F(TestFidelityHopTable, test_invalid) {
+  ASSERT_THROW(FidelityHopTable(0, 1, 1, {1}, {0.9}), std::runtime_error);
+  ASSERT_THROW(FidelityHopTable(1, 1.1, 1, {1}, {0.9}), std::runtime_error);
+  ASSERT_THROW(FidelityHopTable(1, 1, 0.4, {1}, {0.9}), std::runtime_error);
+  ASSERT_THROW(FidelityHopTable(1, 1, 1, {0.9, 1.1}, {0.9}),
+               std::runtime_error);
+  ASSERT_THROW(FidelityHopTable(1, 1, 1, {-0.1}, {0.9}), std::runtime_error);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,201 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/csrgraph.h"
+#include "QuantumRouting/hopdistanceindex.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestHopDistanceIndex : public ::testing::Test {
+  //   /--> 1 -- >2 -+
+  //  /              v
+  // 0               3
+  //  \              ^
+  //   \---> 4 ------+
+  CsrGraph::WeightVector exampleEdgeWeights() {
+    return CsrGraph::WeightVector({
+        {0, 1, 4},
+        {0, 4, 1},
+        {1, 2, 4},
+        {2, 3, 4},
+        {4, 3, 4},
+    });
+  }
+
+  //! \return a random directed graph, with edges sorted by source.
+  CsrGraph::WeightVector randomEdgeWeights(const std::size_t V,
+                                           const std::size_t E,
+                                           const std::size_t aSeed) {
+    support::UniformIntRv<unsigned long> myRv(0, V - 1, aSeed, 0, 0);
+    std::set<std::pair<unsigned long, unsigned long>> myEdges;
+    while (myEdges.size() < E) {
+      const auto u = myRv();
+      const auto v = myRv();
+      if (u != v) {
+        myEdges.emplace(u, v);
+      }
+    }
+    CsrGraph::WeightVector ret;
+    for (const auto& myEdge : myEdges) {
+      ret.emplace_back(myEdge.first, myEdge.second, 1);
+    }
+    return ret;
+  }
+};
+
+TEST_F(TestHopDistanceIndex, test_distances) {
+  const CsrGraph         myGraph(5, exampleEdgeWeights());
+  const HopDistanceIndex myIndex(myGraph, {3, 1, 42, 3});
+
+  ASSERT_EQ(std::vector<unsigned long>({1, 3}), myIndex.targets());
+
+  const auto INF = HopDistanceIndex::INFINITE_DISTANCE;
+  EXPECT_EQ(std::vector<std::uint16_t>({1, 0, INF, INF, INF}),
+            std::vector<std::uint16_t>({myIndex.distance(0, 0),
+                                        myIndex.distance(1, 0),
+                                        myIndex.distance(2, 0),
+                                        myIndex.distance(3, 0),
+                                        myIndex.distance(4, 0)}));
+  EXPECT_EQ(std::vector<std::uint16_t>({2, 2, 1, 0, 1}),
+            std::vector<std::uint16_t>({myIndex.distance(0, 1),
+                                        myIndex.distance(1, 1),
+                                        myIndex.distance(2, 1),
+                                        myIndex.distance(3, 1),
+                                        myIndex.distance(4, 1)}));
+
+  // disabled edges are not followed
+  CsrGraph myDisabled(5, exampleEdgeWeights());
+  myDisabled.disable(myDisabled.findEdge(4, 3).first);
+  EXPECT_EQ(3, HopDistanceIndex(myDisabled, {3}).distance(0, 0));
+  EXPECT_EQ(INF, HopDistanceIndex(myDisabled, {3}).distance(4, 0));
+
+}
+
+TEST_F(TestHopDistanceIndex, test_long_distances) {
+  // chain 0 -> 1 -> ... -> V - 1
+  const std::size_t      V = 70000;
+  CsrGraph::WeightVector myEdges;
+  for (unsigned long u = 0; u + 1 < V; u++) {
+    myEdges.emplace_back(u, u + 1, 1);
+  }
+  const CsrGraph myGraph(V, myEdges);
+
+  // only the distances matter, not the number of vertices
+  const HopDistanceIndex myIndex(myGraph, {100, 65534});
+  EXPECT_EQ(100, myIndex.distance(0, 0));
+  EXPECT_EQ(HopDistanceIndex::INFINITE_DISTANCE, myIndex.distance(101, 0));
+  EXPECT_EQ(65534, myIndex.distance(0, 1));
+  EXPECT_EQ(0, myIndex.distance(65534, 1));
+
+  ASSERT_THROW(HopDistanceIndex(myGraph, {65535}), std::range_error);
+}
+
+TEST_F(TestHopDistanceIndex, test_same_as_hop_distances) {
+  const std::size_t V = 200;
+  for (const auto E : std::vector<std::size_t>({150, 300, 1000})) {
+    const CsrGraph             myGraph(V, randomEdgeWeights(V, E, E));
+    std::vector<unsigned long> myTargets;
+    for (unsigned long t = 0; t < V; t += 7) {
+      myTargets.emplace_back(t);
+    }
+    const HopDistanceIndex myIndex(myGraph, myTargets);
+    ASSERT_EQ(myTargets, myIndex.targets());
+
+    support::UniformRv       myRv(0, 1, 42, 0, 0);
+    std::vector<std::size_t> myDistances;
+    for (std::size_t u = 0; u < V; u++) {
+      myGraph.hopDistances(u, myDistances);
+      std::vector<std::size_t> myExpected;
+      for (std::size_t t = 0; t < myTargets.size(); t++) {
+        const auto myDistance = myDistances[myTargets[t]];
+        if (myDistance == CsrGraph::INFINITE_DISTANCE) {
+          ASSERT_EQ(HopDistanceIndex::INFINITE_DISTANCE,
+                    myIndex.distance(u, t));
+        } else {
+          ASSERT_EQ(myDistance, myIndex.distance(u, t));
+          if (myTargets[t] != u) {
+            myExpected.emplace_back(myDistance);
+          }
+        }
+      }
+      std::sort(myExpected.begin(), myExpected.end());
+
+      // the closest targets found have the smallest distances
+      for (const std::size_t myNum : {0, 1, 5, 99}) {
+        const auto myClosest = myIndex.closest(u, myNum, myRv);
+        ASSERT_EQ(std::min(myNum, myExpected.size()), myClosest.size());
+        for (std::size_t i = 0; i < myClosest.size(); i++) {
+          ASSERT_NE(u, myClosest[i]);
+          ASSERT_EQ(myExpected[i], myDistances[myClosest[i]]);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TestHopDistanceIndex, test_closest) {
+  support::UniformRv myRv(0, 1, 42, 0, 0);
+  CapacityNetwork    myNetwork(exampleEdgeWeights());
+  const auto         myIndex = myNetwork.hopDistanceIndex({0, 1, 2, 3, 4});
+
+  // same targets as closestNodes(), since in this network the ties are never
+  // across the aNum-th closest target, though they may be ordered differently
+  using Set = std::set<unsigned long>;
+  for (unsigned long u = 0; u < 5; u++) {
+    for (const unsigned long myNum : {0, 2, 4, 99}) {
+      const auto myClosest = myIndex.closest(u, myNum, myRv);
+      const auto myClosestNodes =
+          myNetwork.closestNodes(u, myNum, myRv, {0, 1, 2, 3, 4});
+      ASSERT_EQ(Set(myClosestNodes.begin(), myClosestNodes.end()),
+                Set(myClosest.begin(), myClosest.end()));
+    }
+  }
+
+  // ties are broken at random
+  Set myFirst;
+  for (std::size_t i = 0; i < 100; i++) {
+    myFirst.emplace(myIndex.closest(0, 1, myRv).front());
+  }
+  ASSERT_EQ(Set({1, 4}), myFirst);
+}
+
+} // namespace qr
+} // namespace uiiit
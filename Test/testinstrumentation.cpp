@@ -0,0 +1,166 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/csrgraph.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/taskscheduler.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestInstrumentation : public ::testing::Test {};
+
+TEST_F(TestInstrumentation, test_names) {
+  Instrumentation myInstrumentation;
+  ASSERT_EQ(Instrumentation::NUM_COUNTERS + Instrumentation::NUM_PHASES,
+            Instrumentation::names().size());
+
+  // all zero by default, one column per name
+  const auto myCsv = myInstrumentation.toCsv();
+  ASSERT_EQ(Instrumentation::names().size() - 1,
+            std::count(myCsv.begin(), myCsv.end(), ','));
+  for (const auto myChar : myCsv) {
+    ASSERT_TRUE(myChar == ',' or myChar == '0') << myCsv;
+  }
+}
+
+TEST_F(TestInstrumentation, test_scope) {
+  Instrumentation myOuter;
+  Instrumentation myInner;
+  ASSERT_EQ(nullptr, Instrumentation::active());
+
+  // no active object: the costs are discarded
+  Instrumentation::count(Instrumentation::Counter::Allocations);
+  {
+    const Instrumentation::Scope myOuterScope(myOuter);
+    Instrumentation::count(Instrumentation::Counter::Allocations);
+    {
+      const Instrumentation::Scope myInnerScope(myInner);
+      Instrumentation::count(Instrumentation::Counter::Allocations, 10);
+      Instrumentation::LocalCounter myCounter(
+          Instrumentation::Counter::EdgesRelaxed);
+      ++myCounter;
+      ++myCounter;
+    }
+    Instrumentation::count(Instrumentation::Counter::Allocations);
+
+    // other threads do not inherit the active object
+    std::thread myThread([]() {
+      ASSERT_EQ(nullptr, Instrumentation::active());
+      Instrumentation::count(Instrumentation::Counter::Allocations);
+    });
+    myThread.join();
+  }
+  ASSERT_EQ(nullptr, Instrumentation::active());
+
+  if (not Instrumentation::enabled()) {
+    ASSERT_EQ(0, myOuter.value(Instrumentation::Counter::Allocations));
+    ASSERT_EQ(0, myInner.value(Instrumentation::Counter::Allocations));
+    return;
+  }
+  ASSERT_EQ(2, myOuter.value(Instrumentation::Counter::Allocations));
+  ASSERT_EQ(0, myOuter.value(Instrumentation::Counter::EdgesRelaxed));
+  ASSERT_EQ(10, myInner.value(Instrumentation::Counter::Allocations));
+  ASSERT_EQ(2, myInner.value(Instrumentation::Counter::EdgesRelaxed));
+
+  // copies are snapshots
+  const Instrumentation myCopy(myInner);
+  Instrumentation::Scope myScope(myInner);
+  Instrumentation::count(Instrumentation::Counter::Allocations);
+  ASSERT_EQ(10, myCopy.value(Instrumentation::Counter::Allocations));
+  ASSERT_EQ(11, myInner.value(Instrumentation::Counter::Allocations));
+}
+
+TEST_F(TestInstrumentation, test_timer) {
+  Instrumentation myInstrumentation;
+  {
+    const Instrumentation::Scope myScope(myInstrumentation);
+    const Instrumentation::Timer myTimer(Instrumentation::Phase::Ksp);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (Instrumentation::enabled()) {
+    ASSERT_GE(myInstrumentation.time(Instrumentation::Phase::Ksp), 0.01);
+  } else {
+    ASSERT_EQ(0, myInstrumentation.time(Instrumentation::Phase::Ksp));
+  }
+  ASSERT_EQ(0, myInstrumentation.time(Instrumentation::Phase::Topology));
+}
+
+TEST_F(TestInstrumentation, test_task_scheduler) {
+  // line graph: 0 -> 1 -> ... -> 9
+  CsrGraph::WeightVector myEdges;
+  for (unsigned long i = 0; i < 9; i++) {
+    myEdges.emplace_back(i, i + 1, 1.0);
+  }
+  const CsrGraph myGraph(10, myEdges);
+
+  // the same costs, no matter how many workers run the searches
+  std::vector<std::uint64_t> myPathSearches;
+  std::vector<std::uint64_t> myEdgesRelaxed;
+  for (const std::size_t myNumThreads : {1, 4}) {
+    Instrumentation myInstrumentation;
+    TaskScheduler   myScheduler(myNumThreads);
+    myScheduler.submit([&myInstrumentation, &myGraph]() {
+      const Instrumentation::Scope myScope(myInstrumentation);
+      TaskScheduler::current()->parallelFor(
+          0, 10, [&myGraph](const std::size_t aBegin, const std::size_t aEnd) {
+            std::vector<std::size_t> myDistances;
+            for (auto i = aBegin; i < aEnd; i++) {
+              myGraph.hopDistances(i, myDistances);
+            }
+          });
+    });
+    ASSERT_TRUE(myScheduler.wait().empty());
+    myPathSearches.emplace_back(
+        myInstrumentation.value(Instrumentation::Counter::PathSearches));
+    myEdgesRelaxed.emplace_back(
+        myInstrumentation.value(Instrumentation::Counter::EdgesRelaxed));
+  }
+  ASSERT_EQ(myPathSearches[0], myPathSearches[1]);
+  ASSERT_EQ(myEdgesRelaxed[0], myEdgesRelaxed[1]);
+  if (Instrumentation::enabled()) {
+    ASSERT_EQ(10, myPathSearches[0]);
+    ASSERT_EQ(45, myEdgesRelaxed[0]);
+  } else {
+    ASSERT_EQ(0, myPathSearches[0]);
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,106 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/kspcache.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestKspCache : public ::testing::Test {};
+
+TEST_F(TestKspCache, test_find_insert) {
+  using Paths = KspCache::Paths;
+
+  ASSERT_THROW(KspCache(0), std::runtime_error);
+
+  KspCache myCache;
+  Paths    myPaths;
+  ASSERT_FALSE(myCache.find(42, 0, 3, 2, myPaths));
+  ASSERT_EQ(0, myCache.numTopologies());
+
+  myCache.insert(42, 0, 3, 2, Paths({{4, 3}, {1, 2, 3}}));
+  ASSERT_EQ(1, myCache.numTopologies());
+
+  // same or smaller k
+  ASSERT_TRUE(myCache.find(42, 0, 3, 2, myPaths));
+  EXPECT_EQ(Paths({{4, 3}, {1, 2, 3}}), myPaths);
+  ASSERT_TRUE(myCache.find(42, 0, 3, 1, myPaths));
+  EXPECT_EQ(Paths({{4, 3}}), myPaths);
+
+  // larger k, other pairs, other topologies
+  ASSERT_FALSE(myCache.find(42, 0, 3, 3, myPaths));
+  ASSERT_FALSE(myCache.find(42, 3, 0, 1, myPaths));
+  ASSERT_FALSE(myCache.find(43, 0, 3, 1, myPaths));
+
+  // a search with fewer paths than k is valid for any k
+  myCache.insert(42, 0, 3, 10, Paths({{4, 3}, {1, 2, 3}, {1, 4, 3}}));
+  ASSERT_TRUE(myCache.find(42, 0, 3, 99, myPaths));
+  EXPECT_EQ(3, myPaths.size());
+  myCache.insert(42, 3, 0, 1, Paths());
+  ASSERT_TRUE(myCache.find(42, 3, 0, 5, myPaths));
+  EXPECT_TRUE(myPaths.empty());
+
+  // a search with a smaller k does not replace the existing one
+  myCache.insert(42, 0, 3, 1, Paths({{4, 3}}));
+  ASSERT_TRUE(myCache.find(42, 0, 3, 3, myPaths));
+  EXPECT_EQ(3, myPaths.size());
+
+  EXPECT_EQ(5, myCache.hits());
+  EXPECT_EQ(4, myCache.misses());
+
+  myCache.clear();
+  ASSERT_EQ(0, myCache.numTopologies());
+  ASSERT_FALSE(myCache.find(42, 0, 3, 1, myPaths));
+}
+
+TEST_F(TestKspCache, test_max_topologies) {
+  KspCache        myCache(2);
+  KspCache::Paths myPaths;
+
+  myCache.insert(1, 0, 1, 1, KspCache::Paths({{1}}));
+  myCache.insert(2, 0, 1, 1, KspCache::Paths({{1}}));
+  ASSERT_EQ(2, myCache.numTopologies());
+
+  // using topology 1 makes 2 the least recently used one
+  ASSERT_TRUE(myCache.find(1, 0, 1, 1, myPaths));
+  myCache.insert(3, 0, 1, 1, KspCache::Paths({{1}}));
+  ASSERT_EQ(2, myCache.numTopologies());
+  EXPECT_TRUE(myCache.find(1, 0, 1, 1, myPaths));
+  EXPECT_FALSE(myCache.find(2, 0, 1, 1, myPaths));
+  EXPECT_TRUE(myCache.find(3, 0, 1, 1, myPaths));
+}
+
+} // namespace qr
+} // namespace uiiit
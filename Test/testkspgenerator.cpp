@@ -0,0 +1,282 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/csrgraph.h"
+#include "QuantumRouting/kspgenerator.h"
+#include "Support/random.h"
+
+#include "yen/yen_ksp.hpp"
+
+#include "gtest/gtest.h"
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/property_map/property_map.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestKspGenerator : public ::testing::Test {
+  // same as in CapacityNetwork
+  using Graph = boost::adjacency_list<
+      boost::listS,
+      boost::vecS,
+      boost::bidirectionalS,
+      boost::no_property,
+      boost::property<boost::edge_weight_t,
+                      double,
+                      boost::property<boost::edge_index_t, std::size_t>>,
+      boost::no_property,
+      boost::listS>;
+  using Path = KspGenerator::Path;
+
+  // graph with the edges added in random order, its CSR snapshot, in which
+  // the edges are sorted by source, and the ranks of the edge descriptors
+  struct Networks {
+    explicit Networks(const std::size_t aNodes,
+                      const double      aProb,
+                      const std::size_t aSeed)
+        : theGraph(aNodes) {
+      std::vector<std::pair<std::size_t, std::size_t>> myEdges;
+      support::UniformRv myEdgeRv(0, 1, aSeed, 0, 0);
+      for (std::size_t i = 0; i < aNodes; i++) {
+        for (std::size_t j = 0; j < aNodes; j++) {
+          if (i != j and myEdgeRv() < aProb) {
+            myEdges.emplace_back(i, j);
+          }
+        }
+      }
+      support::UniformRv myShuffleRv(0, 1, aSeed, 1, 0);
+      for (std::size_t i = myEdges.size(); i > 1; i--) {
+        std::swap(myEdges[i - 1],
+                  myEdges[static_cast<std::size_t>(myShuffleRv() * i) % i]);
+      }
+      for (const auto& myEdge : myEdges) {
+        boost::add_edge(myEdge.first, myEdge.second, theGraph);
+      }
+
+      CsrGraph::WeightVector myWeights;
+      auto myIndices = boost::get(boost::edge_index, theGraph);
+      for (const auto& u :
+           boost::make_iterator_range(boost::vertices(theGraph))) {
+        for (const auto& e :
+             boost::make_iterator_range(boost::out_edges(u, theGraph))) {
+          myIndices[e] = myWeights.size();
+          myWeights.emplace_back(u, e.m_target, 1);
+          theDescriptors.emplace_back(e);
+        }
+      }
+      theCsr = CsrGraph(aNodes, myWeights);
+
+      std::vector<std::size_t> myOrder(theDescriptors.size());
+      std::iota(myOrder.begin(), myOrder.end(), 0);
+      std::sort(myOrder.begin(),
+                myOrder.end(),
+                [this](const std::size_t aLhs, const std::size_t aRhs) {
+                  return theDescriptors[aLhs] < theDescriptors[aRhs];
+                });
+      theRanks.resize(myOrder.size());
+      for (std::size_t i = 0; i < myOrder.size(); i++) {
+        theRanks[myOrder[i]] = i;
+      }
+    }
+
+    // k-shortest paths found by boost::yen_ksp(), as CSR edges
+    std::vector<Path> yen(const std::size_t aSrc,
+                          const std::size_t aDst,
+                          const std::size_t aK) const {
+      std::vector<Path> ret;
+      for (const auto& elem : boost::yen_ksp(
+               theGraph,
+               aSrc,
+               aDst,
+               boost::make_static_property_map<Graph::edge_descriptor>(1),
+               boost::get(boost::vertex_index, theGraph),
+               aK)) {
+        ret.emplace_back();
+        for (const auto& myEdge : elem.second) {
+          ret.back().emplace_back(
+              boost::get(boost::edge_index, theGraph, myEdge));
+        }
+      }
+      return ret;
+    }
+
+    Graph                                theGraph;
+    CsrGraph                             theCsr;
+    std::vector<Graph::edge_descriptor>  theDescriptors;
+    std::vector<std::size_t>             theRanks;
+  };
+};
+
+TEST_F(TestKspGenerator, test_example) {
+  //   /--> 4 --> 5 -----+
+  //  /                  v
+  // 0 ---> 1 ---------> 3
+  //         \           ^
+  //          \--> 6 ----+
+  CsrGraph myGraph(7,
+                   CsrGraph::WeightVector({
+                       {0, 1, 1},
+                       {0, 4, 1},
+                       {1, 3, 1},
+                       {1, 6, 1},
+                       {4, 5, 1},
+                       {5, 3, 1},
+                       {6, 3, 1},
+                   }));
+  std::vector<std::size_t> myRanks({0, 1, 2, 3, 4, 5, 6});
+  CsrGraph::Scratch        myScratch;
+
+  KspGenerator myGenerator(myGraph, myRanks, 0, 3, 99, 99);
+  ASSERT_TRUE(myGenerator.paths().empty());
+  ASSERT_FALSE(myGenerator.done());
+  ASSERT_TRUE(myGenerator.next(myScratch));
+  ASSERT_EQ(std::vector<Path>({{0, 2}}), myGenerator.paths());
+  ASSERT_TRUE(myGenerator.next(myScratch));
+  ASSERT_EQ(std::vector<Path>({{0, 2}, {0, 3, 6}}), myGenerator.paths());
+  ASSERT_TRUE(myGenerator.next(myScratch));
+  ASSERT_EQ(std::vector<Path>({{0, 2}, {0, 3, 6}, {1, 4, 5}}),
+            myGenerator.paths());
+  ASSERT_FALSE(myGenerator.done());
+  ASSERT_FALSE(myGenerator.next(myScratch));
+  ASSERT_TRUE(myGenerator.done());
+  ASSERT_FALSE(myGenerator.next(myScratch));
+  ASSERT_EQ(3, myGenerator.paths().size());
+
+  // the ties between the paths with the same length are broken by the ranks
+  myRanks = std::vector<std::size_t>({1, 0, 2, 3, 4, 5, 6});
+  KspGenerator myReversed(myGraph, myRanks, 0, 3, 99, 99);
+  while (myReversed.next(myScratch)) {
+  }
+  ASSERT_EQ(std::vector<Path>({{0, 2}, {1, 4, 5}, {0, 3, 6}}),
+            myReversed.paths());
+
+  // limit on the number of paths, at least one
+  KspGenerator myTwo(myGraph, myRanks, 0, 3, 2, 99);
+  while (myTwo.next(myScratch)) {
+  }
+  ASSERT_EQ(std::vector<Path>({{0, 2}, {1, 4, 5}}), myTwo.paths());
+  for (const std::size_t myK : {0, 1}) {
+    KspGenerator myOne(myGraph, myRanks, 0, 3, myK, 99);
+    ASSERT_TRUE(myOne.next(myScratch));
+    ASSERT_FALSE(myOne.next(myScratch));
+    ASSERT_EQ(std::vector<Path>({{0, 2}}), myOne.paths());
+  }
+
+  // limit on the length of the paths
+  KspGenerator myShort(myGraph, myRanks, 0, 3, 99, 2);
+  while (myShort.next(myScratch)) {
+  }
+  ASSERT_EQ(std::vector<Path>({{0, 2}}), myShort.paths());
+  for (const std::size_t myMaxHops : {0, 1}) {
+    KspGenerator myNone(myGraph, myRanks, 0, 3, 99, myMaxHops);
+    ASSERT_FALSE(myNone.next(myScratch));
+    ASSERT_TRUE(myNone.paths().empty());
+  }
+
+  // no paths
+  KspGenerator myDisconnected(myGraph, myRanks, 3, 0, 99, 99);
+  ASSERT_FALSE(myDisconnected.next(myScratch));
+  KspGenerator mySame(myGraph, myRanks, 0, 0, 99, 99);
+  ASSERT_FALSE(mySame.next(myScratch));
+
+  // disabled edges are not used
+  myGraph.disable(3);
+  KspGenerator myDisabled(myGraph, myRanks, 0, 3, 99, 99);
+  while (myDisabled.next(myScratch)) {
+  }
+  ASSERT_EQ(std::vector<Path>({{0, 2}, {1, 4, 5}}), myDisabled.paths());
+
+  // invalid arguments
+  ASSERT_THROW(KspGenerator(myGraph, myRanks, 0, 7, 1, 99),
+               std::runtime_error);
+  ASSERT_THROW(KspGenerator(myGraph, {0, 1}, 0, 3, 1, 99),
+               std::runtime_error);
+}
+
+TEST_F(TestKspGenerator, test_same_as_yen) {
+  const std::size_t V = 30;
+  CsrGraph::Scratch myScratch;
+  for (std::size_t mySeed = 0; mySeed < 5; mySeed++) {
+    const Networks myNetworks(V, 0.1, mySeed);
+    for (std::size_t mySrc = 0; mySrc < V; mySrc += 3) {
+      for (std::size_t myDst = 0; myDst < V; myDst++) {
+        if (mySrc == myDst) {
+          continue;
+        }
+        for (const std::size_t myK : {1, 5, 20}) {
+          const auto myExpected = myNetworks.yen(mySrc, myDst, myK);
+
+          KspGenerator myGenerator(
+              myNetworks.theCsr, myNetworks.theRanks, mySrc, myDst, myK, 99);
+          while (myGenerator.next(myScratch)) {
+          }
+          ASSERT_EQ(myExpected, myGenerator.paths())
+              << "seed " << mySeed << ", " << mySrc << " -> " << myDst
+              << ", k " << myK;
+
+          // with a maximum length the paths are a prefix of those above
+          for (const std::size_t myMaxHops : {1, 2, 3, 4}) {
+            KspGenerator myBounded(myNetworks.theCsr,
+                                   myNetworks.theRanks,
+                                   mySrc,
+                                   myDst,
+                                   myK,
+                                   myMaxHops);
+            while (myBounded.next(myScratch)) {
+            }
+            std::vector<Path> myPrefix;
+            for (const auto& myPath : myExpected) {
+              if (myPath.size() > myMaxHops) {
+                break;
+              }
+              myPrefix.emplace_back(myPath);
+            }
+            ASSERT_EQ(myPrefix, myBounded.paths())
+                << "seed " << mySeed << ", " << mySrc << " -> " << myDst
+                << ", k " << myK << ", max hops " << myMaxHops;
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -40,6 +40,7 @@ SOFTWARE.
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <ctime>
 #include <set>
 #include <stdexcept>
@@ -272,5 +273,112 @@ TEST_F(TestMecQkdNetwork, test_allocation_spf_static) {
   ASSERT_FALSE(myOutput[4].theAllocated);
 }
 
+TEST_F(TestMecQkdNetwork, test_admissible) {
+  for (const auto myAlgo : allMecQkdAlgos()) {
+    // a query returns the same allocation as that of a single app
+    const MecQkdNetwork::Allocation               myApp{0, 1.5, 2.0};
+    std::vector<MecQkdNetwork::Allocation>        myExpected({myApp});
+    support::DeterministicRv<std::vector<double>> myExpectedRv({0.1, 0.4});
+    auto myExpectedNetwork = makeNetwork();
+    myExpectedNetwork->allocate(myExpected, myAlgo, myExpectedRv);
+
+    MecQkdNetwork::QueryScratch                   myScratch;
+    support::DeterministicRv<std::vector<double>> myRv({0.1, 0.4});
+    auto                                          myOutput  = myApp;
+    auto                                          myNetwork = makeNetwork();
+    ASSERT_EQ(myExpected[0].theAllocated,
+              myNetwork->admissible(myOutput, myAlgo, myRv, myScratch));
+    ASSERT_EQ(myExpected[0].toString(), myOutput.toString());
+    ASSERT_EQ(myExpected[0].thePath, myOutput.thePath);
+    ASSERT_FLOAT_EQ(18.0, myNetwork->totProcessing());
+    ASSERT_FLOAT_EQ(13.0, myNetwork->totalCapacity());
+
+    // committing the query has the same effect as allocating the app
+    myNetwork->commit({myOutput});
+    ASSERT_EQ(myExpectedNetwork->edgeNodes(), myNetwork->edgeNodes());
+    ASSERT_FLOAT_EQ(myExpectedNetwork->totalCapacity(),
+                    myNetwork->totalCapacity());
+
+    if (myOutput.theAllocated) {
+      // the same app cannot be committed again, because of either the
+      // processing load or the capacity required
+      std::vector<MecQkdNetwork::Allocation> myTwice({myOutput, myOutput});
+      myTwice[0].theLoad = 0;
+      myTwice[1].theLoad = 99;
+      myTwice[0].theRate = 0.1;
+      myTwice[1].theRate = 0.1;
+      ASSERT_THROW(myNetwork->commit(myTwice), std::runtime_error)
+          << toString(myAlgo);
+      ASSERT_EQ(myExpectedNetwork->edgeNodes(), myNetwork->edgeNodes());
+      ASSERT_FLOAT_EQ(myExpectedNetwork->totalCapacity(),
+                      myNetwork->totalCapacity());
+      myTwice[1].theLoad = 0;
+      myTwice[0].theRate = 0.3;
+      myTwice[1].theRate = 0.3;
+      ASSERT_THROW(myNetwork->commit(myTwice), std::runtime_error)
+          << toString(myAlgo);
+      ASSERT_FLOAT_EQ(myExpectedNetwork->totalCapacity(),
+                      myNetwork->totalCapacity());
+    }
+  }
+}
+
+TEST_F(TestMecQkdNetwork, test_snapshot) {
+  const std::vector<MecQkdAlgo> myAlgos({
+      MecQkdAlgo::Random,
+      MecQkdAlgo::Spf,
+      MecQkdAlgo::BestFit,
+      MecQkdAlgo::RandomBlind,
+      MecQkdAlgo::SpfBlind,
+      MecQkdAlgo::BestFitBlind,
+      MecQkdAlgo::SpfStatic,
+  });
+  const std::vector<MecQkdNetwork::Allocation> myApps({
+      MecQkdNetwork::Allocation{0, 1.0, 1.0},
+      MecQkdNetwork::Allocation{0, 2.0, 3.0},
+      MecQkdNetwork::Allocation{0, 1.0, 0.1},
+      MecQkdNetwork::Allocation{0, 0.5, 4.0},
+      MecQkdNetwork::Allocation{0, 1.0, 1.0},
+  });
+
+  // one network is restored before each algorithm, the other one is created
+  auto       myNetwork  = makeNetwork();
+  const auto mySnapshot = myNetwork->snapshot();
+  support::DeterministicRv<std::vector<double>> myRv(
+      {0.1, 0.4, 0.25, 0.9, 0.6, 0.7, 0.7, 0.3});
+  for (const auto myAlgo : myAlgos) {
+    auto myExpected        = myApps;
+    auto myExpectedNetwork = makeNetwork();
+    myExpectedNetwork->allocate(myExpected, myAlgo, theRv);
+
+    myNetwork->restore(mySnapshot);
+    auto myOutput = myApps;
+    myNetwork->allocate(myOutput, myAlgo, myRv);
+
+    ASSERT_EQ(myExpected.size(), myOutput.size());
+    for (std::size_t i = 0; i < myOutput.size(); i++) {
+      ASSERT_EQ(myExpected[i].toString(), myOutput[i].toString())
+          << toString(myAlgo);
+    }
+    ASSERT_EQ(myExpectedNetwork->edgeNodes(), myNetwork->edgeNodes());
+    auto myExpectedWeights = myExpectedNetwork->weights();
+    auto myWeights         = myNetwork->weights();
+    std::sort(myExpectedWeights.begin(), myExpectedWeights.end());
+    std::sort(myWeights.begin(), myWeights.end());
+    ASSERT_EQ(myExpectedWeights, myWeights);
+    ASSERT_FLOAT_EQ(myExpectedNetwork->totalCapacity(),
+                    myNetwork->totalCapacity());
+  }
+
+  myNetwork->restore(mySnapshot);
+  ASSERT_FLOAT_EQ(18.0, myNetwork->totProcessing());
+  ASSERT_FLOAT_EQ(13.0, myNetwork->totalCapacity());
+
+  // the edge nodes must be the same
+  auto myAnotherNetwork = makeNetwork();
+  myAnotherNetwork->edgeNodes({{3, 5}, {4, 2}, {5, 10}, {7, 1}});
+  ASSERT_THROW(myAnotherNetwork->restore(mySnapshot), std::runtime_error);
+}
+
 } // namespace qr
 } // namespace uiiit
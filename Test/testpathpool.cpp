@@ -0,0 +1,69 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/pathpool.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestPathPool : public ::testing::Test {};
+
+TEST_F(TestPathPool, test_add_paths) {
+  using Edges = std::vector<PathPool::EdgeId>;
+
+  PathPool myPool;
+  ASSERT_EQ(0, myPool.numPaths());
+
+  for (const auto& myEdge : Edges({3, 1, 4})) {
+    myPool.addEdge(myEdge);
+  }
+  ASSERT_EQ(0, myPool.close());
+  ASSERT_EQ(1, myPool.close()); // empty path
+  for (const auto& myEdge : Edges({1, 5})) {
+    myPool.addEdge(myEdge);
+  }
+  ASSERT_EQ(2, myPool.close());
+  ASSERT_EQ(3, myPool.numPaths());
+
+  EXPECT_EQ(3, myPool.size(0));
+  EXPECT_EQ(0, myPool.size(1));
+  EXPECT_EQ(2, myPool.size(2));
+  EXPECT_EQ(Edges({3, 1, 4}), Edges(myPool.begin(0), myPool.end(0)));
+  EXPECT_EQ(myPool.begin(1), myPool.end(1));
+  EXPECT_EQ(Edges({1, 5}), Edges(myPool.begin(2), myPool.end(2)));
+}
+
+} // namespace qr
+} // namespace uiiit
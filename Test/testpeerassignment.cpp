@@ -187,6 +187,29 @@ TEST_F(TestPeerAssignment, test_shortest_path) {
   }
 }
 
+TEST_F(TestPeerAssignment, test_shortest_path_long_distances) {
+  // chain 0 -> 1 -> ... -> V - 1, with data centers too far for the index
+  const unsigned long     V = 70000;
+  EsNetwork::WeightVector myEdges;
+  for (unsigned long u = 0; u + 1 < V; u++) {
+    myEdges.emplace_back(u, u + 1, 1);
+  }
+  EsNetwork myNetwork(myEdges);
+  ASSERT_THROW(myNetwork.hopDistanceIndex({V - 1}), std::range_error);
+
+  auto myAssignment =
+      makePeerAssignment(myNetwork,
+                         PeerAssignmentAlgo::ShortestPath,
+                         theRv,
+                         [](const auto&, const auto&) { return true; });
+  const auto myAssigned = myAssignment->assign(
+      {{0, 1, 0.5}, {V - 2, 1, 0.5}, {V - 1, 1, 0.5}}, 2, {V - 1, 10, 5});
+  ASSERT_EQ(3u, myAssigned.size());
+  ASSERT_EQ(Nodes({5, 10}), myAssigned[0].thePeers);
+  ASSERT_EQ(Nodes({V - 1}), myAssigned[1].thePeers);
+  ASSERT_EQ(Nodes(), myAssigned[2].thePeers);
+}
+
 TEST_F(TestPeerAssignment, test_load_balancing) {
   EsNetwork myNetwork(exampleEdgeWeights());
   myNetwork.measurementProbability(0.5);
@@ -257,5 +280,197 @@ TEST_F(TestPeerAssignment, test_load_balancing) {
                             {{4, 5, 6, 8}, {5, 6, 4, 8}, {5, 6, 8, 4}})));
 }
 
+TEST_F(TestPeerAssignment, test_load_balancing_parallel) {
+  const std::size_t       V = 60;
+  support::UniformRv      myEdgeRv(0, 1, 42, 0, 0);
+  EsNetwork::WeightVector myWeights;
+  for (std::size_t i = 0; i < V; i++) {
+    for (std::size_t j = 0; j < V; j++) {
+      if (i != j and (j == (i + 1) % V or myEdgeRv() < 0.05)) {
+        myWeights.emplace_back(i, j, 1 + 99 * myEdgeRv());
+      }
+    }
+  }
+
+  std::vector<PeerAssignment::AppDescriptor> myApps;
+  Nodes                                      myDataCenters;
+  for (std::size_t i = 0; i < V; i++) {
+    if (i % 3 == 0) {
+      myApps.emplace_back(i, 1, 0.5);
+    } else if (i % 7 == 1) {
+      myDataCenters.emplace_back(i);
+    }
+  }
+
+  const auto myCheckFunction = [](const auto&, const auto& aPath) {
+    return aPath.size() <= 5;
+  };
+  std::vector<std::vector<EsNetwork::AppDescriptor>> myAssigned;
+  for (const std::size_t myNumThreads : {1, 3, 0}) {
+    EsNetwork myNetwork(myWeights);
+    myNetwork.measurementProbability(0.5);
+    auto myAssignment = makePeerAssignment(myNetwork,
+                                           PeerAssignmentAlgo::LoadBalancing,
+                                           theRv,
+                                           myCheckFunction,
+                                           myNumThreads);
+    myAssigned.emplace_back(myAssignment->assign(myApps, 2, myDataCenters));
+  }
+
+  ASSERT_EQ(myApps.size(), myAssigned[0].size());
+  for (std::size_t i = 1; i < myAssigned.size(); i++) {
+    ASSERT_EQ(myAssigned[0].size(), myAssigned[i].size());
+    for (std::size_t a = 0; a < myAssigned[0].size(); a++) {
+      ASSERT_EQ(2, myAssigned[0][a].thePeers.size());
+      ASSERT_EQ(myAssigned[0][a].thePeers, myAssigned[i][a].thePeers);
+    }
+  }
+}
+
+TEST_F(TestPeerAssignment, test_load_balancing_mcf) {
+  EsNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  const auto myCheckFunction = [](const auto&, const auto&) { return true; };
+
+  auto myAssignment = makePeerAssignment(
+      myNetwork, PeerAssignmentAlgo::LoadBalancingMcf, theRv, myCheckFunction);
+  ASSERT_EQ(PeerAssignmentAlgo::LoadBalancingMcf, myAssignment->algo());
+  auto myHungarian = makePeerAssignment(
+      myNetwork, PeerAssignmentAlgo::LoadBalancing, theRv, myCheckFunction);
+
+  // total net rate of the assignment
+  const auto myTotal = [&](const EsNetwork& aNetwork, const auto& aAssigned) {
+    double ret = 0;
+    for (const auto& myApp : aAssigned) {
+      for (const auto& myPeer : myApp.thePeers) {
+        ret += aNetwork.maxNetRate(myApp, myPeer, myCheckFunction);
+      }
+    }
+    return ret;
+  };
+
+  // W = 1: same as the Hungarian algorithm
+  auto myAssigned = myAssignment->assign(theApps, 1, theDataCenters);
+  ASSERT_EQ(theApps.size(), myAssigned.size());
+  ASSERT_FLOAT_EQ(
+      myTotal(myNetwork, myHungarian->assign(theApps, 1, theDataCenters)),
+      myTotal(myNetwork, myAssigned));
+  ASSERT_EQ(Nodes({4}), myAssigned[0].thePeers);
+  ASSERT_EQ(Nodes({5}), myAssigned[1].thePeers);
+  ASSERT_EQ(Nodes({6}), myAssigned[2].thePeers);
+
+  // W >= number of data centers: each app is assigned to all data centers
+  for (const unsigned long W : {4, 10}) {
+    myAssigned = myAssignment->assign(theApps, W, theDataCenters);
+    ASSERT_EQ(theApps.size(), myAssigned.size());
+    for (const auto& myApp : myAssigned) {
+      ASSERT_EQ(theDataCenters.size(), myApp.thePeers.size());
+      ASSERT_EQ(std::set<unsigned long>(theDataCenters.begin(),
+                                        theDataCenters.end()),
+                std::set<unsigned long>(myApp.thePeers.begin(),
+                                        myApp.thePeers.end()));
+    }
+  }
+
+  // random network: same total net rate as the Hungarian algorithm with W = 1
+  // and data centers not assigned more than C = 1 + (apps * W - 1) / DCs
+  const std::size_t       V = 40;
+  support::UniformRv      myEdgeRv(0, 1, 42, 0, 0);
+  EsNetwork::WeightVector myWeights;
+  for (std::size_t i = 0; i < V; i++) {
+    for (std::size_t j = 0; j < V; j++) {
+      if (i != j and (j == (i + 1) % V or myEdgeRv() < 0.05)) {
+        myWeights.emplace_back(i, j, 1 + 99 * myEdgeRv());
+      }
+    }
+  }
+  EsNetwork myRandomNetwork(myWeights);
+  myRandomNetwork.measurementProbability(0.5);
+  std::vector<PeerAssignment::AppDescriptor> myApps;
+  Nodes                                      myDataCenters;
+  for (std::size_t i = 0; i < V; i++) {
+    if (i % 3 != 0) {
+      myApps.emplace_back(i, 1, 0.5);
+    } else {
+      myDataCenters.emplace_back(i);
+    }
+  }
+  myAssignment = makePeerAssignment(myRandomNetwork,
+                                    PeerAssignmentAlgo::LoadBalancingMcf,
+                                    theRv,
+                                    myCheckFunction);
+  myHungarian  = makePeerAssignment(myRandomNetwork,
+                                   PeerAssignmentAlgo::LoadBalancing,
+                                   theRv,
+                                   myCheckFunction);
+  ASSERT_NEAR(
+      myTotal(myRandomNetwork, myHungarian->assign(myApps, 1, myDataCenters)),
+      myTotal(myRandomNetwork, myAssignment->assign(myApps, 1, myDataCenters)),
+      1e-6);
+  const unsigned long W = 3;
+  const auto          C = 1 + (myApps.size() * W - 1) / myDataCenters.size();
+  std::map<unsigned long, std::size_t> myLoads;
+  for (const auto& myApp : myAssignment->assign(myApps, W, myDataCenters)) {
+    ASSERT_LE(myApp.thePeers.size(), W);
+    ASSERT_EQ(myApp.thePeers.size(),
+              std::set<unsigned long>(myApp.thePeers.begin(),
+                                      myApp.thePeers.end())
+                  .size());
+    for (const auto& myPeer : myApp.thePeers) {
+      ASSERT_LE(++myLoads[myPeer], C);
+    }
+  }
+}
+
+TEST_F(TestPeerAssignment, test_load_balancing_hop_limit) {
+  EsNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  const std::vector<PeerAssignment::AppDescriptor> myApps({
+      {0, 1, 0.6},
+      {1, 1, 0.7},
+      {2, 1, 0.8},
+  });
+
+  // data center 8 is 3 hops away from all the apps, the others 2 hops
+  const auto myMaxHops = [](const auto& aApp) -> std::size_t {
+    return aApp.theFidelityThreshold < 0.75 ? 2 : 3;
+  };
+  const auto myCheckFunction = [&myMaxHops](const auto& aApp,
+                                            const auto& aPath) {
+    return aPath.size() <= myMaxHops(aApp);
+  };
+  const auto myAcceptAll = [](const auto&, const auto&) { return true; };
+  std::set<double> myThresholds;
+  const auto       myHopLimit = [&myMaxHops, &myThresholds](const auto& aApp) {
+    myThresholds.emplace(aApp.theFidelityThreshold);
+    return myMaxHops(aApp);
+  };
+
+  for (const auto myAlgo : {PeerAssignmentAlgo::LoadBalancing,
+                            PeerAssignmentAlgo::LoadBalancingMcf}) {
+    auto myChecked =
+        makePeerAssignment(myNetwork, myAlgo, theRv, myCheckFunction);
+    auto myLimited = makePeerAssignment(
+        myNetwork, myAlgo, theRv, myAcceptAll, 1, myHopLimit);
+    for (const unsigned long W : {1, 2, 4}) {
+      // same assignment as with the check function, which does not depend
+      // on the fidelity thresholds of the apps, since the net rates are
+      // found with a fixed threshold of 0.5
+      const auto myExpected = myChecked->assign(theApps, W, theDataCenters);
+      const auto myChecks   = myChecked->assign(myApps, W, theDataCenters);
+      const auto myAssigned = myLimited->assign(myApps, W, theDataCenters);
+      ASSERT_EQ(myExpected.size(), myChecks.size());
+      ASSERT_EQ(myExpected.size(), myAssigned.size());
+      for (std::size_t a = 0; a < myApps.size(); a++) {
+        ASSERT_EQ(myExpected[a].thePeers, myChecks[a].thePeers)
+            << toString(myAlgo) << ", W = " << W << ", app " << a;
+        ASSERT_EQ(myExpected[a].thePeers, myAssigned[a].thePeers)
+            << toString(myAlgo) << ", W = " << W << ", app " << a;
+      }
+    }
+  }
+  ASSERT_EQ(std::set<double>({0.5}), myThresholds);
+}
+
 } // namespace qr
 } // namespace uiiit
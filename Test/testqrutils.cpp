@@ -30,6 +30,7 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/qrutils.h"
+#include "Support/random.h"
 
 #include "Details/examplenetwork.h"
 
@@ -42,6 +43,7 @@ SOFTWARE.
 #include <fstream>
 #include <limits>
 #include <sstream>
+#include <stdexcept>
 
 namespace uiiit {
 namespace qr {
@@ -85,6 +87,50 @@ TEST_F(TestQrUtils, test_find_links) {
   ASSERT_EQ(4, findLinks(myItems, 1.5, 0.8, 0).size());
 }
 
+TEST_F(TestQrUtils, test_find_links_grid) {
+  // reference implementation checking all the pairs
+  const auto myAllPairs = [](const std::vector<Coordinate>& aItems,
+                             const double                   aThreshold,
+                             const double                   aProbability,
+                             const unsigned long            aSeed) {
+    support::UniformRv myRv(0, 1, aSeed, 0, 0);
+    std::vector<std::pair<unsigned long, unsigned long>> ret;
+    for (unsigned long i = 0; i < aItems.size(); i++) {
+      for (unsigned long j = 0; j < i; j++) {
+        if (distance(aItems[i], aItems[j]) < aThreshold and
+            (aProbability == 1 or myRv() < aProbability)) {
+          ret.push_back({i, j});
+        }
+      }
+    }
+    return ret;
+  };
+
+  // random items, plus some on the same spot and some on a line
+  support::UniformRv      myRv(0, 100, 42, 0, 0);
+  std::vector<Coordinate> myItems;
+  for (std::size_t i = 0; i < 500; i++) {
+    myItems.emplace_back(myRv(), myRv(), 0);
+  }
+  for (std::size_t i = 0; i < 5; i++) {
+    myItems.emplace_back(50, 50, 0);
+  }
+  for (std::size_t i = 0; i < 20; i++) {
+    myItems.emplace_back(i * 0.5, 10, 0);
+  }
+
+  for (const auto myThreshold : {0.0, 0.5, 3.0, 10.0, 50.0, 1000.0}) {
+    for (const auto myProbability : {1.0, 0.5}) {
+      const auto myExpected =
+          myAllPairs(myItems, myThreshold, myProbability, 1);
+      ASSERT_EQ(myExpected,
+                findLinks(myItems, myThreshold, myProbability, 1))
+          << "threshold " << myThreshold << ", probability "
+          << myProbability;
+    }
+  }
+}
+
 TEST_F(TestQrUtils, test_find_links_graphml) {
   std::stringstream myStream;
   myStream << exampleNetwork();
@@ -116,6 +162,21 @@ TEST_F(TestQrUtils, test_find_links_graphml) {
   }
 }
 
+TEST_F(TestQrUtils, test_find_duplicate_edges) {
+  using Edges = std::vector<std::pair<unsigned long, unsigned long>>;
+
+  ASSERT_EQ(std::vector<bool>(), findDuplicateEdges(Edges()));
+  ASSERT_EQ(std::vector<bool>({false, false, true, false, true, true}),
+            findDuplicateEdges(Edges({
+                {1, 23},
+                {12, 3},
+                {1, 23},
+                {23, 1},
+                {12, 3},
+                {1, 23},
+            })));
+}
+
 TEST_F(TestQrUtils, test_bigraph_connected) {
   using Graph = std::vector<std::pair<unsigned long, unsigned long>>;
 
@@ -144,6 +205,80 @@ TEST_F(TestQrUtils, test_bigraph_connected) {
   ASSERT_TRUE(bigraphConnected(myEdges));
 }
 
+TEST_F(TestQrUtils, test_counter_uniform) {
+  // same key, same value, in any order
+  ASSERT_EQ(counterUniform(42, 1, 2, 3), counterUniform(42, 1, 2, 3));
+  ASSERT_NE(counterUniform(42, 1, 2, 3), counterUniform(42, 1, 3, 2));
+  ASSERT_NE(counterUniform(42, 1, 2, 3), counterUniform(43, 1, 2, 3));
+  ASSERT_NE(counterUniform(42, 1, 2, 3), counterUniform(42, 0, 2, 3));
+
+  const std::size_t N     = 100;
+  double            mySum = 0;
+  for (std::size_t i = 0; i < N; i++) {
+    for (std::size_t j = 0; j < N; j++) {
+      const auto myValue = counterUniform(42, 0, i, j);
+      ASSERT_GE(myValue, 0);
+      ASSERT_LT(myValue, 1);
+      mySum += myValue;
+    }
+  }
+  ASSERT_NEAR(0.5, mySum / (N * N), 0.01);
+}
+
+TEST_F(TestQrUtils, test_find_waxman_links) {
+  ASSERT_THROW(checkWaxmanParameters(10, 100, 0, 0.5), std::range_error);
+  ASSERT_THROW(checkWaxmanParameters(10, 100, 0.5, 1.1), std::range_error);
+  ASSERT_THROW(checkWaxmanParameters(10, -1, 0.5, 0.5), std::range_error);
+  ASSERT_THROW(checkWaxmanParameters(0, 100, 0.5, 0.5), std::range_error);
+  ASSERT_NO_THROW(checkWaxmanParameters(10, 100, 1, 1));
+
+  const auto myCoordinates = waxmanCoordinates(200, 100, 42, 0);
+  ASSERT_EQ(200, myCoordinates.size());
+  ASSERT_EQ(myCoordinates, waxmanCoordinates(200, 100, 42, 0));
+  ASSERT_NE(myCoordinates, waxmanCoordinates(200, 100, 42, 1));
+
+  for (const auto myBeta : {0.01, 0.1, 1.0}) {
+    auto       myExpectedConnected = false;
+    const auto myExpected          = findWaxmanLinks(
+        myCoordinates, 100, 0.4, myBeta, 42, 0, 1, myExpectedConnected);
+    ASSERT_FALSE(myExpected.empty());
+    ASSERT_TRUE(std::is_sorted(myExpected.begin(), myExpected.end()));
+    for (const auto& myLink : myExpected) {
+      ASSERT_LT(myLink.first, myLink.second);
+    }
+    ASSERT_EQ(bigraphConnected(myExpected), myExpectedConnected);
+    ASSERT_EQ(myBeta > 0.01, myExpectedConnected);
+
+    // the links do not depend on the number of threads
+    for (const std::size_t myNumThreads : {0, 2, 3}) {
+      auto myConnected = false;
+      ASSERT_EQ(myExpected,
+                findWaxmanLinks(myCoordinates,
+                                100,
+                                0.4,
+                                myBeta,
+                                42,
+                                0,
+                                myNumThreads,
+                                myConnected));
+      ASSERT_EQ(myExpectedConnected, myConnected);
+    }
+  }
+
+  // a single item is never connected
+  auto myConnected = true;
+  ASSERT_TRUE(findWaxmanLinks(waxmanCoordinates(1, 100, 42, 0),
+                              100,
+                              0.4,
+                              1,
+                              42,
+                              0,
+                              1,
+                              myConnected)
+                  .empty());
+  ASSERT_FALSE(myConnected);
+}
+
 TEST_F(TestQrUtils, test_fidelity_swapping) {
   ASSERT_FLOAT_EQ(0.9925, fidelitySwapping(1, 1, 1, 0, 0.9925));
   ASSERT_FLOAT_EQ(0.985075, fidelitySwapping(1, 1, 1, 2, 0.9925));
@@ -160,6 +295,44 @@ TEST_F(TestQrUtils, test_fidelity_swapping) {
   ASSERT_FLOAT_EQ(0.279446282739145, fidelitySwapping(0.9, 0.5, 0.95, 4, 0.98));
 }
 
+TEST_F(TestQrUtils, test_fidelity_max_hops) {
+  constexpr auto UNLIMITED = std::numeric_limits<std::size_t>::max();
+
+  // F below the threshold: no path at all
+  ASSERT_EQ(0, fidelityMaxHops(1, 1, 1, 0.9, 0.95));
+
+  // no impairments or threshold not above the asymptotic value
+  ASSERT_EQ(UNLIMITED, fidelityMaxHops(1, 1, 1, 1, 0.95));
+  ASSERT_EQ(UNLIMITED, fidelityMaxHops(0.9, 0.5, 0.95, 0.98, 0.25));
+  ASSERT_EQ(UNLIMITED, fidelityMaxHops(0.9, 0.5, 0.95, 0.98, 0));
+
+  // compare with the brute force check on fidelitySwapping()
+  for (const auto p1 : {0.9, 0.99, 1.0}) {
+    for (const auto p2 : {0.5, 0.99, 1.0}) {
+      for (const auto eta : {0.95, 0.99, 1.0}) {
+        for (const auto F : {0.9, 0.95, 0.98, 0.9925, 1.0}) {
+          for (const auto myThreshold : {0.5, 0.7, 0.9, 0.95, 0.97}) {
+            const auto myMaxHops = fidelityMaxHops(p1, p2, eta, F, myThreshold);
+            std::size_t myExpected = 0;
+            while (myExpected < 1000 and
+                   fidelitySwapping(p1, p2, eta, myExpected, F) >=
+                       myThreshold) {
+              myExpected++;
+            }
+            if (myExpected == 1000) {
+              ASSERT_EQ(UNLIMITED, myMaxHops);
+            } else {
+              ASSERT_EQ(myExpected, myMaxHops)
+                  << "p1 " << p1 << ", p2 " << p2 << ", eta " << eta << ", F "
+                  << F << ", threshold " << myThreshold;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 TEST_F(TestQrUtils, DISABLED_print_fidelity_per_hops) {
   constexpr double p1  = 1.0;
   constexpr double p2  = 1.0;
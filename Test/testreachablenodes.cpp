@@ -0,0 +1,96 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/reachablenodes.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestReachableNodes : public ::testing::Test {};
+
+TEST_F(TestReachableNodes, test_set_get) {
+  using Peers = std::vector<unsigned long>;
+
+  CompactReachableNodes myEmpty(0);
+  ASSERT_EQ(0, myEmpty.numNodes());
+  ASSERT_TRUE(myEmpty.toMap().empty());
+
+  // more than one word per row
+  CompactReachableNodes myNodes(130);
+  ASSERT_EQ(130, myNodes.numNodes());
+  for (std::size_t i = 0; i < myNodes.numNodes(); i++) {
+    ASSERT_EQ(0, myNodes.count(i));
+    ASSERT_TRUE(myNodes.peers(i).empty());
+  }
+
+  myNodes.set(0, 1);
+  myNodes.set(0, 64);
+  myNodes.set(0, 129);
+  myNodes.set(129, 0);
+  myNodes.set(129, 0);
+  myNodes.set(63, 63);
+
+  EXPECT_TRUE(myNodes.reachable(0, 1));
+  EXPECT_TRUE(myNodes.reachable(0, 64));
+  EXPECT_TRUE(myNodes.reachable(0, 129));
+  EXPECT_FALSE(myNodes.reachable(0, 0));
+  EXPECT_FALSE(myNodes.reachable(0, 128));
+  EXPECT_FALSE(myNodes.reachable(1, 0));
+  EXPECT_TRUE(myNodes.reachable(129, 0));
+
+  EXPECT_EQ(3, myNodes.count(0));
+  EXPECT_EQ(1, myNodes.count(129));
+  EXPECT_EQ(1, myNodes.count(63));
+  EXPECT_EQ(0, myNodes.count(1));
+  EXPECT_EQ(Peers({1, 64, 129}), myNodes.peers(0));
+  EXPECT_EQ(Peers({0}), myNodes.peers(129));
+
+  const auto myMap = myNodes.toMap();
+  ASSERT_EQ(130, myMap.size());
+  EXPECT_EQ(std::set<unsigned long>({1, 64, 129}), myMap.at(0));
+  EXPECT_EQ(std::set<unsigned long>({63}), myMap.at(63));
+  EXPECT_TRUE(myMap.at(1).empty());
+
+  auto myCopy = myNodes;
+  EXPECT_TRUE(myCopy == myNodes);
+  myCopy.set(1, 1);
+  EXPECT_FALSE(myCopy == myNodes);
+  EXPECT_FALSE(myNodes == CompactReachableNodes(129));
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,295 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/resultsink.h"
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestResultSink : public ::testing::Test {
+  struct Parameters {
+    std::size_t theSeed;
+    std::string theName;
+
+    std::string toCsv() const {
+      return std::to_string(theSeed) + ',' + theName;
+    }
+
+    std::string key() const {
+      return theName;
+    }
+  };
+
+  struct Output {
+    double theValue;
+
+    std::string toCsv() const {
+      std::stringstream myStream;
+      myStream << theValue << ",end";
+      return myStream.str();
+    }
+  };
+
+  using Sink = ResultSink<Parameters, Output>;
+
+  TestResultSink()
+      : theFilename(
+            (boost::filesystem::current_path() / "removeme.sink").string()) {
+    // noop
+  }
+
+  void SetUp() override {
+    boost::filesystem::remove(theFilename);
+  }
+
+  void TearDown() override {
+    boost::filesystem::remove(theFilename);
+  }
+
+  // run the experiments with seeds in [aSeedStart, aSeedEnd) that are not
+  // in the sink already
+  static void run(Sink&              aSink,
+                  const std::size_t  aSeedStart,
+                  const std::size_t  aSeedEnd,
+                  const std::string& aName = "name") {
+    for (auto mySeed = aSeedStart; mySeed < aSeedEnd; ++mySeed) {
+      if (aSink.contains(Parameters{mySeed, aName})) {
+        continue;
+      }
+      Sink::Raii myRaii(aSink, Parameters{mySeed, aName});
+      myRaii.finish(Output{myRaii.in().theSeed * 0.5});
+    }
+  }
+
+  // return the CSV lines without the durations
+  static std::vector<std::string> csvLines(const Sink& aSink) {
+    std::stringstream myStream;
+    aSink.toCsv(myStream);
+    std::vector<std::string> ret;
+    std::string              myLine;
+    while (std::getline(myStream, myLine)) {
+      ret.emplace_back(myLine.substr(0, myLine.rfind(',')));
+    }
+    return ret;
+  }
+
+  const std::string theFilename;
+};
+
+TEST_F(TestResultSink, test_split_csv) {
+  ASSERT_EQ(std::vector<std::string>({""}), ResultFile::splitCsv(""));
+  ASSERT_EQ(std::vector<std::string>({"a"}), ResultFile::splitCsv("a"));
+  ASSERT_EQ(std::vector<std::string>({"a", "", "b", ""}),
+            ResultFile::splitCsv("a,,b,"));
+}
+
+TEST_F(TestResultSink, test_in_memory) {
+  Sink mySink;
+  run(mySink, 0, 3);
+  ASSERT_EQ(3, mySink.size());
+  ASSERT_TRUE(mySink.contains(Parameters{2, "name"}));
+  ASSERT_FALSE(mySink.contains(Parameters{3, "name"}));
+  ASSERT_EQ(std::vector<std::string>({
+                "0,name,0,end",
+                "1,name,0.5,end",
+                "2,name,1,end",
+            }),
+            csvLines(mySink));
+  ASSERT_FALSE(boost::filesystem::exists(theFilename));
+}
+
+TEST_F(TestResultSink, test_streaming_and_resume) {
+  std::vector<std::string> myExpected;
+  {
+    Sink mySink(theFilename);
+    run(mySink, 0, 5);
+
+    // records are on disk before the sink is destroyed
+    Sink myOther(theFilename, true);
+    ASSERT_EQ(5, myOther.size());
+    myExpected = csvLines(mySink);
+    ASSERT_EQ(myExpected, csvLines(myOther));
+  }
+  ASSERT_EQ(5, myExpected.size());
+
+  {
+    // only the seeds missing are run
+    Sink mySink(theFilename, true);
+    ASSERT_EQ(5, mySink.size());
+    run(mySink, 3, 8);
+    ASSERT_EQ(8, mySink.size());
+    myExpected.emplace_back("5,name,2.5,end");
+    myExpected.emplace_back("6,name,3,end");
+    myExpected.emplace_back("7,name,3.5,end");
+    ASSERT_EQ(myExpected, csvLines(mySink));
+  }
+
+  {
+    // the file is overwritten if not resuming
+    Sink mySink(theFilename, false);
+    ASSERT_EQ(0, mySink.size());
+    run(mySink, 10, 11);
+    ASSERT_EQ(std::vector<std::string>({"10,name,5,end"}), csvLines(mySink));
+  }
+}
+
+TEST_F(TestResultSink, test_resume_other_parameters) {
+  {
+    Sink mySink(theFilename);
+    run(mySink, 0, 3);
+  }
+
+  // neither the seeds already saved are skipped nor the new ones are added
+  {
+    Sink mySink(theFilename, true);
+    ASSERT_THROW(run(mySink, 0, 3, "other"), std::runtime_error);
+    ASSERT_THROW(run(mySink, 3, 5, "other"), std::runtime_error);
+    ASSERT_THROW(Sink::Raii(mySink, Parameters{3, "other"})
+                     .finish(Output{1.5}),
+                 std::runtime_error);
+    ASSERT_EQ(3, mySink.size());
+  }
+
+  // the file is unchanged, and it can be resumed with the same parameters
+  Sink mySink(theFilename, true);
+  run(mySink, 0, 4);
+  ASSERT_EQ(std::vector<std::string>({
+                "0,name,0,end",
+                "1,name,0.5,end",
+                "2,name,1,end",
+                "3,name,1.5,end",
+            }),
+            csvLines(mySink));
+
+  // the same holds in memory
+  Sink myMemory;
+  run(myMemory, 0, 2);
+  ASSERT_THROW(run(myMemory, 2, 3, "other"), std::runtime_error);
+  ASSERT_EQ(2, myMemory.size());
+}
+
+TEST_F(TestResultSink, test_for_each) {
+  {
+    Sink mySink(theFilename);
+    run(mySink, 0, 3);
+  }
+  Sink mySink(theFilename, true);
+  run(mySink, 0, 4);
+
+  std::vector<std::size_t>              mySeeds;
+  std::vector<std::vector<std::string>> myCells;
+  mySink.forEach([&mySeeds, &myCells](const ResultFile::Record& aRecord) {
+    mySeeds.emplace_back(aRecord.theSeed);
+    myCells.emplace_back(aRecord.theCells);
+  });
+  ASSERT_EQ(std::vector<std::size_t>({0, 1, 2, 3}), mySeeds);
+  ASSERT_EQ(std::vector<std::string>({"3", "name", "1.5", "end"}),
+            myCells.back());
+}
+
+TEST_F(TestResultSink, test_incomplete_record) {
+  {
+    Sink mySink(theFilename);
+    run(mySink, 0, 2);
+  }
+  const auto mySize = boost::filesystem::file_size(theFilename);
+
+  // the process was killed while writing the third record
+  {
+    Sink mySink(theFilename, true);
+    run(mySink, 2, 3);
+  }
+  boost::filesystem::resize_file(
+      theFilename, (mySize + boost::filesystem::file_size(theFilename)) / 2);
+
+  Sink mySink(theFilename, true);
+  ASSERT_EQ(mySize, boost::filesystem::file_size(theFilename));
+  ASSERT_EQ(2, mySink.size());
+  ASSERT_FALSE(mySink.contains(Parameters{2, "name"}));
+  run(mySink, 0, 4);
+  ASSERT_EQ(std::vector<std::string>({
+                "0,name,0,end",
+                "1,name,0.5,end",
+                "2,name,1,end",
+                "3,name,1.5,end",
+            }),
+            csvLines(mySink));
+}
+
+TEST_F(TestResultSink, test_dictionary_overflow) {
+  const std::size_t N = 2 * ResultFile::MAX_DICTIONARY + 10;
+  {
+    Sink mySink(theFilename);
+    run(mySink, 0, N / 2);
+  }
+  Sink mySink(theFilename, true);
+  run(mySink, 0, N);
+  const auto myLines = csvLines(mySink);
+  ASSERT_EQ(N, myLines.size());
+  for (std::size_t i = 0; i < N; i++) {
+    std::stringstream myStream;
+    myStream << i << ",name," << i * 0.5 << ",end";
+    ASSERT_EQ(myStream.str(), myLines[i]);
+  }
+
+  // the file is smaller than its CSV export, both without the durations,
+  // whose textual length depends on the actual time taken by the runs
+  std::size_t myCsvSize = 0;
+  for (const auto& myLine : myLines) {
+    myCsvSize += myLine.size() + 1;
+  }
+  ASSERT_LT(boost::filesystem::file_size(theFilename) - N * sizeof(double),
+            myCsvSize);
+}
+
+TEST_F(TestResultSink, test_invalid_file) {
+  {
+    std::ofstream myStream(theFilename);
+    myStream << "seed,name,value,end,duration\n";
+  }
+  ASSERT_THROW(Sink(theFilename, true), std::runtime_error);
+
+  // an empty file is just overwritten
+  { std::ofstream myStream(theFilename); }
+  Sink mySink(theFilename, true);
+  ASSERT_EQ(0, mySink.size());
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,110 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/shard.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestShard : public ::testing::Test {};
+
+TEST_F(TestShard, test_from_string) {
+  ASSERT_EQ("0/1", Shard().toString());
+  ASSERT_EQ("2/5", Shard::fromString("2/5").toString());
+  ASSERT_EQ(2, Shard::fromString("2/5").index());
+  ASSERT_EQ(5, Shard::fromString("2/5").count());
+
+  for (const auto& myInvalid :
+       {"", "/", "1", "1/", "/2", "2/2", "0/0", "-1/2", "1/-2", "1/2/3"}) {
+    ASSERT_THROW(Shard::fromString(myInvalid), std::runtime_error)
+        << myInvalid;
+  }
+}
+
+TEST_F(TestShard, test_assign) {
+  ASSERT_THROW(Shard::assign({1, 2}, 0), std::runtime_error);
+  ASSERT_THROW(Shard::assign({1, -2}, 2), std::runtime_error);
+  ASSERT_TRUE(Shard::assign({}, 3).empty());
+
+  // same costs: round-robin, also with zero costs
+  ASSERT_EQ(std::vector<std::size_t>({0, 1, 2, 0, 1}),
+            Shard::assign({1, 1, 1, 1, 1}, 3));
+  ASSERT_EQ(std::vector<std::size_t>({0, 1, 2, 0, 1}),
+            Shard::assign({0, 0, 0, 0, 0}, 3));
+
+  // longest processing time first
+  ASSERT_EQ(std::vector<std::size_t>({1, 0, 1, 1}),
+            Shard::assign({1, 5, 2, 2}, 2));
+
+  // the total costs of the shards are close to one another
+  std::vector<double> myCosts;
+  for (std::size_t i = 0; i < 1000; i++) {
+    myCosts.emplace_back(1 + (i * 7919) % 100);
+  }
+  const auto          myShards = Shard::assign(myCosts, 7);
+  std::vector<double> myTotals(7, 0);
+  for (std::size_t i = 0; i < myCosts.size(); i++) {
+    ASSERT_LT(myShards[i], 7);
+    myTotals[myShards[i]] += myCosts[i];
+  }
+  const auto myMinMax = std::minmax_element(myTotals.begin(), myTotals.end());
+  ASSERT_LE(*myMinMax.second - *myMinMax.first, 100);
+}
+
+TEST_F(TestShard, test_select) {
+  std::vector<std::size_t> myAll;
+  for (std::size_t i = 0; i < 20; i++) {
+    myAll.emplace_back(i);
+  }
+  const auto myCost = [](const std::size_t aTask) { return aTask % 4; };
+
+  // every task is in exactly one shard, in the original order
+  std::vector<std::size_t> myFound;
+  for (std::size_t i = 0; i < 3; i++) {
+    auto       myTasks    = myAll;
+    const auto mySelected = Shard(i, 3).select(std::move(myTasks), myCost);
+    ASSERT_TRUE(std::is_sorted(mySelected.begin(), mySelected.end()));
+    myFound.insert(myFound.end(), mySelected.begin(), mySelected.end());
+  }
+  std::sort(myFound.begin(), myFound.end());
+  ASSERT_EQ(myAll, myFound);
+
+  auto myTasks = myAll;
+  ASSERT_EQ(myAll, Shard().select(std::move(myTasks), myCost));
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,169 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/taskscheduler.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestTaskScheduler : public ::testing::Test {};
+
+TEST_F(TestTaskScheduler, test_submit) {
+  // with one worker the tasks are executed in order
+  {
+    TaskScheduler            myScheduler(1);
+    std::vector<std::size_t> myOrder;
+    for (std::size_t i = 0; i < 10; i++) {
+      myScheduler.submit([&myOrder, i]() { myOrder.emplace_back(i); });
+    }
+    ASSERT_TRUE(myScheduler.wait().empty());
+    std::vector<std::size_t> myExpected(10);
+    std::iota(myExpected.begin(), myExpected.end(), 0);
+    ASSERT_EQ(myExpected, myOrder);
+  }
+
+  // exceptions are collected
+  {
+    TaskScheduler            myScheduler(4);
+    std::atomic<std::size_t> myCounter(0);
+    for (std::size_t i = 0; i < 100; i++) {
+      myScheduler.submit([&myCounter, i]() {
+        myCounter++;
+        if (i % 10 == 0) {
+          throw std::runtime_error("error " + std::to_string(i));
+        }
+      });
+    }
+    ASSERT_EQ(10, myScheduler.wait().size());
+    ASSERT_EQ(100, myCounter);
+    ASSERT_TRUE(myScheduler.wait().empty());
+  }
+}
+
+TEST_F(TestTaskScheduler, test_parallel_for) {
+  ASSERT_EQ(nullptr, TaskScheduler::current());
+
+  for (const auto myNumThreads : {1, 2, 7}) {
+    TaskScheduler myScheduler(myNumThreads);
+    ASSERT_EQ(myNumThreads, myScheduler.numThreads());
+    for (const std::size_t N : {0, 1, 5, 1000}) {
+      std::vector<std::atomic<std::size_t>> myCounts(N);
+      myScheduler.parallelFor(
+          0, N, [&myCounts](const std::size_t aFirst, const std::size_t aLast) {
+            for (auto i = aFirst; i < aLast; i++) {
+              myCounts[i]++;
+            }
+          });
+      for (const auto& myCount : myCounts) {
+        ASSERT_EQ(1, myCount);
+      }
+    }
+
+    ASSERT_THROW(myScheduler.parallelFor(
+                     10,
+                     20,
+                     [](const std::size_t aFirst, const std::size_t) {
+                       if (aFirst == 10) {
+                         throw std::runtime_error("error");
+                       }
+                     }),
+                 std::runtime_error);
+  }
+}
+
+TEST_F(TestTaskScheduler, test_nested) {
+  for (const auto myNumThreads : {1, 3}) {
+    TaskScheduler myScheduler(myNumThreads);
+
+    // every task runs two levels of nested loops
+    const std::size_t                     N = 20;
+    std::vector<std::atomic<std::size_t>> mySums(N);
+    std::atomic<std::size_t>              myInScheduler(0);
+    for (std::size_t t = 0; t < N; t++) {
+      myScheduler.submit([&, t]() {
+        parallelFor(0, 10, 1, [&](const std::size_t aFirst,
+                                  const std::size_t aLast) {
+          if (TaskScheduler::current() == &myScheduler) {
+            myInScheduler++;
+          }
+          for (auto i = aFirst; i < aLast; i++) {
+            parallelFor(0, 100, 1, [&](const std::size_t aInnerFirst,
+                                       const std::size_t aInnerLast) {
+              mySums[t] += aInnerLast - aInnerFirst;
+            });
+          }
+        });
+      });
+    }
+    ASSERT_TRUE(myScheduler.wait().empty());
+    for (const auto& mySum : mySums) {
+      ASSERT_EQ(1000, mySum);
+    }
+    ASSERT_LT(0, myInScheduler);
+  }
+}
+
+TEST_F(TestTaskScheduler, test_free_parallel_for) {
+  for (const auto myNumThreads : {0, 1, 4}) {
+    std::vector<std::atomic<std::size_t>> myCounts(100);
+    std::atomic<std::size_t>              myOtherThreads(0);
+    const auto myThisThread = std::this_thread::get_id();
+    parallelFor(
+        0,
+        myCounts.size(),
+        myNumThreads,
+        [&](const std::size_t aFirst, const std::size_t aLast) {
+          if (std::this_thread::get_id() != myThisThread) {
+            myOtherThreads++;
+          }
+          for (auto i = aFirst; i < aLast; i++) {
+            myCounts[i]++;
+          }
+        });
+    for (const auto& myCount : myCounts) {
+      ASSERT_EQ(1, myCount);
+    }
+    if (myNumThreads == 1) {
+      ASSERT_EQ(0, myOtherThreads);
+    }
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,164 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/topologycache.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestTopologyCache : public ::testing::Test {
+  TestTopologyCache()
+      : theDirectory((boost::filesystem::current_path() / "removeme.topo")
+                         .string()) {
+    // noop
+  }
+
+  void SetUp() override {
+    boost::filesystem::remove_all(theDirectory);
+  }
+
+  void TearDown() override {
+    boost::filesystem::remove_all(theDirectory);
+  }
+
+  const std::string theDirectory;
+};
+
+TEST_F(TestTopologyCache, test_save_load) {
+  const TopologyCache::Topology myTopology{
+      {{1, 0}, {2, 1}, {3, 0}},
+      {{0, 0, 0}, {1.5, 2.5, 0}, {1e-9, 1e9, 0}, {0.1, 0.2, 0.3}}};
+  const auto myKey = TopologyCache::key("test", 42, {1.0 / 3, 2});
+
+  // disabled cache
+  TopologyCache::Topology myLoaded;
+  TopologyCache().save(myKey, myTopology);
+  ASSERT_FALSE(TopologyCache().load(myKey, myLoaded));
+  ASSERT_FALSE(boost::filesystem::exists(theDirectory));
+
+  // topology not in the cache
+  TopologyCache myCache(theDirectory);
+  ASSERT_TRUE(boost::filesystem::is_directory(theDirectory));
+  ASSERT_FALSE(myCache.load(myKey, myLoaded));
+
+  // topology saved and loaded back
+  myCache.save(myKey, myTopology);
+  ASSERT_TRUE(myCache.load(myKey, myLoaded));
+  ASSERT_EQ(myTopology.theEdges, myLoaded.theEdges);
+  ASSERT_EQ(myTopology.theCoordinates, myLoaded.theCoordinates);
+  ASSERT_TRUE(TopologyCache(theDirectory).load(myKey, myLoaded));
+  ASSERT_FALSE(
+      myCache.load(TopologyCache::key("test", 43, {1.0 / 3, 2}), myLoaded));
+  ASSERT_FALSE(
+      myCache.load(TopologyCache::key("test", 42, {0.333, 2}), myLoaded));
+
+  // truncated file
+  boost::filesystem::resize_file(
+      myCache.filename(myKey),
+      boost::filesystem::file_size(myCache.filename(myKey)) - 8);
+  ASSERT_THROW(myCache.load(myKey, myLoaded), std::runtime_error);
+
+  // not a cache file
+  std::ofstream(myCache.filename(myKey)) << "not a topology";
+  ASSERT_THROW(myCache.load(myKey, myLoaded), std::runtime_error);
+}
+
+TEST_F(TestTopologyCache, test_factories) {
+  TopologyCache myCache(theDirectory);
+
+  // Poisson point process: the same network is created with and without the
+  // cache, also drawing the same number of capacities
+  for (auto i = 0; i < 3; i++) {
+    support::UniformRv      myRv(1, 10, 42, 0, 0);
+    std::vector<Coordinate> myCoordinates;
+    const auto myNetwork = makeCapacityNetworkPpp<CapacityNetwork>(
+        myRv, 42, 30, 60, 20, 0.9, myCoordinates, myCache);
+
+    support::UniformRv      myExpectedRv(1, 10, 42, 0, 0);
+    std::vector<Coordinate> myExpectedCoordinates;
+    const auto myExpected = makeCapacityNetworkPpp<CapacityNetwork>(
+        myExpectedRv, 42, 30, 60, 20, 0.9, myExpectedCoordinates);
+
+    ASSERT_EQ(myExpected->weights(), myNetwork->weights());
+    ASSERT_EQ(myExpectedCoordinates, myCoordinates);
+    ASSERT_EQ(myExpectedRv(), myRv());
+  }
+
+  // Waxman
+  const auto myCapacity = [](const double d) {
+    return 100e3 * std::exp(-d / 100);
+  };
+  for (auto i = 0; i < 3; i++) {
+    std::vector<Coordinate> myCoordinates;
+    const auto myNetwork = makeCapacityNetworkWaxman<CapacityNetwork>(
+        myCapacity, 42, 50, 100, 0.5, 0.5, myCoordinates, myCache);
+
+    std::vector<Coordinate> myExpectedCoordinates;
+    const auto myExpected = makeCapacityNetworkWaxman<CapacityNetwork>(
+        myCapacity, 42, 50, 100, 0.5, 0.5, myExpectedCoordinates);
+
+    ASSERT_EQ(myExpected->weights(), myNetwork->weights());
+    ASSERT_EQ(myExpectedCoordinates, myCoordinates);
+  }
+
+  // Waxman, drawing the edges in parallel
+  for (auto i = 0; i < 3; i++) {
+    std::vector<Coordinate> myCoordinates;
+    const auto myNetwork = makeCapacityNetworkWaxmanParallel<CapacityNetwork>(
+        myCapacity, 42, 50, 100, 0.5, 0.5, myCoordinates, 1, myCache);
+
+    std::vector<Coordinate> myExpectedCoordinates;
+    const auto myExpected = makeCapacityNetworkWaxmanParallel<CapacityNetwork>(
+        myCapacity, 42, 50, 100, 0.5, 0.5, myExpectedCoordinates, 1);
+
+    ASSERT_EQ(myExpected->weights(), myNetwork->weights());
+    ASSERT_EQ(myExpectedCoordinates, myCoordinates);
+  }
+
+  // one file per topology
+  ASSERT_EQ(3,
+            std::distance(boost::filesystem::directory_iterator(theDirectory),
+                          boost::filesystem::directory_iterator()));
+}
+
+} // namespace qr
+} // namespace uiiit